@@ -4,14 +4,19 @@
 
 #include "boiler_manager.hpp"
 #include "mqtt_bridge.hpp"
+#include "diagnostics_snapshot.h"
 #include "open_therm.h"
+#include "bus_log.h"
 #include "esp_log.h"
-#include "esp_timer.h"
+#include "ot_clock.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "freertos/semphr.h"
+#include <algorithm>
 #include <atomic>
 #include <cstring>
+#include <new>
 
 static const char* TAG = "BoilerMgr";
 
@@ -59,6 +64,64 @@ static constexpr DiagnosticCmd DIAG_COMMANDS[] = {
 
 static constexpr size_t DIAG_COMMANDS_COUNT = sizeof(DIAG_COMMANDS) / sizeof(DIAG_COMMANDS[0]);
 
+// Task notification bits for the main loop
+static constexpr uint32_t EVENT_THERMOSTAT = 1u << 0;  // Thermostat frame decoded
+static constexpr uint32_t EVENT_BOILER = 1u << 1;      // Boiler frame decoded (cut-through)
+static constexpr uint32_t EVENT_MODE = 1u << 2;        // setMode() called
+static constexpr uint32_t EVENT_GATEWAY = 1u << 3;     // queueRequest() called
+static constexpr uint32_t EVENT_STOP = 1u << 31;       // stop() requested
+
+static constexpr int64_t HEARTBEAT_INTERVAL_US = 3000000;
+// A thermostat talks at least once a second; after this long without a
+// frame the bus is free for gateway requests back to back
+static constexpr int64_t THERMOSTAT_PERIOD_MAX_US = 1000000;
+static constexpr int64_t THERMOSTAT_SILENT_US = 1500000;
+// Room left before the thermostat's next request is due
+static constexpr int64_t GATEWAY_GAP_MARGIN_US = 50000;
+// The boiler channel's inter-frame delay after each gateway exchange, which
+// a forwarded request that follows would have to sit out
+static constexpr int64_t GATEWAY_DELAY_US = OpenThermProtocol::MASTER_DELAY_US;
+// The boiler has 800 ms to answer; the bus times out at 1 s
+static constexpr std::chrono::milliseconds GATEWAY_RESPONSE_TIMEOUT{1100};
+
+// A queueRequest() entry
+struct GatewayRequest {
+    Frame request;
+    uint32_t tag;
+    GatewayDone done;
+    void* context;
+    int64_t queuedUs;
+};
+
+// A writeData() caller waiting on the main loop. Whichever of the two lets
+// go last frees it, so a caller that timed out leaves it to the callback.
+struct GatewayWaiter {
+    SemaphoreHandle_t done;
+    GatewayResult result;
+    std::atomic<int> refs{2};
+
+    static void release(GatewayWaiter* waiter) {
+        if (waiter->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            vSemaphoreDelete(waiter->done);
+            delete waiter;
+        }
+    }
+
+    static void complete(void* context, const GatewayResult& result) {
+        GatewayWaiter* waiter = static_cast<GatewayWaiter*>(context);
+        waiter->result = result;
+        xSemaphoreGive(waiter->done);
+        release(waiter);
+    }
+};
+
+// MQTT diagnostic publish policies: deadband, deadband %, min and max
+// interval (ms). MqttConfig::policies overrides them per sensor id.
+static const PublishPolicy TEMPERATURE_POLICY{0.2f, 0.0f, 10000, 300000};
+static const PublishPolicy MODULATION_POLICY{2.0f, 0.0f, 10000, 300000};
+static const PublishPolicy PRESSURE_POLICY{0.05f, 0.0f, 10000, 300000};
+static const PublishPolicy STATE_POLICY{0.0f, 0.0f, 0, 300000};     // Every change, at once
+
 // Loop states
 enum class LoopState {
     Idle,
@@ -83,15 +146,29 @@ static uint16_t buildStatusWord(bool chOn) {
     return status;
 }
 
+// Repair stage counts for one side, once it has had failed frames
+static void logRepairStats(const char* side, const RepairStats& stats) {
+    if (stats.attempted == 0) return;
+    ESP_LOGI(TAG, "Repairs (%s): failed=%lu spike=%lu split=%lu flip=%lu unrepaired=%lu", side,
+             (unsigned long)stats.attempted, (unsigned long)stats.spikeMerges,
+             (unsigned long)stats.pulseSplits, (unsigned long)stats.halfBitFlips,
+             (unsigned long)stats.unrepaired);
+}
+
 class BoilerManager::Impl {
 public:
     explicit Impl(const ManagerConfig& config)
         : config_(config)
+        , trace_(config.traceRecords)
+        , gatewayQueue_(xQueueCreate(GATEWAY_REQUEST_QUEUE, sizeof(GatewayRequest)))
     {
     }
 
     ~Impl() {
         stop();
+        if (gatewayQueue_) {
+            vQueueDelete(gatewayQueue_);
+        }
     }
 
     esp_err_t start() {
@@ -107,6 +184,11 @@ public:
         thermostat_->begin();
         boiler_->begin();
 
+        // Bus logging is drained below the bus tasks' priority
+        if (BusLog::start() != ESP_OK) {
+            ESP_LOGW(TAG, "Bus log task not started, bus events are not printed");
+        }
+
         running_ = true;
 
         BaseType_t ret = xTaskCreate(
@@ -132,6 +214,12 @@ public:
 
     void stop() {
         running_ = false;
+        if (taskHandle_) {
+            xTaskNotify(taskHandle_, EVENT_STOP, eSetBits);
+        }
+        // Each side's edge ISR feeds the other side's TX: detach both first
+        if (thermostat_) thermostat_->repeatTo(nullptr);
+        if (boiler_) boiler_->repeatTo(nullptr);
         if (thermostat_) thermostat_->end();
         if (boiler_) boiler_->end();
         if (taskHandle_) {
@@ -159,36 +247,161 @@ public:
         s.demandChEnabled = false;
         s.lastDemandTime = std::chrono::milliseconds{0};
         s.mqttAvailable = false;
+
+        uint32_t count = wakeLatencyCount_.load();
+        s.wakeLatencyLastUs = wakeLatencyLastUs_.load();
+        s.wakeLatencyMaxUs = wakeLatencyMaxUs_.load();
+        s.wakeLatencyAvgUs = count ? static_cast<uint32_t>(wakeLatencySumUs_.load() / count) : 0;
+        s.forwardLatencyLastUs = forwardLatencyLastUs_.load();
+        s.forwardLatencyMaxUs = forwardLatencyMaxUs_.load();
+        s.gatewayQueued = gatewayQueued_.load(std::memory_order_relaxed);
+        s.gatewayRejected = gatewayRejected_.load(std::memory_order_relaxed);
+        s.gatewayAnswered = gatewayAnswered_.load(std::memory_order_relaxed);
+        s.gatewayFailed = gatewayFailed_.load(std::memory_order_relaxed);
+        s.gatewayPending = gatewayPending_.load(std::memory_order_relaxed);
         return s;
     }
 
+    BusStats thermostatBusStats() const {
+        return thermostat_ ? thermostat_->busStats() : BusStats{};
+    }
+
+    BusStats boilerBusStats() const {
+        return boiler_ ? boiler_->busStats() : BusStats{};
+    }
+
     void setMode(ManagerMode mode) {
         config_.mode = mode;
+        // Cut-through is armed/disarmed from the main loop
+        if (taskHandle_) {
+            xTaskNotify(taskHandle_, EVENT_MODE, eSetBits);
+        }
     }
 
+    // Through the gateway queue like any other request, so the boiler
+    // channel only ever has the main loop driving it
     esp_err_t writeData(uint8_t dataId, uint16_t dataValue,
                         std::optional<Frame>& response,
                         std::chrono::milliseconds timeout) {
-        Frame request = Frame::buildRequest(MessageType::WriteData, dataId, dataValue);
+        GatewayWaiter* waiter = new (std::nothrow) GatewayWaiter;
+        if (!waiter) {
+            return ESP_ERR_NO_MEM;
+        }
+        waiter->done = xSemaphoreCreateBinary();
+        if (!waiter->done) {
+            delete waiter;
+            return ESP_ERR_NO_MEM;
+        }
+        esp_err_t err = queueRequest(Frame::buildRequest(MessageType::WriteData, dataId, dataValue), 0,
+                                     &GatewayWaiter::complete, waiter);
+        if (err != ESP_OK) {
+            vSemaphoreDelete(waiter->done);
+            delete waiter;
+            return err;
+        }
+        if (xSemaphoreTake(waiter->done, pdMS_TO_TICKS(timeout.count())) != pdTRUE) {
+            GatewayWaiter::release(waiter);
+            return ESP_ERR_TIMEOUT;
+        }
+        err = waiter->result.err;
+        if (err == ESP_OK) {
+            response = waiter->result.response;
+        }
+        GatewayWaiter::release(waiter);
+        return err;
+    }
 
-        // Send request to boiler
-        auto boilerResponse = boiler_->sendRequest(request.raw());
-        if (boilerResponse == 0) {
-            return ESP_ERR_INVALID_STATE; // Boiler busy
+    esp_err_t queueRequest(Frame request, uint32_t tag, GatewayDone done, void* context) {
+        if (!running_.load() || !gatewayQueue_ || !taskHandle_) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        GatewayRequest entry{request, tag, done, context, clockUs()};
+        gatewayPending_.fetch_add(1, std::memory_order_relaxed);
+        if (xQueueSend(gatewayQueue_, &entry, 0) != pdTRUE) {
+            gatewayPending_.fetch_sub(1, std::memory_order_relaxed);
+            gatewayRejected_.fetch_add(1, std::memory_order_relaxed);
+            return ESP_ERR_NO_MEM;
         }
-        response = Frame(boilerResponse);
+        gatewayQueued_.fetch_add(1, std::memory_order_relaxed);
+        xTaskNotify(taskHandle_, EVENT_GATEWAY, eSetBits);
         return ESP_OK;
     }
 
-    void setMessageCallback(MessageCallback callback) {
-        messageCallback_ = std::move(callback);
+    // Send request to the boiler and sleep until it completes or times out;
+    // main loop only. status, if given, gets how the response decoded
+    esp_err_t transact(Frame request, std::optional<Frame>& response, std::chrono::milliseconds timeout,
+                       OpenThermResponseStatus* status = nullptr) {
+        OpenThermTransaction txn = boiler_->submitRequest(request.raw());
+        if (!txn) {
+            return ESP_ERR_INVALID_STATE; // Boiler busy
+        }
+
+        const OpenThermResponseStatus result = txn.wait(pdMS_TO_TICKS(timeout.count()));
+        if (status) {
+            *status = result;
+        }
+        switch (result) {
+            case OpenThermResponseStatus::SUCCESS:
+                response = Frame(txn.response());
+                return ESP_OK;
+            case OpenThermResponseStatus::INVALID:
+                // Decoded but not an ACK (e.g. UNKNOWN_DATA_ID) - let the caller see it
+                if (txn.response() != 0) {
+                    response = Frame(txn.response());
+                    return ESP_OK;
+                }
+                return ESP_ERR_INVALID_RESPONSE;
+            case OpenThermResponseStatus::NONE:
+                txn.cancel();
+                return ESP_ERR_TIMEOUT;
+            default:
+                return ESP_ERR_TIMEOUT;
+        }
     }
 
+    FrameEventBus& events() { return events_; }
+
     void setMqttBridge(MqttBridge* mqtt) {
+        if (mqtt) {
+            // Declared once; discovery goes out per connection, not per value
+            mqttSensors_.chMode = mqtt->declareBinarySensor("ch_mode", "CH Mode", STATE_POLICY);
+            mqttSensors_.dhwMode = mqtt->declareBinarySensor("dhw_mode", "DHW Mode", STATE_POLICY);
+            mqttSensors_.flame = mqtt->declareBinarySensor("flame", "Flame Status", STATE_POLICY);
+            mqttSensors_.tBoiler = mqtt->declareSensor("tboiler", "Boiler Temperature", "C", TEMPERATURE_POLICY);
+            mqttSensors_.maxChWaterTemp = mqtt->declareSensor("maxchwatertemp", "Max CH Water Temperature", "C",
+                                                              TEMPERATURE_POLICY);
+            mqttSensors_.tReturn = mqtt->declareSensor("treturn", "Return Temperature", "C", TEMPERATURE_POLICY);
+            mqttSensors_.tExhaust = mqtt->declareSensor("texhaust", "Exhaust Temperature", "C", TEMPERATURE_POLICY);
+            mqttSensors_.tSet = mqtt->declareSensor("tset", "Boiler Setpoint", "C", TEMPERATURE_POLICY);
+            mqttSensors_.modulation = mqtt->declareSensor("modulation", "Modulation Level", "%", MODULATION_POLICY);
+            mqttSensors_.pressure = mqtt->declareSensor("pressure", "CH Pressure", "bar", PRESSURE_POLICY);
+            mqttSensors_.fault = mqtt->declareSensor("fault", "Fault Code", "", STATE_POLICY);
+            // Runs on the MQTT publisher task, into the bridge's buffer
+            mqtt->setSnapshotWriter([this](char* buf, size_t size) {
+                return formatDiagnosticsSnapshot(diagnostics_, clockMs(), buf, size);
+            });
+            // <base>/ot/<id>/read|write: queued here, answered from the main loop
+            mqtt->setBusCommandHandler([this, mqtt](const BusCommand& command) {
+                Frame request = Frame::buildRequest(command.write ? MessageType::WriteData : MessageType::ReadData,
+                                                    command.dataId, command.value);
+                return queueRequest(request, command.tag, &Impl::busCommandDone, mqtt);
+            });
+        }
         mqttBridge_ = mqtt;
     }
 
+    FrameTrace& frameTrace() { return trace_; }
+
 private:
+    static void busCommandDone(void* context, const GatewayResult& result) {
+        BusCommand command;
+        command.dataId = result.request.dataId();
+        command.write = result.request.messageType() == MessageType::WriteData;
+        command.value = result.request.dataValue();
+        command.tag = result.tag;
+        static_cast<MqttBridge*>(context)->publishBusResponse(command, result.err, result.response.raw());
+    }
+
     static void taskEntry(void* arg) {
         auto* self = static_cast<Impl*>(arg);
         self->taskFunction();
@@ -344,77 +557,296 @@ private:
 
     void taskFunction() {
         ESP_LOGI(TAG, "Main loop task started");
-        uint32_t loopCount = 0;
         uint32_t validFrames = 0;
         uint32_t invalidFrames = 0;
+        int64_t lastHeartbeatUs = clockUs();
+        int64_t lastThermostatUs = clockUs();
+        int64_t thermostatPeriodUs = THERMOSTAT_PERIOD_MAX_US;
+
+        // Block until the thermostat monitor task decodes a frame (or a
+        // process() timeout is due) instead of polling every tick
+        thermostat_->setEventNotify(xTaskGetCurrentTaskHandle(), EVENT_THERMOSTAT);
+        bool cutThrough = false;
 
-        // Rewrite the loop into a task waiting for notifications from the OpenTherm instances
-        // Rewrite OpenTherm to use notifications, and try to use RMT instead of interrupts
         while (running_.load()) {
-            thermostat_->process([this, &loopCount, &validFrames, &invalidFrames](unsigned long request, OpenThermResponseStatus status) {
+            if ((config_.mode == ManagerMode::CutThrough) != cutThrough) {
+                cutThrough = setCutThrough(!cutThrough);
+            }
+
+            int64_t nowUs = clockUs();
+            int64_t heartbeatDueUs = lastHeartbeatUs + HEARTBEAT_INTERVAL_US - nowUs;
+            TickType_t wait = heartbeatDueUs > 0 ? pdMS_TO_TICKS(heartbeatDueUs / 1000) + 1 : 0;
+            wait = std::min(wait, thermostat_->nextProcessDeadline());
+            if (cutThrough) {
+                wait = std::min(wait, boiler_->nextProcessDeadline());
+            } else if (gatewayPending_.load(std::memory_order_relaxed) > 0) {
+                // Wake for queued gateway requests once the thermostat is silent
+                int64_t silentDueUs = lastThermostatUs + THERMOSTAT_SILENT_US - nowUs;
+                wait = std::min(wait, silentDueUs > 0 ? pdMS_TO_TICKS(silentDueUs / 1000) + 1 : 0);
+            }
+
+            uint32_t events = 0;
+            xTaskNotifyWait(0, UINT32_MAX, &events, wait);
+            if (events & EVENT_STOP) {
+                break;
+            }
+
+            bool forwarded = false;
+            thermostat_->process([this, cutThrough, &validFrames, &invalidFrames, &forwarded, &lastThermostatUs,
+                                  &thermostatPeriodUs](unsigned long request, OpenThermResponseStatus status) {
                 if (status == OpenThermResponseStatus::TIMEOUT) {
                     // Don't log timeouts - they're normal when no data
                     return;
                 }
+                int64_t now = clockUs();
+                thermostatPeriodUs = std::min(now - lastThermostatUs, THERMOSTAT_PERIOD_MAX_US);
+                lastThermostatUs = now;
 
                 Frame reqFrame(request);
                 uint8_t dataId = reqFrame.dataId();
                 auto msgType = reqFrame.messageType();
 
-                int64_t t0 = esp_timer_get_time();
+                int64_t t0 = clockUs();
+                // The frame timestamp is a 32-bit microsecond count, so take
+                // the difference in 32 bits for it to survive the wrap
+                const uint32_t decodedUs = static_cast<uint32_t>(thermostat_->lastFrameTimestamp());
+                recordWakeLatency(static_cast<uint32_t>(t0) - decodedUs);
 
                 if (status == OpenThermResponseStatus::INVALID) {
                     invalidFrames++;
-                    logMessage("DISCARDED_REQUEST", MessageSource::ThermostatBoiler, reqFrame);
+                    logMessage(MessageDirection::DiscardedRequest, MessageSource::ThermostatBoiler, reqFrame,
+                               status);
+                    return;
+                } else if (cutThrough) {
+                    // Already on its way to the boiler; the response is picked
+                    // up from the boiler side below
+                    validFrames++;
+                    logMessage(MessageDirection::Request, MessageSource::ThermostatBoiler, reqFrame, status);
                     return;
                 } else {
                     validFrames++;
-                    Frame reqFrame(request);
-                    ESP_LOGI(TAG, "Forwarding ID=%d request 0x%08lX to boiler", reqFrame.dataId(), request);
-                    logMessage("REQUEST", MessageSource::ThermostatBoiler, reqFrame);
+                    BusLog::push(LogEvent::Forwarding, 0, request, 0);
+                    logMessage(MessageDirection::Request, MessageSource::ThermostatBoiler, reqFrame, status);
                 }
 
                 auto boilerResponse = boiler_->sendRequest(request);
-                int64_t t1 = esp_timer_get_time();
+                // Set by the wait above, on this task
+                const OpenThermResponseStatus boilerStatus = boiler_->getLastResponseStatus();
+                int64_t t1 = clockUs();
+                forwarded = true;
 
                 if (!boilerResponse) {
-                    ESP_LOGW(TAG, "Failed to send request to boiler (took %lld ms)", (t1 - t0) / 1000);
+                    trace_.record(TraceEvent::BoilerTimeout, static_cast<uint8_t>(MessageSource::ThermostatBoiler),
+                                  request, static_cast<uint8_t>(OpenThermResponseStatus::TIMEOUT));
+                    BusLog::push(LogEvent::BoilerTimeout, 0, request, static_cast<uint32_t>(t1 - t0));
                     return;
                 }
 
                 Frame respFrame(boilerResponse);
-
-                ESP_LOGI(TAG, "Boiler response: 0x%08lX (took %lld ms)", boilerResponse, (t1 - t0) / 1000);
-
-                logMessage("RESPONSE", MessageSource::ThermostatBoiler, respFrame);
                 bool sent = thermostat_->sendResponse(boilerResponse);
-                int64_t t2 = esp_timer_get_time();
-                ESP_LOGI(TAG, "Response sent to thermostat: %s (took %lld ms total)", sent ? "OK" : "FAILED", (t2 - t0) / 1000);
+                int64_t t2 = clockUs();
+                recordForwardLatency(static_cast<uint32_t>(t2) - decodedUs);
+
+                BusLog::push(LogEvent::BoilerResponse, 0, boilerResponse, static_cast<uint32_t>(t1 - t0));
+                logMessage(MessageDirection::Response, MessageSource::ThermostatBoiler, respFrame, boilerStatus);
+                BusLog::push(LogEvent::ResponseSent, 0, boilerResponse,
+                             (static_cast<uint32_t>(t2 - t0) & 0x7FFFFFFF) | (sent ? 1u << 31 : 0));
 
                 parseDiagnosticResponse(respFrame.dataId(), respFrame);
             });
 
+            // Cut-through: boiler responses reach the thermostat bit by bit,
+            // the decoded copies are only logged and parsed
+            if (cutThrough) {
+                boiler_->process([this](unsigned long response, OpenThermResponseStatus status) {
+                    if (status == OpenThermResponseStatus::TIMEOUT) {
+                        return;
+                    }
+                    Frame respFrame(response);
+                    logMessage(MessageDirection::Response, MessageSource::ThermostatBoiler, respFrame, status);
+                    parseDiagnosticResponse(respFrame.dataId(), respFrame);
+                });
+            }
+            const unsigned long heardUs = thermostat_->lastFrameTimestamp();
+
+            // Gateway requests go in the gap a forwarded exchange leaves
+            // before the thermostat's next request, or one per pass while
+            // the thermostat is silent. Repeating leaves no room for them.
+            if (cutThrough) {
+                failGatewayRequests();
+            } else if (clockUs() - lastThermostatUs >= THERMOSTAT_SILENT_US) {
+                // Not once the thermostat speaks again: the frame the
+                // monitor decoded since process() goes first, next pass
+                if (thermostat_->lastFrameTimestamp() == heardUs) {
+                    runGatewayRequest();
+                }
+            } else if (forwarded) {
+                runGatewayRequests(lastThermostatUs + thermostatPeriodUs - GATEWAY_GAP_MARGIN_US);
+            }
+
             // Periodic status logging
-            loopCount++;
-            if (loopCount % 3000 == 0) {
-                ESP_LOGI(TAG, "Heartbeat: valid=%lu invalid=%lu gpio=%d",
+            nowUs = clockUs();
+            if (nowUs - lastHeartbeatUs >= HEARTBEAT_INTERVAL_US) {
+                lastHeartbeatUs = nowUs;
+                uint32_t count = wakeLatencyCount_.load();
+                ESP_LOGI(TAG, "Heartbeat: valid=%lu invalid=%lu gpio=%d wake_us(last=%lu max=%lu avg=%lu)",
                          (unsigned long)validFrames,
                          (unsigned long)invalidFrames,
-                         gpio_get_level(config_.thermostatInPin));
+                         gpio_get_level(config_.thermostatInPin),
+                         (unsigned long)wakeLatencyLastUs_.load(),
+                         (unsigned long)wakeLatencyMaxUs_.load(),
+                         (unsigned long)(count ? wakeLatencySumUs_.load() / count : 0));
+                if (cutThrough) {
+                    ESP_LOGI(TAG, "Cut-through drops: thermostat->boiler=%lu boiler->thermostat=%lu",
+                             (unsigned long)thermostat_->repeatDropCount(),
+                             (unsigned long)boiler_->repeatDropCount());
+                }
+                logRepairStats("thermostat", thermostat_->repairStats());
+                logRepairStats("boiler", boiler_->repairStats());
+                ESP_LOGI(TAG, "Forward us(last=%lu max=%lu) stack free(thermostat=%lu boiler=%lu) log drops=%lu",
+                         (unsigned long)forwardLatencyLastUs_.load(),
+                         (unsigned long)forwardLatencyMaxUs_.load(),
+                         (unsigned long)thermostat_->monitorStackHeadroom(),
+                         (unsigned long)boiler_->monitorStackHeadroom(),
+                         (unsigned long)BusLog::dropped());
             }
-
-            // Small delay to prevent busy looping
-            vTaskDelay(pdMS_TO_TICKS(1));
         }
 
+        if (cutThrough) {
+            setCutThrough(false);
+        }
+        failGatewayRequests();
+        thermostat_->setEventNotify(nullptr, 0);
         ESP_LOGI(TAG, "Main loop task stopped");
     }
 
+    void completeGatewayRequest(const GatewayRequest& entry, GatewayResult& result) {
+        gatewayPending_.fetch_sub(1, std::memory_order_relaxed);
+        (result.err == ESP_OK ? gatewayAnswered_ : gatewayFailed_).fetch_add(1, std::memory_order_relaxed);
+        if (entry.done) {
+            entry.done(entry.context, result);
+        }
+    }
+
+    // As many queued gateway requests as are expected to be done by
+    // deadlineUs, judging by how long recent ones took, with the boiler's
+    // inter-frame delay after the last one also over by then
+    void runGatewayRequests(int64_t deadlineUs) {
+        while (gatewayPending_.load(std::memory_order_relaxed) > 0 &&
+               clockUs() + gatewayRequestUs_ + GATEWAY_DELAY_US <= deadlineUs) {
+            int64_t startUs = clockUs();
+            if (!runGatewayRequest()) {
+                break;
+            }
+            // Follows a slower boiler at once, a faster one gradually
+            int64_t tookUs = clockUs() - startUs;
+            gatewayRequestUs_ = std::max(tookUs, gatewayRequestUs_ - gatewayRequestUs_ / 8);
+        }
+    }
+
+    // Send the oldest queued gateway request and hand over the result.
+    // False when none was queued.
+    bool runGatewayRequest() {
+        GatewayRequest entry;
+        if (!gatewayQueue_ || xQueueReceive(gatewayQueue_, &entry, 0) != pdTRUE) {
+            return false;
+        }
+        GatewayResult result;
+        result.request = entry.request;
+        result.tag = entry.tag;
+        result.waitedUs = static_cast<uint32_t>(clockUs() - entry.queuedUs);
+
+        logMessage(MessageDirection::Request, MessageSource::GatewayBoiler, entry.request,
+                   OpenThermResponseStatus::SUCCESS);
+        std::optional<Frame> response;
+        OpenThermResponseStatus status = OpenThermResponseStatus::NONE;
+        result.err = transact(entry.request, response, GATEWAY_RESPONSE_TIMEOUT, &status);
+        if (result.err == ESP_OK && response) {
+            result.response = *response;
+            logMessage(MessageDirection::Response, MessageSource::GatewayBoiler, *response, status);
+            if (response->messageType() == MessageType::ReadAck) {
+                parseDiagnosticResponse(response->dataId(), *response);
+            }
+        } else if (result.err == ESP_ERR_TIMEOUT) {
+            trace_.record(TraceEvent::BoilerTimeout, static_cast<uint8_t>(MessageSource::GatewayBoiler),
+                          entry.request.raw(), static_cast<uint8_t>(OpenThermResponseStatus::TIMEOUT));
+        }
+        completeGatewayRequest(entry, result);
+        return true;
+    }
+
+    // Fail everything queued: the gateway cannot transmit
+    void failGatewayRequests() {
+        GatewayRequest entry;
+        while (gatewayQueue_ && xQueueReceive(gatewayQueue_, &entry, 0) == pdTRUE) {
+            GatewayResult result;
+            result.request = entry.request;
+            result.tag = entry.tag;
+            result.err = ESP_ERR_INVALID_STATE;
+            result.waitedUs = static_cast<uint32_t>(clockUs() - entry.queuedUs);
+            completeGatewayRequest(entry, result);
+        }
+    }
 
-    void logMessage(std::string_view direction, MessageSource source, Frame message) {
-        if (messageCallback_) {
-            messageCallback_(direction, source, message);
+    // Arm or disarm the bit-level repeaters in both directions. Returns the
+    // resulting state; falls back to passthrough if arming fails.
+    bool setCutThrough(bool enable) {
+        if (enable) {
+            esp_err_t err = thermostat_->repeatTo(boiler_.get());
+            if (err == ESP_OK) {
+                err = boiler_->repeatTo(thermostat_.get());
+            }
+            if (err == ESP_OK) {
+                boiler_->setEventNotify(xTaskGetCurrentTaskHandle(), EVENT_BOILER);
+                ESP_LOGI(TAG, "Cut-through repeating enabled");
+                return true;
+            }
+            ESP_LOGE(TAG, "Failed to enable cut-through: %s", esp_err_to_name(err));
+            config_.mode = ManagerMode::Passthrough;
         }
+        thermostat_->repeatTo(nullptr);
+        boiler_->repeatTo(nullptr);
+        boiler_->setEventNotify(nullptr, 0);
+        if (!enable) {
+            ESP_LOGI(TAG, "Cut-through repeating disabled");
+        }
+        return false;
+    }
+
+    // Time from the monitor task decoding a thermostat frame to this task
+    // starting to forward it
+    void recordWakeLatency(unsigned long latencyUs) {
+        uint32_t us = static_cast<uint32_t>(latencyUs);
+        wakeLatencyLastUs_.store(us);
+        if (us > wakeLatencyMaxUs_.load()) {
+            wakeLatencyMaxUs_.store(us);
+        }
+        wakeLatencySumUs_.fetch_add(us);
+        wakeLatencyCount_.fetch_add(1);
+    }
+
+    // Time from the monitor task decoding a thermostat frame to the boiler's
+    // response having been sent back
+    void recordForwardLatency(unsigned long latencyUs) {
+        uint32_t us = static_cast<uint32_t>(latencyUs);
+        forwardLatencyLastUs_.store(us);
+        if (us > forwardLatencyMaxUs_.load()) {
+            forwardLatencyMaxUs_.store(us);
+        }
+    }
+
+    // Traced with the status the frame decoded with, and published to the
+    // event bus subscribers
+    void logMessage(MessageDirection direction, MessageSource source, Frame message,
+                    OpenThermResponseStatus status) {
+        TraceEvent event = TraceEvent::Request;
+        if (direction == MessageDirection::Response) {
+            event = TraceEvent::Response;
+        } else if (direction == MessageDirection::DiscardedRequest) {
+            event = TraceEvent::DiscardedRequest;
+        }
+        trace_.record(event, static_cast<uint8_t>(source), message.raw(), static_cast<uint8_t>(status));
+        events_.publish(source, direction, message);
     }
 
     void parseDiagnosticResponse(uint8_t dataId, Frame response) {
@@ -430,33 +862,33 @@ private:
                     // Bit 1: CH mode
                     bool chActive = (slaveStatus & 0x02) != 0;
                     diagnostics_.chMode.update(chActive ? 1.0f : 0.0f);
-                    publishBinaryDiag("ch_mode", "CH Mode", chActive);
+                    publishBinaryDiag(mqttSensors_.chMode, chActive);
                     
                     // Bit 2: DHW mode
                     bool dhwActive = (slaveStatus & 0x04) != 0;
                     diagnostics_.dhwMode.update(dhwActive ? 1.0f : 0.0f);
-                    publishBinaryDiag("dhw_mode", "DHW Mode", dhwActive);
+                    publishBinaryDiag(mqttSensors_.dhwMode, dhwActive);
                     
                     // Bit 3: Flame indicator
                     bool flame = (slaveStatus & 0x08) != 0;
                     diagnostics_.flameOn.update(flame ? 1.0f : 0.0f);
-                    publishBinaryDiag("flame", "Flame Status", flame);
+                    publishBinaryDiag(mqttSensors_.flame, flame);
                 }
                 break;
             case 25:
                 floatVal = response.asFloat();
                 diagnostics_.tBoiler.update(floatVal);
-                publishDiag("tboiler", "Boiler Temperature", "C", diagnostics_.tBoiler);
+                publishDiag(mqttSensors_.tBoiler, diagnostics_.tBoiler);
                 break;
             case 57:
                 floatVal = response.asFloat();
                 diagnostics_.maxChWaterTemp.update(floatVal);
-                publishDiag("maxchwatertemp", "Max CH Water Temperature", "C", diagnostics_.maxChWaterTemp);
+                publishDiag(mqttSensors_.maxChWaterTemp, diagnostics_.maxChWaterTemp);
                 break;
             case 28:
                 floatVal = response.asFloat();
                 diagnostics_.tReturn.update(floatVal);
-                publishDiag("treturn", "Return Temperature", "C", diagnostics_.tReturn);
+                publishDiag(mqttSensors_.tReturn, diagnostics_.tReturn);
                 break;
             case 26:
                 floatVal = response.asFloat();
@@ -474,7 +906,7 @@ private:
                 floatVal = static_cast<float>(static_cast<int16_t>(response.dataValue()));
                 if (floatVal > -40 && floatVal < 500) {
                     diagnostics_.tExhaust.update(floatVal);
-                    publishDiag("texhaust", "Exhaust Temperature", "C", diagnostics_.tExhaust);
+                    publishDiag(mqttSensors_.tExhaust, diagnostics_.tExhaust);
                 }
                 break;
             case 34:
@@ -497,21 +929,21 @@ private:
                 floatVal = response.asFloat();
                 if (floatVal > 0 && floatVal < 100) {
                     diagnostics_.tSetpoint.update(floatVal);
-                    publishDiag("tset", "Boiler Setpoint", "C", diagnostics_.tSetpoint);
+                    publishDiag(mqttSensors_.tSet, diagnostics_.tSetpoint);
                 }
                 break;
             case 17:
                 floatVal = response.asFloat();
                 if (floatVal >= 0 && floatVal <= 100) {
                     diagnostics_.modulationLevel.update(floatVal);
-                    publishDiag("modulation", "Modulation Level", "%", diagnostics_.modulationLevel);
+                    publishDiag(mqttSensors_.modulation, diagnostics_.modulationLevel);
                 }
                 break;
             case 18:
                 floatVal = response.asFloat();
                 if (floatVal >= 0) {
                     diagnostics_.pressure.update(floatVal);
-                    publishDiag("pressure", "CH Pressure", "bar", diagnostics_.pressure);
+                    publishDiag(mqttSensors_.pressure, diagnostics_.pressure);
                 }
                 break;
             case 19:
@@ -521,7 +953,7 @@ private:
             case 5:
                 uint8Val = response.lowByte();
                 diagnostics_.faultCode.update(static_cast<float>(uint8Val));
-                publishDiag("fault", "Fault Code", "", diagnostics_.faultCode);
+                publishDiag(mqttSensors_.fault, diagnostics_.faultCode);
                 break;
             case 115:
                 uint16Val = response.dataValue();
@@ -584,15 +1016,16 @@ private:
         }
     }
 
-    void publishDiag(const char* id, const char* name, const char* unit, const DiagnosticValue& dv) {
+    // Queued for the MQTT publisher task; no broker I/O on the bus task
+    void publishDiag(SensorHandle sensor, const DiagnosticValue& dv) {
         if (mqttBridge_ && dv.isValid()) {
-            mqttBridge_->publishSensor(id, name, unit, dv.valueOr(0.0f), true);
+            (void)mqttBridge_->publishSensor(sensor, dv.valueOr(0.0f), true);
         }
     }
 
-    void publishBinaryDiag(const char* id, const char* name, bool state) {
+    void publishBinaryDiag(SensorHandle sensor, bool state) {
         if (mqttBridge_) {
-            mqttBridge_->publishBinarySensor(id, name, state, true);
+            (void)mqttBridge_->publishBinarySensor(sensor, state, true);
         }
     }
 
@@ -607,10 +1040,42 @@ private:
 
     // Diagnostics
     Diagnostics diagnostics_;
-    // Callback (for logging)
-    MessageCallback messageCallback_;
+    // Frame events for the WebSocket feed, loggers and the like
+    FrameEventBus events_;
     // MQTT bridge for publishing diagnostics
     MqttBridge* mqttBridge_ = nullptr;
+    struct {
+        SensorHandle chMode = INVALID_SENSOR;
+        SensorHandle dhwMode = INVALID_SENSOR;
+        SensorHandle flame = INVALID_SENSOR;
+        SensorHandle tBoiler = INVALID_SENSOR;
+        SensorHandle maxChWaterTemp = INVALID_SENSOR;
+        SensorHandle tReturn = INVALID_SENSOR;
+        SensorHandle tExhaust = INVALID_SENSOR;
+        SensorHandle tSet = INVALID_SENSOR;
+        SensorHandle modulation = INVALID_SENSOR;
+        SensorHandle pressure = INVALID_SENSOR;
+        SensorHandle fault = INVALID_SENSOR;
+    } mqttSensors_;
+    // Recent frames; written by the main loop only
+    FrameTrace trace_;
+
+    // Frame-decoded to forward-start latency of the main loop
+    std::atomic<uint32_t> wakeLatencyLastUs_{0};
+    std::atomic<uint32_t> wakeLatencyMaxUs_{0};
+    std::atomic<uint64_t> wakeLatencySumUs_{0};
+    std::atomic<uint32_t> wakeLatencyCount_{0};
+    std::atomic<uint32_t> forwardLatencyLastUs_{0};
+    std::atomic<uint32_t> forwardLatencyMaxUs_{0};
+
+    // queueRequest() entries, taken by the main loop in bus gaps
+    QueueHandle_t gatewayQueue_ = nullptr;
+    int64_t gatewayRequestUs_ = 0;              // Expected time per request; main loop only
+    std::atomic<uint32_t> gatewayQueued_{0};
+    std::atomic<uint32_t> gatewayRejected_{0};
+    std::atomic<uint32_t> gatewayAnswered_{0};
+    std::atomic<uint32_t> gatewayFailed_{0};
+    std::atomic<uint32_t> gatewayPending_{0};
 };
 
 // BoilerManager implementation
@@ -648,6 +1113,14 @@ ManagerStatus BoilerManager::status() const {
     return impl_->status();
 }
 
+BusStats BoilerManager::thermostatBusStats() const {
+    return impl_->thermostatBusStats();
+}
+
+BusStats BoilerManager::boilerBusStats() const {
+    return impl_->boilerBusStats();
+}
+
 void BoilerManager::setMode(ManagerMode mode) {
     impl_->setMode(mode);
 }
@@ -658,14 +1131,22 @@ esp_err_t BoilerManager::writeData(uint8_t dataId, uint16_t dataValue,
     return impl_->writeData(dataId, dataValue, response, timeout);
 }
 
-void BoilerManager::setMessageCallback(MessageCallback callback) {
-    impl_->setMessageCallback(std::move(callback));
+esp_err_t BoilerManager::queueRequest(Frame request, uint32_t tag, GatewayDone done, void* context) {
+    return impl_->queueRequest(request, tag, done, context);
+}
+
+FrameEventBus& BoilerManager::events() {
+    return impl_->events();
 }
 
 void BoilerManager::setMqttBridge(MqttBridge* mqtt) {
     impl_->setMqttBridge(mqtt);
 }
 
+FrameTrace& BoilerManager::frameTrace() {
+    return impl_->frameTrace();
+}
+
 // Helper functions
 
 const char* toString(ManagerMode mode) {
@@ -673,6 +1154,7 @@ const char* toString(ManagerMode mode) {
         case ManagerMode::Proxy:       return "PROXY";
         case ManagerMode::Passthrough: return "PASSTHROUGH";
         case ManagerMode::Control:     return "CONTROL";
+        case ManagerMode::CutThrough:  return "CUT_THROUGH";
         default:                       return "UNKNOWN";
     }
 }
@@ -0,0 +1,64 @@
+/*
+ * Diagnostics snapshot (see diagnostics_snapshot.h)
+ */
+
+#include "diagnostics_snapshot.h"
+#include <cstdio>
+
+namespace ot {
+
+const DiagnosticField DIAGNOSTIC_FIELDS[] = {
+    {"t_boiler", &Diagnostics::tBoiler}, {"t_return", &Diagnostics::tReturn},
+    {"t_dhw", &Diagnostics::tDhw}, {"t_dhw2", &Diagnostics::tDhw2},
+    {"t_outside", &Diagnostics::tOutside}, {"t_exhaust", &Diagnostics::tExhaust},
+    {"t_heat_exchanger", &Diagnostics::tHeatExchanger}, {"t_flow_ch2", &Diagnostics::tFlowCh2},
+    {"t_storage", &Diagnostics::tStorage}, {"t_collector", &Diagnostics::tCollector},
+    {"t_setpoint", &Diagnostics::tSetpoint}, {"modulation_level", &Diagnostics::modulationLevel},
+    {"pressure", &Diagnostics::pressure}, {"flow_rate", &Diagnostics::flowRate},
+    {"fault_code", &Diagnostics::faultCode}, {"diag_code", &Diagnostics::diagCode},
+    {"burner_starts", &Diagnostics::burnerStarts}, {"dhw_burner_starts", &Diagnostics::dhwBurnerStarts},
+    {"ch_pump_starts", &Diagnostics::chPumpStarts}, {"dhw_pump_starts", &Diagnostics::dhwPumpStarts},
+    {"burner_hours", &Diagnostics::burnerHours}, {"dhw_burner_hours", &Diagnostics::dhwBurnerHours},
+    {"ch_pump_hours", &Diagnostics::chPumpHours}, {"dhw_pump_hours", &Diagnostics::dhwPumpHours},
+    {"max_capacity", &Diagnostics::maxCapacity}, {"min_mod_level", &Diagnostics::minModLevel},
+    {"fan_setpoint", &Diagnostics::fanSetpoint}, {"fan_current", &Diagnostics::fanCurrent},
+    {"fan_exhaust_rpm", &Diagnostics::fanExhaustRpm}, {"fan_supply_rpm", &Diagnostics::fanSupplyRpm},
+    {"co2_exhaust", &Diagnostics::co2Exhaust}, {"flame_on", &Diagnostics::flameOn},
+    {"ch_mode", &Diagnostics::chMode}, {"dhw_mode", &Diagnostics::dhwMode},
+};
+
+const size_t DIAGNOSTIC_FIELD_COUNT = sizeof(DIAGNOSTIC_FIELDS) / sizeof(DIAGNOSTIC_FIELDS[0]);
+
+size_t formatDiagnosticsSnapshot(const Diagnostics& diag, std::chrono::milliseconds now,
+                                 char* buf, size_t size)
+{
+    size_t len = 0;
+    // Appends, tracking the length; false once out of room
+    auto append = [buf, size, &len](int written) {
+        if (written < 0 || static_cast<size_t>(written) >= size - len) {
+            return false;
+        }
+        len += static_cast<size_t>(written);
+        return true;
+    };
+
+    if (size == 0 || !append(snprintf(buf, size, "{\"uptime_ms\":%lld", static_cast<long long>(now.count())))) {
+        return 0;
+    }
+    for (size_t i = 0; i < DIAGNOSTIC_FIELD_COUNT; i++) {
+        const DiagnosticValue& v = diag.*DIAGNOSTIC_FIELDS[i].value;
+        if (!v.isValid()) {
+            continue;
+        }
+        if (!append(snprintf(buf + len, size - len, ",\"%s\":[%.2f,%lld]", DIAGNOSTIC_FIELDS[i].name,
+                             v.valueOr(0.0f), static_cast<long long>(v.age(now).count())))) {
+            return 0;
+        }
+    }
+    if (!append(snprintf(buf + len, size - len, "}"))) {
+        return 0;
+    }
+    return len;
+}
+
+} // namespace ot
@@ -0,0 +1,208 @@
+/*
+ * Frame event bus (see frame_event_bus.h)
+ */
+
+#include "frame_event_bus.h"
+#include "esp_log.h"
+#include "ot_clock.h"
+
+static const char* TAG = "FrameEvents";
+
+namespace ot {
+
+struct FrameEventBus::Subscriber
+{
+    Subscriber(const FrameEventBus& bus, const char* name, Handler handler)
+        : name(name), handler(std::move(handler)), reader(bus)
+    {
+    }
+
+    const char* name;
+    Handler handler;
+    Reader reader;
+    TaskHandle_t task = nullptr;
+    std::atomic<bool> stop{false};
+    SemaphoreHandle_t stopped = nullptr;
+};
+
+static uint32_t roundUpPow2(size_t n)
+{
+    uint32_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+FrameEventBus::FrameEventBus(size_t capacity)
+    : slots_(new Slot[roundUpPow2(capacity ? capacity : 1)])
+    , mask_(roundUpPow2(capacity ? capacity : 1) - 1)
+    , registry_(xSemaphoreCreateMutex())
+{
+}
+
+FrameEventBus::~FrameEventBus()
+{
+    for (size_t i = 0; i < MAX_SUBSCRIBERS; i++) {
+        unsubscribe(static_cast<int>(i));
+    }
+    if (registry_) {
+        vSemaphoreDelete(registry_);
+    }
+}
+
+void FrameEventBus::publish(MessageSource source, MessageDirection direction, Frame frame)
+{
+    const uint32_t index = head_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[index & mask_];
+
+    // Seqlock write: readers that see the odd sequence, or a different one
+    // after copying, know the slot changed under them
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timestampUs.store(static_cast<uint32_t>(clockUs()), std::memory_order_relaxed);
+    slot.frame.store(frame.raw(), std::memory_order_relaxed);
+    slot.meta.store(static_cast<uint32_t>(source) | static_cast<uint32_t>(direction) << 8,
+                    std::memory_order_relaxed);
+    slot.seq.store(2 * index + 2, std::memory_order_release);
+    head_.store(index + 1, std::memory_order_release);
+
+    publishing_.fetch_add(1);
+    for (std::atomic<Subscriber*>& entry : subscribers_) {
+        Subscriber* sub = entry.load();
+        if (sub && sub->task) {
+            xTaskNotifyGive(sub->task);
+        }
+    }
+    publishing_.fetch_sub(1);
+}
+
+FrameEventBus::Reader::Reader(const FrameEventBus& bus)
+    : bus_(bus)
+    , cursor_(bus.head_.load(std::memory_order_acquire))
+{
+}
+
+bool FrameEventBus::Reader::next(FrameEvent& out)
+{
+    const uint32_t capacity = bus_.mask_ + 1;
+    while (true) {
+        const uint32_t head = bus_.head_.load(std::memory_order_acquire);
+        if (cursor_ == head) {
+            return false;
+        }
+        if (head - cursor_ > capacity) {
+            dropped_.fetch_add(head - cursor_ - capacity, std::memory_order_relaxed);
+            cursor_ = head - capacity;
+        }
+
+        const Slot& slot = bus_.slots_[cursor_ & bus_.mask_];
+        const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+        const uint32_t timestampUs = slot.timestampUs.load(std::memory_order_relaxed);
+        const uint32_t frame = slot.frame.load(std::memory_order_relaxed);
+        const uint32_t meta = slot.meta.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const bool intact = seq == 2 * cursor_ + 2 && slot.seq.load(std::memory_order_relaxed) == seq;
+        cursor_++;
+        if (!intact) {
+            // Lapped by the publisher while reading
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        out.timestampUs = timestampUs;
+        out.frame = Frame(frame);
+        out.source = static_cast<MessageSource>(meta & 0xFF);
+        out.direction = static_cast<MessageDirection>((meta >> 8) & 0xFF);
+        delivered_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+}
+
+void FrameEventBus::subscriberTask(void* arg)
+{
+    auto* sub = static_cast<Subscriber*>(arg);
+    FrameEvent event;
+    while (!sub->stop.load()) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (!sub->stop.load() && sub->reader.next(event)) {
+            sub->handler(event);
+        }
+    }
+    xSemaphoreGive(sub->stopped);
+    vTaskDelete(nullptr);
+}
+
+int FrameEventBus::subscribe(const char* name, Handler handler, UBaseType_t priority, uint32_t stackSize)
+{
+    if (!registry_ || !handler) {
+        return -1;
+    }
+    xSemaphoreTake(registry_, portMAX_DELAY);
+    int id = -1;
+    for (size_t i = 0; i < MAX_SUBSCRIBERS; i++) {
+        if (!subscribers_[i].load()) {
+            id = static_cast<int>(i);
+            break;
+        }
+    }
+    if (id < 0) {
+        xSemaphoreGive(registry_);
+        ESP_LOGE(TAG, "No subscriber slot left for %s", name);
+        return -1;
+    }
+
+    auto* sub = new Subscriber(*this, name, std::move(handler));
+    sub->stopped = xSemaphoreCreateBinary();
+    if (!sub->stopped ||
+        xTaskCreate(&FrameEventBus::subscriberTask, name, stackSize, sub, priority, &sub->task) != pdPASS) {
+        if (sub->stopped) vSemaphoreDelete(sub->stopped);
+        delete sub;
+        xSemaphoreGive(registry_);
+        ESP_LOGE(TAG, "Failed to start subscriber %s", name);
+        return -1;
+    }
+    subscribers_[id].store(sub);
+    xSemaphoreGive(registry_);
+    ESP_LOGI(TAG, "Subscriber %s attached", name);
+    return id;
+}
+
+void FrameEventBus::unsubscribe(int id)
+{
+    if (id < 0 || id >= static_cast<int>(MAX_SUBSCRIBERS) || !registry_) {
+        return;
+    }
+    xSemaphoreTake(registry_, portMAX_DELAY);
+    Subscriber* sub = subscribers_[id].exchange(nullptr);
+    if (sub) {
+        // A publish() that loaded the entry before it was cleared may still
+        // notify the task; let it finish first
+        while (publishing_.load() != 0) {
+            vTaskDelay(1);
+        }
+        sub->stop.store(true);
+        xTaskNotifyGive(sub->task);
+        xSemaphoreTake(sub->stopped, portMAX_DELAY);
+        vSemaphoreDelete(sub->stopped);
+        delete sub;
+    }
+    xSemaphoreGive(registry_);
+}
+
+size_t FrameEventBus::subscriberStats(SubscriberStats* out, size_t max) const
+{
+    // Under the registry lock: unsubscribe() frees the entries
+    xSemaphoreTake(registry_, portMAX_DELAY);
+    size_t n = 0;
+    for (const std::atomic<Subscriber*>& entry : subscribers_) {
+        const Subscriber* sub = entry.load();
+        if (sub && n < max) {
+            out[n++] = SubscriberStats{sub->name, sub->reader.delivered(), sub->reader.dropped()};
+        }
+    }
+    xSemaphoreGive(registry_);
+    return n;
+}
+
+} // namespace ot
@@ -0,0 +1,149 @@
+/*
+ * Frame trace recorder (see frame_trace.h)
+ */
+
+#include "frame_trace.h"
+#include "ot_clock.h"
+#include <sys/time.h>
+#include <algorithm>
+#include <new>
+
+namespace ot {
+
+// Records copied per write() call during an export
+static constexpr size_t EXPORT_CHUNK = 32;
+
+// Unix time before this means the clock was never set
+static constexpr int64_t WALL_CLOCK_VALID_US = 1600000000LL * 1000000;
+
+FrameTrace::FrameTrace(size_t capacity)
+    : ring_(capacity ? new (std::nothrow) TraceRecord[capacity] : nullptr)
+    , capacity_(ring_ ? capacity : 0)
+    , margin_(capacity_ / 8)
+{
+}
+
+FrameTrace::~FrameTrace() = default;
+
+void FrameTrace::record(TraceEvent event, uint8_t source, uint32_t frame, uint8_t status)
+{
+    if (capacity_ == 0) {
+        return;
+    }
+    const int64_t now = clockUs();
+    uint64_t delta = lastUs_ ? static_cast<uint64_t>(now - lastUs_) : 0;
+    if (delta > UINT32_MAX) {
+        append(TraceRecord{static_cast<uint32_t>(delta), static_cast<uint32_t>(delta >> 32),
+                           TraceEvent::Gap, 0, 0, 0}, now);
+        delta = 0;
+    }
+    append(TraceRecord{static_cast<uint32_t>(delta), frame, event, source, status, 0}, now);
+}
+
+void FrameTrace::append(const TraceRecord& r, int64_t nowUs)
+{
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    ring_[head % capacity_] = r;
+    taskENTER_CRITICAL(&lock_);
+    lastUs_ = nowUs;
+    head_.store(head + 1, std::memory_order_release);
+    taskEXIT_CRITICAL(&lock_);
+}
+
+void FrameTrace::clear(uint32_t upTo)
+{
+    // Never past the head, and never back: a slower export clearing after a
+    // newer one must not bring its records back
+    const uint32_t head = head_.load(std::memory_order_acquire);
+    if (static_cast<int32_t>(head - upTo) < 0) {
+        upTo = head;
+    }
+    uint32_t cleared = clearedAt_.load(std::memory_order_relaxed);
+    while (static_cast<int32_t>(upTo - cleared) > 0 &&
+           !clearedAt_.compare_exchange_weak(cleared, upTo, std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+    }
+}
+
+int FrameTrace::exportTo(const Writer& write, uint32_t* exportedTo) const
+{
+    taskENTER_CRITICAL(&lock_);
+    const uint32_t head = head_.load(std::memory_order_acquire);
+    const int64_t lastUs = lastUs_;
+    taskEXIT_CRITICAL(&lock_);
+
+    // Leave the writer room to wrap while this runs
+    const uint32_t cleared = clearedAt_.load(std::memory_order_acquire);
+    const uint32_t wrapped = head > capacity_ ? head - static_cast<uint32_t>(capacity_ - margin_) : 0;
+    const uint32_t first = std::min(head, std::max(cleared, wrapped));
+    auto stillValid = [this](uint32_t index) {
+        // The writer fills slot index + capacity before publishing it
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return head_.load(std::memory_order_acquire) - index < capacity_;
+    };
+
+    // Time of the first record: walk the deltas back from the last one
+    int64_t firstUs = lastUs;
+    for (uint32_t i = first + 1; i < head; i++) {
+        const TraceRecord& r = ring_[i % capacity_];
+        firstUs -= r.deltaUs;
+        if (r.event == TraceEvent::Gap) {
+            firstUs -= static_cast<int64_t>(r.frame) << 32;
+        }
+    }
+    if (head != first && !stillValid(first)) {
+        return -1;
+    }
+
+    TraceFileHeader header = {};
+    header.magic = TraceFileHeader::MAGIC;
+    header.version = TraceFileHeader::VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    header.recordCount = head - first;
+    header.overwritten = first - std::min(first, cleared);
+    header.firstUs = firstUs;
+    struct timeval tv;
+    if (gettimeofday(&tv, nullptr) == 0) {
+        int64_t wallUs = static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+        if (wallUs >= WALL_CLOCK_VALID_US) {
+            header.wallOffsetUs = wallUs - clockUs();
+        }
+    }
+    if (!write(&header, sizeof(header))) {
+        return -1;
+    }
+
+    TraceRecord chunk[EXPORT_CHUNK];
+    for (uint32_t i = first; i < head; ) {
+        size_t n = std::min<size_t>(EXPORT_CHUNK, head - i);
+        for (size_t k = 0; k < n; k++) {
+            chunk[k] = ring_[(i + k) % capacity_];
+        }
+        // Overwritten while copying: the export fell a margin behind
+        if (!stillValid(i)) {
+            return -1;
+        }
+        if (!write(chunk, n * sizeof(TraceRecord))) {
+            return -1;
+        }
+        i += n;
+    }
+    if (exportedTo) {
+        *exportedTo = head;
+    }
+    return static_cast<int>(head - first);
+}
+
+const char* toString(TraceEvent event)
+{
+    switch (event) {
+        case TraceEvent::Request:          return "REQUEST";
+        case TraceEvent::DiscardedRequest: return "DISCARDED_REQUEST";
+        case TraceEvent::Response:         return "RESPONSE";
+        case TraceEvent::BoilerTimeout:    return "BOILER_TIMEOUT";
+        case TraceEvent::Gap:              return "GAP";
+        default:                           return "UNKNOWN";
+    }
+}
+
+} // namespace ot
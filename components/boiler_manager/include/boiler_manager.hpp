@@ -14,24 +14,32 @@
 #include <memory>
 #include <string_view>
 #include "open_therm.h"
+#include "frame_trace.h"
+#include "frame_event_bus.h"
 #include "esp_err.h"
-#include "esp_timer.h"
+#include "ot_clock.h"
 #include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
 
 namespace ot {
 
+#ifdef CONFIG_OT_FRAME_TRACE_RECORDS
+static constexpr size_t FRAME_TRACE_RECORDS = CONFIG_OT_FRAME_TRACE_RECORDS;
+#else
+static constexpr size_t FRAME_TRACE_RECORDS = 1024;
+#endif
+#ifdef CONFIG_OT_GATEWAY_REQUEST_QUEUE
+static constexpr size_t GATEWAY_REQUEST_QUEUE = CONFIG_OT_GATEWAY_REQUEST_QUEUE;
+#else
+static constexpr size_t GATEWAY_REQUEST_QUEUE = 16;
+#endif
+
 // Operation modes
 enum class ManagerMode {
     Proxy,       // Intercept ID=0, inject diagnostics
     Passthrough, // Pass everything through unchanged
-    Control      // Apply MQTT overrides, stub thermostat replies
-};
-
-// Message source categories for logging
-enum class MessageSource {
-    ThermostatBoiler,   // Proxied: Thermostat <-> Boiler
-    GatewayBoiler,      // Gateway <-> Boiler (diagnostics)
-    ThermostatGateway   // Thermostat <-> Gateway (control mode)
+    Control,     // Apply MQTT overrides, stub thermostat replies
+    CutThrough   // Repeat half-bits as they arrive, decode in parallel (observe only)
 };
 
 // Diagnostic value with timestamp
@@ -43,7 +51,12 @@ struct DiagnosticValue {
 
     void update(float v) {
         value = v;
-        timestamp = std::chrono::milliseconds(esp_timer_get_time() / 1000);
+        timestamp = clockMs();
+    }
+
+    // Time since the last update, or -1 ms if there is no valid value
+    [[nodiscard]] std::chrono::milliseconds age(std::chrono::milliseconds now) const {
+        return isValid() && timestamp.count() > 0 ? now - timestamp : std::chrono::milliseconds(-1);
     }
 
     void invalidate() {
@@ -103,12 +116,42 @@ struct ManagerStatus {
     float demandTsetC = 0.0f;
     bool demandChEnabled = false;
     std::chrono::milliseconds lastDemandTime{0};
+
+    // Main loop wake-to-forward latency (frame decoded -> forwarding starts)
+    uint32_t wakeLatencyLastUs = 0;
+    uint32_t wakeLatencyMaxUs = 0;
+    uint32_t wakeLatencyAvgUs = 0;
+
+    // Passthrough forward latency (frame decoded -> response sent to thermostat)
+    uint32_t forwardLatencyLastUs = 0;
+    uint32_t forwardLatencyMaxUs = 0;
+
+    // Gateway requests (BoilerManager::queueRequest)
+    uint32_t gatewayQueued = 0;     // Accepted
+    uint32_t gatewayRejected = 0;   // Queue full
+    uint32_t gatewayAnswered = 0;   // The boiler responded (ACK or not)
+    uint32_t gatewayFailed = 0;     // No usable response, or not sent
+    uint32_t gatewayPending = 0;    // Still waiting for a bus gap
 };
 
-// Message callback type
-using MessageCallback = std::function<void(std::string_view direction,
-                                           MessageSource source,
-                                           Frame message)>;
+/**
+ * Outcome of a request queued with BoilerManager::queueRequest()
+ */
+struct GatewayResult {
+    Frame request;
+    uint32_t tag = 0;           // As passed to queueRequest()
+    // ESP_OK: response holds the boiler's answer, which may be a NACK
+    // (DATA_INVALID, UNKNOWN_ID). ESP_ERR_TIMEOUT: no answer.
+    // ESP_ERR_INVALID_RESPONSE: an answer that did not decode.
+    // ESP_ERR_INVALID_STATE: not sent (cut-through mode, boiler busy,
+    // manager stopping).
+    esp_err_t err = ESP_OK;
+    Frame response;
+    uint32_t waitedUs = 0;      // In the queue, before the request went out
+};
+
+// Called on the manager task with the result; must not block
+using GatewayDone = void (*)(void* context, const GatewayResult& result);
 
 /**
  * Configuration for boiler manager
@@ -118,6 +161,7 @@ struct ManagerConfig {
     uint32_t interceptRate = 10;  // Intercept every Nth ID=0 frame
     uint32_t taskStackSize = 4096;
     UBaseType_t taskPriority = 5;
+    size_t traceRecords = FRAME_TRACE_RECORDS;  // Frame trace depth, 0 disables it
 
     // OpenTherm pin configuration
     gpio_num_t thermostatInPin = GPIO_NUM_16;
@@ -137,7 +181,7 @@ struct ManagerConfig {
  *
  * Coordinates communication between thermostat and boiler:
  * - Runs in its own FreeRTOS task
- * - Polls queues for requests/responses
+ * - Sleeps until the thermostat side decodes a frame
  * - Injects diagnostic queries
  * - Handles MQTT control overrides
  */
@@ -163,13 +207,34 @@ public:
     [[nodiscard]] ManagerStatus status() const;
     void setMode(ManagerMode mode);
 
-    // Manual write to boiler (thread-safe, blocks up to timeout)
+    // Per-channel bus counters (all zero before start())
+    [[nodiscard]] BusStats thermostatBusStats() const;
+    [[nodiscard]] BusStats boilerBusStats() const;
+
+    // Manual write to boiler: queued as queueRequest() does and sent by the
+    // main loop in a bus gap. Thread-safe; sleeps up to timeout for the
+    // result (ESP_ERR_TIMEOUT), after which the write may still go out.
     [[nodiscard]] esp_err_t writeData(uint8_t dataId, uint16_t dataValue,
                                       std::optional<Frame>& response,
                                       std::chrono::milliseconds timeout = std::chrono::seconds(2));
 
-    // Message callback for logging
-    void setMessageCallback(MessageCallback callback);
+    /**
+     * Queue a request from the gateway itself for the boiler. The main loop
+     * sends one in the gap after each forwarded thermostat exchange, or
+     * back to back while the thermostat is silent, in order; in cut-through
+     * mode the gateway cannot transmit and they fail. Never blocks, so any
+     * number may be pipelined up to GATEWAY_REQUEST_QUEUE. done gets the
+     * result on the manager task. Returns ESP_ERR_NO_MEM when the queue is
+     * full, ESP_ERR_INVALID_STATE when the manager is not running.
+     */
+    [[nodiscard]] esp_err_t queueRequest(Frame request, uint32_t tag, GatewayDone done, void* context);
+
+    // Every frame the manager handles, for any number of consumers
+    // (subscribe before start() to see the first frames)
+    [[nodiscard]] FrameEventBus& events();
+
+    // Recent frames for download and replay (export/clear from any task)
+    [[nodiscard]] FrameTrace& frameTrace();
 
     // Set MQTT bridge for diagnostics publishing
     void setMqttBridge(class MqttBridge* mqtt);
@@ -0,0 +1,41 @@
+/*
+ * Diagnostics snapshot
+ *
+ * All valid Diagnostics fields as one compact JSON object, for the MQTT
+ * <base>/state message:
+ *
+ *   {"uptime_ms":123456,"t_boiler":[45.20,830],"flame_on":[1.00,830],...}
+ *
+ * Each field is [value, age in ms]; fields without a value are left out.
+ * Written into the caller's buffer, never allocating.
+ */
+
+#ifndef DIAGNOSTICS_SNAPSHOT_H
+#define DIAGNOSTICS_SNAPSHOT_H
+
+#include <stddef.h>
+#include <chrono>
+#include "boiler_manager.hpp"
+
+namespace ot {
+
+struct DiagnosticField {
+    const char* name;
+    DiagnosticValue Diagnostics::*value;
+};
+
+// Every Diagnostics field with its JSON name, in /api/diagnostics order
+extern const DiagnosticField DIAGNOSTIC_FIELDS[];
+extern const size_t DIAGNOSTIC_FIELD_COUNT;
+
+/**
+ * Serialise the valid fields of diag as of now. Returns the length written
+ * (without the terminating NUL), or 0 when the snapshot does not fit in
+ * size; a truncated object is never returned.
+ */
+size_t formatDiagnosticsSnapshot(const Diagnostics& diag, std::chrono::milliseconds now,
+                                 char* buf, size_t size);
+
+} // namespace ot
+
+#endif // DIAGNOSTICS_SNAPSHOT_H
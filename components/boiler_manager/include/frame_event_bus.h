@@ -0,0 +1,133 @@
+/*
+ * Frame event bus
+ *
+ * The manager loop publishes every frame it handles once into a lock-free
+ * broadcast ring. Each subscriber reads the ring through its own cursor at
+ * its own pace: a consumer that falls a ring behind loses the oldest events
+ * (counted per subscriber) instead of holding up the publisher, so the
+ * WebSocket feed, MQTT or a logger can never add latency to the
+ * thermostat <-> boiler path.
+ */
+
+#ifndef FRAME_EVENT_BUS_H
+#define FRAME_EVENT_BUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "open_therm_protocol.h"
+#include "bus_log.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+namespace ot {
+
+#ifdef CONFIG_OT_FRAME_EVENT_DEPTH
+static constexpr size_t FRAME_EVENT_DEPTH = CONFIG_OT_FRAME_EVENT_DEPTH;
+#else
+static constexpr size_t FRAME_EVENT_DEPTH = 64;
+#endif
+
+// Message source types
+enum class MessageSource {
+    ThermostatBoiler,   // Proxied: Thermostat <-> Boiler
+    GatewayBoiler,      // Gateway <-> Boiler (diagnostics)
+    ThermostatGateway   // Thermostat <-> Gateway (control mode)
+};
+
+struct FrameEvent
+{
+    uint32_t timestampUs;       // clockUs() at publish, truncated
+    Frame frame;
+    MessageSource source;
+    MessageDirection direction;
+};
+
+class FrameEventBus
+{
+public:
+    typedef std::function<void(const FrameEvent& event)> Handler;
+    static constexpr size_t MAX_SUBSCRIBERS = 6;
+
+    /**
+     * Pull-side cursor for a consumer that runs its own loop. Starts at the
+     * next event published; one Reader per consuming task.
+     */
+    class Reader
+    {
+    public:
+        explicit Reader(const FrameEventBus& bus);
+
+        // Next event, oldest first; false when caught up
+        bool next(FrameEvent& out);
+
+        uint32_t delivered() const { return delivered_.load(std::memory_order_relaxed); }
+        uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+        const FrameEventBus& bus_;
+        uint32_t cursor_;
+        std::atomic<uint32_t> delivered_{0};
+        std::atomic<uint32_t> dropped_{0};     // Overwritten before they were read
+    };
+
+    struct SubscriberStats
+    {
+        const char* name;
+        uint32_t delivered;
+        uint32_t dropped;
+    };
+
+    // capacity events, rounded up to a power of two
+    explicit FrameEventBus(size_t capacity = FRAME_EVENT_DEPTH);
+    ~FrameEventBus();
+
+    FrameEventBus(const FrameEventBus&) = delete;
+    FrameEventBus& operator=(const FrameEventBus&) = delete;
+
+    // Single producer (the manager loop). Never blocks; wakes the
+    // subscriber tasks without yielding to them.
+    void publish(MessageSource source, MessageDirection direction, Frame frame);
+
+    /**
+     * Run handler for every event on a task of its own, below the bus
+     * tasks' priority. Returns an id for unsubscribe(), or -1 when all
+     * MAX_SUBSCRIBERS slots are taken or the task cannot be created.
+     */
+    int subscribe(const char* name, Handler handler, UBaseType_t priority = 2, uint32_t stackSize = 3072);
+    // Stop the subscriber's task and wait for its current handler to return
+    void unsubscribe(int id);
+
+    // Per-subscriber counters; returns the number filled in
+    size_t subscriberStats(SubscriberStats* out, size_t max) const;
+    uint32_t published() const { return head_.load(std::memory_order_relaxed); }
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> seq{0};       // 2 * index + 1 while written, 2 * index + 2 once complete
+        std::atomic<uint32_t> timestampUs{0};
+        std::atomic<uint32_t> frame{0};
+        std::atomic<uint32_t> meta{0};      // source | direction << 8
+    };
+    struct Subscriber;
+
+    static void subscriberTask(void* arg);
+
+    std::unique_ptr<Slot[]> slots_;
+    uint32_t mask_;
+    std::atomic<uint32_t> head_{0};         // Events ever published
+    std::atomic<Subscriber*> subscribers_[MAX_SUBSCRIBERS] = {};
+    std::atomic<int> publishing_{0};        // publish() calls touching subscribers_
+    SemaphoreHandle_t registry_;            // subscribe/unsubscribe
+};
+
+} // namespace ot
+
+#endif // FRAME_EVENT_BUS_H
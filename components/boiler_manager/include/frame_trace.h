@@ -0,0 +1,111 @@
+/*
+ * Frame trace recorder
+ *
+ * Keeps the most recent frames the manager handled in a RAM ring of
+ * 12-byte records, for download as a capture file (/api/trace) and replay
+ * on the host (components/boiler_manager/test/trace_replay).
+ */
+
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "freertos/FreeRTOS.h"
+
+namespace ot {
+
+enum class TraceEvent : uint8_t
+{
+    Request,            // Thermostat request decoded and forwarded
+    DiscardedRequest,   // Thermostat frame decoded but not a valid request
+    Response,           // Boiler response (sent back to the thermostat when proxied)
+    BoilerTimeout,      // frame: the request the boiler did not answer
+    Gap,                // Time skip: (frame << 32 | deltaUs) us before the next record
+};
+
+/**
+ * One record, little-endian. deltaUs is the time since the previous record;
+ * gaps that do not fit are carried by a Gap record in front.
+ */
+struct TraceRecord
+{
+    uint32_t deltaUs;
+    uint32_t frame;
+    TraceEvent event;
+    uint8_t source;     // MessageSource
+    uint8_t status;     // OpenThermResponseStatus of the frame as the gateway saw it
+    uint8_t reserved;
+};
+static_assert(sizeof(TraceRecord) == 12, "trace records are 12 bytes");
+
+/**
+ * Capture file: this header, then recordCount records, oldest first.
+ * Times are clockUs() of the recording device; wallUs converts them to
+ * Unix time when the device clock was set.
+ */
+struct TraceFileHeader
+{
+    static constexpr uint32_t MAGIC = 0x4354544F;   // "OTTC"
+    static constexpr uint16_t VERSION = 1;
+
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t recordCount;
+    uint32_t overwritten;   // Records lost to the ring wrapping since the last clear
+    int64_t firstUs;        // Time of the first record (its deltaUs is meaningless)
+    int64_t wallOffsetUs;   // Unix time minus clockUs(), 0 if unknown
+};
+static_assert(sizeof(TraceFileHeader) == 32, "trace header is 32 bytes");
+
+class FrameTrace
+{
+public:
+    // Returns false to abort an export (e.g. the HTTP client went away)
+    typedef std::function<bool(const void* data, size_t len)> Writer;
+
+    // capacity records; 0 records nothing
+    explicit FrameTrace(size_t capacity);
+    ~FrameTrace();
+
+    FrameTrace(const FrameTrace&) = delete;
+    FrameTrace& operator=(const FrameTrace&) = delete;
+
+    // Append a record at clockUs(). Single writer: the manager loop.
+    void record(TraceEvent event, uint8_t source, uint32_t frame, uint8_t status);
+
+    // Stream the capture through write in chunks, from any task, while
+    // recording continues. The oldest eighth of a full ring is left out so
+    // the writer can keep wrapping during the export. Returns the records
+    // exported, or -1 if write failed or the export fell that far behind;
+    // exportedTo, if given, is set to the index just past the last one.
+    int exportTo(const Writer& write, uint32_t* exportedTo = nullptr) const;
+
+    // Forget the records before index upTo, e.g. those an export just sent,
+    // and keep anything recorded since (from any task)
+    void clear(uint32_t upTo);
+
+    size_t capacity() const { return capacity_; }
+    uint32_t recorded() const { return head_.load(std::memory_order_acquire); }
+
+private:
+    void append(const TraceRecord& r, int64_t nowUs);
+
+    std::unique_ptr<TraceRecord[]> ring_;
+    size_t capacity_;
+    size_t margin_;
+    mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;   // head_ and lastUs_ together
+    std::atomic<uint32_t> head_{0};         // Records ever written; slot = index % capacity
+    std::atomic<uint32_t> clearedAt_{0};    // First index still exported
+    int64_t lastUs_ = 0;                    // Time of record head_ - 1
+};
+
+const char* toString(TraceEvent event);
+
+} // namespace ot
+
+#endif // FRAME_TRACE_H
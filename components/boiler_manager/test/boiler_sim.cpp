@@ -0,0 +1,294 @@
+// Boiler manager simulator
+//
+// Runs the unmodified BoilerManager (and the OpenTherm RMT driver under it)
+// on the host port, between a virtual thermostat polling once a second and
+// a virtual boiler heating a house. Reports per-transaction latency as the
+// thermostat sees it, lost and timed-out frames, and the CPU time of the
+// gateway's tasks.
+//
+//   boiler_sim [--duration=S] [--speed=X] [--boiler-latency=MIN[-MAX]] [--poll=MS]
+//              [--drop=PCT] [--glitch=PCT] [--seed=N] [--min-success=PCT]
+//              [--gateway=N] [--trace-out=FILE] [-v]
+//
+// --speed runs simulated time faster than real time; CPU figures are real.
+// --gateway queues N reads of its own per poll period through
+// queueRequest(), as the MQTT <base>/ot/<id>/read topics do, and one
+// writeData() half way through, as /api/write does.
+// --trace-out saves the manager's frame trace, as /api/trace serves it, for
+// trace_replay.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "boiler_manager.hpp"
+#include "host_port.h"
+#include "sim_devices.h"
+
+using ot::BoilerManager;
+using ot::BusStats;
+using ot::ManagerConfig;
+
+static const char* TAG = "boiler_sim";
+
+// Results of the --gateway requests, from the manager task
+struct GatewayTally {
+    std::mutex lock;
+    uint32_t answered = 0;
+    uint32_t failed = 0;
+    uint32_t outOfOrder = 0;
+    uint32_t nextTag = 0;
+    std::vector<uint32_t> waitedUs;
+
+    static void done(void* context, const ot::GatewayResult& result)
+    {
+        auto* self = static_cast<GatewayTally*>(context);
+        std::lock_guard<std::mutex> guard(self->lock);
+        if (result.err == ESP_OK && result.response.dataId() == result.request.dataId()) {
+            self->answered++;
+        } else {
+            self->failed++;
+        }
+        if (result.tag != self->nextTag) {
+            self->outOfOrder++;
+        }
+        self->nextTag = result.tag + 1;
+        self->waitedUs.push_back(result.waitedUs);
+    }
+};
+
+static void printPercentiles(const char* name, std::vector<uint32_t> us)
+{
+    if (us.empty()) {
+        printf("  %-12s (none)\n", name);
+        return;
+    }
+    std::sort(us.begin(), us.end());
+    auto pct = [&us](double p) { return us[std::min(us.size() - 1, static_cast<size_t>(p * us.size()))] / 1000.0; };
+    printf("  %-12s p50 %7.1f  p90 %7.1f  p99 %7.1f  max %7.1f ms  (n=%zu)\n",
+           name, pct(0.50), pct(0.90), pct(0.99), us.back() / 1000.0, us.size());
+}
+
+static void printBusStats(const char* side, const BusStats& s)
+{
+    printf("  %-10s tx=%u rx=%u invalid=%u errors=%u txFailed=%u timeouts=%u decode avg/max=%u/%u us\n",
+           side, s.txFrames, s.rxFrames, s.rxInvalid, s.rxErrorTotal(), s.txFailed, s.timeouts,
+           s.decodeAvgUs, s.decodeMaxUs);
+}
+
+int main(int argc, char** argv)
+{
+    long durationS = 300;
+    double speed = 1.0;
+    long latencyMinMs = 20;
+    long latencyMaxMs = 100;
+    long pollMs = 1000;
+    long dropPct = 0;
+    long glitchPct = 0;
+    long seed = 1;
+    double minSuccessPct = 0.0;
+    long gatewayPerPoll = 0;
+    const char* traceOut = nullptr;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--duration=", 11) == 0) {
+            durationS = strtol(argv[i] + 11, nullptr, 10);
+        } else if (strncmp(argv[i], "--speed=", 8) == 0) {
+            speed = strtod(argv[i] + 8, nullptr);
+        } else if (strncmp(argv[i], "--boiler-latency=", 17) == 0) {
+            char* end;
+            latencyMinMs = strtol(argv[i] + 17, &end, 10);
+            latencyMaxMs = *end == '-' ? strtol(end + 1, nullptr, 10) : latencyMinMs;
+        } else if (strncmp(argv[i], "--poll=", 7) == 0) {
+            pollMs = strtol(argv[i] + 7, nullptr, 10);
+        } else if (strncmp(argv[i], "--drop=", 7) == 0) {
+            dropPct = strtol(argv[i] + 7, nullptr, 10);
+        } else if (strncmp(argv[i], "--glitch=", 9) == 0) {
+            glitchPct = strtol(argv[i] + 9, nullptr, 10);
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            seed = strtol(argv[i] + 7, nullptr, 10);
+        } else if (strncmp(argv[i], "--min-success=", 14) == 0) {
+            minSuccessPct = strtod(argv[i] + 14, nullptr);
+        } else if (strncmp(argv[i], "--gateway=", 10) == 0) {
+            gatewayPerPoll = strtol(argv[i] + 10, nullptr, 10);
+        } else if (strncmp(argv[i], "--trace-out=", 12) == 0) {
+            traceOut = argv[i] + 12;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--duration=S] [--speed=X] [--boiler-latency=MIN[-MAX]] [--poll=MS]\n"
+                    "          [--drop=PCT] [--glitch=PCT] [--seed=N] [--min-success=PCT]\n"
+                    "          [--gateway=N] [--trace-out=FILE] [-v]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (durationS <= 0 || speed <= 0 || pollMs <= 0 || latencyMaxMs < latencyMinMs || gatewayPerPoll < 0) {
+        fprintf(stderr, "invalid arguments\n");
+        return 2;
+    }
+
+    esp_log_level_set("*", verbose ? ESP_LOG_INFO : ESP_LOG_WARN);
+    host::setSpeed(speed);
+
+    ManagerConfig config;
+    BoilerManager manager(config);
+    if (manager.start() != ESP_OK) {
+        ESP_LOGE(TAG, "BoilerManager failed to start");
+        return 1;
+    }
+
+    WireFaults faults;
+    faults.dropPct = static_cast<uint32_t>(dropPct);
+    faults.glitchPct = static_cast<uint32_t>(glitchPct);
+
+    Plant plant;
+    VirtualBoiler::Config boilerConfig;
+    boilerConfig.latencyMinUs = static_cast<uint32_t>(latencyMinMs * 1000);
+    boilerConfig.latencyMaxUs = static_cast<uint32_t>(latencyMaxMs * 1000);
+    boilerConfig.faults = faults;
+    boilerConfig.seed = static_cast<uint32_t>(seed);
+    VirtualBoiler boiler(config.boilerOutPin, config.boilerInPin, plant, boilerConfig);
+
+    VirtualThermostat::Config thermostatConfig;
+    thermostatConfig.periodUs = static_cast<uint32_t>(pollMs * 1000);
+    thermostatConfig.faults = faults;
+    thermostatConfig.seed = static_cast<uint32_t>(seed) * 2654435761u;
+    VirtualThermostat thermostat(config.thermostatInPin, config.thermostatOutPin, plant, boiler,
+                                 thermostatConfig);
+
+    // Give the manager's tasks a moment to arm their receivers
+    int64_t startUs = host::nowUs() + 100000;
+    int64_t endUs = startUs + durationS * 1000000LL;
+    plant.start();
+    boiler.start();
+    host::at(startUs, [&thermostat, endUs] { thermostat.start(endUs); });
+
+    // Let the last transaction finish, then sample before stopping
+    GatewayTally gateway;
+    uint32_t gatewayTag = 0;
+    int64_t nextGatewayUs = startUs;
+    bool written = false;
+    esp_err_t writeErr = ESP_OK;
+    auto wallStart = std::chrono::steady_clock::now();
+    while (host::nowUs() < endUs + 2 * thermostatConfig.periodUs) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (gatewayPerPoll > 0 && host::nowUs() >= nextGatewayUs && host::nowUs() < endUs) {
+            nextGatewayUs += thermostatConfig.periodUs;
+            for (long i = 0; i < gatewayPerPoll; i++) {
+                ot::Frame request = ot::Frame::buildRequest(ot::MessageType::ReadData, 25, 0);
+                if (manager.queueRequest(request, gatewayTag, &GatewayTally::done, &gateway) == ESP_OK) {
+                    gatewayTag++;
+                }
+            }
+        }
+        if (gatewayPerPoll > 0 && !written && host::nowUs() >= startUs + durationS * 500000LL) {
+            written = true;
+            std::optional<ot::Frame> response;
+            writeErr = manager.writeData(1, 45 << 8, response);
+            if (writeErr == ESP_OK && (!response || response->dataId() != 1)) {
+                writeErr = ESP_ERR_INVALID_RESPONSE;
+            }
+        }
+    }
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double simS = (host::nowUs() - startUs) / 1e6;
+
+    VirtualThermostat::Stats stats = thermostat.stats();
+    std::vector<host::TaskCpu> cpu = host::taskCpu();
+    ot::ManagerStatus status = manager.status();
+    BusStats thermostatBus = manager.thermostatBusStats();
+    BusStats boilerBus = manager.boilerBusStats();
+    Plant::State plantState = plant.state();
+    int traceRecords = -1;
+    if (traceOut) {
+        FILE* f = fopen(traceOut, "wb");
+        if (f) {
+            traceRecords = manager.frameTrace().exportTo([f](const void* data, size_t len) {
+                return fwrite(data, 1, len, f) == len;
+            });
+            if (fclose(f) != 0) {
+                traceRecords = -1;
+            }
+        }
+    }
+    manager.stop();
+
+    double successPct = stats.sent ? 100.0 * stats.answered / stats.sent : 0.0;
+    printf("Simulated %.0f s in %.1f s (x%.1f), poll %ld ms, boiler latency %ld-%ld ms, drop %ld%%, glitch %ld%%\n",
+           simS, wallS, speed, pollMs, latencyMinMs, latencyMaxMs, dropPct, glitchPct);
+
+    printf("\nTransactions (thermostat side)\n");
+    printf("  sent %u  answered %u (%.1f%%, %u unknown ID)  invalid %u  timeouts %u  dropped %u\n",
+           stats.sent, stats.answered, successPct, stats.unknownId, stats.invalid, stats.timeouts, stats.dropped);
+    printf("  boiler ignored %u requests, %llu captures missed (receiver not armed)\n",
+           boiler.requestsIgnored(), static_cast<unsigned long long>(host::missedCaptures()));
+    printPercentiles("round trip", stats.roundTripUs);
+    printPercentiles("in gateway", stats.gatewayUs);
+
+    printf("\nGateway (simulated clock: host decode times are scaled by --speed)\n");
+    printf("  wake latency avg/max %u/%u us, forward latency last/max %u/%u us\n",
+           status.wakeLatencyAvgUs, status.wakeLatencyMaxUs, status.forwardLatencyLastUs,
+           status.forwardLatencyMaxUs);
+    printBusStats("thermostat", thermostatBus);
+    printBusStats("boiler", boilerBus);
+
+    double gatewayPct = 100.0;
+    if (gatewayPerPoll > 0) {
+        std::lock_guard<std::mutex> guard(gateway.lock);
+        const uint32_t reads = status.gatewayQueued - (written ? 1 : 0);
+        gatewayPct = reads ? 100.0 * gateway.answered / reads : 0.0;
+        printf("\nGateway requests (%ld per poll)\n", gatewayPerPoll);
+        printf("  queued %u  rejected %u  answered %u (%.1f%%)  failed %u  pending %u  out of order %u\n",
+               status.gatewayQueued, status.gatewayRejected, gateway.answered, gatewayPct, gateway.failed,
+               status.gatewayPending, gateway.outOfOrder);
+        printPercentiles("queue wait", gateway.waitedUs);
+        printf("  manual write: %s\n", written ? esp_err_to_name(writeErr) : "not sent");
+    }
+
+    printf("\nCPU (host)\n");
+    uint32_t transactions = std::max<uint32_t>(1, stats.sent);
+    for (const char* name : {"bm_main", "ot_rmt_monitor", "ot_bus_log"}) {
+        for (const host::TaskCpu& task : cpu) {
+            if (task.name != name) continue;
+            printf("  %-16s %8.1f ms  %6.1f us/transaction  %5.2f%% of a core\n",
+                   name, task.cpuUs / 1000.0, static_cast<double>(task.cpuUs) / transactions,
+                   wallS > 0 ? task.cpuUs / (wallS * 1e4) : 0.0);
+        }
+    }
+
+    printf("\nPlant\n");
+    printf("  room %.1f C, flow %.1f C, return %.1f C, setpoint %.1f C, modulation %.0f%%, flame %s, %u burner starts\n",
+           plantState.tRoom, plantState.tFlow, plantState.tReturn, plantState.tSet, plantState.modulation,
+           plantState.flame ? "on" : "off", plantState.burnerStarts);
+
+    if (traceOut && traceRecords >= 0) {
+        printf("\nTrace: %d records written to %s\n", traceRecords, traceOut);
+    }
+
+    int rc = successPct >= minSuccessPct ? 0 : 1;
+    if (rc != 0) {
+        printf("\nFAIL: %.1f%% answered, below --min-success=%.1f\n", successPct, minSuccessPct);
+    }
+    if (gatewayPct < minSuccessPct || gateway.outOfOrder) {
+        printf("\nFAIL: %.1f%% of gateway requests answered, %u out of order\n", gatewayPct, gateway.outOfOrder);
+        rc = 1;
+    }
+    if (written && writeErr != ESP_OK) {
+        printf("\nFAIL: manual write: %s\n", esp_err_to_name(writeErr));
+        rc = 1;
+    }
+    if (traceOut && traceRecords < 0) {
+        printf("\nFAIL: could not write the trace to %s\n", traceOut);
+        rc = 1;
+    }
+    fflush(stdout);
+    fflush(stderr);
+    // Task threads are detached and never joined
+    std::_Exit(rc);
+}
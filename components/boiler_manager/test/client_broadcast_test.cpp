@@ -0,0 +1,227 @@
+// WebSocket client broadcast
+//
+// Every client gets every message pushed after it joined, in order; a
+// client that stops reading loses only its own oldest messages, and the
+// others see nothing of it. Frames come out in runs for batching.
+//
+//   client_broadcast_test
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "client_broadcast.h"
+#include "check.h"
+
+using ot::ClientBroadcast;
+
+static bool push(ClientBroadcast& b, const std::string& text)
+{
+    return b.push(text.c_str(), text.size());
+}
+
+// Send slot's next message; empty when it is caught up
+static std::string take(ClientBroadcast& b, size_t slot)
+{
+    char text[ClientBroadcast::MESSAGE_MAX];
+    uint32_t seq = 0;
+    const size_t len = b.nextText(slot, text, seq);
+    if (!len) {
+        return std::string();
+    }
+    b.sent(slot, seq, 1, len);
+    return std::string(text, len);
+}
+
+static ClientBroadcast::ClientStats statsOf(const ClientBroadcast& b, int fd)
+{
+    ClientBroadcast::ClientStats all[ClientBroadcast::MAX_CLIENTS];
+    const size_t n = b.stats(all, ClientBroadcast::MAX_CLIENTS);
+    for (size_t i = 0; i < n; i++) {
+        if (all[i].fd == fd) {
+            return all[i];
+        }
+    }
+    return ClientBroadcast::ClientStats{-1, ClientBroadcast::Format::Json, 0, 0, 0, 0, 0, 0};
+}
+
+static void testClients()
+{
+    static ClientBroadcast b;
+    CHECK(b.add(-1) < 0);
+    const int a = b.add(10);
+    CHECK(a >= 0 && b.fd(a) == 10);
+    CHECK(push(b, "one"));
+
+    // A late joiner starts at the next message
+    const int c = b.add(11);
+    CHECK(c >= 0 && c != a && b.clients() == 2);
+    CHECK(push(b, "two"));
+    CHECK(take(b, a) == "one");
+    CHECK(take(b, a) == "two");
+    CHECK(take(b, a).empty());
+    CHECK(take(b, c) == "two");
+    CHECK(take(b, c).empty());
+
+    // Full table
+    CHECK(b.add(12) >= 0 && b.add(13) >= 0);
+    CHECK(b.add(14) < 0);
+    CHECK(b.clients() == ClientBroadcast::MAX_CLIENTS);
+
+    // A reused fd starts over in the same slot
+    CHECK(push(b, "three"));
+    CHECK(b.add(10) == a);
+    CHECK(take(b, a).empty());
+    CHECK(statsOf(b, 10).sent == 0);
+
+    b.remove(c);
+    CHECK(b.fd(c) == -1 && b.clients() == ClientBroadcast::MAX_CLIENTS - 1);
+    CHECK(take(b, c).empty());
+    CHECK(b.add(14) == c);
+}
+
+static void testSlowClient()
+{
+    static ClientBroadcast b;
+    const int fast = b.add(1);
+    const int slow = b.add(2);
+
+    const uint32_t total = 3 * ClientBroadcast::DEPTH;
+    for (uint32_t i = 0; i < total; i++) {
+        CHECK(push(b, "m" + std::to_string(i)));
+        CHECK(take(b, fast) == "m" + std::to_string(i));
+        if (i % 4 == 0) {
+            b.stalled(slow);
+        }
+    }
+
+    // The fast client saw everything; the slow one keeps the newest DEPTH
+    const auto f = statsOf(b, 1);
+    CHECK(f.sent == total && f.dropped == 0 && f.lag == 0 && f.maxLag == 1);
+    auto s = statsOf(b, 2);
+    CHECK(s.sent == 0 && s.dropped == total - ClientBroadcast::DEPTH);
+    CHECK(s.lag == ClientBroadcast::DEPTH && s.maxLag == ClientBroadcast::DEPTH);
+    CHECK(s.stalls == total / 4);
+    for (uint32_t i = total - ClientBroadcast::DEPTH; i < total; i++) {
+        CHECK(take(b, slow) == "m" + std::to_string(i));
+    }
+    CHECK(take(b, slow).empty());
+    s = statsOf(b, 2);
+    CHECK(s.sent == ClientBroadcast::DEPTH && s.lag == 0);
+    CHECK(s.bytes == ClientBroadcast::DEPTH * 3 && f.bytes == 10 * 2 + (total - 10) * 3);
+    CHECK(b.published() == total);
+}
+
+static void testDroppedWhileSending()
+{
+    static ClientBroadcast b;
+    const int slot = b.add(5);
+    for (uint32_t i = 0; i < ClientBroadcast::DEPTH; i++) {
+        CHECK(push(b, "m" + std::to_string(i)));
+    }
+
+    // The message being sent is overwritten meanwhile: the client must
+    // move on to the oldest one left, not skip it
+    char text[ClientBroadcast::MESSAGE_MAX];
+    uint32_t seq = 0;
+    CHECK(b.nextText(slot, text, seq) == 2 && strcmp(text, "m0") == 0);
+    CHECK(push(b, "late"));
+    b.sent(slot, seq, 1, 2);
+    CHECK(take(b, slot) == "m1");
+    CHECK(statsOf(b, 5).dropped == 1);
+}
+
+static ot::FrameRecord frame(uint32_t raw)
+{
+    ot::FrameRecord r = {};
+    r.timeUs = raw * 1000;
+    r.frame = raw;
+    return r;
+}
+
+static void testFrames()
+{
+    static ClientBroadcast b;
+    const int json = b.add(7);
+    const int binary = b.add(8, ClientBroadcast::Format::Binary);
+    CHECK(b.format(json) == ClientBroadcast::Format::Json);
+    CHECK(b.format(binary) == ClientBroadcast::Format::Binary);
+    CHECK(b.pending(binary) == ClientBroadcast::Pending::None);
+
+    for (uint32_t i = 1; i <= 5; i++) {
+        b.pushFrame(frame(i));
+    }
+    CHECK(push(b, "status"));
+    b.pushFrame(frame(6));
+
+    // A run of frames stops at the text message
+    ot::FrameRecord out[8];
+    uint32_t seq = 0;
+    char text[ClientBroadcast::MESSAGE_MAX];
+    CHECK(b.pending(binary) == ClientBroadcast::Pending::Frame);
+    CHECK(b.nextText(binary, text, seq) == 0);
+    CHECK(b.nextFrames(binary, out, 3, seq) == 3 && seq == 0);
+    CHECK(out[0].frame == 1 && out[2].frame == 3 && out[0].seq == 0 && out[2].seq == 2);
+    b.sent(binary, seq, 3, 44);
+    CHECK(b.nextFrames(binary, out, 8, seq) == 2 && out[0].frame == 4 && out[1].frame == 5);
+    b.sent(binary, seq, 2, 32);
+    CHECK(b.pending(binary) == ClientBroadcast::Pending::Text);
+    CHECK(b.nextFrames(binary, out, 8, seq) == 0);
+    CHECK(take(b, binary) == "status");
+    CHECK(b.nextFrames(binary, out, 8, seq) == 1 && out[0].frame == 6 && out[0].seq == 6);
+    b.sent(binary, seq, 1, 20);
+    CHECK(b.pending(binary) == ClientBroadcast::Pending::None);
+    const auto s = statsOf(b, 8);
+    CHECK(s.sent == 7 && s.bytes == 44 + 32 + 6 + 20 && s.lag == 0);
+    CHECK(s.format == ClientBroadcast::Format::Binary);
+
+    // The JSON client has its own cursor over the same messages
+    CHECK(b.nextFrames(json, out, 1, seq) == 1 && out[0].frame == 1);
+    CHECK(statsOf(b, 7).lag == 7);
+
+    // A batch partly overwritten while it was sent moves on past it
+    static ClientBroadcast d;
+    const int slot = d.add(9, ClientBroadcast::Format::Binary);
+    for (uint32_t i = 0; i < ClientBroadcast::DEPTH; i++) {
+        d.pushFrame(frame(i));
+    }
+    CHECK(d.nextFrames(slot, out, 4, seq) == 4 && seq == 0);
+    d.pushFrame(frame(100));
+    d.pushFrame(frame(101));
+    d.sent(slot, seq, 4, 56);
+    CHECK(d.nextFrames(slot, out, 1, seq) == 1 && out[0].frame == 4);
+    CHECK(statsOf(d, 9).dropped == 2);
+}
+
+static void testMessageSize()
+{
+    static ClientBroadcast b;
+    const int slot = b.add(3);
+    const std::string longest(ClientBroadcast::MESSAGE_MAX - 1, 'x');
+    CHECK(push(b, longest));
+    CHECK(!push(b, longest + "x"));
+    CHECK(!b.push(nullptr, 0));
+    CHECK(take(b, slot) == longest);
+    CHECK(take(b, slot).empty());
+}
+
+int main()
+{
+    printf("clients\n");
+    testClients();
+    printf("slow client\n");
+    testSlowClient();
+    printf("dropped while sending\n");
+    testDroppedWhileSending();
+    printf("frames\n");
+    testFrames();
+    printf("message size\n");
+    testMessageSize();
+
+    if (s_failures) {
+        printf("FAIL: %d checks\n", s_failures.load());
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
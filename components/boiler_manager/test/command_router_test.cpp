@@ -0,0 +1,173 @@
+// MQTT command router
+//
+// <base>/<name>/set topics reach their handler with the payload as sent;
+// anything else reaches none. Raw <base>/ot/<id>/read|write commands parse.
+//
+//   command_router_test
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "command_router.h"
+#include "check.h"
+
+using ot::CommandRouter;
+
+struct Received {
+    int calls = 0;
+    std::string payload;
+};
+
+static void record(void* context, const char* payload, size_t len)
+{
+    auto* r = static_cast<Received*>(context);
+    r->calls++;
+    r->payload.assign(payload, len);
+}
+
+static bool route(const CommandRouter& router, const char* topic, const char* payload)
+{
+    return router.dispatch(topic, strlen(topic), payload, strlen(payload));
+}
+
+static void testRouting()
+{
+    CommandRouter router;
+    router.setBase("ot_gateway");
+    CHECK(router.filter() == "ot_gateway/+/set");
+
+    Received tset, control;
+    CHECK(router.add("tset", record, &tset));
+    CHECK(router.add("control", record, &control));
+    CHECK(router.size() == 2);
+
+    CHECK(route(router, "ot_gateway/tset/set", "55.5"));
+    CHECK(tset.calls == 1 && tset.payload == "55.5");
+    CHECK(control.calls == 0);
+
+    CHECK(route(router, "ot_gateway/control/set", "ON"));
+    CHECK(control.calls == 1 && control.payload == "ON");
+
+    // The payload is passed by length, not up to a NUL
+    const char raw[] = "OFFjunk";
+    CHECK(router.dispatch("ot_gateway/control/set", 22, raw, 3));
+    CHECK(control.payload == "OFF");
+
+    CHECK(!route(router, "ot_gateway/unknown/set", "1"));
+    CHECK(!route(router, "ot_gateway/tset/state", "1"));
+    CHECK(!route(router, "ot_gateway/tset/set/x", "1"));
+    CHECK(!route(router, "ot_gateway/a/tset/set", "1"));
+    CHECK(!route(router, "other/tset/set", "1"));
+    CHECK(!route(router, "ot_gateway//set", "1"));
+    CHECK(!route(router, "ot_gateway/set", "1"));
+    CHECK(!route(router, "ot_gateway/tse/set", "1"));
+    CHECK(!route(router, "ot_gateway/tsett/set", "1"));
+    CHECK(tset.calls == 1);
+
+    // Same commands under another base
+    router.setBase("boiler/kitchen");
+    CHECK(!route(router, "ot_gateway/tset/set", "1"));
+    CHECK(route(router, "boiler/kitchen/tset/set", "60"));
+    CHECK(tset.calls == 2 && tset.payload == "60");
+}
+
+static void testAdd()
+{
+    CommandRouter router;
+    router.setBase("b");
+    Received r;
+    CHECK(!router.add("", record, &r));
+    CHECK(!router.add("a/b", record, &r));
+    CHECK(!router.add(nullptr, record, &r));
+    CHECK(!router.add("x", nullptr, &r));
+    CHECK(router.add("x", record, &r));
+    CHECK(!router.add("x", record, &r));
+
+    // Fill the table; every name still routes to its own handler
+    static const char* names[] = {"a", "b", "c", "d", "e", "f", "g", "h",
+                                  "i", "j", "k", "l", "m", "n", "o", "p"};
+    Received each[CommandRouter::MAX_COMMANDS];
+    size_t added = 1;
+    for (size_t i = 0; added < CommandRouter::MAX_COMMANDS; i++, added++) {
+        CHECK(router.add(names[i], record, &each[i]));
+    }
+    CHECK(router.size() == CommandRouter::MAX_COMMANDS);
+    CHECK(!router.add("full", record, &r));
+    for (size_t i = 0; i + 1 < CommandRouter::MAX_COMMANDS; i++) {
+        std::string topic = std::string("b/") + names[i] + "/set";
+        CHECK(route(router, topic.c_str(), names[i]));
+        CHECK(each[i].calls == 1 && each[i].payload == names[i]);
+    }
+    CHECK(route(router, "b/x/set", ""));
+    CHECK(r.calls == 1 && r.payload.empty());
+}
+
+static bool busTopic(const char* topic, ot::BusCommand& command)
+{
+    return ot::parseBusTopic("gw/ot/", topic, strlen(topic), command);
+}
+
+static bool busPayload(const char* payload, ot::BusCommand& command)
+{
+    return ot::parseBusPayload(payload, strlen(payload), command);
+}
+
+static void testBusCommands()
+{
+    ot::BusCommand c;
+    CHECK(busTopic("gw/ot/25/read", c) && c.dataId == 25 && !c.write);
+    CHECK(busTopic("gw/ot/0/write", c) && c.dataId == 0 && c.write);
+    CHECK(busTopic("gw/ot/255/read", c) && c.dataId == 255);
+    CHECK(!busTopic("gw/ot/256/read", c));
+    CHECK(!busTopic("gw/ot/1000/read", c));
+    CHECK(!busTopic("gw/ot//read", c));
+    CHECK(!busTopic("gw/ot/x/read", c));
+    CHECK(!busTopic("gw/ot/25/response", c));
+    CHECK(!busTopic("gw/ot/25/reads", c));
+    CHECK(!busTopic("gw/ot/25", c));
+    CHECK(!busTopic("other/ot/25/read", c));
+
+    ot::BusCommand read;
+    CHECK(busPayload("", read) && read.tag == 0);
+    CHECK(busPayload("42", read) && read.tag == 42);
+    CHECK(!busPayload("abc", read));
+    CHECK(!busPayload("1,2", read));
+
+    ot::BusCommand write;
+    write.write = true;
+    CHECK(busPayload("300", write) && write.value == 300 && write.tag == 0);
+    CHECK(busPayload("0x1A2b,7", write) && write.value == 0x1A2B && write.tag == 7);
+    CHECK(busPayload("-1", write) && write.value == 0xFFFF);
+    CHECK(busPayload("65535", write) && write.value == 0xFFFF);
+    CHECK(busPayload("21.5", write) && write.value == 0x1580);
+    CHECK(busPayload("-1.5,3", write) && write.value == 0xFE80 && write.tag == 3);
+    CHECK(!busPayload("", write));
+    CHECK(!busPayload("65536", write));
+    CHECK(!busPayload("0x10000", write));
+    CHECK(!busPayload("12abc", write));
+    CHECK(!busPayload("128.0", write));
+    CHECK(!busPayload("1,x", write));
+    CHECK(!busPayload("1,", write));
+    CHECK(!busPayload("0123456789012345678901234567890123", write));
+
+    // Payloads are taken by length
+    CHECK(ot::parseBusPayload("12,9junk", 4, write) && write.value == 12 && write.tag == 9);
+}
+
+int main()
+{
+    printf("routing\n");
+    testRouting();
+    printf("add\n");
+    testAdd();
+    printf("bus commands\n");
+    testBusCommands();
+
+    if (s_failures) {
+        printf("FAIL: %d checks\n", s_failures.load());
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,77 @@
+// Diagnostics snapshot serialisation
+//
+// Only valid fields, their ages, and a buffer that is too small yielding
+// nothing rather than a truncated object.
+//
+//   diagnostics_snapshot_test
+
+#include <cstdio>
+#include <cstring>
+
+#include "diagnostics_snapshot.h"
+#include "host_port.h"
+#include "mqtt_bridge.hpp"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+static void testFields()
+{
+    ot::Diagnostics diag;
+    char buf[ot::MqttBridge::SNAPSHOT_MAX];
+
+    size_t len = ot::formatDiagnosticsSnapshot(diag, 5000ms, buf, sizeof(buf));
+    CHECK(len == strlen(buf));
+    CHECK(strcmp(buf, "{\"uptime_ms\":5000}") == 0);
+
+    diag.tBoiler.value = 45.2f;
+    diag.tBoiler.timestamp = 4000ms;
+    diag.flameOn.value = 1.0f;
+    diag.flameOn.timestamp = 4900ms;
+    len = ot::formatDiagnosticsSnapshot(diag, 5000ms, buf, sizeof(buf));
+    printf("  %s\n", buf);
+    CHECK(len == strlen(buf));
+    CHECK(strcmp(buf, "{\"uptime_ms\":5000,\"t_boiler\":[45.20,1000],\"flame_on\":[1.00,100]}") == 0);
+
+    diag.tBoiler.invalidate();
+    len = ot::formatDiagnosticsSnapshot(diag, 5000ms, buf, sizeof(buf));
+    CHECK(strstr(buf, "t_boiler") == nullptr);
+    CHECK(strstr(buf, "flame_on") != nullptr);
+}
+
+static void testAllFieldsFit()
+{
+    ot::Diagnostics diag;
+    for (size_t i = 0; i < ot::DIAGNOSTIC_FIELD_COUNT; i++) {
+        (diag.*ot::DIAGNOSTIC_FIELDS[i].value).value = -12345.67f;
+        (diag.*ot::DIAGNOSTIC_FIELDS[i].value).timestamp = 1ms;
+    }
+    const std::chrono::milliseconds year = 86400000ms * 365;
+    char buf[ot::MqttBridge::SNAPSHOT_MAX];
+    size_t len = ot::formatDiagnosticsSnapshot(diag, year, buf, sizeof(buf));
+    printf("  all %zu fields: %zu of %zu bytes\n", ot::DIAGNOSTIC_FIELD_COUNT, len, sizeof(buf));
+    CHECK(len > 0);
+
+    // Too small, even by just the NUL: nothing
+    char small[64];
+    CHECK(ot::formatDiagnosticsSnapshot(diag, year, small, sizeof(small)) == 0);
+    CHECK(ot::formatDiagnosticsSnapshot(diag, year, buf, len) == 0);
+    CHECK(ot::formatDiagnosticsSnapshot(diag, year, buf, len + 1) == len);
+    CHECK(ot::formatDiagnosticsSnapshot(diag, year, buf, 0) == 0);
+}
+
+int main()
+{
+    esp_log_level_set("*", ESP_LOG_WARN);
+    printf("fields\n");
+    testFields();
+    printf("all fields\n");
+    testAllFieldsFit();
+
+    if (s_failures) {
+        printf("FAIL: %d checks\n", s_failures.load());
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,167 @@
+// FrameEventBus on the host port
+//
+// Checks ordering and per-reader drop accounting when a reader is lapped,
+// and that a subscriber stalling in its handler loses events without
+// slowing publish() or the other subscribers.
+//
+//   event_bus_test
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "frame_event_bus.h"
+#include "host_port.h"
+#include "check.h"
+
+using ot::Frame;
+using ot::FrameEvent;
+using ot::FrameEventBus;
+using ot::MessageDirection;
+using ot::MessageSource;
+
+static void publishN(FrameEventBus& bus, uint32_t first, uint32_t n)
+{
+    for (uint32_t i = first; i < first + n; i++) {
+        bus.publish(MessageSource::ThermostatBoiler,
+                    i % 2 ? MessageDirection::Response : MessageDirection::Request, Frame(i));
+    }
+}
+
+static void testReader()
+{
+    FrameEventBus bus(16);
+    CHECK(bus.capacity() == 16);
+    publishN(bus, 1, 3);    // Before the reader: not seen
+
+    FrameEventBus::Reader reader(bus);
+    FrameEvent event;
+    CHECK(!reader.next(event));
+
+    publishN(bus, 100, 10);
+    for (uint32_t i = 100; i < 110; i++) {
+        CHECK(reader.next(event));
+        CHECK(event.frame.raw() == i);
+        CHECK(event.direction == (i % 2 ? MessageDirection::Response : MessageDirection::Request));
+        CHECK(event.source == MessageSource::ThermostatBoiler);
+    }
+    CHECK(!reader.next(event));
+    CHECK(reader.delivered() == 10);
+    CHECK(reader.dropped() == 0);
+
+    // Three rings' worth: the newest ring is kept, the rest counted
+    publishN(bus, 1000, 48);
+    uint32_t expected = 1000 + 32;
+    while (reader.next(event)) {
+        CHECK(event.frame.raw() == expected);
+        expected++;
+    }
+    CHECK(expected == 1048);
+    CHECK(reader.dropped() == 32);
+    CHECK(reader.delivered() == 26);
+}
+
+static bool waitFor(const std::function<bool()>& done)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static void testSlowSubscriber()
+{
+    constexpr uint32_t EVENTS = 2000;
+    FrameEventBus bus(256);
+
+    std::atomic<uint32_t> fastCount{0}, fastLast{0};
+    bool inOrder = true;
+    int fast = bus.subscribe("fast", [&](const FrameEvent& e) {
+        if (e.frame.raw() <= fastLast.load()) inOrder = false;
+        fastLast = e.frame.raw();
+        fastCount++;
+    });
+    std::atomic<uint32_t> slowCount{0};
+    int slow = bus.subscribe("slow", [&](const FrameEvent&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        slowCount++;
+    });
+    CHECK(fast >= 0 && slow >= 0);
+
+    // Paced so the fast subscriber keeps up; the slow one cannot
+    uint64_t maxPublishNs = 0;
+    for (uint32_t i = 1; i <= EVENTS; i++) {
+        auto t0 = std::chrono::steady_clock::now();
+        bus.publish(MessageSource::ThermostatBoiler, MessageDirection::Request, Frame(i));
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+        maxPublishNs = std::max<uint64_t>(maxPublishNs, static_cast<uint64_t>(ns));
+        if (i % 8 == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    }
+
+    FrameEventBus::SubscriberStats stats[FrameEventBus::MAX_SUBSCRIBERS];
+    auto accounted = [&](size_t which) {
+        size_t n = bus.subscriberStats(stats, FrameEventBus::MAX_SUBSCRIBERS);
+        return n == 2 && stats[which].delivered + stats[which].dropped == EVENTS;
+    };
+    CHECK(waitFor([&] { return accounted(0); }));
+    CHECK(waitFor([&] { return accounted(1); }));
+    bus.subscriberStats(stats, FrameEventBus::MAX_SUBSCRIBERS);
+
+    printf("  published %u, max publish %.1f us\n", bus.published(), maxPublishNs / 1000.0);
+    printf("  %-5s delivered %u dropped %u\n", stats[0].name, stats[0].delivered, stats[0].dropped);
+    printf("  %-5s delivered %u dropped %u\n", stats[1].name, stats[1].delivered, stats[1].dropped);
+
+    CHECK(bus.published() == EVENTS);
+    CHECK(stats[0].dropped == 0);
+    CHECK(fastCount == EVENTS);
+    CHECK(fastLast == EVENTS);
+    CHECK(inOrder);
+    CHECK(stats[1].dropped > 0);
+    // Each slow handler takes 2 ms; publish must not have waited on one
+    CHECK(maxPublishNs < 1000000);
+
+    bus.unsubscribe(slow);
+    CHECK(bus.subscriberStats(stats, FrameEventBus::MAX_SUBSCRIBERS) == 1);
+    publishN(bus, EVENTS + 1, 8);
+    CHECK(waitFor([&] { return fastCount == EVENTS + 8; }));
+    bus.unsubscribe(fast);
+    CHECK(bus.subscriberStats(stats, FrameEventBus::MAX_SUBSCRIBERS) == 0);
+}
+
+static void testSubscriberLimit()
+{
+    FrameEventBus bus(8);
+    std::vector<int> ids;
+    for (size_t i = 0; i < FrameEventBus::MAX_SUBSCRIBERS; i++) {
+        ids.push_back(bus.subscribe("sub", [](const FrameEvent&) {}));
+        CHECK(ids.back() >= 0);
+    }
+    CHECK(bus.subscribe("extra", [](const FrameEvent&) {}) < 0);
+    bus.unsubscribe(ids[2]);
+    CHECK(bus.subscribe("extra", [](const FrameEvent&) {}) == ids[2]);
+}
+
+int main()
+{
+    esp_log_level_set("*", ESP_LOG_WARN);
+    printf("reader\n");
+    testReader();
+    printf("slow subscriber\n");
+    testSlowSubscriber();
+    printf("subscriber limit\n");
+    testSubscriberLimit();
+
+    if (s_failures) {
+        printf("FAIL: %d checks\n", s_failures.load());
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,195 @@
+// Live frame stream encodings
+//
+// The binary batch layout byte by byte, the JSON text the default stream
+// has always sent, record times taken from the events rather than from
+// when they were drained, and what each costs per frame: bytes on air
+// (WebSocket header included) and encode time on this host.
+//
+//   frame_stream_test [--frames=N]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "frame_stream.h"
+#include "boiler_manager.hpp"
+#include "check.h"
+
+using namespace ot;
+
+static FrameRecord record(int64_t timeUs, uint32_t frame, MessageSource source, MessageDirection direction,
+                          uint16_t seq)
+{
+    FrameRecord r = {};
+    r.timeUs = timeUs;
+    r.frame = frame;
+    r.source = static_cast<uint8_t>(source);
+    r.direction = static_cast<uint8_t>(direction);
+    r.seq = seq;
+    return r;
+}
+
+static void testBatchLayout()
+{
+    const FrameRecord records[] = {
+        record(0x100000005LL, 0x00190000, MessageSource::ThermostatBoiler, MessageDirection::Request, 0xFFFF),
+        record(0x100000005LL + 70000, 0xC0192D00, MessageSource::GatewayBoiler, MessageDirection::Response, 0),
+    };
+    const uint8_t expect[] = {
+        1, 12, 2, 0,  0x05, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,  0x00, 0x00, 0x19, 0x00,  0, 0,  0xFF, 0xFF,
+        0x70, 0x11, 0x01, 0x00,  0x00, 0x2D, 0x19, 0xC0,  1, 1,  0x00, 0x00,
+    };
+    uint8_t out[FRAME_BATCH_BYTES_MAX];
+    CHECK(encodeFrameBatch(out, sizeof(out), records, 2) == sizeof(expect));
+    CHECK(memcmp(out, expect, sizeof(expect)) == 0);
+
+    CHECK(encodeFrameBatch(out, sizeof(expect) - 1, records, 2) == 0);
+    CHECK(encodeFrameBatch(out, sizeof(out), records, 0) == 0);
+    FrameRecord many[FRAME_BATCH_MAX + 1] = {};
+    CHECK(encodeFrameBatch(out, sizeof(out), many, FRAME_BATCH_MAX) == FRAME_BATCH_BYTES_MAX);
+    CHECK(encodeFrameBatch(out, sizeof(out), many, FRAME_BATCH_MAX + 1) == 0);
+}
+
+static void testJson()
+{
+    const FrameRecord r = record(1234567890, 0xC0192D00, MessageSource::GatewayBoiler,
+                                 MessageDirection::Response, 3);
+    char out[256];
+    const size_t len = formatFrameJson(out, sizeof(out), r);
+    const char* expect =
+        "{\"timestamp\":1234567,\"direction\":\"RESPONSE\",\"source\":\"GATEWAY_BOILER\","
+        "\"message\":3222875392,\"msg_type\":\"READ_ACK\",\"data_id\":25,\"data_value\":11520}";
+    CHECK(len == strlen(expect) && strcmp(out, expect) == 0);
+    CHECK(formatFrameJson(out, len, r) == 0);
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void testEventTimes()
+{
+    // Published across a 32-bit wrap of the microsecond clock, then drained
+    // in one go well after the last of them
+    const int64_t base = 0x1FFFFF000LL;
+    const uint32_t offsets[] = {0, 1000, 1500, 250000, 1250000};
+    const int64_t nowUs = base + 3000000;
+    FrameRecord records[5];
+    for (size_t i = 0; i < 5; i++) {
+        FrameEvent event = {};
+        event.timestampUs = static_cast<uint32_t>(base + offsets[i]);
+        event.frame = Frame(0x00190000 + i);
+        event.source = MessageSource::ThermostatBoiler;
+        event.direction = MessageDirection::Request;
+        records[i] = frameRecord(event, nowUs);
+        CHECK(records[i].timeUs == base + offsets[i]);
+        CHECK(records[i].frame == 0x00190000 + i);
+    }
+
+    uint8_t out[FRAME_BATCH_BYTES_MAX];
+    CHECK(encodeFrameBatch(out, sizeof(out), records, 5) == FRAME_BATCH_HEADER_BYTES + 5 * FRAME_RECORD_BYTES);
+    CHECK(get32(out + 4) == static_cast<uint32_t>(base));
+    for (size_t i = 0; i < 5; i++) {
+        const uint32_t delta = get32(out + FRAME_BATCH_HEADER_BYTES + i * FRAME_RECORD_BYTES);
+        CHECK(delta == (i ? offsets[i] - offsets[i - 1] : 0));
+    }
+
+    char text[256];
+    CHECK(formatFrameJson(text, sizeof(text), records[4]) > 0);
+    const std::string expect = "{\"timestamp\":" + std::to_string((base + offsets[4]) / 1000) + ",";
+    CHECK(strncmp(text, expect.c_str(), expect.size()) == 0);
+}
+
+// Server-to-client WebSocket frame header for a payload of len bytes
+static size_t wsHeader(size_t len)
+{
+    return len < 126 ? 2 : 4;
+}
+
+static void compare(uint32_t frames)
+{
+    using Clock = std::chrono::steady_clock;
+
+    // A thermostat's exchange pattern: request and response alternating,
+    // about one a second, a few IDs
+    static const uint32_t pattern[] = {0x00000300, 0x40000300, 0x10011400, 0x50011400,
+                                       0x00190000, 0x40193A80, 0x001C0000, 0x401C2C00};
+    auto nth = [](uint32_t i) {
+        return record(1000000LL * 3600 + i * 500000LL, pattern[i % 8], MessageSource::ThermostatBoiler,
+                      (i & 1) ? MessageDirection::Response : MessageDirection::Request,
+                      static_cast<uint16_t>(i));
+    };
+
+    char text[256];
+    size_t jsonBytes = 0;
+    size_t jsonAir = 0;
+    const auto jsonStart = Clock::now();
+    for (uint32_t i = 0; i < frames; i++) {
+        const size_t len = formatFrameJson(text, sizeof(text), nth(i));
+        jsonBytes += len;
+        jsonAir += len + wsHeader(len);
+    }
+    const double jsonNs = std::chrono::duration<double, std::nano>(Clock::now() - jsonStart).count() / frames;
+
+    uint8_t batch[FRAME_BATCH_BYTES_MAX];
+    FrameRecord records[FRAME_BATCH_MAX];
+    size_t binaryBytes = 0;
+    size_t binaryAir = 0;
+    const auto binaryStart = Clock::now();
+    for (uint32_t i = 0; i < frames;) {
+        size_t n = 0;
+        for (; n < FRAME_BATCH_MAX && i < frames; n++, i++) {
+            records[n] = nth(i);
+        }
+        const size_t len = encodeFrameBatch(batch, sizeof(batch), records, n);
+        binaryBytes += len;
+        binaryAir += len + wsHeader(len);
+    }
+    const double binaryNs = std::chrono::duration<double, std::nano>(Clock::now() - binaryStart).count() / frames;
+
+    // A busy bus hands the sender one frame at a time: batches of one
+    const size_t single = encodeFrameBatch(batch, sizeof(batch), records, 1);
+
+    printf("  %u frames            bytes/frame   on air/frame   ns/frame\n", frames);
+    printf("  json                   %7.1f        %7.1f    %7.1f\n",
+           double(jsonBytes) / frames, double(jsonAir) / frames, jsonNs);
+    printf("  binary, %2zu per batch   %7.1f        %7.1f    %7.1f\n", FRAME_BATCH_MAX,
+           double(binaryBytes) / frames, double(binaryAir) / frames, binaryNs);
+    printf("  binary, 1 per batch    %7.1f        %7.1f\n", double(single), double(single + wsHeader(single)));
+
+    CHECK(binaryBytes * 10 < jsonBytes);
+    CHECK(single + wsHeader(single) < (jsonAir / frames) / 4);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t frames = 200000;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--frames=", 9) == 0) {
+            frames = static_cast<uint32_t>(strtoul(argv[i] + 9, nullptr, 10));
+        }
+    }
+    if (frames == 0) {
+        frames = 1;
+    }
+
+    printf("batch layout\n");
+    testBatchLayout();
+    printf("json\n");
+    testJson();
+    printf("event times\n");
+    testEventTimes();
+    printf("cost per frame\n");
+    compare(frames);
+
+    if (s_failures) {
+        printf("FAIL: %d checks\n", s_failures.load());
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
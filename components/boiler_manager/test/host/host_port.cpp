@@ -0,0 +1,878 @@
+// Host port of ESP-IDF and FreeRTOS (see host_port.h)
+
+#include "host_port.h"
+
+#include <pthread.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "driver/rmt_rx.h"
+#include "driver/rmt_tx.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+// Kernel objects. Everything below is guarded by g_kernel; blocked callers
+// wait on g_changed, which is signalled on every state change.
+
+struct host_task {
+    std::string name;
+    uint32_t stackDepth = 0;
+    uint32_t notifyValue = 0;
+    bool notifyPending = false;
+    bool deleted = false;
+    bool finished = false;
+    bool hasCpuClock = false;
+    clockid_t cpuClock = {};
+    uint64_t cpuUsAtExit = 0;
+};
+
+struct host_semaphore {
+    UBaseType_t count;
+    UBaseType_t max;
+};
+
+struct host_queue {
+    size_t length;
+    size_t itemSize;
+    std::deque<std::vector<uint8_t> > items;
+};
+
+struct rmt_channel_t {
+    bool tx = false;
+    gpio_num_t gpio = GPIO_NUM_NC;
+    bool enabled = false;
+    bool deleted = false;
+    void* userCtx = nullptr;
+
+    // RX
+    rmt_rx_done_callback_t onRecvDone = nullptr;
+    size_t memBlockSymbols = 0;
+    bool armed = false;
+    rmt_symbol_word_t* buffer = nullptr;
+    size_t bufferSymbols = 0;
+    bool partial = false;
+    uint32_t idleUs = 0;
+    uint64_t capture = 0;       // Bumped per capture; stale deliveries are dropped
+
+    // TX
+    rmt_tx_done_callback_t onTransDone = nullptr;
+    int64_t busyUntilUs = 0;
+    size_t pending = 0;
+};
+
+struct rmt_encoder_t {
+    int unused;
+};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point g_epoch = Clock::now();
+std::atomic<double> g_speed{1.0};
+
+std::mutex g_kernel;
+std::condition_variable g_changed;
+std::recursive_mutex g_critical;
+std::vector<std::unique_ptr<host_task> > g_tasks;
+thread_local host_task* t_self = nullptr;
+
+std::map<int, rmt_channel_t*> g_rxByPin;
+std::map<int, host::WireSink> g_sinks;
+std::map<int, uint32_t> g_levels;
+uint64_t g_missedCaptures = 0;
+
+std::atomic<int> g_logLevel{ESP_LOG_INFO};
+
+// Thrown into a task's thread by vTaskDelete, caught by its trampoline
+struct TaskExit {};
+
+Clock::time_point realTime(int64_t us)
+{
+    return g_epoch + std::chrono::nanoseconds(static_cast<int64_t>(us * 1000.0 / g_speed.load()));
+}
+
+uint64_t threadCpuUs(clockid_t clock)
+{
+    timespec ts;
+    if (clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Task record of the calling thread; threads not started by xTaskCreate
+// (main, the hardware thread) are registered on first use
+host_task* self(std::unique_lock<std::mutex>&)
+{
+    if (t_self == nullptr) {
+        g_tasks.emplace_back(new host_task);
+        t_self = g_tasks.back().get();
+        t_self->name = "main";
+    }
+    return t_self;
+}
+
+// Block until pred() holds or ticks expire; false on timeout
+template <typename Pred>
+bool waitFor(std::unique_lock<std::mutex>& lock, TickType_t ticks, Pred pred)
+{
+    host_task* me = self(lock);
+    auto ready = [me, &pred] { return me->deleted || pred(); };
+    if (ticks == portMAX_DELAY) {
+        g_changed.wait(lock, ready);
+    } else {
+        g_changed.wait_until(lock, realTime(host::nowUs() + static_cast<int64_t>(ticks) * 1000), ready);
+    }
+    if (me->deleted) {
+        throw TaskExit();
+    }
+    return pred();
+}
+
+// Hardware thread: timed callbacks in (time, submission) order
+
+struct HwEvent {
+    int64_t atUs;
+    uint64_t seq;
+    std::function<void()> fn;
+};
+
+bool later(const HwEvent& a, const HwEvent& b)
+{
+    return a.atUs != b.atUs ? a.atUs > b.atUs : a.seq > b.seq;
+}
+
+std::mutex g_hwLock;
+std::condition_variable g_hwChanged;
+std::vector<HwEvent> g_hwEvents;    // Min-heap on (atUs, seq)
+uint64_t g_hwSeq = 0;
+std::once_flag g_hwStarted;
+
+void hardwareThread()
+{
+    std::unique_lock<std::mutex> lock(g_hwLock);
+    while (true) {
+        if (g_hwEvents.empty()) {
+            g_hwChanged.wait(lock);
+            continue;
+        }
+        int64_t due = g_hwEvents.front().atUs;
+        if (host::nowUs() < due) {
+            g_hwChanged.wait_until(lock, realTime(due));
+            continue;
+        }
+        std::pop_heap(g_hwEvents.begin(), g_hwEvents.end(), later);
+        std::function<void()> fn = std::move(g_hwEvents.back().fn);
+        g_hwEvents.pop_back();
+        lock.unlock();
+        fn();
+        lock.lock();
+    }
+}
+
+void deliverCapture(rmt_channel_t* ch, uint64_t capture, std::vector<rmt_symbol_word_t> symbols, bool last)
+{
+    rmt_rx_done_event_data_t edata = {};
+    rmt_rx_done_callback_t cb;
+    {
+        std::unique_lock<std::mutex> lock(g_kernel);
+        if (ch->deleted || !ch->enabled || ch->capture != capture || !ch->armed) {
+            return;
+        }
+        size_t n = std::min(symbols.size(), ch->bufferSymbols);
+        std::copy(symbols.begin(), symbols.begin() + n, ch->buffer);
+        edata.received_symbols = ch->buffer;
+        edata.num_symbols = n;
+        edata.flags.is_last = last;
+        if (last) {
+            ch->armed = false;
+        }
+        cb = ch->onRecvDone;
+    }
+    if (cb) {
+        cb(ch, &edata, ch->userCtx);
+    }
+}
+
+}  // namespace
+
+namespace host {
+
+void setSpeed(double speed)
+{
+    g_speed = speed > 0 ? speed : 1.0;
+}
+
+int64_t nowUs()
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - g_epoch).count();
+    return static_cast<int64_t>(elapsed * g_speed.load() / 1000.0);
+}
+
+void at(int64_t us, std::function<void()> fn)
+{
+    std::call_once(g_hwStarted, [] { std::thread(hardwareThread).detach(); });
+    std::lock_guard<std::mutex> lock(g_hwLock);
+    g_hwEvents.push_back(HwEvent{us, g_hwSeq++, std::move(fn)});
+    std::push_heap(g_hwEvents.begin(), g_hwEvents.end(), later);
+    g_hwChanged.notify_one();
+}
+
+uint32_t durationUs(const Runs& runs)
+{
+    uint32_t us = 0;
+    for (const Run& r : runs) {
+        us += r.us;
+    }
+    return us;
+}
+
+std::vector<rmt_symbol_word_t> captureSymbols(const Runs& runs)
+{
+    // Halves as (level, duration); the receiver never sees the final idle end
+    std::vector<std::pair<uint32_t, uint32_t> > halves;
+    for (const Run& r : runs) {
+        uint32_t level = r.active ? 1 : 0;
+        if (!halves.empty() && halves.back().first == level) {
+            halves.back().second += r.us;
+        } else if (r.us > 0) {
+            halves.push_back(std::make_pair(level, r.us));
+        }
+    }
+    while (!halves.empty() && halves.back().first == 0) {
+        halves.pop_back();
+    }
+    halves.push_back(std::make_pair(0u, 0u));
+
+    std::vector<rmt_symbol_word_t> symbols;
+    for (size_t i = 0; i < halves.size(); i += 2) {
+        rmt_symbol_word_t sym = {};
+        sym.level0 = halves[i].first;
+        sym.duration0 = std::min<uint32_t>(halves[i].second, 0x7FFF);
+        if (i + 1 < halves.size()) {
+            sym.level1 = halves[i + 1].first;
+            sym.duration1 = std::min<uint32_t>(halves[i + 1].second, 0x7FFF);
+        }
+        symbols.push_back(sym);
+    }
+    return symbols;
+}
+
+void onTransmit(gpio_num_t pin, WireSink sink)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    g_sinks[pin] = std::move(sink);
+}
+
+void drive(gpio_num_t pin, const Runs& runs)
+{
+    const int64_t start = nowUs();
+    const std::vector<rmt_symbol_word_t> symbols = captureSymbols(runs);
+
+    std::lock_guard<std::mutex> lock(g_kernel);
+    auto it = g_rxByPin.find(pin);
+    rmt_channel_t* ch = it != g_rxByPin.end() ? it->second : nullptr;
+    if (ch == nullptr || ch->deleted || !ch->enabled || !ch->armed) {
+        g_missedCaptures++;
+        return;
+    }
+    const uint64_t capture = ++ch->capture;
+
+    // Each chunk lands when its last symbol has been received; the rest
+    // once the line has been idle for the receive timeout
+    size_t first = 0;
+    if (ch->partial && ch->memBlockSymbols >= 2) {
+        const size_t chunk = ch->memBlockSymbols / 2;
+        int64_t endUs = start;
+        for (size_t i = 0; i < symbols.size(); i++) {
+            endUs += symbols[i].duration0 + symbols[i].duration1;
+            if (i + 1 - first == chunk && i + 1 < symbols.size()) {
+                std::vector<rmt_symbol_word_t> part(symbols.begin() + first, symbols.begin() + i + 1);
+                at(endUs, [ch, capture, part] { deliverCapture(ch, capture, part, false); });
+                first = i + 1;
+            }
+        }
+    }
+    std::vector<rmt_symbol_word_t> rest(symbols.begin() + first, symbols.end());
+    at(start + durationUs(runs) + ch->idleUs, [ch, capture, rest] { deliverCapture(ch, capture, rest, true); });
+}
+
+uint64_t missedCaptures()
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    return g_missedCaptures;
+}
+
+std::vector<TaskCpu> taskCpu()
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    std::vector<TaskCpu> out;
+    for (const auto& task : g_tasks) {
+        if (!task->hasCpuClock) {
+            continue;
+        }
+        uint64_t us = task->finished ? task->cpuUsAtExit : threadCpuUs(task->cpuClock);
+        auto it = std::find_if(out.begin(), out.end(), [&task](const TaskCpu& t) { return t.name == task->name; });
+        if (it == out.end()) {
+            out.push_back(TaskCpu{task->name, 1, us});
+        } else {
+            it->tasks++;
+            it->cpuUs += us;
+        }
+    }
+    return out;
+}
+
+}  // namespace host
+
+// esp_err / esp_log / esp_timer
+
+const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                   return "ESP_OK";
+        case ESP_FAIL:                 return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:           return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:      return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:    return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:     return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:        return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:    return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:          return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC:      return "ESP_ERR_INVALID_CRC";
+        default:                       return "UNKNOWN ERROR";
+    }
+}
+
+void host_error_check_failed(esp_err_t rc, const char* file, int line, const char* expression)
+{
+    fprintf(stderr, "ESP_ERROR_CHECK failed: esp_err_t 0x%x (%s) at %s:%d\nexpression: %s\n",
+            rc, esp_err_to_name(rc), file, line, expression);
+    abort();
+}
+
+void esp_log_level_set(const char* tag, esp_log_level_t level)
+{
+    if (strcmp(tag, "*") == 0) {
+        g_logLevel = level;
+    }
+}
+
+void host_log(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    if (level > g_logLevel.load()) {
+        return;
+    }
+    static const char LETTERS[] = "NEWIDV";
+    char line[512];
+    int n = snprintf(line, sizeof(line), "%c (%lld) %s: ", LETTERS[level],
+                     static_cast<long long>(host::nowUs() / 1000), tag);
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line + n, sizeof(line) - n, format, args);
+    va_end(args);
+    fprintf(stderr, "%s\n", line);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return host::nowUs();
+}
+
+// FreeRTOS
+
+void host_enter_critical(portMUX_TYPE*)
+{
+    g_critical.lock();
+}
+
+void host_exit_critical(portMUX_TYPE*)
+{
+    g_critical.unlock();
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* arg,
+                                   UBaseType_t, TaskHandle_t* handle, BaseType_t)
+{
+    host_task* task;
+    {
+        std::lock_guard<std::mutex> lock(g_kernel);
+        g_tasks.emplace_back(new host_task);
+        task = g_tasks.back().get();
+        task->name = name ? name : "";
+        task->stackDepth = stackDepth;
+    }
+    if (handle) {
+        *handle = task;
+    }
+    std::thread([task, fn, arg] {
+        t_self = task;
+        clockid_t clock;
+        bool hasClock = pthread_getcpuclockid(pthread_self(), &clock) == 0;
+        {
+            std::lock_guard<std::mutex> lock(g_kernel);
+            task->cpuClock = clock;
+            task->hasCpuClock = hasClock;
+        }
+        try {
+            fn(arg);
+        } catch (const TaskExit&) {
+        }
+        std::lock_guard<std::mutex> lock(g_kernel);
+        task->cpuUsAtExit = hasClock ? threadCpuUs(clock) : 0;
+        task->finished = true;
+    }).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* arg,
+                       UBaseType_t priority, TaskHandle_t* handle)
+{
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == nullptr || task == t_self) {
+        throw TaskExit();
+    }
+    std::lock_guard<std::mutex> lock(g_kernel);
+    task->deleted = true;
+    g_changed.notify_all();
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(g_kernel);
+    waitFor(lock, ticks, [] { return false; });
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return static_cast<TickType_t>(host::nowUs() / 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    std::unique_lock<std::mutex> lock(g_kernel);
+    return self(lock);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    return task ? task->stackDepth : 0;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    switch (action) {
+        case eNoAction:
+            break;
+        case eSetBits:
+            task->notifyValue |= value;
+            break;
+        case eIncrement:
+            task->notifyValue++;
+            break;
+        case eSetValueWithOverwrite:
+            task->notifyValue = value;
+            break;
+        case eSetValueWithoutOverwrite:
+            if (task->notifyPending) {
+                return pdFAIL;
+            }
+            task->notifyValue = value;
+            break;
+    }
+    task->notifyPending = true;
+    g_changed.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t* woken)
+{
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xTaskNotify(task, value, action);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(g_kernel);
+    host_task* me = self(lock);
+    if (!me->notifyPending) {
+        me->notifyValue &= ~clearOnEntry;
+    }
+    bool notified = waitFor(lock, ticks, [me] { return me->notifyPending; });
+    if (value) {
+        *value = me->notifyValue;
+    }
+    if (notified) {
+        me->notifyValue &= ~clearOnExit;
+        me->notifyPending = false;
+    }
+    return notified ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    return xTaskNotify(task, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken)
+{
+    xTaskNotifyFromISR(task, 0, eIncrement, woken);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(g_kernel);
+    host_task* me = self(lock);
+    waitFor(lock, ticks, [me] { return me->notifyValue != 0; });
+    uint32_t value = me->notifyValue;
+    if (value != 0) {
+        me->notifyValue = clearOnExit ? 0 : value - 1;
+    }
+    me->notifyPending = false;
+    return value;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return new host_semaphore{0, 1};
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+    return new host_semaphore{initialCount, maxCount};
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return new host_semaphore{1, 1};
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    delete sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(g_kernel);
+    if (!waitFor(lock, ticks, [sem] { return sem->count > 0; })) {
+        return pdFALSE;
+    }
+    sem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    if (sem->count >= sem->max) {
+        return pdFALSE;
+    }
+    sem->count++;
+    g_changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* woken)
+{
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xSemaphoreGive(sem);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    host_queue* queue = new host_queue;
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(g_kernel);
+    if (!waitFor(lock, ticks, [queue] { return queue->items.size() < queue->length; })) {
+        return pdFALSE;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    g_changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken)
+{
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    std::lock_guard<std::mutex> lock(g_kernel);
+    if (queue->items.size() >= queue->length) {
+        return pdFALSE;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    g_changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(g_kernel);
+    if (!waitFor(lock, ticks, [queue] { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    g_changed.notify_all();
+    return pdTRUE;
+}
+
+// GPIO
+
+esp_err_t gpio_config(const gpio_config_t*)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    g_levels[pin] = level;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    auto it = g_levels.find(pin);
+    return it != g_levels.end() ? static_cast<int>(it->second) : 0;
+}
+
+esp_err_t gpio_install_isr_service(int)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t, gpio_isr_t, void*)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t, gpio_int_type_t)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t)
+{
+    return ESP_OK;
+}
+
+// RMT. Channels are never freed so that deliveries still queued on the
+// hardware thread can find them marked deleted.
+
+esp_err_t rmt_new_rx_channel(const rmt_rx_channel_config_t* config, rmt_channel_handle_t* channel)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    rmt_channel_t* ch = new rmt_channel_t;
+    ch->gpio = config->gpio_num;
+    ch->memBlockSymbols = config->mem_block_symbols;
+    g_rxByPin[config->gpio_num] = ch;
+    *channel = ch;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t* config, rmt_channel_handle_t* channel)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    rmt_channel_t* ch = new rmt_channel_t;
+    ch->tx = true;
+    ch->gpio = config->gpio_num;
+    *channel = ch;
+    return ESP_OK;
+}
+
+esp_err_t rmt_rx_register_event_callbacks(rmt_channel_handle_t channel, const rmt_rx_event_callbacks_t* cbs,
+                                          void* user_data)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    channel->onRecvDone = cbs->on_recv_done;
+    channel->userCtx = user_data;
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_register_event_callbacks(rmt_channel_handle_t channel, const rmt_tx_event_callbacks_t* cbs,
+                                          void* user_data)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    channel->onTransDone = cbs->on_trans_done;
+    channel->userCtx = user_data;
+    return ESP_OK;
+}
+
+esp_err_t rmt_enable(rmt_channel_handle_t channel)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    if (channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    channel->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_disable(rmt_channel_handle_t channel)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    if (!channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    channel->enabled = false;
+    channel->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_channel(rmt_channel_handle_t channel)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    if (channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    channel->deleted = true;
+    if (!channel->tx && g_rxByPin[channel->gpio] == channel) {
+        g_rxByPin.erase(channel->gpio);
+    }
+    return ESP_OK;
+}
+
+esp_err_t rmt_receive(rmt_channel_handle_t channel, void* buffer, size_t buffer_size,
+                      const rmt_receive_config_t* config)
+{
+    std::lock_guard<std::mutex> lock(g_kernel);
+    if (!channel->enabled || channel->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    channel->buffer = static_cast<rmt_symbol_word_t*>(buffer);
+    channel->bufferSymbols = buffer_size / sizeof(rmt_symbol_word_t);
+    channel->partial = config->flags.en_partial_rx;
+    channel->idleUs = config->signal_range_max_ns / 1000;
+    channel->armed = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_copy_encoder(const rmt_copy_encoder_config_t*, rmt_encoder_handle_t* encoder)
+{
+    *encoder = new rmt_encoder_t;
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder)
+{
+    delete encoder;
+    return ESP_OK;
+}
+
+esp_err_t rmt_transmit(rmt_channel_handle_t channel, rmt_encoder_handle_t, const void* payload,
+                       size_t payload_bytes, const rmt_transmit_config_t* config)
+{
+    // The line after the output stage: any level but the idle one is active
+    const uint32_t idleLevel = config->flags.eot_level;
+    const rmt_symbol_word_t* symbols = static_cast<const rmt_symbol_word_t*>(payload);
+    host::Runs runs;
+    for (size_t i = 0; i < payload_bytes / sizeof(rmt_symbol_word_t); i++) {
+        const uint32_t levels[2] = {symbols[i].level0, symbols[i].level1};
+        const uint32_t durations[2] = {symbols[i].duration0, symbols[i].duration1};
+        for (int h = 0; h < 2; h++) {
+            if (durations[h] == 0) continue;
+            bool active = levels[h] != idleLevel;
+            if (!runs.empty() && runs.back().active == active) {
+                runs.back().us += durations[h];
+            } else {
+                runs.push_back(host::Run{active, durations[h]});
+            }
+        }
+    }
+    const size_t numSymbols = payload_bytes / sizeof(rmt_symbol_word_t);
+
+    std::lock_guard<std::mutex> lock(g_kernel);
+    if (!channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Queued transmissions go out back to back
+    const int64_t endUs = std::max(host::nowUs(), channel->busyUntilUs) + host::durationUs(runs);
+    channel->busyUntilUs = endUs;
+    channel->pending++;
+    host::at(endUs, [channel, runs, numSymbols] {
+        rmt_tx_done_callback_t cb;
+        host::WireSink sink;
+        {
+            std::lock_guard<std::mutex> lock(g_kernel);
+            channel->pending--;
+            g_changed.notify_all();
+            if (channel->deleted) {
+                return;
+            }
+            cb = channel->onTransDone;
+            auto it = g_sinks.find(channel->gpio);
+            if (it != g_sinks.end()) {
+                sink = it->second;
+            }
+        }
+        if (cb) {
+            rmt_tx_done_event_data_t edata = {numSymbols};
+            cb(channel, &edata, channel->userCtx);
+        }
+        if (sink) {
+            sink(runs);
+        }
+    });
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t channel, int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(g_kernel);
+    TickType_t ticks = timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return waitFor(lock, ticks, [channel] { return channel->pending == 0; }) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
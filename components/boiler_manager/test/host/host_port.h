@@ -0,0 +1,69 @@
+// Host port of ESP-IDF and FreeRTOS for running the gateway on Linux
+//
+// The headers in include/ declare the subset of the IDF API that
+// components/ot, components/boiler_manager and BusLog use, so those sources
+// build unmodified. This file is the other side: what the simulator uses
+// to drive them.
+//
+// Time is simulated: esp_timer_get_time(), ticks and timeouts all run on a
+// clock that advances setSpeed() times faster than real time. Interrupts
+// (RMT RX/TX done) run in time order on one "hardware" thread, as do the
+// callbacks handed to at(). Both RMT directions go through the wire below:
+// frames the gateway transmits are handed to the sink registered for the
+// TX pin, and frames a device sends are captured on the RX channel of the
+// pin they are driven onto, if rmt_receive() is armed by then.
+
+#ifndef HOST_PORT_H
+#define HOST_PORT_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "driver/gpio.h"
+#include "driver/rmt_types.h"
+#include "esp_log.h"
+
+namespace host {
+
+// Simulated clock rate relative to real time. Set before anything runs.
+void setSpeed(double speed);
+int64_t nowUs();
+
+// Run fn on the hardware thread at simulated time us (or now if past)
+void at(int64_t us, std::function<void()> fn);
+
+// The line as seen by the OpenTherm interface: runs of active (current
+// flowing) and idle level
+struct Run {
+    bool active;
+    uint32_t us;
+};
+typedef std::vector<Run> Runs;
+
+uint32_t durationUs(const Runs& runs);
+// Symbols the RMT receiver would capture for the line: active as level 1,
+// trailing idle dropped, terminated by a zero-duration half
+std::vector<rmt_symbol_word_t> captureSymbols(const Runs& runs);
+
+// Called on the hardware thread as each transmission on pin completes
+typedef std::function<void(const Runs& runs)> WireSink;
+void onTransmit(gpio_num_t pin, WireSink sink);
+// Drive runs onto pin starting now. Lost (and counted) if the RX channel
+// on pin is not receiving at this moment.
+void drive(gpio_num_t pin, const Runs& runs);
+// Captures lost because rmt_receive() was not armed
+uint64_t missedCaptures();
+
+// CPU time consumed so far by the tasks created with each name
+struct TaskCpu {
+    std::string name;
+    uint32_t tasks;
+    uint64_t cpuUs;
+};
+std::vector<TaskCpu> taskCpu();
+
+}  // namespace host
+
+#endif  // HOST_PORT_H
@@ -0,0 +1,9 @@
+// Host port of the ESP-IDF API used by the gateway (see ../../host_port.h)
+#pragma once
+
+#include "esp_err.h"
+#include "driver/rmt_types.h"
+
+esp_err_t rmt_enable(rmt_channel_handle_t channel);
+esp_err_t rmt_disable(rmt_channel_handle_t channel);
+esp_err_t rmt_del_channel(rmt_channel_handle_t channel);
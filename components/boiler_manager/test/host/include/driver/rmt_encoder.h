@@ -0,0 +1,12 @@
+// Host port of the ESP-IDF API used by the gateway (see ../../host_port.h)
+#pragma once
+
+#include "esp_err.h"
+#include "driver/rmt_types.h"
+
+typedef struct {
+    int unused;
+} rmt_copy_encoder_config_t;
+
+esp_err_t rmt_new_copy_encoder(const rmt_copy_encoder_config_t* config, rmt_encoder_handle_t* encoder);
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder);
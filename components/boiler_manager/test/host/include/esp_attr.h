@@ -0,0 +1,5 @@
+// Host port of the ESP-IDF API used by the gateway (see ../host_port.h)
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
@@ -0,0 +1,7 @@
+// Host port of the ESP-IDF API used by the gateway (see ../host_port.h)
+#pragma once
+
+#include <stdint.h>
+
+// Microseconds of simulated time since start
+int64_t esp_timer_get_time(void);
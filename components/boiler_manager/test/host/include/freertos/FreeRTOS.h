@@ -0,0 +1,46 @@
+// Host port of the FreeRTOS API used by the gateway (see ../../host_port.h)
+//
+// Tasks are threads and ticks are milliseconds of simulated time. Priorities
+// and core affinity are accepted and ignored; critical sections share one
+// recursive lock, which the simulated interrupts also take.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  1
+#define pdFAIL  0
+
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFu)
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 25
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define pdTICKS_TO_MS(ticks) ((uint32_t)(((uint64_t)(ticks) * 1000) / configTICK_RATE_HZ))
+
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void host_enter_critical(portMUX_TYPE* mux);
+void host_exit_critical(portMUX_TYPE* mux);
+
+#define taskENTER_CRITICAL(mux)     host_enter_critical(mux)
+#define taskEXIT_CRITICAL(mux)      host_exit_critical(mux)
+#define taskENTER_CRITICAL_ISR(mux) host_enter_critical(mux)
+#define taskEXIT_CRITICAL_ISR(mux)  host_exit_critical(mux)
+#define portYIELD_FROM_ISR(...)     ((void)0)
+
+typedef struct host_task* TaskHandle_t;
+typedef struct host_semaphore* SemaphoreHandle_t;
+typedef struct host_queue* QueueHandle_t;
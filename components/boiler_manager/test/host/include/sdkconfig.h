@@ -0,0 +1,18 @@
+// Host port: the gateway's Kconfig defaults (components/ot/Kconfig,
+// components/boiler_manager/Kconfig) for an ESP32-S3/C3 target. Override on the compiler command line.
+#pragma once
+
+#define CONFIG_FREERTOS_HZ 1000
+
+#ifndef CONFIG_OT_RMT_STREAMING_RX
+#define CONFIG_OT_RMT_STREAMING_RX 1
+#endif
+
+#if !CONFIG_OT_RMT_STREAMING_RX && !defined(CONFIG_OT_RMT_FRAME_REPAIR)
+#define CONFIG_OT_RMT_FRAME_REPAIR 1
+#endif
+
+#define CONFIG_OT_BUS_LOG_DEPTH 32
+#define CONFIG_OT_RMT_PARSER_KERNEL_STATE_MACHINE 1
+#define CONFIG_OT_FRAME_TRACE_RECORDS 1024
+#define CONFIG_OT_FRAME_EVENT_DEPTH 64
@@ -0,0 +1,5 @@
+// Host port of the ESP-IDF API used by the gateway (see ../../host_port.h)
+#pragma once
+
+#define SOC_RMT_MEM_WORDS_PER_CHANNEL 48
+#define SOC_RMT_SUPPORT_RX_PINGPONG   1
@@ -0,0 +1,42 @@
+// MqttBridge publishing as seen by BoilerManager on the host
+//
+// The simulator never attaches a bridge, so these only satisfy the linker
+// for the calls in boiler_manager.cpp.
+
+#include "mqtt_bridge.hpp"
+
+namespace ot {
+
+SensorHandle MqttBridge::declareSensor(const char*, const char*, const char*, const PublishPolicy&)
+{
+    return INVALID_SENSOR;
+}
+
+SensorHandle MqttBridge::declareBinarySensor(const char*, const char*, const PublishPolicy&)
+{
+    return INVALID_SENSOR;
+}
+
+void MqttBridge::setSnapshotWriter(SnapshotWriter)
+{
+}
+
+esp_err_t MqttBridge::publishSensor(SensorHandle, float, bool)
+{
+    return ESP_OK;
+}
+
+esp_err_t MqttBridge::publishBinarySensor(SensorHandle, bool, bool)
+{
+    return ESP_OK;
+}
+
+void MqttBridge::setBusCommandHandler(BusCommandHandler)
+{
+}
+
+void MqttBridge::publishBusResponse(const BusCommand&, esp_err_t, uint32_t)
+{
+}
+
+}  // namespace ot
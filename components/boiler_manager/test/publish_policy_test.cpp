@@ -0,0 +1,121 @@
+// MQTT diagnostic publish policy
+//
+// Deadbands, the min/max intervals, and the override text form that
+// /api/mqtt_config takes.
+//
+//   publish_policy_test
+
+#include <cstdio>
+#include <vector>
+
+#include "publish_policy.h"
+#include "check.h"
+
+using ot::PublishDecision;
+using ot::PublishPolicy;
+using ot::SensorPolicy;
+
+static void testDeadband()
+{
+    PublishPolicy any;
+    CHECK(!any.exceeds(20.0f, 20.0f));
+    CHECK(any.exceeds(20.0f, 20.01f));
+
+    PublishPolicy absolute{0.5f, 0.0f, 0, 0};
+    CHECK(!absolute.exceeds(20.0f, 20.5f));
+    CHECK(!absolute.exceeds(20.0f, 19.6f));
+    CHECK(absolute.exceeds(20.0f, 20.6f));
+
+    PublishPolicy relative{0.0f, 5.0f, 0, 0};
+    CHECK(!relative.exceeds(40.0f, 41.9f));
+    CHECK(relative.exceeds(40.0f, 42.1f));
+    CHECK(relative.exceeds(0.0f, 0.1f));      // Nothing is 5% of zero
+
+    // Both set: a change must clear both
+    PublishPolicy both{1.0f, 10.0f, 0, 0};
+    CHECK(!both.exceeds(50.0f, 54.0f));
+    CHECK(!both.exceeds(5.0f, 5.9f));
+    CHECK(both.exceeds(50.0f, 56.0f));
+}
+
+static void testDecision()
+{
+    PublishPolicy p{0.2f, 0.0f, 10000, 300000};
+
+    // First value on a connection goes out whatever it is
+    CHECK(ot::decidePublish(p, false, false, 0.0f, true, 20.0f, 0) == PublishDecision::Send);
+
+    // Within the deadband: suppressed until the keep-alive is due
+    CHECK(ot::decidePublish(p, true, true, 20.0f, true, 20.1f, 1000) == PublishDecision::Suppress);
+    CHECK(ot::decidePublish(p, true, true, 20.0f, true, 20.1f, 299999) == PublishDecision::Suppress);
+    CHECK(ot::decidePublish(p, true, true, 20.0f, true, 20.1f, 300000) == PublishDecision::KeepAlive);
+
+    // A real change is held until the min interval has passed
+    CHECK(ot::decidePublish(p, true, true, 20.0f, true, 21.0f, 9999) == PublishDecision::Hold);
+    CHECK(ot::decidePublish(p, true, true, 20.0f, true, 21.0f, 10000) == PublishDecision::Send);
+
+    // Going invalid (or valid again) is a change
+    CHECK(ot::decidePublish(p, true, true, 20.0f, false, 20.0f, 20000) == PublishDecision::Send);
+    CHECK(ot::decidePublish(p, true, false, 20.0f, true, 20.0f, 20000) == PublishDecision::Send);
+    CHECK(ot::decidePublish(p, true, false, 0.0f, false, 5.0f, 20000) == PublishDecision::Suppress);
+
+    // No max interval: never a keep-alive
+    PublishPolicy quiet{0.0f, 0.0f, 0, 0};
+    CHECK(ot::decidePublish(quiet, true, true, 1.0f, true, 1.0f, 86400000) == PublishDecision::Suppress);
+    CHECK(ot::decidePublish(quiet, true, true, 1.0f, true, 0.0f, 0) == PublishDecision::Send);
+}
+
+static void testText()
+{
+    std::vector<SensorPolicy> policies;
+    CHECK(ot::parsePolicies("tboiler=0.5,0,5000,600000;pressure=0.1;flame=0,0,0,60000;", policies));
+    CHECK(policies.size() == 3);
+    if (policies.size() == 3) {
+        CHECK(policies[0].id == "tboiler");
+        CHECK((policies[0].policy == PublishPolicy{0.5f, 0.0f, 5000, 600000}));
+        CHECK(policies[1].id == "pressure");
+        CHECK((policies[1].policy == PublishPolicy{0.1f, 0.0f, 0, 0}));
+        CHECK((policies[2].policy == PublishPolicy{0.0f, 0.0f, 0, 60000}));
+    }
+
+    // Round trip through the stored form
+    std::vector<SensorPolicy> again;
+    CHECK(ot::parsePolicies(ot::formatPolicies(policies), again));
+    CHECK(again.size() == policies.size());
+    for (size_t i = 0; i < again.size() && i < policies.size(); i++) {
+        CHECK(again[i].id == policies[i].id);
+        CHECK(again[i].policy == policies[i].policy);
+    }
+
+    CHECK(ot::parsePolicies("", again));
+    CHECK(again.empty());
+
+    // Malformed input leaves the list alone
+    for (const char* bad : {"tboiler", "=1", "tboiler=x", "tboiler=1,2,3,4,5", "tboiler=-1",
+                            "tboiler=1,0,-5", "t\"boiler=1", "tboiler=1;pressure=0.1bar", "tboiler=nan",
+                            "tboiler=0,inf"}) {
+        std::vector<SensorPolicy> kept = policies;
+        if (ot::parsePolicies(bad, kept)) {
+            fprintf(stderr, "  accepted \"%s\"\n", bad);
+            s_failures++;
+        }
+        CHECK(kept.size() == policies.size());
+    }
+}
+
+int main()
+{
+    printf("deadband\n");
+    testDeadband();
+    printf("decision\n");
+    testDecision();
+    printf("text form\n");
+    testText();
+
+    if (s_failures) {
+        printf("FAIL: %d checks\n", s_failures.load());
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
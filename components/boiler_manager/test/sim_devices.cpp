@@ -0,0 +1,405 @@
+// Virtual thermostat and boiler (see sim_devices.h)
+
+#include "sim_devices.h"
+
+#include <algorithm>
+
+#include "rmt_parser.h"
+
+using ot::Frame;
+using ot::MessageType;
+
+namespace {
+
+constexpr uint32_t HALF_BIT_US = 500;
+
+// Boiler and house. A 24 kW modulating boiler (20% minimum) with about
+// 10 l of water, radiators sized for 55 C flow, and a house losing
+// 0.25 kW per kelvin to the outside.
+constexpr float POWER_KW = 24.0f;
+constexpr float MIN_MODULATION = 20.0f;
+constexpr float WATER_KJ_PER_K = 40.0f;
+constexpr float CIRCULATION_KW_PER_K = 0.8f;    // Pump flow * heat capacity
+constexpr float RADIATORS_KW_PER_K = 0.3f;
+constexpr float STANDING_LOSS_KW_PER_K = 0.03f; // Pump off
+constexpr float HOUSE_LOSS_KW_PER_K = 0.25f;
+constexpr float HOUSE_KJ_PER_K = 4000.0f;
+constexpr float BURNER_HYSTERESIS = 5.0f;       // Flow above/below setpoint to stop/restart
+constexpr int64_t PLANT_STEP_US = 1000000;
+
+uint32_t xorshift32(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Returns false if the frame is lost; may put a spike into one pulse
+bool applyFaults(host::Runs& runs, const WireFaults& faults, uint32_t& rng)
+{
+    if (faults.dropPct > 0 && xorshift32(rng) % 100 < faults.dropPct) {
+        return false;
+    }
+    if (faults.glitchPct > 0 && xorshift32(rng) % 100 < faults.glitchPct) {
+        size_t i = xorshift32(rng) % runs.size();
+        host::Run run = runs[i];
+        if (run.us >= HALF_BIT_US) {
+            constexpr uint32_t SPIKE_US = 40;
+            uint32_t before = run.us / 2 - SPIKE_US / 2;
+            host::Run split[3] = {
+                {run.active, before},
+                {!run.active, SPIKE_US},
+                {run.active, run.us - before - SPIKE_US},
+            };
+            runs.erase(runs.begin() + i);
+            runs.insert(runs.begin() + i, split, split + 3);
+        }
+    }
+    return true;
+}
+
+uint16_t toF88(float value)
+{
+    return static_cast<uint16_t>(static_cast<int16_t>(value * 256.0f));
+}
+
+bool isResponse(MessageType type)
+{
+    return type == MessageType::ReadAck || type == MessageType::WriteAck ||
+           type == MessageType::DataInvalid || type == MessageType::UnknownId;
+}
+
+}  // namespace
+
+host::Runs encodeFrame(uint32_t frame)
+{
+    // '1' is active then idle, '0' idle then active; start and stop bits are '1'
+    uint64_t bits = (1ULL << 33) | (static_cast<uint64_t>(frame) << 1) | 1ULL;
+    host::Runs runs;
+    for (int i = 33; i >= 0; i--) {
+        bool bit = (bits >> i) & 1;
+        for (bool active : {bit, !bit}) {
+            if (!runs.empty() && runs.back().active == active) {
+                runs.back().us += HALF_BIT_US;
+            } else {
+                runs.push_back(host::Run{active, HALF_BIT_US});
+            }
+        }
+    }
+    return runs;
+}
+
+uint32_t decodeFrame(const host::Runs& runs)
+{
+    std::vector<rmt_symbol_word_t> symbols = host::captureSymbols(runs);
+    return ot::parseRMTSymbols(symbols.data(), symbols.size());
+}
+
+// Plant
+
+void Plant::start()
+{
+    int64_t next = host::nowUs() + PLANT_STEP_US;
+    host::at(next, [this] {
+        step(PLANT_STEP_US / 1e6f);
+        start();
+    });
+}
+
+Plant::State Plant::state() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return s_;
+}
+
+void Plant::setChEnable(bool enable)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    s_.chEnable = enable;
+}
+
+void Plant::setTSet(float t)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    s_.tSet = t;
+}
+
+void Plant::setMaxRelMod(float pct)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    s_.maxRelMod = pct;
+}
+
+void Plant::step(float dtS)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    State& s = s_;
+
+    // On/off with hysteresis around the setpoint, modulating in between
+    if (s.flame && (!s.chEnable || s.tFlow > s.tSet + BURNER_HYSTERESIS)) {
+        s.flame = false;
+    } else if (!s.flame && s.chEnable && s.tFlow < s.tSet - BURNER_HYSTERESIS) {
+        s.flame = true;
+        s.burnerStarts++;
+    }
+    float maxMod = std::max(MIN_MODULATION, s.maxRelMod);
+    s.modulation = s.flame ? std::min(maxMod, std::max(MIN_MODULATION, MIN_MODULATION + 10.0f * (s.tSet - s.tFlow)))
+                           : 0.0f;
+
+    const bool pump = s.chEnable || s.flame;
+    const float burnerKw = POWER_KW * s.modulation / 100.0f;
+    const float emittedKw = (pump ? RADIATORS_KW_PER_K : STANDING_LOSS_KW_PER_K) * (s.tFlow - s.tRoom);
+    s.tFlow += (burnerKw - emittedKw) * dtS / WATER_KJ_PER_K;
+    s.tReturn = pump ? s.tFlow - emittedKw / CIRCULATION_KW_PER_K : s.tFlow;
+    s.tRoom += (emittedKw - HOUSE_LOSS_KW_PER_K * (s.tRoom - s.tOutside)) * dtS / HOUSE_KJ_PER_K;
+}
+
+// VirtualBoiler
+
+VirtualBoiler::VirtualBoiler(gpio_num_t rxPin, gpio_num_t txPin, Plant& plant, const Config& config) :
+    rxPin_(rxPin),
+    txPin_(txPin),
+    plant_(plant),
+    config_(config),
+    rng_(config.seed ? config.seed : 1)
+{
+}
+
+void VirtualBoiler::start()
+{
+    host::onTransmit(rxPin_, [this](const host::Runs& runs) { onRequest(runs); });
+}
+
+VirtualBoiler::Exchange VirtualBoiler::lastExchange() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return last_;
+}
+
+uint32_t VirtualBoiler::requestsIgnored() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return ignored_;
+}
+
+void VirtualBoiler::onRequest(const host::Runs& runs)
+{
+    const int64_t now = host::nowUs();
+    host::Runs response;
+    uint32_t latencyUs;
+    bool lost;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        host::Runs received = runs;
+        Frame request(applyFaults(received, config_.faults, rng_) ? decodeFrame(received) : 0);
+        if (!request || (request.messageType() != MessageType::ReadData &&
+                         request.messageType() != MessageType::WriteData)) {
+            ignored_++;     // A slave stays silent on frames it cannot use
+            return;
+        }
+
+        response = encodeFrame(respond(request));
+        uint32_t spread = config_.latencyMaxUs > config_.latencyMinUs ? config_.latencyMaxUs - config_.latencyMinUs : 0;
+        latencyUs = config_.latencyMinUs + (spread ? xorshift32(rng_) % (spread + 1) : 0);
+        lost = !applyFaults(response, config_.faults, rng_);
+        last_.request = request.raw();
+        last_.requestRxUs = now;
+        last_.responseEndUs = now + latencyUs + host::durationUs(response);
+    }
+    if (!lost) {
+        host::at(now + latencyUs, [this, response] { host::drive(txPin_, response); });
+    }
+}
+
+uint32_t VirtualBoiler::respond(Frame request)
+{
+    const uint8_t id = request.dataId();
+    const bool write = request.messageType() == MessageType::WriteData;
+    Plant::State s = plant_.state();
+
+    auto ack = [&request](uint16_t value) {
+        MessageType type = request.messageType() == MessageType::WriteData ? MessageType::WriteAck : MessageType::ReadAck;
+        return Frame::buildResponse(type, request.dataId(), value).raw();
+    };
+
+    switch (id) {
+        case 0: {   // Master status in, slave status out
+            bool chEnable = request.highByte() & 0x01;
+            plant_.setChEnable(chEnable);
+            uint8_t slave = (chEnable && s.flame ? 0x02 : 0) | (s.flame ? 0x08 : 0);
+            return ack(static_cast<uint16_t>(request.highByte() << 8 | slave));
+        }
+        case 1:     // Control setpoint
+            if (write) plant_.setTSet(request.asFloat());
+            return ack(request.dataValue());
+        case 14:    // Maximum relative modulation
+            if (write) plant_.setMaxRelMod(request.asFloat());
+            return ack(request.dataValue());
+        case 16:    // Room setpoint
+        case 24:    // Room temperature
+            return ack(request.dataValue());
+        case 3:  return ack(0x0100);                    // Slave config: DHW present, member 0
+        case 5:  return ack(0x0000);                    // No faults
+        case 15: return ack(static_cast<uint16_t>(static_cast<int>(POWER_KW) << 8 | static_cast<int>(MIN_MODULATION)));
+        case 17: return ack(toF88(s.modulation));
+        case 18: return ack(toF88(1.6f));               // CH pressure, bar
+        case 25: return ack(toF88(s.tFlow));
+        case 26: return ack(toF88(48.0f));              // DHW temperature
+        case 28: return ack(toF88(s.tReturn));
+        case 56: return ack(toF88(50.0f));              // DHW setpoint
+        case 57: return ack(toF88(80.0f));              // Max CH setpoint
+        case 116: return ack(static_cast<uint16_t>(s.burnerStarts));
+        case 125: return ack(toF88(2.2f));              // OpenTherm version
+        case 127: return ack(0x0A01);                   // Product type and version
+        default:
+            return Frame::buildResponse(MessageType::UnknownId, id, request.dataValue()).raw();
+    }
+}
+
+// VirtualThermostat
+
+// A modulating room unit's cycle: status on every other poll, the setpoint
+// and the values it displays or logs in between. Writes carry live values.
+static const struct {
+    MessageType type;
+    uint8_t id;
+} POLL_CYCLE[] = {
+    {MessageType::WriteData, 1},    // Control setpoint
+    {MessageType::ReadData, 25},    // Flow temperature
+    {MessageType::ReadData, 17},    // Modulation
+    {MessageType::WriteData, 14},   // Max modulation
+    {MessageType::ReadData, 28},    // Return temperature
+    {MessageType::WriteData, 16},   // Room setpoint
+    {MessageType::WriteData, 24},   // Room temperature
+    {MessageType::ReadData, 5},     // Fault flags
+    {MessageType::ReadData, 18},    // Pressure
+    {MessageType::ReadData, 26},    // DHW temperature
+    {MessageType::ReadData, 3},     // Slave config
+    {MessageType::ReadData, 15},    // Capacity / min modulation
+    {MessageType::ReadData, 56},    // DHW setpoint
+    {MessageType::ReadData, 57},    // Max CH setpoint
+    {MessageType::ReadData, 125},   // OpenTherm version
+    {MessageType::ReadData, 127},   // Product version
+    {MessageType::ReadData, 116},   // Burner starts
+    {MessageType::ReadData, 115},   // OEM diagnostic code (not supported by this boiler)
+};
+
+VirtualThermostat::VirtualThermostat(gpio_num_t txPin, gpio_num_t rxPin, Plant& plant,
+                                     const VirtualBoiler& boiler, const Config& config) :
+    txPin_(txPin),
+    rxPin_(rxPin),
+    plant_(plant),
+    boiler_(boiler),
+    config_(config),
+    rng_(config.seed ? config.seed : 2)
+{
+}
+
+void VirtualThermostat::start(int64_t endUs)
+{
+    host::onTransmit(rxPin_, [this](const host::Runs& runs) { onResponse(runs); });
+    int64_t first = host::nowUs();
+    host::at(first, [this, first, endUs] { poll(first, endUs); });
+}
+
+VirtualThermostat::Stats VirtualThermostat::stats() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return stats_;
+}
+
+Frame VirtualThermostat::nextRequest()
+{
+    const Plant::State s = plant_.state();
+    const float set = config_.roomSetpoint;
+    const size_t slot = slot_++;
+
+    if (slot % 2 == 0) {
+        // CH on below the room setpoint; DHW always enabled
+        uint8_t master = (s.tRoom < set ? 0x01 : 0) | 0x02;
+        return Frame::buildRequest(MessageType::ReadData, 0, static_cast<uint16_t>(master << 8));
+    }
+
+    const auto& entry = POLL_CYCLE[(slot / 2) % (sizeof(POLL_CYCLE) / sizeof(POLL_CYCLE[0]))];
+    uint16_t value = 0;
+    switch (entry.id) {
+        case 1: {
+            // Weather compensation plus a proportional room correction
+            float tSet = set + 1.5f * (set - s.tOutside) + 15.0f * (set - s.tRoom);
+            value = toF88(std::min(75.0f, std::max(10.0f, tSet)));
+            break;
+        }
+        case 14: value = toF88(100.0f); break;
+        case 16: value = toF88(set); break;
+        case 24: value = toF88(s.tRoom); break;
+        default: break;
+    }
+    return Frame::buildRequest(entry.type, entry.id, value);
+}
+
+void VirtualThermostat::closeTransaction()
+{
+    if (pending_) {
+        stats_.timeouts++;
+        pending_ = Frame();
+    }
+}
+
+void VirtualThermostat::poll(int64_t dueUs, int64_t endUs)
+{
+    host::Runs runs;
+    bool lost;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        closeTransaction();
+        if (dueUs >= endUs) {
+            return;
+        }
+        pending_ = nextRequest();
+        runs = encodeFrame(pending_.raw());
+        pendingEndUs_ = host::nowUs() + host::durationUs(runs);
+        stats_.sent++;
+        lost = !applyFaults(runs, config_.faults, rng_);
+        if (lost) {
+            stats_.dropped++;
+        }
+    }
+    if (!lost) {
+        host::drive(txPin_, runs);
+    }
+    int64_t next = dueUs + config_.periodUs;
+    host::at(next, [this, next, endUs] { poll(next, endUs); });
+}
+
+void VirtualThermostat::onResponse(const host::Runs& runs)
+{
+    const int64_t now = host::nowUs();
+    std::lock_guard<std::mutex> lock(lock_);
+    host::Runs received = runs;
+    Frame response(applyFaults(received, config_.faults, rng_) ? decodeFrame(received) : 0);
+    if (!pending_) {
+        stats_.invalid++;   // Late or unsolicited
+        return;
+    }
+    if (!response || !isResponse(response.messageType()) || response.dataId() != pending_.dataId()) {
+        stats_.invalid++;
+        pending_ = Frame();
+        return;
+    }
+
+    stats_.answered++;
+    if (response.messageType() == MessageType::UnknownId) {
+        stats_.unknownId++;
+    }
+    stats_.roundTripUs.push_back(static_cast<uint32_t>(now - pendingEndUs_));
+
+    // Both legs less the gateway's own retransmission of each frame
+    VirtualBoiler::Exchange ex = boiler_.lastExchange();
+    if (ex.request == pending_.raw()) {
+        int64_t frameUs = host::durationUs(encodeFrame(pending_.raw()));
+        int64_t gatewayUs = (ex.requestRxUs - pendingEndUs_) + (now - ex.responseEndUs) - 2 * frameUs;
+        stats_.gatewayUs.push_back(static_cast<uint32_t>(std::max<int64_t>(0, gatewayUs)));
+    }
+    pending_ = Frame();
+}
@@ -0,0 +1,154 @@
+// Virtual thermostat and boiler for the boiler manager simulator
+//
+// Both sit on the far side of the gateway's OpenTherm interfaces and run on
+// the host port's hardware thread (see host/host_port.h). The boiler answers
+// from a lumped thermal model of its water circuit and the house it heats;
+// the thermostat polls it once a second the way a modulating room unit
+// does and times every transaction.
+
+#ifndef SIM_DEVICES_H
+#define SIM_DEVICES_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "host_port.h"
+#include "open_therm_protocol.h"
+
+// Faults applied to every frame between the gateway and a device, in
+// percent of frames
+struct WireFaults {
+    uint32_t dropPct = 0;
+    uint32_t glitchPct = 0;     // 40 us spike inside one pulse
+};
+
+// Manchester line runs of a frame, and back (0 if it does not decode)
+host::Runs encodeFrame(uint32_t frame);
+uint32_t decodeFrame(const host::Runs& runs);
+
+/**
+ * Boiler water circuit and the house it heats, stepped once a second of
+ * simulated time. Shared by both devices: the boiler reads and drives the
+ * water side, the thermostat reads the room.
+ */
+class Plant
+{
+public:
+    struct State {
+        // Set by the thermostat through the boiler
+        bool chEnable = false;
+        float tSet = 0.0f;
+        float maxRelMod = 100.0f;
+
+        float tFlow = 30.0f;
+        float tReturn = 28.0f;
+        float tRoom = 18.5f;
+        float tOutside = 5.0f;
+        float modulation = 0.0f;     // % of maximum power while the flame is on
+        bool flame = false;
+        uint32_t burnerStarts = 0;
+    };
+
+    void start();
+    State state() const;
+    void setChEnable(bool enable);
+    void setTSet(float t);
+    void setMaxRelMod(float pct);
+
+private:
+    void step(float dtS);
+
+    mutable std::mutex lock_;
+    State s_;
+};
+
+class VirtualBoiler
+{
+public:
+    struct Config {
+        uint32_t latencyMinUs = 20000;  // Request received -> response starts
+        uint32_t latencyMaxUs = 100000;
+        WireFaults faults;
+        uint32_t seed = 1;
+    };
+
+    // The gateway transmits to the boiler on rxPin and listens on txPin
+    VirtualBoiler(gpio_num_t rxPin, gpio_num_t txPin, Plant& plant, const Config& config);
+    void start();
+
+    // Timestamps of the last request answered, for the thermostat's
+    // gateway delay figures
+    struct Exchange {
+        uint32_t request = 0;
+        int64_t requestRxUs = 0;        // Request fully received
+        int64_t responseEndUs = 0;      // Response fully sent
+    };
+    Exchange lastExchange() const;
+    uint32_t requestsIgnored() const;
+
+private:
+    void onRequest(const host::Runs& runs);
+    uint32_t respond(ot::Frame request);
+
+    const gpio_num_t rxPin_;
+    const gpio_num_t txPin_;
+    Plant& plant_;
+    const Config config_;
+
+    mutable std::mutex lock_;
+    uint32_t rng_;
+    Exchange last_;
+    uint32_t ignored_ = 0;          // Lost or undecodable requests
+};
+
+class VirtualThermostat
+{
+public:
+    struct Config {
+        uint32_t periodUs = 1000000;
+        float roomSetpoint = 20.0f;
+        WireFaults faults;
+        uint32_t seed = 2;
+    };
+
+    struct Stats {
+        uint32_t sent = 0;
+        uint32_t answered = 0;      // Decoded response matching the request
+        uint32_t unknownId = 0;     // ... of which UNKNOWN_DATA_ID
+        uint32_t invalid = 0;       // Undecodable, or not a response to the request
+        uint32_t timeouts = 0;      // No response before the next poll
+        uint32_t dropped = 0;       // Requests lost on the wire (fault injection)
+        std::vector<uint32_t> roundTripUs;      // Request sent -> response received
+        std::vector<uint32_t> gatewayUs;        // Of which spent in the gateway
+    };
+
+    // The thermostat transmits on txPin (the gateway's thermostat-side RX)
+    // and listens on rxPin
+    VirtualThermostat(gpio_num_t txPin, gpio_num_t rxPin, Plant& plant, const VirtualBoiler& boiler,
+                      const Config& config);
+    // Poll until simulated time endUs
+    void start(int64_t endUs);
+    Stats stats() const;
+
+private:
+    void poll(int64_t dueUs, int64_t endUs);
+    void onResponse(const host::Runs& runs);
+    ot::Frame nextRequest();
+    void closeTransaction();
+
+    const gpio_num_t txPin_;
+    const gpio_num_t rxPin_;
+    Plant& plant_;
+    const VirtualBoiler& boiler_;
+    const Config config_;
+
+    mutable std::mutex lock_;
+    uint32_t rng_;
+    size_t slot_ = 0;
+    ot::Frame pending_;             // Request awaiting its response
+    int64_t pendingEndUs_ = 0;      // When it left the wire
+    Stats stats_;
+};
+
+#endif // SIM_DEVICES_H
@@ -0,0 +1,223 @@
+// 24-hour bus soak on a virtual clock
+//
+// A master polls a slave once a second over SimBus for a simulated day,
+// with the slave going silent for ten minutes every six hours, a fraction
+// of frames corrupted on the wire, and the MQTT heartbeat pausing twice.
+// The bus clock is installed with ot::setClock(), so DiagnosticValue ages
+// and MqttState heartbeat expiry run on the same time as the bus
+// timeouts. Checks that every outage shows up as timeouts, stale
+// diagnostics and an expired heartbeat, and that all three recover.
+//
+//   soak_test [--hours=H] [--corrupt=PERMILLE]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "boiler_manager.hpp"
+#include "mqtt_bridge.hpp"
+#include "sim_bus.h"
+#include "check.h"
+
+using ot::DiagnosticValue;
+using ot::MqttState;
+using ot::OpenThermMessageID;
+using ot::OpenThermMessageType;
+using ot::OpenThermProtocol;
+using ot::OpenThermResponseStatus;
+using std::chrono::milliseconds;
+
+static constexpr uint64_t SECOND_US = 1000000;
+static constexpr uint64_t HOUR_US = 3600 * SECOND_US;
+static constexpr uint64_t BOILER_OUTAGE_US = 600 * SECOND_US;    // From 3 h, every 6 h
+static constexpr uint64_t MQTT_OUTAGE_US = 300 * SECOND_US;      // From 1 h, every 12 h
+static constexpr uint64_t HEARTBEAT_PERIOD_US = 30 * SECOND_US;
+
+static uint32_t xorshift32(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static bool inWindow(uint64_t t, uint64_t firstUs, uint64_t periodUs, uint64_t lengthUs)
+{
+    return t >= firstUs && (t - firstUs) % periodUs < lengthUs;
+}
+
+int main(int argc, char** argv)
+{
+    long hours = 24;
+    long corruptPermille = 5;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--hours=", 8) == 0) {
+            hours = strtol(argv[i] + 8, nullptr, 10);
+        } else if (strncmp(argv[i], "--corrupt=", 10) == 0) {
+            corruptPermille = strtol(argv[i] + 10, nullptr, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--hours=H] [--corrupt=PERMILLE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    SimBus bus;
+    // Start past zero: a zero timestamp means "never" to the age checks
+    bus.runUntil(SECOND_US);
+    ot::setClock(&bus.clock());
+    bus.begin();
+
+    uint32_t rng = 0x9E3779B9;
+    bus.setFault([&rng, corruptPermille](const SimNode&, uint32_t) {
+        return static_cast<long>(xorshift32(rng) % 1000) < corruptPermille ? SimBus::Fault::Corrupt
+                                                                            : SimBus::Fault::None;
+    });
+
+    auto boilerDown = [](uint64_t t) { return inWindow(t, 3 * HOUR_US, 6 * HOUR_US, BOILER_OUTAGE_US); };
+    auto brokerDown = [](uint64_t t) { return inWindow(t, 1 * HOUR_US, 12 * HOUR_US, MQTT_OUTAGE_US); };
+
+    SimNode& master = bus.master();
+    SimNode& slave = bus.slave();
+    DiagnosticValue tBoiler;
+    MqttState mqtt;
+    mqtt.connected = true;
+
+    uint64_t polls = 0, skipped = 0, success = 0, timeouts = 0, invalid = 0;
+    uint64_t outagePolls = 0, outageTimeouts = 0;
+    uint64_t heartbeats = 0, expiries = 0;
+    int64_t maxAgeUp = 0, maxAgeDown = 0;   // tBoiler age (ms) outside / at the end of outages
+    uint64_t lastDownUs = 0;
+    bool sawOutage = false, wasFresh = false;
+    bool requestDuringOutage = false;
+
+    const uint64_t startUs = bus.now();
+    auto respond = [&](unsigned long request, OpenThermResponseStatus status) {
+        if (status != OpenThermResponseStatus::SUCCESS || boilerDown(bus.now() - startUs)) {
+            return;
+        }
+        slave.sendResponse(OpenThermProtocol::buildResponse(
+            OpenThermMessageType::READ_ACK, OpenThermProtocol::getDataID(request), 0x3780));  // 55.5 C
+    };
+    auto complete = [&](unsigned long response, OpenThermResponseStatus status) {
+        switch (status) {
+            case OpenThermResponseStatus::SUCCESS:
+                success++;
+                if (OpenThermProtocol::getDataID(response) == OpenThermMessageID::Tboiler) {
+                    tBoiler.update(OpenThermProtocol::getFloat(response));
+                }
+                break;
+            case OpenThermResponseStatus::TIMEOUT:
+                timeouts++;
+                if (requestDuringOutage) outageTimeouts++;
+                break;
+            case OpenThermResponseStatus::INVALID:
+                invalid++;
+                break;
+            default:
+                break;
+        }
+    };
+
+    static const OpenThermMessageID CYCLE[] = {
+        OpenThermMessageID::Tboiler, OpenThermMessageID::RelModLevel, OpenThermMessageID::Tret,
+    };
+
+    const uint64_t endUs = startUs + static_cast<uint64_t>(hours) * HOUR_US;
+    uint64_t nextHeartbeat = startUs;
+    auto wall0 = std::chrono::steady_clock::now();
+
+    for (uint64_t second = startUs; second < endUs; second += SECOND_US) {
+        const uint64_t t = second - startUs;
+        const bool down = boilerDown(t);
+
+        // Thermostat poll
+        if (master.isReady()) {
+            unsigned long request = OpenThermProtocol::buildRequest(
+                OpenThermMessageType::READ_DATA, CYCLE[polls % 3], 0);
+            if (master.sendRequestAsync(request)) {
+                polls++;
+                requestDuringOutage = down;
+                if (down) outagePolls++;
+            }
+        } else {
+            skipped++;      // Still waiting out a timeout
+        }
+
+        // MQTT heartbeat from the home automation side
+        if (second >= nextHeartbeat) {
+            if (!brokerDown(t)) {
+                mqtt.heartbeatValue = static_cast<float>(heartbeats++);
+                mqtt.lastHeartbeatTime = ot::clockMs();
+            }
+            nextHeartbeat += HEARTBEAT_PERIOD_US;
+        }
+
+        while (bus.now() < second + SECOND_US) {
+            bus.advance(second + SECOND_US);
+            slave.process(respond);
+            master.process(complete);
+        }
+
+        // Once a second: diagnostic age and heartbeat freshness
+        const milliseconds now = ot::clockMs();
+        const int64_t age = tBoiler.age(now).count();
+        if (down) {
+            maxAgeDown = std::max(maxAgeDown, age);
+            lastDownUs = t;
+            sawOutage = true;
+        } else if (!sawOutage || t - lastDownUs > 10 * SECOND_US) {
+            maxAgeUp = std::max(maxAgeUp, age);
+        }
+        const bool fresh = mqtt.heartbeatFresh(now);
+        if (wasFresh && !fresh) {
+            expiries++;
+            // Expired once the timeout passed, not before
+            CHECK(now - mqtt.lastHeartbeatTime > MqttState::HEARTBEAT_TIMEOUT);
+            CHECK(now - mqtt.lastHeartbeatTime <= MqttState::HEARTBEAT_TIMEOUT + milliseconds(1000));
+        }
+        wasFresh = fresh;
+    }
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall0).count();
+    ot::setClock(nullptr);
+
+    const uint64_t boilerOutages = hours > 3 ? (hours - 3 + 5) / 6 : 0;
+    const uint64_t mqttOutages = hours > 1 ? (hours - 1 + 11) / 12 : 0;
+    ot::BusStats stats = master.busStats();
+
+    printf("Simulated %ld h in %.0f ms\n", hours, wallMs);
+    printf("Polls: %llu (%llu skipped while timing out), success %llu, timeouts %llu, invalid %llu\n",
+           (unsigned long long)polls, (unsigned long long)skipped, (unsigned long long)success,
+           (unsigned long long)timeouts, (unsigned long long)invalid);
+    printf("Boiler outages: %llu, %llu polls during them, %llu timed out\n",
+           (unsigned long long)boilerOutages, (unsigned long long)outagePolls, (unsigned long long)outageTimeouts);
+    printf("Tboiler age: max %lld ms while answering, %lld ms at the end of an outage\n",
+           (long long)maxAgeUp, (long long)maxAgeDown);
+    printf("MQTT heartbeats: %llu, expiries %llu (outages %llu)\n",
+           (unsigned long long)heartbeats, (unsigned long long)expiries, (unsigned long long)mqttOutages);
+
+    // Every poll during an outage times out; outside them only corruption fails
+    CHECK(outageTimeouts == outagePolls);
+    CHECK(success + timeouts + invalid == polls || success + timeouts + invalid + 1 == polls);
+    CHECK(stats.timeouts == timeouts);
+    if (corruptPermille == 0) {
+        CHECK(timeouts == outageTimeouts);
+        CHECK(invalid == 0);
+    }
+    // Tboiler is read every third poll (a few seconds, more when a read is
+    // corrupted); stale only across an outage
+    CHECK(maxAgeUp <= 15000);
+    if (boilerOutages > 0) {
+        CHECK(maxAgeDown >= static_cast<int64_t>(BOILER_OUTAGE_US / 1000) - 5000);
+        CHECK(maxAgeDown <= static_cast<int64_t>(BOILER_OUTAGE_US / 1000) + 10000);
+    }
+    CHECK(expiries == mqttOutages);
+
+    if (s_failures) {
+        printf("FAIL: %d checks\n", s_failures.load());
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,473 @@
+// Frame trace replay
+//
+// Feeds a capture downloaded from /api/trace (or written by boiler_sim
+// --trace-out) back through the unmodified BoilerManager on the host port.
+// A scripted thermostat sends the recorded requests at their recorded
+// times; a scripted boiler answers each forwarded request with the recorded
+// response after the recorded delay, or stays silent where the boiler timed
+// out. The manager's own trace of the replay must reproduce the capture
+// record for record, so a change in how the gateway handles real traffic
+// shows up as the first record that differs. Latency and CPU are reported
+// as boiler_sim does.
+//
+//   trace_replay [--speed=X] [--max-gap=S] [-v] FILE
+//   trace_replay --dump FILE
+//
+// Idle stretches longer than --max-gap (default 5 s) are shortened to it.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boiler_manager.hpp"
+#include "frame_trace.h"
+#include "host_port.h"
+#include "open_therm.h"
+#include "sim_devices.h"
+
+using ot::BoilerManager;
+using ot::Frame;
+using ot::ManagerConfig;
+using ot::MessageSource;
+using ot::OpenThermProtocol;
+using ot::TraceEvent;
+using ot::TraceFileHeader;
+using ot::TraceRecord;
+
+static const char* TAG = "trace_replay";
+
+// A parsed capture. Gap records are folded into the times and dropped.
+struct Capture {
+    TraceFileHeader header = {};
+    std::vector<TraceRecord> records;
+    std::vector<int64_t> timesUs;       // Recording device's clockUs()
+};
+
+static bool parseCapture(const std::vector<uint8_t>& bytes, Capture& capture, std::string& error)
+{
+    if (bytes.size() < sizeof(TraceFileHeader)) {
+        error = "too short for a trace header";
+        return false;
+    }
+    memcpy(&capture.header, bytes.data(), sizeof(TraceFileHeader));
+    const TraceFileHeader& h = capture.header;
+    if (h.magic != TraceFileHeader::MAGIC) {
+        error = "not a frame trace (bad magic)";
+        return false;
+    }
+    if (h.version != TraceFileHeader::VERSION || h.recordSize != sizeof(TraceRecord)) {
+        error = "unsupported trace version " + std::to_string(h.version) + " / record size " +
+                std::to_string(h.recordSize);
+        return false;
+    }
+    if (bytes.size() - sizeof(TraceFileHeader) < static_cast<size_t>(h.recordCount) * sizeof(TraceRecord)) {
+        error = "truncated: header announces " + std::to_string(h.recordCount) + " records";
+        return false;
+    }
+
+    int64_t t = h.firstUs;
+    const uint8_t* p = bytes.data() + sizeof(TraceFileHeader);
+    for (uint32_t i = 0; i < h.recordCount; i++, p += sizeof(TraceRecord)) {
+        TraceRecord r;
+        memcpy(&r, p, sizeof(r));
+        if (i > 0) {
+            t += r.deltaUs;
+        }
+        if (r.event == TraceEvent::Gap) {
+            t += static_cast<int64_t>(r.frame) << 32;
+            continue;
+        }
+        capture.records.push_back(r);
+        capture.timesUs.push_back(t);
+    }
+    return true;
+}
+
+static bool loadCapture(const char* path, Capture& capture)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+    std::vector<uint8_t> bytes;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        bytes.insert(bytes.end(), buf, buf + n);
+    }
+    fclose(f);
+
+    std::string error;
+    if (!parseCapture(bytes, capture, error)) {
+        fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+static const char* sourceName(uint8_t source)
+{
+    switch (static_cast<MessageSource>(source)) {
+        case MessageSource::ThermostatBoiler:  return "thermostat-boiler";
+        case MessageSource::GatewayBoiler:     return "gateway-boiler";
+        case MessageSource::ThermostatGateway: return "thermostat-gateway";
+        default:                               return "?";
+    }
+}
+
+static void printRecord(const char* prefix, size_t index, const TraceRecord& r)
+{
+    Frame frame(r.frame);
+    printf("%s#%zu %-17s %-18s 0x%08" PRIx32 " %-12s id %3u value 0x%04x  %s\n",
+           prefix, index, ot::toString(r.event), sourceName(r.source), r.frame,
+           ot::toString(frame.messageType()), frame.dataId(), frame.dataValue(),
+           OpenThermProtocol::statusToString(static_cast<ot::OpenThermResponseStatus>(r.status)));
+}
+
+static int dump(const Capture& capture)
+{
+    const TraceFileHeader& h = capture.header;
+    printf("%u records (%zu frames), %u overwritten before the download, first at %.6f s\n",
+           h.recordCount, capture.records.size(), h.overwritten, h.firstUs / 1e6);
+    for (size_t i = 0; i < capture.records.size(); i++) {
+        const int64_t t = capture.timesUs[i];
+        char wall[40] = "";
+        if (h.wallOffsetUs) {
+            int64_t unixUs = t + h.wallOffsetUs;
+            time_t s = static_cast<time_t>(unixUs / 1000000);
+            struct tm tm;
+            gmtime_r(&s, &tm);
+            size_t len = strftime(wall, sizeof(wall), "%Y-%m-%d %H:%M:%S", &tm);
+            snprintf(wall + len, sizeof(wall) - len, ".%03d UTC  ", static_cast<int>(unixUs % 1000000 / 1000));
+        }
+        char prefix[80];
+        snprintf(prefix, sizeof(prefix), "%12.6f  %s", t / 1e6, wall);
+        printRecord(prefix, i, capture.records[i]);
+    }
+    return 0;
+}
+
+static void printPercentiles(const char* name, std::vector<uint32_t> us)
+{
+    if (us.empty()) {
+        printf("  %-12s (none)\n", name);
+        return;
+    }
+    std::sort(us.begin(), us.end());
+    auto pct = [&us](double p) { return us[std::min(us.size() - 1, static_cast<size_t>(p * us.size()))] / 1000.0; };
+    printf("  %-12s p50 %7.1f  p90 %7.1f  p99 %7.1f  max %7.1f ms  (n=%zu)\n",
+           name, pct(0.50), pct(0.90), pct(0.99), us.back() / 1000.0, us.size());
+}
+
+// Request decoded -> boiler response decoded, as the gateway timed it
+static std::vector<uint32_t> exchangeTimes(const Capture& capture)
+{
+    std::vector<uint32_t> us;
+    for (size_t i = 0; i + 1 < capture.records.size(); i++) {
+        if (capture.records[i].event == TraceEvent::Request &&
+            capture.records[i + 1].event == TraceEvent::Response) {
+            us.push_back(static_cast<uint32_t>(capture.timesUs[i + 1] - capture.timesUs[i]));
+        }
+    }
+    return us;
+}
+
+static bool sameRecord(const TraceRecord& a, const TraceRecord& b)
+{
+    return a.event == b.event && a.source == b.source && a.frame == b.frame && a.status == b.status;
+}
+
+// What the scripted devices do, on the replay's compressed time line
+struct Script {
+    struct Send {
+        int64_t atUs;               // Decoded by the gateway, relative to the start
+        uint32_t frame;
+    };
+    struct Answer {
+        uint32_t request;
+        uint32_t response;          // 0: stay silent
+        uint32_t delayUs;           // Forwarded request fully received -> response starts
+    };
+    std::vector<Send> thermostat;
+    std::vector<Answer> boiler;
+    std::vector<TraceRecord> expected;
+    int64_t endUs = 0;
+};
+
+static Script buildScript(const Capture& capture, int64_t maxGapUs, uint32_t frameUs)
+{
+    Script script;
+    size_t start = 0;
+    // A capture cut by the ring starts wherever; begin at a request
+    while (start < capture.records.size() && capture.records[start].event != TraceEvent::Request &&
+           capture.records[start].event != TraceEvent::DiscardedRequest) {
+        start++;
+    }
+
+    int64_t rel = 0;
+    std::vector<int64_t> relUs(capture.records.size(), 0);
+    for (size_t i = start; i < capture.records.size(); i++) {
+        if (i > start) {
+            rel += std::min(capture.timesUs[i] - capture.timesUs[i - 1], maxGapUs);
+        }
+        relUs[i] = rel;
+    }
+
+    for (size_t i = start; i < capture.records.size(); i++) {
+        const TraceRecord& r = capture.records[i];
+        script.expected.push_back(r);
+        if (r.source != static_cast<uint8_t>(MessageSource::ThermostatBoiler)) {
+            continue;
+        }
+        if (r.event == TraceEvent::Request || r.event == TraceEvent::DiscardedRequest) {
+            script.thermostat.push_back({relUs[i], r.frame});
+        }
+        if (r.event != TraceEvent::Request) {
+            continue;
+        }
+        // The gateway retransmits the request, the boiler waits, then its
+        // response has to come in whole before it is recorded
+        Script::Answer answer = {r.frame, 0, 0};
+        if (i + 1 < capture.records.size() && capture.records[i + 1].event == TraceEvent::Response) {
+            int64_t delay = relUs[i + 1] - relUs[i] - 2 * static_cast<int64_t>(frameUs);
+            answer.response = capture.records[i + 1].frame;
+            answer.delayUs = static_cast<uint32_t>(std::max<int64_t>(delay, 0));
+        }
+        script.boiler.push_back(answer);
+    }
+    script.endUs = rel;
+    return script;
+}
+
+// The far ends of both interfaces, playing the script
+class ScriptedDevices
+{
+public:
+    ScriptedDevices(const ManagerConfig& config, const Script& script) : config_(config), script_(script) {}
+
+    void start(int64_t baseUs, uint32_t frameUs)
+    {
+        host::onTransmit(config_.boilerOutPin, [this](const host::Runs& runs) { onForwarded(runs); });
+        host::onTransmit(config_.thermostatOutPin, [this](const host::Runs& runs) { onResponse(runs); });
+        for (const Script::Send& send : script_.thermostat) {
+            // Sent so that it finishes when it was decoded in the capture
+            host::Runs runs = encodeFrame(send.frame);
+            host::at(baseUs + send.atUs - frameUs, [this, runs] {
+                {
+                    std::lock_guard<std::mutex> lock(lock_);
+                    sentEndUs_ = host::nowUs() + host::durationUs(runs);
+                }
+                host::drive(config_.thermostatInPin, runs);
+            });
+        }
+    }
+
+    struct Stats {
+        uint32_t forwarded = 0;
+        uint32_t unexpected = 0;    // Forwarded past the end of the script
+        uint32_t mismatched = 0;    // Forwarded something other than the recorded request
+        uint32_t responses = 0;     // Reached the thermostat
+        std::vector<uint32_t> roundTripUs;
+    };
+    Stats stats() const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return stats_;
+    }
+
+private:
+    void onForwarded(const host::Runs& runs)
+    {
+        const int64_t now = host::nowUs();
+        const uint32_t frame = decodeFrame(runs);
+        Script::Answer answer;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            stats_.forwarded++;
+            if (next_ >= script_.boiler.size()) {
+                stats_.unexpected++;
+                return;
+            }
+            answer = script_.boiler[next_++];
+            if (frame != answer.request) {
+                stats_.mismatched++;
+            }
+        }
+        if (answer.response) {
+            host::Runs response = encodeFrame(answer.response);
+            host::at(now + answer.delayUs, [this, response] { host::drive(config_.boilerInPin, response); });
+        }
+    }
+
+    void onResponse(const host::Runs&)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stats_.responses++;
+        stats_.roundTripUs.push_back(static_cast<uint32_t>(host::nowUs() - sentEndUs_));
+    }
+
+    const ManagerConfig& config_;
+    const Script& script_;
+    mutable std::mutex lock_;
+    size_t next_ = 0;
+    int64_t sentEndUs_ = 0;
+    Stats stats_;
+};
+
+int main(int argc, char** argv)
+{
+    double speed = 20.0;
+    double maxGapS = 5.0;
+    bool dumpOnly = false;
+    bool verbose = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--speed=", 8) == 0) {
+            speed = strtod(argv[i] + 8, nullptr);
+        } else if (strncmp(argv[i], "--max-gap=", 10) == 0) {
+            maxGapS = strtod(argv[i] + 10, nullptr);
+        } else if (strcmp(argv[i], "--dump") == 0) {
+            dumpOnly = true;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr,
+                "usage: %s [--speed=X] [--max-gap=S] [-v] FILE\n"
+                "       %s --dump FILE\n",
+                argv[0], argv[0]);
+        return 2;
+    }
+    // Leave room for the boiler's recorded delays and a timeout
+    if (speed <= 0 || maxGapS < 1.0) {
+        fprintf(stderr, "invalid arguments\n");
+        return 2;
+    }
+
+    Capture capture;
+    if (!loadCapture(path, capture)) {
+        return 2;
+    }
+    if (dumpOnly) {
+        return dump(capture);
+    }
+
+    const uint32_t frameUs = host::durationUs(encodeFrame(0));
+    const Script script = buildScript(capture, static_cast<int64_t>(maxGapS * 1e6), frameUs);
+    if (script.thermostat.empty()) {
+        fprintf(stderr, "%s: no requests to replay\n", path);
+        return 2;
+    }
+
+    // The recorded boiler timeouts are replayed too; only -v shows them
+    esp_log_level_set("*", verbose ? ESP_LOG_INFO : ESP_LOG_ERROR);
+    host::setSpeed(speed);
+
+    ManagerConfig config;
+    // Nothing of the replay may be overwritten before it is compared
+    config.traceRecords = std::max<size_t>(config.traceRecords, 2 * capture.header.recordCount + 64);
+    BoilerManager manager(config);
+    if (manager.start() != ESP_OK) {
+        ESP_LOGE(TAG, "BoilerManager failed to start");
+        return 1;
+    }
+
+    ScriptedDevices devices(config, script);
+    // Give the manager's tasks a moment to arm their receivers
+    const int64_t baseUs = host::nowUs() + 100000 + frameUs;
+    devices.start(baseUs, frameUs);
+
+    // Past the last record by more than a boiler timeout
+    const int64_t endUs = baseUs + script.endUs + 2000000;
+    auto wallStart = std::chrono::steady_clock::now();
+    while (host::nowUs() < endUs) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    std::vector<uint8_t> bytes;
+    manager.frameTrace().exportTo([&bytes](const void* data, size_t len) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), p, p + len);
+        return true;
+    });
+    ScriptedDevices::Stats stats = devices.stats();
+    std::vector<host::TaskCpu> cpu = host::taskCpu();
+    manager.stop();
+
+    Capture replay;
+    std::string error;
+    if (!parseCapture(bytes, replay, error)) {
+        fprintf(stderr, "replay trace: %s\n", error.c_str());
+        std::_Exit(1);
+    }
+
+    printf("Replayed %zu records (%.0f s recorded, %.0f s replayed) in %.1f s (x%.1f)\n",
+           script.expected.size(), (capture.timesUs.back() - capture.timesUs.front()) / 1e6,
+           (script.endUs + 2000000) / 1e6, wallS, speed);
+    printf("  %zu requests sent, %u forwarded (%u unexpected, %u not the recorded request), "
+           "%u responses back\n",
+           script.thermostat.size(), stats.forwarded, stats.unexpected, stats.mismatched, stats.responses);
+
+    printf("\nGateway request -> boiler response\n");
+    printPercentiles("recorded", exchangeTimes(capture));
+    printPercentiles("replayed", exchangeTimes(replay));
+    printPercentiles("round trip", stats.roundTripUs);
+
+    printf("\nCPU (host)\n");
+    uint32_t transactions = std::max<uint32_t>(1, static_cast<uint32_t>(script.thermostat.size()));
+    for (const char* name : {"bm_main", "ot_rmt_monitor", "ot_bus_log"}) {
+        for (const host::TaskCpu& task : cpu) {
+            if (task.name != name) continue;
+            printf("  %-16s %8.1f ms  %6.1f us/transaction  %5.2f%% of a core\n",
+                   name, task.cpuUs / 1000.0, static_cast<double>(task.cpuUs) / transactions,
+                   wallS > 0 ? task.cpuUs / (wallS * 1e4) : 0.0);
+        }
+    }
+
+    // Record for record, ignoring timing; the replay may run on past the
+    // end of the capture (a request whose response was not recorded yet)
+    int rc = 0;
+    const std::vector<TraceRecord>& expected = script.expected;
+    const std::vector<TraceRecord>& got = replay.records;
+    size_t i = 0;
+    while (i < expected.size() && i < got.size() && sameRecord(expected[i], got[i])) {
+        i++;
+    }
+    printf("\n");
+    if (i < expected.size()) {
+        printf("FAIL: replay differs at record %zu of %zu\n", i, expected.size());
+        printRecord("  recorded ", i, expected[i]);
+        if (i < got.size()) {
+            printRecord("  replayed ", i, got[i]);
+        } else {
+            printf("  replayed #%zu (none)\n", i);
+        }
+        rc = 1;
+    } else {
+        printf("OK: %zu records reproduced", expected.size());
+        if (got.size() > expected.size()) {
+            printf(", %zu more after the end of the capture", got.size() - expected.size());
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+    fflush(stderr);
+    // Task threads are detached and never joined
+    std::_Exit(rc);
+}
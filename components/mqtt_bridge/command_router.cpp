@@ -0,0 +1,166 @@
+/*
+ * MQTT command router (see command_router.h)
+ */
+
+#include "command_router.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace ot {
+
+static constexpr char SET_SUFFIX[] = "/set";
+static constexpr size_t SET_SUFFIX_LEN = sizeof(SET_SUFFIX) - 1;
+
+void CommandRouter::setBase(const std::string& base)
+{
+    prefix_ = base + "/";
+    filter_ = prefix_ + "+" + SET_SUFFIX;
+}
+
+// FNV-1a
+uint32_t CommandRouter::hash(const char* s, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ static_cast<uint8_t>(s[i])) * 16777619u;
+    }
+    return h;
+}
+
+const CommandRouter::Command* CommandRouter::find(const char* name, size_t len) const
+{
+    for (size_t i = hash(name, len) & (SLOTS - 1);; i = (i + 1) & (SLOTS - 1)) {
+        const Command& c = slots_[i];
+        if (!c.name) {
+            return nullptr;
+        }
+        if (c.nameLen == len && memcmp(c.name, name, len) == 0) {
+            return &c;
+        }
+    }
+}
+
+bool CommandRouter::add(const char* name, Handler handler, void* context)
+{
+    if (!name || !handler || count_ >= MAX_COMMANDS) {
+        return false;
+    }
+    const size_t len = strlen(name);
+    if (len == 0 || memchr(name, '/', len) || find(name, len)) {
+        return false;
+    }
+    size_t i = hash(name, len) & (SLOTS - 1);
+    while (slots_[i].name) {
+        i = (i + 1) & (SLOTS - 1);
+    }
+    slots_[i] = Command{name, len, handler, context};
+    count_++;
+    return true;
+}
+
+bool CommandRouter::dispatch(const char* topic, size_t topicLen, const char* payload, size_t len) const
+{
+    const size_t prefixLen = prefix_.size();
+    if (!topic || topicLen <= prefixLen + SET_SUFFIX_LEN ||
+        memcmp(topic, prefix_.data(), prefixLen) != 0 ||
+        memcmp(topic + topicLen - SET_SUFFIX_LEN, SET_SUFFIX, SET_SUFFIX_LEN) != 0) {
+        return false;
+    }
+    const Command* c = find(topic + prefixLen, topicLen - prefixLen - SET_SUFFIX_LEN);
+    if (!c) {
+        return false;
+    }
+    c->handler(c->context, payload, len);
+    return true;
+}
+
+bool parseBusTopic(const std::string& prefix, const char* topic, size_t len, BusCommand& command)
+{
+    if (!topic || len <= prefix.size() || memcmp(topic, prefix.data(), prefix.size()) != 0) {
+        return false;
+    }
+    const char* p = topic + prefix.size();
+    const char* end = topic + len;
+    unsigned id = 0;
+    size_t digits = 0;
+    for (; p < end && *p >= '0' && *p <= '9' && digits < 3; p++, digits++) {
+        id = id * 10 + static_cast<unsigned>(*p - '0');
+    }
+    if (digits == 0 || id > 255 || p == end || *p++ != '/') {
+        return false;
+    }
+    const size_t rest = static_cast<size_t>(end - p);
+    if (rest == 4 && memcmp(p, "read", 4) == 0) {
+        command.write = false;
+    } else if (rest == 5 && memcmp(p, "write", 5) == 0) {
+        command.write = true;
+    } else {
+        return false;
+    }
+    command.dataId = static_cast<uint8_t>(id);
+    return true;
+}
+
+// The whole of s as a number in [min, max]
+static bool parseLong(const char* s, int base, long min, long max, long& out)
+{
+    if (!*s) {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    long v = strtol(s, &end, base);
+    if (errno || *end || v < min || v > max) {
+        return false;
+    }
+    out = v;
+    return true;
+}
+
+bool parseBusPayload(const char* payload, size_t len, BusCommand& command)
+{
+    char buf[32];
+    if (len >= sizeof(buf) || (len && !payload)) {
+        return false;
+    }
+    if (len) {
+        memcpy(buf, payload, len);
+    }
+    buf[len] = '\0';
+
+    char* tag = strchr(buf, ',');
+    if (command.write) {
+        if (tag) {
+            *tag++ = '\0';
+        }
+        long v = 0;
+        if (strchr(buf, '.')) {
+            char* end = nullptr;
+            float f = strtof(buf, &end);
+            if (*end || end == buf || f < -128.0f || f >= 128.0f) {
+                return false;
+            }
+            command.value = static_cast<uint16_t>(static_cast<int16_t>(f * 256.0f));
+        } else if ((buf[0] == '0' && (buf[1] == 'x' || buf[1] == 'X') && parseLong(buf + 2, 16, 0, 0xFFFF, v)) ||
+                   parseLong(buf, 10, -32768, 65535, v)) {
+            command.value = static_cast<uint16_t>(v);
+        } else {
+            return false;
+        }
+    } else {
+        if (tag) {
+            return false;
+        }
+        tag = buf[0] ? buf : nullptr;
+    }
+
+    long t = 0;
+    if (tag && !parseLong(tag, 10, 0, 0x7FFFFFFF, t)) {
+        return false;
+    }
+    command.tag = static_cast<uint32_t>(t);
+    return true;
+}
+
+} // namespace ot
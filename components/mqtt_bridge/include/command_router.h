@@ -0,0 +1,92 @@
+/*
+ * MQTT command router
+ *
+ * The bridge subscribes once to <base>/+/set; this maps each inbound
+ * topic to its command by the name between the base and "/set", through
+ * a small hash table filled when the bridge is set up. Routing compares
+ * the topic in place: nothing is copied or allocated per message, and
+ * the cost does not grow with the number of commands. Also parses the
+ * raw <base>/ot/<id>/read|write bus commands. No IDF dependencies; the
+ * host tests build it as is.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ot {
+
+class CommandRouter {
+public:
+    static constexpr size_t MAX_COMMANDS = 16;
+
+    // Called with the message payload, which is not NUL-terminated
+    using Handler = void (*)(void* context, const char* payload, size_t len);
+
+    // Topics are <base>/<name>/set
+    void setBase(const std::string& base);
+    const std::string& filter() const { return filter_; }   // <base>/+/set
+
+    /**
+     * Route <base>/<name>/set to handler. name is kept by pointer and must
+     * be a string literal. Returns false when name is empty, contains '/',
+     * is already added, or the table is full.
+     */
+    bool add(const char* name, Handler handler, void* context);
+
+    /**
+     * Call the handler for topic. Returns false, calling nothing, when the
+     * topic is not a command topic or names no added command.
+     */
+    bool dispatch(const char* topic, size_t topicLen, const char* payload, size_t len) const;
+
+    size_t size() const { return count_; }
+
+private:
+    static constexpr size_t SLOTS = 32;     // Power of two, at most half full
+    static_assert(SLOTS >= 2 * MAX_COMMANDS, "keep probe chains short");
+
+    struct Command {
+        const char* name = nullptr;
+        size_t nameLen = 0;
+        Handler handler = nullptr;
+        void* context = nullptr;
+    };
+
+    static uint32_t hash(const char* s, size_t len);
+    const Command* find(const char* name, size_t len) const;
+
+    std::string prefix_;                    // <base>/
+    std::string filter_;
+    Command slots_[SLOTS];
+    size_t count_ = 0;
+};
+
+/**
+ * A raw OpenTherm request from <base>/ot/<id>/read or <base>/ot/<id>/write
+ */
+struct BusCommand {
+    uint8_t dataId = 0;
+    bool write = false;
+    uint16_t value = 0;     // Write only
+    uint32_t tag = 0;       // The sender's correlation number, echoed in the response
+};
+
+/**
+ * Data ID and operation from <prefix><id>/read or <prefix><id>/write, where
+ * prefix is <base>/ot/ and id is 0-255 in decimal. Returns false for any
+ * other topic.
+ */
+bool parseBusTopic(const std::string& prefix, const char* topic, size_t len, BusCommand& command);
+
+/**
+ * Value and tag from a bus command payload: "[<tag>]" for a read,
+ * "<value>[,<tag>]" for a write. The value is decimal (-32768 to 65535),
+ * 0x hex, or f8.8 when it has a decimal point, as /api/write takes it.
+ * Returns false when the payload is malformed.
+ */
+bool parseBusPayload(const char* payload, size_t len, BusCommand& command);
+
+} // namespace ot
@@ -1,8 +1,10 @@
 /*
  * MQTT Bridge (C++)
  *
- * Receives external overrides (TSet, CH enable) via MQTT.
- * Publishes diagnostic sensors with Home Assistant discovery.
+ * Receives external overrides (TSet, CH enable) and raw OpenTherm
+ * reads/writes via MQTT.
+ * Publishes diagnostic sensors with Home Assistant discovery from a
+ * publisher task of its own; callers only queue updates.
  */
 
 #pragma once
@@ -14,7 +16,10 @@
 #include <functional>
 #include <chrono>
 #include <memory>
+#include <vector>
 #include "esp_err.h"
+#include "command_router.h"
+#include "publish_policy.h"
 
 namespace ot {
 
@@ -29,6 +34,9 @@ struct MqttConfig {
     std::string password;
     std::string baseTopic = "ot_gateway";
     std::string discoveryPrefix = "homeassistant";
+    std::vector<SensorPolicy> policies;     // Override the declared publish policies, by sensor id
+    uint32_t snapshotIntervalMs = 0;        // <base>/state snapshot cadence; 0: off
+    bool snapshotOnChange = false;          // ... and whenever a sensor's policy sends a change
 };
 
 /**
@@ -47,11 +55,66 @@ struct MqttState {
 
     // Heartbeat value (for monitoring)
     std::optional<float> heartbeatValue;
+
+    static constexpr std::chrono::milliseconds HEARTBEAT_TIMEOUT{90000};
+
+    // A heartbeat arrived within HEARTBEAT_TIMEOUT of now
+    [[nodiscard]] bool heartbeatFresh(std::chrono::milliseconds now) const {
+        return heartbeatValue.has_value() && lastHeartbeatTime.count() > 0 &&
+               now - lastHeartbeatTime <= HEARTBEAT_TIMEOUT;
+    }
 };
 
+/**
+ * Diagnostic publishing counters
+ */
+struct MqttPublishStats {
+    uint32_t queued = 0;           // Updates accepted by publishSensor()/publishBinarySensor()
+    uint32_t dropped = 0;          // Rejected: queue full
+    uint32_t coalesced = 0;        // Superseded by a newer value before they were sent
+    uint32_t suppressed = 0;       // Unchanged within the sensor's deadband: not sent
+    uint32_t keepAlives = 0;       // Sent unchanged after the sensor's max interval
+    uint32_t published = 0;        // State messages handed to the client
+    uint32_t failed = 0;           // ... of which the client refused
+    uint32_t discoveries = 0;      // Discovery configs sent
+    uint32_t discoveryBytes = 0;   // Topic + payload bytes of those
+    uint32_t stateBytes = 0;       // Topic + payload bytes of the state messages
+    uint32_t snapshots = 0;        // <base>/state snapshots sent
+    uint32_t snapshotBytes = 0;    // Topic + payload bytes of those
+    uint32_t offlineBuffered = 0;  // Values kept while disconnected
+    uint32_t offlineDropped = 0;   // ... pushed out, oldest first, by newer ones
+    uint32_t offlineReplayed = 0;  // ... sent to <base>/diag/<id>/replay after the connect
+    uint32_t offlinePending = 0;   // ... still waiting to be replayed
+    uint32_t busCommands = 0;      // <base>/ot/<id>/read|write handed to the bus command handler
+    uint32_t busRejected = 0;      // ... malformed, or refused by the handler
+    uint32_t busResponses = 0;     // <base>/ot/<id>/response messages queued
+};
+
+/**
+ * One declared sensor's publish policy in force and what it let through
+ */
+struct MqttSensorStats {
+    const char* id;
+    PublishPolicy policy;
+    uint32_t sent;
+    uint32_t suppressed;
+};
+
+// Handle of a sensor declared with MqttBridge::declareSensor()
+using SensorHandle = int;
+static constexpr SensorHandle INVALID_SENSOR = -1;
+
+// Writes a <base>/state snapshot payload into buf; returns its length,
+// 0 to skip this one
+using SnapshotWriter = std::function<size_t(char* buf, size_t size)>;
+
 // Callback for control mode changes
 using ControlModeCallback = std::function<void(bool enabled)>;
 
+// Takes a raw bus command on the MQTT event task: queue it and return at
+// once, ESP_OK if it will be answered through publishBusResponse()
+using BusCommandHandler = std::function<esp_err_t(const BusCommand& command)>;
+
 /**
  * RAII MQTT client wrapper
  *
@@ -60,6 +123,9 @@ using ControlModeCallback = std::function<void(bool enabled)>;
  */
 class MqttBridge {
 public:
+    static constexpr size_t MAX_SENSORS = 48;     // Sensors the registry can hold
+    static constexpr size_t SNAPSHOT_MAX = 1536;  // Largest <base>/state payload
+
     explicit MqttBridge(const MqttConfig& config);
     ~MqttBridge();
 
@@ -75,16 +141,57 @@ public:
     // Reconfigure with new settings (stops, updates config, restarts)
     [[nodiscard]] esp_err_t reconfigure(const MqttConfig& config);
 
-    // Thread-safe state access
+    // Thread-safe state access. Never blocks: the state is read from a
+    // lock-free snapshot (snapshot_cell.h) that writers replace whole, so
+    // the fields always belong together.
     [[nodiscard]] MqttState state() const;
-
-    // Publish sensor value with Home Assistant discovery
-    [[nodiscard]] esp_err_t publishSensor(std::string_view id, std::string_view name,
-                                          std::string_view unit, float value, bool valid);
-
-    // Publish binary sensor value (ON/OFF) with Home Assistant discovery
-    [[nodiscard]] esp_err_t publishBinarySensor(std::string_view id, std::string_view name,
-                                                 bool state, bool valid);
+    // Reads of state() that overlapped a write and read again
+    [[nodiscard]] uint32_t stateRetries() const;
+
+    /**
+     * Sensor registry. Declare each diagnostic sensor once: its Home
+     * Assistant discovery config is published once per connection, and
+     * again only when Home Assistant comes back online or the declaration
+     * changes, so value updates carry just the value. id, name and unit are
+     * kept by pointer and must be string literals. Declaring an id again
+     * returns its existing handle. Returns INVALID_SENSOR when the
+     * registry is full.
+     *
+     * policy decides which values are worth sending (see publish_policy.h);
+     * MqttConfig::policies overrides it by id. The default sends every
+     * change and suppresses repeats.
+     */
+    SensorHandle declareSensor(const char* id, const char* name, const char* unit,
+                               const PublishPolicy& policy = PublishPolicy());
+    SensorHandle declareBinarySensor(const char* id, const char* name,
+                                     const PublishPolicy& policy = PublishPolicy());
+
+    // Queue a value for the publisher task, which puts it through the
+    // sensor's policy after the coalescing window; a newer value for the
+    // same sensor replaces a queued or held-back one. While disconnected,
+    // the values the policy lets through are buffered with their time and
+    // replayed at a bounded rate after the connect. Keep-alives are
+    // checked as samples arrive, so a sensor that stops reporting goes
+    // quiet rather than being refreshed with a stale value. Never blocks.
+    // Returns ESP_ERR_INVALID_ARG for an undeclared handle,
+    // ESP_ERR_INVALID_STATE when the bridge is not running, ESP_ERR_NO_MEM
+    // when the queue is full (update dropped).
+    [[nodiscard]] esp_err_t publishSensor(SensorHandle sensor, float value, bool valid);
+
+    // Binary sensor (ON/OFF), queued the same way
+    [[nodiscard]] esp_err_t publishBinarySensor(SensorHandle sensor, bool state, bool valid);
+
+    /**
+     * Source of the <base>/state snapshot, published (not retained) from
+     * the publisher task every MqttConfig::snapshotIntervalMs and, with
+     * snapshotOnChange, after a flush that sent a changed sensor value.
+     * The writer fills a buffer of SNAPSHOT_MAX bytes owned by the bridge.
+     */
+    void setSnapshotWriter(SnapshotWriter writer);
+
+    [[nodiscard]] MqttPublishStats publishStats() const;
+    // Per declared sensor, in declaration order; returns the number filled in
+    size_t sensorStats(MqttSensorStats* out, size_t max) const;
 
     // Control mode callback
     void setControlCallback(ControlModeCallback callback);
@@ -92,6 +199,24 @@ public:
     // Publish control state (for UI sync)
     void publishControlState(bool enabled);
 
+    /**
+     * Raw OpenTherm access. <base>/ot/<id>/read with an optional tag, and
+     * <base>/ot/<id>/write with "<value>[,<tag>]", go to handler; the result
+     * comes back on <base>/ot/<id>/response as
+     *
+     *   {"id":25,"op":"read","tag":7,"status":"ok","type":"READ_ACK","value":11520,"raw":"0xC0192D00"}
+     *
+     * status is ok, timeout, invalid_response, busy (queue full),
+     * unavailable or bad_request; type, value and raw only come with ok.
+     * Requests that the handler refuses, or that cannot be parsed, are
+     * answered at once. Set before start().
+     */
+    void setBusCommandHandler(BusCommandHandler handler);
+    // Answer a command the handler accepted. Never blocks: the publisher
+    // task sends it. Dropped while disconnected or when too many are
+    // waiting.
+    void publishBusResponse(const BusCommand& command, esp_err_t result, uint32_t response);
+
     // Configuration persistence (static utilities)
     [[nodiscard]] static esp_err_t loadConfig(MqttConfig& config);
     [[nodiscard]] static esp_err_t saveConfig(const MqttConfig& config);
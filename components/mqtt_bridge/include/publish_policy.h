@@ -0,0 +1,72 @@
+/*
+ * Diagnostic publish policy
+ *
+ * Decides, per sensor, whether a fresh sample is worth a retained MQTT
+ * message: changes inside the deadband are suppressed, changes arriving
+ * faster than the minimum interval are held back, and an unchanged value
+ * is resent after the maximum interval as a keep-alive. No IDF
+ * dependencies; the host tests build it as is.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ot {
+
+struct PublishPolicy {
+    float deadband = 0.0f;          // Absolute change that counts, in the sensor's unit
+    float deadbandPct = 0.0f;       // Relative change that counts, % of the last sent value
+    uint32_t minIntervalMs = 0;     // Changes closer together are held back
+    uint32_t maxIntervalMs = 0;     // Resend an unchanged value after this; 0: never
+
+    // The change from last exceeds every deadband set; with none set, any
+    // change does
+    [[nodiscard]] bool exceeds(float last, float value) const;
+
+    bool operator==(const PublishPolicy& other) const {
+        return deadband == other.deadband && deadbandPct == other.deadbandPct &&
+               minIntervalMs == other.minIntervalMs && maxIntervalMs == other.maxIntervalMs;
+    }
+    bool operator!=(const PublishPolicy& other) const { return !(*this == other); }
+};
+
+// A configured override of a sensor's declared policy
+struct SensorPolicy {
+    std::string id;
+    PublishPolicy policy;
+};
+
+enum class PublishDecision {
+    Send,       // Changed (or first on this connection)
+    KeepAlive,  // Unchanged, but maxIntervalMs has passed
+    Hold,       // Changed, but minIntervalMs has not passed yet
+    Suppress    // Unchanged
+};
+
+/**
+ * What to do with a fresh sample. published: a value went out on this
+ * connection, lastValid/lastValue being that value and sinceLastMs its
+ * age. A change of validity always counts as a change.
+ */
+[[nodiscard]] PublishDecision decidePublish(const PublishPolicy& policy, bool published,
+                                            bool lastValid, float lastValue,
+                                            bool valid, float value, int64_t sinceLastMs);
+
+/**
+ * Overrides in their text form, as stored in NVS and taken by
+ * /api/mqtt_config:
+ *
+ *   id=deadband,deadband_pct,min_ms,max_ms[;id=...]
+ *
+ * ids are letters, digits and '_'. Trailing fields may be left out and
+ * keep their defaults. parsePolicies() returns false, leaving out
+ * untouched, on a malformed entry.
+ */
+[[nodiscard]] bool parsePolicies(std::string_view text, std::vector<SensorPolicy>& out);
+[[nodiscard]] std::string formatPolicies(const std::vector<SensorPolicy>& policies);
+
+} // namespace ot
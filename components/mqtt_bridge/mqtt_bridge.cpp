@@ -3,14 +3,21 @@
  */
 
 #include "mqtt_bridge.hpp"
+#include "command_router.h"
 #include "esp_event.h"
 #include "esp_log.h"
-#include "esp_timer.h"
+#include "open_therm_protocol.h"
+#include "ot_clock.h"
+#include "snapshot_cell.h"
 #include "mqtt_client.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 #include "nvs_flash.h"
 #include "sdkconfig.h"
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <cstdlib>
 
@@ -18,23 +25,74 @@ static const char* TAG = "MQTT_BRIDGE";
 
 namespace ot {
 
-// Heartbeat timeout for availability check
-static constexpr int64_t HEARTBEAT_TIMEOUT_MS = 90000;
+#ifdef CONFIG_OT_MQTT_PUBLISH_QUEUE
+static constexpr size_t PUBLISH_QUEUE_LENGTH = CONFIG_OT_MQTT_PUBLISH_QUEUE;
+#else
+static constexpr size_t PUBLISH_QUEUE_LENGTH = 32;
+#endif
+// Bus command results waiting for the publisher task; about as many as the
+// gateway can have in flight
+static constexpr size_t BUS_RESPONSE_QUEUE_LENGTH = 16;
+#ifdef CONFIG_OT_MQTT_COALESCE_MS
+static constexpr uint32_t PUBLISH_COALESCE_MS = CONFIG_OT_MQTT_COALESCE_MS;
+#else
+static constexpr uint32_t PUBLISH_COALESCE_MS = 1000;
+#endif
+static constexpr size_t MAX_SENSORS = MqttBridge::MAX_SENSORS;
+#ifdef CONFIG_OT_MQTT_OFFLINE_SAMPLES
+static constexpr size_t OFFLINE_SAMPLES = CONFIG_OT_MQTT_OFFLINE_SAMPLES;
+#else
+static constexpr size_t OFFLINE_SAMPLES = 256;
+#endif
+#ifdef CONFIG_OT_MQTT_REPLAY_RATE
+static constexpr uint32_t REPLAY_RATE = CONFIG_OT_MQTT_REPLAY_RATE;
+#else
+static constexpr uint32_t REPLAY_RATE = 10;
+#endif
+#ifdef CONFIG_OT_MQTT_SNAPSHOT_INTERVAL
+static constexpr uint32_t SNAPSHOT_INTERVAL_S = CONFIG_OT_MQTT_SNAPSHOT_INTERVAL;
+#else
+static constexpr uint32_t SNAPSHOT_INTERVAL_S = 0;
+#endif
+#ifdef CONFIG_OT_MQTT_SNAPSHOT_ON_CHANGE
+static constexpr bool SNAPSHOT_ON_CHANGE = true;
+#else
+static constexpr bool SNAPSHOT_ON_CHANGE = false;
+#endif
+static_assert(MAX_SENSORS <= 256, "SensorUpdate carries the handle in a byte");
 
 class MqttBridge::Impl {
 public:
     explicit Impl(const MqttConfig& config)
         : config_(config)
         , mutex_(xSemaphoreCreateMutex())
+        , stateWriter_(xSemaphoreCreateMutex())
+        , publishQueue_(xQueueCreate(PUBLISH_QUEUE_LENGTH, sizeof(SensorUpdate)))
+        , busResponseQueue_(xQueueCreate(BUS_RESPONSE_QUEUE_LENGTH, sizeof(BusResponse)))
+        , publishStopped_(xSemaphoreCreateBinary())
+        , offline_(OFFLINE_SAMPLES ? new OfflineSample[OFFLINE_SAMPLES] : nullptr)
     {
+        addCommands();
         buildTopics();
     }
 
     ~Impl() {
         stop();
+        if (publishQueue_) {
+            vQueueDelete(publishQueue_);
+        }
+        if (busResponseQueue_) {
+            vQueueDelete(busResponseQueue_);
+        }
+        if (publishStopped_) {
+            vSemaphoreDelete(publishStopped_);
+        }
         if (mutex_) {
             vSemaphoreDelete(mutex_);
         }
+        if (stateWriter_) {
+            vSemaphoreDelete(stateWriter_);
+        }
     }
 
     esp_err_t start() {
@@ -43,7 +101,7 @@ public:
             return ESP_OK;  // Disabled is not an error
         }
 
-        if (!mutex_) {
+        if (!mutex_ || !stateWriter_ || !publishQueue_ || !busResponseQueue_ || !publishStopped_) {
             return ESP_ERR_NO_MEM;
         }
 
@@ -66,6 +124,16 @@ public:
         ESP_ERROR_CHECK(esp_mqtt_client_register_event(
             client_, static_cast<esp_mqtt_event_id_t>(ESP_EVENT_ANY_ID), &Impl::eventHandler, this));
 
+        // All diagnostic broker I/O happens on this task, below the bus tasks
+        publishStop_ = false;
+        if (xTaskCreate(&Impl::publishTask, "mqtt_pub", 4096, this, 1, &publishTask_) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create MQTT publisher task");
+            publishTask_ = nullptr;
+            esp_mqtt_client_destroy(client_);
+            client_ = nullptr;
+            return ESP_ERR_NO_MEM;
+        }
+
         esp_err_t err = esp_mqtt_client_start(client_);
         if (err != ESP_OK) {
             ESP_LOGE(TAG, "Failed to start MQTT client: %s", esp_err_to_name(err));
@@ -80,6 +148,18 @@ public:
 
     void stop() {
         running_ = false;
+        if (publishTask_) {
+            // Pending updates are dropped; the latest values stay in the
+            // table and go out again after the next connect
+            publishStop_ = true;
+            xQueueReset(publishQueue_);
+            xQueueReset(busResponseQueue_);
+            SensorUpdate wake = {};
+            xQueueSendToFront(publishQueue_, &wake, 0);
+            xTaskNotifyGive(publishTask_);
+            xSemaphoreTake(publishStopped_, portMAX_DELAY);
+            publishTask_ = nullptr;
+        }
         if (client_) {
             esp_mqtt_client_stop(client_);
             esp_mqtt_client_destroy(client_);
@@ -94,92 +174,526 @@ public:
         stop();
         config_ = config;
         buildTopics();
+        if (mutex_) {
+            xSemaphoreTake(mutex_, portMAX_DELAY);
+            for (size_t i = 0; i < sensorCount_.load(); i++) {
+                resolvePolicy(sensorInfo_[i]);
+            }
+            xSemaphoreGive(mutex_);
+        }
         return start();
     }
 
     MqttState state() const {
-        MqttState result;
-        int64_t nowMs = esp_timer_get_time() / 1000;
-
-        if (mutex_ && xSemaphoreTake(mutex_, pdMS_TO_TICKS(50)) == pdTRUE) {
-            result.connected = state_.connected;
-            result.lastTsetC = state_.lastTsetC;
-            result.lastChEnable = state_.lastChEnable;
-            result.lastControlEnabled = state_.lastControlEnabled;
-            result.lastUpdateTime = state_.lastUpdateTime;
-            result.lastHeartbeatTime = state_.lastHeartbeatTime;
-            result.heartbeatValue = state_.heartbeatValue;
-
-            // Calculate availability
-            bool hbFresh = state_.heartbeatValue.has_value() &&
-                          state_.lastHeartbeatTime.count() > 0 &&
-                          (nowMs - state_.lastHeartbeatTime.count()) <= HEARTBEAT_TIMEOUT_MS;
-            result.available = state_.connected && hbFresh;
+        MqttState result = state_.load();
+        result.available = result.connected && result.heartbeatFresh(clockMs());
+        return result;
+    }
+
+    uint32_t stateRetries() const { return state_.retries(); }
 
+    SensorHandle declare(bool binary, const char* id, const char* name, const char* unit,
+                         const PublishPolicy& policy) {
+        if (!mutex_ || !id || !name) {
+            return INVALID_SENSOR;
+        }
+        if (unit && !*unit) {
+            unit = nullptr;
+        }
+
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+        const size_t count = sensorCount_.load();
+        SensorHandle handle = INVALID_SENSOR;
+        for (size_t i = 0; i < count; i++) {
+            if (strcmp(sensorInfo_[i].id, id) == 0) {
+                handle = static_cast<SensorHandle>(i);
+                break;
+            }
+        }
+        bool changed = false;
+        if (handle == INVALID_SENSOR && count < MAX_SENSORS) {
+            handle = static_cast<SensorHandle>(count);
+            sensorInfo_[count] = SensorInfo{binary, id, name, unit, 1, policy, policy};
+            resolvePolicy(sensorInfo_[count]);
+            sensorCount_.store(count + 1);
+            changed = true;
+        } else if (handle != INVALID_SENSOR) {
+            SensorInfo& info = sensorInfo_[handle];
+            if (info.binary != binary || strcmp(info.name, name) != 0 || !sameText(info.unit, unit)) {
+                // Announced again with the new config
+                info.binary = binary;
+                info.name = name;
+                info.unit = unit;
+                info.revision++;
+                changed = true;
+            }
+            info.declaredPolicy = policy;
+            resolvePolicy(info);
+        }
+        xSemaphoreGive(mutex_);
+
+        if (handle == INVALID_SENSOR) {
+            ESP_LOGE(TAG, "Sensor registry full, %s not declared", id);
+        } else if (changed && running_) {
+            wakePublisher();
+        }
+        return handle;
+    }
+
+    // Called from the bus task: a queue push, nothing else
+    esp_err_t publishValue(SensorHandle sensor, float value, bool valid) {
+        if (sensor < 0 || static_cast<size_t>(sensor) >= sensorCount_.load()) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        return queueUpdate(SensorUpdate{SensorUpdate::Value, valid, static_cast<uint8_t>(sensor), value});
+    }
+
+    MqttPublishStats publishStats() const {
+        MqttPublishStats s;
+        s.queued = queued_.load(std::memory_order_relaxed);
+        s.dropped = dropped_.load(std::memory_order_relaxed);
+        s.coalesced = coalesced_.load(std::memory_order_relaxed);
+        s.suppressed = suppressed_.load(std::memory_order_relaxed);
+        s.keepAlives = keepAlives_.load(std::memory_order_relaxed);
+        s.published = published_.load(std::memory_order_relaxed);
+        s.failed = failed_.load(std::memory_order_relaxed);
+        s.discoveries = discoveries_.load(std::memory_order_relaxed);
+        s.discoveryBytes = discoveryBytes_.load(std::memory_order_relaxed);
+        s.stateBytes = stateBytes_.load(std::memory_order_relaxed);
+        s.snapshots = snapshots_.load(std::memory_order_relaxed);
+        s.snapshotBytes = snapshotBytes_.load(std::memory_order_relaxed);
+        s.offlineBuffered = offlineBuffered_.load(std::memory_order_relaxed);
+        s.offlineDropped = offlineDropped_.load(std::memory_order_relaxed);
+        s.offlineReplayed = offlineReplayed_.load(std::memory_order_relaxed);
+        s.offlinePending = offlineCount_.load(std::memory_order_relaxed);
+        s.busCommands = busCommands_.load(std::memory_order_relaxed);
+        s.busRejected = busRejected_.load(std::memory_order_relaxed);
+        s.busResponses = busResponses_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    void setSnapshotWriter(SnapshotWriter writer) {
+        if (mutex_) {
+            xSemaphoreTake(mutex_, portMAX_DELAY);
+            snapshotWriter_ = std::move(writer);
             xSemaphoreGive(mutex_);
         }
-        return result;
     }
 
-    esp_err_t publishSensor(std::string_view id, std::string_view name,
-                            std::string_view unit, float value, bool valid) {
-        if (!client_ || !state_.connected) {
-            return ESP_ERR_INVALID_STATE;
+    size_t sensorStats(MqttSensorStats* out, size_t max) const {
+        if (!mutex_) {
+            return 0;
+        }
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+        const size_t count = std::min(sensorCount_.load(), max);
+        for (size_t i = 0; i < count; i++) {
+            out[i].id = sensorInfo_[i].id;
+            out[i].policy = sensorInfo_[i].policy;
+            out[i].sent = sensorValues_[i].sent.load(std::memory_order_relaxed);
+            out[i].suppressed = sensorValues_[i].suppressed.load(std::memory_order_relaxed);
         }
+        xSemaphoreGive(mutex_);
+        return count;
+    }
 
-        // Publish discovery
-        publishSensorDiscovery(id, name, unit);
+    void setControlCallback(ControlModeCallback callback) {
+        controlCallback_ = std::move(callback);
+    }
 
-        // Build state topic
-        std::string topic = config_.baseTopic + "/diag/" + std::string(id) + "/state";
+    void setBusCommandHandler(BusCommandHandler handler) {
+        busHandler_ = std::move(handler);
+    }
 
-        if (!valid) {
-            return publishState(topic, "");  // Clear value
+    // Called on the manager task: only hands the result to the publisher
+    // task, which owns the broker I/O
+    void publishBusResponse(const BusCommand& command, esp_err_t result, uint32_t response) {
+        if (!running_ || !connected()) {
+            return;
+        }
+        const BusResponse entry{command, result, response};
+        if (xQueueSend(busResponseQueue_, &entry, 0) != pdTRUE) {
+            failed_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // Past the coalescing window too: someone is waiting for this one
+        wakePublisher();
+        if (TaskHandle_t task = publishTask_) {
+            xTaskNotifyGive(task);
+        }
+    }
+
+    void publishControlState(bool enabled) {
+        if (!client_ || !connected()) {
+            return;
         }
 
-        char buf[32];
-        snprintf(buf, sizeof(buf), "%.2f", value);
-        return publishState(topic, buf);
+        updateState([enabled](MqttState& st) { st.lastControlEnabled = enabled; });
+
+        publishState(topicControlState_, enabled ? "ON" : "OFF");
     }
 
-    esp_err_t publishBinarySensor(std::string_view id, std::string_view name,
-                                   bool state, bool valid) {
-        if (!client_ || !state_.connected) {
-            return ESP_ERR_INVALID_STATE;
+private:
+    // A bus command result on its way to the publisher task
+    struct BusResponse {
+        BusCommand command;
+        esp_err_t result;
+        uint32_t response;
+    };
+
+    // Publisher task: <base>/ot/<id>/response for each queued result
+    void sendBusResponses() {
+        BusResponse entry;
+        while (xQueueReceive(busResponseQueue_, &entry, 0) == pdTRUE) {
+            sendBusResponse(entry.command, entry.result, entry.response);
+        }
+    }
+
+    void sendBusResponse(const BusCommand& command, esp_err_t result, uint32_t response) {
+        if (!client_ || !connected()) {
+            return;
+        }
+        char topic[160];
+        int topicLen = snprintf(topic, sizeof(topic), "%s%u/response", topicBusBase_.c_str(), command.dataId);
+        if (topicLen < 0 || static_cast<size_t>(topicLen) >= sizeof(topic)) {
+            ESP_LOGW(TAG, "Bus response topic too long");
+            return;
+        }
+        char payload[192];
+        int len = snprintf(payload, sizeof(payload), "{\"id\":%u,\"op\":\"%s\",\"tag\":%lu,\"status\":\"%s\"",
+                           command.dataId, command.write ? "write" : "read",
+                           static_cast<unsigned long>(command.tag), busStatusName(result));
+        if (result == ESP_OK) {
+            Frame frame(response);
+            len += snprintf(payload + len, sizeof(payload) - len, ",\"type\":\"%s\",\"value\":%u,\"raw\":\"0x%08lX\"",
+                            toString(frame.messageType()), frame.dataValue(), static_cast<unsigned long>(response));
         }
+        len += snprintf(payload + len, sizeof(payload) - len, "}");
+        if (esp_mqtt_client_publish(client_, topic, payload, len, 1, 0) >= 0) {
+            busResponses_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            failed_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // A declared sensor; written under mutex_
+    struct SensorInfo {
+        bool binary;
+        const char* id;
+        const char* name;
+        const char* unit;               // nullptr: none
+        uint16_t revision;              // Bumped when the declaration changes
+        PublishPolicy declaredPolicy;
+        PublishPolicy policy;           // declaredPolicy or the configured override
+    };
+
+    // The publisher task's view of one sensor
+    struct SensorValue {
+        float value = 0.0f;
+        bool valid = false;
+        bool dirty = false;             // value not decided on yet
+        int64_t sampledAtMs = 0;        // When value arrived
+        uint16_t announced = 0;         // revision sent on this connection, 0: none
+        bool published = false;         // A value went out on this connection
+        bool sentValid = false;
+        float sentValue = 0.0f;
+        int64_t sentAtMs = 0;
+        std::atomic<uint32_t> sent{0};
+        std::atomic<uint32_t> suppressed{0};
+    };
+
+    // A sample decided on while disconnected, replayed after the connect
+    struct OfflineSample {
+        uint32_t atMs;                  // clockMs(), truncated
+        float value;
+        uint8_t sensor;
+        bool valid;
+    };
+
+    // A value on its way to the publisher task
+    struct SensorUpdate {
+        enum Kind : uint8_t { Wake, Value } kind;
+        bool valid;
+        uint8_t sensor;
+        float value;
+    };
+
+    static bool sameText(const char* a, const char* b) {
+        return a == b || (a && b && strcmp(a, b) == 0);
+    }
 
-        // Publish discovery
-        publishBinarySensorDiscovery(id, name);
+    // Under mutex_
+    void resolvePolicy(SensorInfo& info) {
+        info.policy = info.declaredPolicy;
+        for (const SensorPolicy& sp : config_.policies) {
+            if (sp.id == info.id) {
+                info.policy = sp.policy;
+                break;
+            }
+        }
+    }
 
-        // Build state topic
-        std::string topic = config_.baseTopic + "/diag/" + std::string(id) + "/state";
+    void wakePublisher() {
+        SensorUpdate wake = {};
+        xQueueSendToFront(publishQueue_, &wake, 0);
+    }
 
-        if (!valid) {
-            return publishState(topic, "");  // Clear value
+    esp_err_t queueUpdate(const SensorUpdate& update) {
+        if (!running_) {
+            return ESP_ERR_INVALID_STATE;
         }
+        if (xQueueSend(publishQueue_, &update, 0) != pdTRUE) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return ESP_ERR_NO_MEM;
+        }
+        queued_.fetch_add(1, std::memory_order_relaxed);
+        return ESP_OK;
+    }
 
-        return publishState(topic, state ? "ON" : "OFF");
+    static void publishTask(void* arg) {
+        static_cast<Impl*>(arg)->publishLoop();
+        vTaskDelete(nullptr);
     }
 
-    void setControlCallback(ControlModeCallback callback) {
-        controlCallback_ = std::move(callback);
+    void publishLoop() {
+        SensorUpdate update;
+        TickType_t wait = portMAX_DELAY;
+        while (!publishStop_) {
+            // Times out when a held-back change, the snapshot or the next
+            // replayed sample is due
+            if (xQueueReceive(publishQueue_, &update, wait) == pdTRUE) {
+                absorb(update);
+                sendBusResponses();
+                // Collect the window's updates; stop() cuts the wait short
+                if (PUBLISH_COALESCE_MS > 0) {
+                    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PUBLISH_COALESCE_MS));
+                }
+                while (xQueueReceive(publishQueue_, &update, 0) == pdTRUE) {
+                    absorb(update);
+                }
+            }
+            if (publishStop_) {
+                break;
+            }
+            sendBusResponses();
+            if (announce_.exchange(false)) {
+                // New connection or Home Assistant restarted: entities
+                // first, then every known value again
+                publishDiscovery();
+                for (SensorValue& v : sensorValues_) {
+                    v.announced = 0;
+                    v.published = false;
+                    v.dirty = v.dirty || v.valid;
+                }
+            }
+            int64_t dueInMs = flush();
+            for (int64_t nextInMs : {snapshot(), replay()}) {
+                if (nextInMs >= 0 && (dueInMs < 0 || nextInMs < dueInMs)) {
+                    dueInMs = nextInMs;
+                }
+            }
+            wait = dueInMs < 0 ? portMAX_DELAY : pdMS_TO_TICKS(dueInMs) + 1;
+        }
+        xSemaphoreGive(publishStopped_);
     }
 
-    void publishControlState(bool enabled) {
-        if (!client_ || !state_.connected) {
+    void absorb(const SensorUpdate& update) {
+        if (update.kind == SensorUpdate::Wake) {
             return;
         }
+        SensorValue& v = sensorValues_[update.sensor];
+        if (v.dirty) {
+            coalesced_.fetch_add(1, std::memory_order_relaxed);
+        }
+        v.value = update.value;
+        v.valid = update.valid;
+        v.sampledAtMs = clockMs().count();
+        v.dirty = true;
+    }
 
-        // Update internal state
-        if (mutex_ && xSemaphoreTake(mutex_, pdMS_TO_TICKS(50)) == pdTRUE) {
-            state_.lastControlEnabled = enabled;
+    // Announce sensors not yet (or no longer) known to Home Assistant on
+    // this connection, then put each fresh value through its sensor's
+    // publish policy. While disconnected the values the policy lets through
+    // go to the offline buffer instead. Returns the ms until the first
+    // held-back change is due, -1 when none is.
+    int64_t flush() {
+        const bool online = client_ && connected();
+        if (!online && !offline_) {
+            return -1;  // Kept dirty until the next connect
+        }
+        const int64_t nowMs = clockMs().count();
+        int64_t dueInMs = -1;
+        const size_t count = sensorCount_.load();
+        for (size_t i = 0; i < count; i++) {
+            SensorValue& v = sensorValues_[i];
+            xSemaphoreTake(mutex_, portMAX_DELAY);
+            const SensorInfo info = sensorInfo_[i];
             xSemaphoreGive(mutex_);
+
+            if (online && v.announced != info.revision) {
+                if (info.binary) {
+                    publishBinarySensorDiscovery(info.id, info.name);
+                } else {
+                    publishSensorDiscovery(info.id, info.name, info.unit ? info.unit : "");
+                }
+                v.announced = info.revision;
+            }
+            if (!v.dirty) {
+                continue;
+            }
+
+            const int64_t sinceLastMs = nowMs - v.sentAtMs;
+            switch (decidePublish(info.policy, v.published, v.sentValid, v.sentValue,
+                                  v.valid, v.value, sinceLastMs)) {
+                case PublishDecision::Hold: {
+                    const int64_t due = info.policy.minIntervalMs - sinceLastMs;
+                    dueInMs = dueInMs < 0 ? due : std::min(dueInMs, due);
+                    continue;   // Stays dirty; newer samples replace it meanwhile
+                }
+                case PublishDecision::Suppress:
+                    v.suppressed.fetch_add(1, std::memory_order_relaxed);
+                    suppressed_.fetch_add(1, std::memory_order_relaxed);
+                    v.dirty = false;
+                    continue;
+                case PublishDecision::KeepAlive:
+                    keepAlives_.fetch_add(1, std::memory_order_relaxed);
+                    break;
+                case PublishDecision::Send:
+                    changedSinceSnapshot_ = online;
+                    break;
+            }
+
+            if (!online) {
+                bufferOffline(static_cast<uint8_t>(i), v);
+                // The policy carries on from what was buffered
+                v.published = true;
+                v.sentValid = v.valid;
+                v.sentValue = v.value;
+                v.sentAtMs = nowMs;
+                v.dirty = false;
+                continue;
+            }
+
+            std::string topic = topicDiagBase_ + info.id + "/state";
+            char buf[32] = "";  // Empty clears the value
+            if (v.valid) {
+                if (info.binary) {
+                    strcpy(buf, v.value != 0.0f ? "ON" : "OFF");
+                } else {
+                    snprintf(buf, sizeof(buf), "%.2f", v.value);
+                }
+            }
+            if (publishState(topic, buf) == ESP_OK) {
+                published_.fetch_add(1, std::memory_order_relaxed);
+                stateBytes_.fetch_add(topic.size() + strlen(buf), std::memory_order_relaxed);
+                v.sent.fetch_add(1, std::memory_order_relaxed);
+                v.published = true;
+                v.sentValid = v.valid;
+                v.sentValue = v.value;
+                v.sentAtMs = nowMs;
+            } else {
+                failed_.fetch_add(1, std::memory_order_relaxed);
+            }
+            v.dirty = false;
         }
+        return dueInMs;
+    }
 
-        publishState(topicControlState_, enabled ? "ON" : "OFF");
+    // Oldest first out when full
+    void bufferOffline(uint8_t sensor, const SensorValue& v) {
+        uint32_t count = offlineCount_.load(std::memory_order_relaxed);
+        if (count == OFFLINE_SAMPLES) {
+            offlineHead_ = (offlineHead_ + 1) % OFFLINE_SAMPLES;
+            count--;
+            offlineDropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        offline_[(offlineHead_ + count) % OFFLINE_SAMPLES] =
+            OfflineSample{static_cast<uint32_t>(v.sampledAtMs), v.value, sensor, v.valid};
+        offlineCount_.store(count + 1, std::memory_order_relaxed);
+        offlineBuffered_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Drain the offline buffer at REPLAY_RATE samples/s, oldest first, to
+    // <base>/diag/<id>/replay as {"value":V,"age_ms":A} (not retained; the
+    // state topics already carry the current values). Returns the ms until
+    // the next sample is due, -1 when none is pending.
+    int64_t replay() {
+        if (offlineCount_.load(std::memory_order_relaxed) == 0 || !client_ || !connected()) {
+            return -1;
+        }
+        const int64_t nowMs = clockMs().count();
+        const int64_t intervalMs = std::max<int64_t>(1, 1000 / REPLAY_RATE);
+        if (nextReplayMs_ < nowMs - intervalMs) {
+            nextReplayMs_ = nowMs;  // Idle since the last sample: no catch-up burst
+        }
+        while (offlineCount_.load(std::memory_order_relaxed) > 0 && nextReplayMs_ <= nowMs) {
+            const OfflineSample& sample = offline_[offlineHead_];
+            xSemaphoreTake(mutex_, portMAX_DELAY);
+            const char* id = sensorInfo_[sample.sensor].id;
+            xSemaphoreGive(mutex_);
+
+            std::string topic = topicDiagBase_ + id + "/replay";
+            const uint32_t ageMs = static_cast<uint32_t>(nowMs) - sample.atMs;
+            char payload[64];
+            if (sample.valid) {
+                snprintf(payload, sizeof(payload), "{\"value\":%.2f,\"age_ms\":%lu}",
+                         sample.value, static_cast<unsigned long>(ageMs));
+            } else {
+                snprintf(payload, sizeof(payload), "{\"value\":null,\"age_ms\":%lu}",
+                         static_cast<unsigned long>(ageMs));
+            }
+            if (esp_mqtt_client_publish(client_, topic.c_str(), payload, 0, 1, 0) < 0) {
+                // Outbox full or the connection went: try again later
+                failed_.fetch_add(1, std::memory_order_relaxed);
+                nextReplayMs_ = nowMs + intervalMs;
+                break;
+            }
+            offlineHead_ = (offlineHead_ + 1) % OFFLINE_SAMPLES;
+            offlineCount_.fetch_sub(1, std::memory_order_relaxed);
+            offlineReplayed_.fetch_add(1, std::memory_order_relaxed);
+            nextReplayMs_ += intervalMs;
+        }
+        return offlineCount_.load(std::memory_order_relaxed) > 0 ? std::max<int64_t>(0, nextReplayMs_ - nowMs) : -1;
+    }
+
+    // Publish the <base>/state snapshot when it is due; returns the ms until
+    // the next periodic one, -1 when there is none
+    int64_t snapshot() {
+        const uint32_t intervalMs = config_.snapshotIntervalMs;
+        if ((intervalMs == 0 && !config_.snapshotOnChange) || !client_ || !connected()) {
+            changedSinceSnapshot_ = false;
+            return -1;
+        }
+        const int64_t nowMs = clockMs().count();
+        const bool due = intervalMs > 0 && nowMs >= nextSnapshotMs_;
+        if (due || (config_.snapshotOnChange && changedSinceSnapshot_)) {
+            publishSnapshot();
+            changedSinceSnapshot_ = false;
+            if (intervalMs > 0) {
+                nextSnapshotMs_ = nowMs + intervalMs;
+            }
+        }
+        return intervalMs > 0 ? std::max<int64_t>(0, nextSnapshotMs_ - nowMs) : -1;
+    }
+
+    void publishSnapshot() {
+        size_t len = 0;
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+        if (snapshotWriter_) {
+            len = snapshotWriter_(snapshotBuf_, sizeof(snapshotBuf_));
+        }
+        xSemaphoreGive(mutex_);
+        if (len == 0 || len > sizeof(snapshotBuf_)) {
+            return;
+        }
+        // A feed for collectors rather than state to restore: not retained
+        if (esp_mqtt_client_publish(client_, topicSnapshot_.c_str(), snapshotBuf_, static_cast<int>(len), 0, 0) >= 0) {
+            snapshots_.fetch_add(1, std::memory_order_relaxed);
+            snapshotBytes_.fetch_add(topicSnapshot_.size() + len, std::memory_order_relaxed);
+        } else {
+            failed_.fetch_add(1, std::memory_order_relaxed);
+        }
     }
 
-private:
     void buildTopics() {
         const std::string& base = config_.baseTopic.empty() ? "ot_gateway" : config_.baseTopic;
 
@@ -191,55 +705,169 @@ private:
         topicHbState_ = base + "/heartbeat/state";
         topicControlCmd_ = base + "/control/set";
         topicControlState_ = base + "/control/state";
+        topicDiagBase_ = base + "/diag/";
+        topicSnapshot_ = base + "/state";
+        topicHaStatus_ = (config_.discoveryPrefix.empty() ? "homeassistant" : config_.discoveryPrefix) + "/status";
+        router_.setBase(base);
+        topicBusBase_ = base + "/ot/";
+        topicBusRead_ = topicBusBase_ + "+/read";
+        topicBusWrite_ = topicBusBase_ + "+/write";
     }
 
-    void setConnected(bool connected) {
-        if (mutex_ && xSemaphoreTake(mutex_, pdMS_TO_TICKS(50)) == pdTRUE) {
-            state_.connected = connected;
-            xSemaphoreGive(mutex_);
+    // <base>/<name>/set commands, all under the one <base>/+/set subscription
+    void addCommands() {
+        router_.add("tset", [](void* self, const char* payload, size_t len) {
+            static_cast<Impl*>(self)->onTset(payload, len);
+        }, this);
+        router_.add("ch_enable", [](void* self, const char* payload, size_t len) {
+            static_cast<Impl*>(self)->onChEnable(payload, len);
+        }, this);
+        router_.add("heartbeat", [](void* self, const char* payload, size_t len) {
+            static_cast<Impl*>(self)->onHeartbeat(payload, len);
+        }, this);
+        router_.add("control", [](void* self, const char* payload, size_t len) {
+            static_cast<Impl*>(self)->onControl(payload, len);
+        }, this);
+    }
+
+    // Command payloads are numbers or ON/OFF; longer ones are cut short
+    static constexpr size_t COMMAND_PAYLOAD_MAX = 32;
+
+    static void copyPayload(char (&buf)[COMMAND_PAYLOAD_MAX], const char* payload, size_t len) {
+        len = std::min(len, COMMAND_PAYLOAD_MAX - 1);
+        memcpy(buf, payload, len);
+        buf[len] = '\0';
+    }
+
+    static bool parseOn(const char* payload) {
+        return strcasecmp(payload, "on") == 0 || strcmp(payload, "1") == 0 ||
+               strcasecmp(payload, "true") == 0;
+    }
+
+    void onTset(const char* payload, size_t len) {
+        char buf[COMMAND_PAYLOAD_MAX];
+        copyPayload(buf, payload, len);
+        float val = std::strtof(buf, nullptr);
+        setTset(val);
+        ESP_LOGI(TAG, "Received TSet override: %.2f C", val);
+        publishState(topicTsetState_, buf);
+    }
+
+    void onChEnable(const char* payload, size_t len) {
+        char buf[COMMAND_PAYLOAD_MAX];
+        copyPayload(buf, payload, len);
+        bool on = parseOn(buf);
+        setChEnable(on);
+        ESP_LOGI(TAG, "Received CH enable override: %s", on ? "ON" : "OFF");
+        publishState(topicChEnableState_, on ? "ON" : "OFF");
+    }
+
+    void onHeartbeat(const char* payload, size_t len) {
+        char buf[COMMAND_PAYLOAD_MAX];
+        copyPayload(buf, payload, len);
+        setHeartbeat(std::strtof(buf, nullptr));
+        publishState(topicHbState_, buf);
+    }
+
+    static const char* busStatusName(esp_err_t err) {
+        switch (err) {
+            case ESP_OK:                    return "ok";
+            case ESP_ERR_TIMEOUT:           return "timeout";
+            case ESP_ERR_INVALID_RESPONSE:  return "invalid_response";
+            case ESP_ERR_NO_MEM:            return "busy";
+            case ESP_ERR_INVALID_ARG:       return "bad_request";
+            default:                        return "unavailable";
         }
     }
 
-    void setTset(float value) {
-        if (mutex_ && xSemaphoreTake(mutex_, pdMS_TO_TICKS(50)) == pdTRUE) {
-            state_.lastTsetC = value;
-            state_.lastUpdateTime = std::chrono::milliseconds(esp_timer_get_time() / 1000);
-            xSemaphoreGive(mutex_);
+    // Parsed and handed over here; answered later from the handler's side
+    void onBusCommand(BusCommand& command, const char* payload, size_t len) {
+        esp_err_t err = ESP_ERR_INVALID_ARG;
+        if (parseBusPayload(payload, len, command)) {
+            err = busHandler_ ? busHandler_(command) : ESP_ERR_NOT_SUPPORTED;
         }
+        if (err == ESP_OK) {
+            busCommands_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        busRejected_.fetch_add(1, std::memory_order_relaxed);
+        ESP_LOGW(TAG, "Bus %s of ID %u refused: %s", command.write ? "write" : "read", command.dataId,
+                 esp_err_to_name(err));
+        publishBusResponse(command, err, 0);
     }
 
-    void setChEnable(bool enabled) {
-        if (mutex_ && xSemaphoreTake(mutex_, pdMS_TO_TICKS(50)) == pdTRUE) {
-            state_.lastChEnable = enabled;
-            state_.lastUpdateTime = std::chrono::milliseconds(esp_timer_get_time() / 1000);
-            xSemaphoreGive(mutex_);
+    void onControl(const char* payload, size_t len) {
+        char buf[COMMAND_PAYLOAD_MAX];
+        copyPayload(buf, payload, len);
+        bool on = parseOn(buf);
+        setControl(on);
+        ESP_LOGI(TAG, "Received Control Mode override: %s", on ? "ON" : "OFF");
+        publishState(topicControlState_, on ? "ON" : "OFF");
+    }
+
+    bool connected() const { return state_.load().connected; }
+
+    // Writers (MQTT event task, publishControlState() callers) take turns
+    // on stateWriter_; readers of state_ never wait for them
+    template <typename F>
+    void updateState(F&& modify) {
+        if (!stateWriter_) {
+            return;
         }
+        xSemaphoreTake(stateWriter_, portMAX_DELAY);
+        state_.update(modify);
+        xSemaphoreGive(stateWriter_);
+    }
+
+    void setConnected(bool connected) {
+        updateState([connected](MqttState& st) { st.connected = connected; });
+    }
+
+    void setTset(float value) {
+        const std::chrono::milliseconds now = clockMs();
+        updateState([value, now](MqttState& st) {
+            st.lastTsetC = value;
+            st.lastUpdateTime = now;
+        });
+    }
+
+    void setChEnable(bool enabled) {
+        const std::chrono::milliseconds now = clockMs();
+        updateState([enabled, now](MqttState& st) {
+            st.lastChEnable = enabled;
+            st.lastUpdateTime = now;
+        });
     }
 
     void setHeartbeat(float value) {
-        if (mutex_ && xSemaphoreTake(mutex_, pdMS_TO_TICKS(50)) == pdTRUE) {
-            state_.heartbeatValue = value;
-            state_.lastHeartbeatTime = std::chrono::milliseconds(esp_timer_get_time() / 1000);
-            xSemaphoreGive(mutex_);
-        }
+        const std::chrono::milliseconds now = clockMs();
+        updateState([value, now](MqttState& st) {
+            st.heartbeatValue = value;
+            st.lastHeartbeatTime = now;
+        });
     }
 
     void setControl(bool enabled) {
-        if (mutex_ && xSemaphoreTake(mutex_, pdMS_TO_TICKS(50)) == pdTRUE) {
-            state_.lastControlEnabled = enabled;
-            xSemaphoreGive(mutex_);
-        }
+        updateState([enabled](MqttState& st) { st.lastControlEnabled = enabled; });
         // Invoke callback outside mutex
         if (controlCallback_) {
             controlCallback_(enabled);
         }
     }
 
-    esp_err_t publishState(const std::string& topic, const std::string& payload) {
-        int msgId = esp_mqtt_client_publish(client_, topic.c_str(), payload.c_str(), 0, 1, 1);
+    esp_err_t publishState(const std::string& topic, const char* payload) {
+        int msgId = esp_mqtt_client_publish(client_, topic.c_str(), payload, 0, 1, 1);
         return (msgId >= 0) ? ESP_OK : ESP_FAIL;
     }
 
+    // Retained Home Assistant discovery config
+    void publishConfig(const std::string& topic, const char* payload) {
+        if (publishState(topic, payload) == ESP_OK) {
+            discoveries_.fetch_add(1, std::memory_order_relaxed);
+            discoveryBytes_.fetch_add(topic.size() + strlen(payload), std::memory_order_relaxed);
+        }
+    }
+
     void publishDiscovery() {
         const std::string& disc = config_.discoveryPrefix.empty() ? "homeassistant" : config_.discoveryPrefix;
         const std::string& base = config_.baseTopic.empty() ? "ot_gateway" : config_.baseTopic;
@@ -252,7 +880,7 @@ private:
             R"("unit_of_meas":"°C","min":10,"max":100,"step":0.5,"retain":true,)"
             R"("dev":{"ids":["%s"],"name":"OpenTherm Gateway","mf":"OT Gateway","mdl":"ESP32"}})",
             base.c_str(), topicTsetCmd_.c_str(), topicTsetState_.c_str(), base.c_str());
-        publishState(topicTset, payloadTset);
+        publishConfig(topicTset, payloadTset);
 
         // CH Enable switch
         std::string topicCh = disc + "/switch/" + base + "_ch/config";
@@ -262,7 +890,7 @@ private:
             R"("pl_on":"ON","pl_off":"OFF","retain":true,)"
             R"("dev":{"ids":["%s"],"name":"OpenTherm Gateway","mf":"OT Gateway","mdl":"ESP32"}})",
             base.c_str(), topicChEnableCmd_.c_str(), topicChEnableState_.c_str(), base.c_str());
-        publishState(topicCh, payloadCh);
+        publishConfig(topicCh, payloadCh);
 
         // Control Mode switch
         std::string topicControl = disc + "/switch/" + base + "_control/config";
@@ -272,7 +900,7 @@ private:
             R"("pl_on":"ON","pl_off":"OFF","retain":true,)"
             R"("dev":{"ids":["%s"],"name":"OpenTherm Gateway","mf":"OT Gateway","mdl":"ESP32"}})",
             base.c_str(), topicControlCmd_.c_str(), topicControlState_.c_str(), base.c_str());
-        publishState(topicControl, payloadControl);
+        publishConfig(topicControl, payloadControl);
 
         // Heartbeat number
         std::string topicHb = disc + "/number/" + base + "_hb/config";
@@ -282,7 +910,7 @@ private:
             R"("min":0,"max":1000000,"step":1,"retain":true,)"
             R"("dev":{"ids":["%s"],"name":"OpenTherm Gateway","mf":"OT Gateway","mdl":"ESP32"}})",
             base.c_str(), topicHbCmd_.c_str(), topicHbState_.c_str(), base.c_str());
-        publishState(topicHb, payloadHb);
+        publishConfig(topicHb, payloadHb);
     }
 
     void publishSensorDiscovery(std::string_view id, std::string_view name, std::string_view unit) {
@@ -290,7 +918,7 @@ private:
         const std::string& base = config_.baseTopic.empty() ? "ot_gateway" : config_.baseTopic;
 
         std::string topic = disc + "/sensor/" + base + "_" + std::string(id) + "/config";
-        std::string stateTopic = base + "/diag/" + std::string(id) + "/state";
+        std::string stateTopic = topicDiagBase_ + std::string(id) + "/state";
 
         char payload[512];
         if (!unit.empty()) {
@@ -311,7 +939,7 @@ private:
                 stateTopic.c_str(),
                 base.c_str());
         }
-        publishState(topic, payload);
+        publishConfig(topic, payload);
     }
 
     void publishBinarySensorDiscovery(std::string_view id, std::string_view name) {
@@ -319,7 +947,7 @@ private:
         const std::string& base = config_.baseTopic.empty() ? "ot_gateway" : config_.baseTopic;
 
         std::string topic = disc + "/binary_sensor/" + base + "_" + std::string(id) + "/config";
-        std::string stateTopic = base + "/diag/" + std::string(id) + "/state";
+        std::string stateTopic = topicDiagBase_ + std::string(id) + "/state";
 
         char payload[512];
         snprintf(payload, sizeof(payload),
@@ -329,44 +957,35 @@ private:
             base.c_str(), static_cast<int>(id.size()), id.data(),
             stateTopic.c_str(),
             base.c_str());
-        publishState(topic, payload);
+        publishConfig(topic, payload);
     }
 
     void handleMessage(esp_mqtt_event_handle_t event) {
-        if (!event || !event->topic || !event->data) {
+        if (!event || !event->topic || !event->data || event->topic_len <= 0 || event->data_len < 0) {
             return;
         }
+        const size_t topicLen = static_cast<size_t>(event->topic_len);
+        const size_t len = static_cast<size_t>(event->data_len);
 
-        std::string topic(event->topic, event->topic_len);
-        std::string payload(event->data, event->data_len);
-
-        if (topic == topicTsetCmd_) {
-            float val = std::strtof(payload.c_str(), nullptr);
-            setTset(val);
-            ESP_LOGI(TAG, "Received TSet override: %.2f C", val);
-            publishState(topicTsetState_, payload);
-        }
-        else if (topic == topicChEnableCmd_) {
-            bool on = (strcasecmp(payload.c_str(), "on") == 0 ||
-                      payload == "1" ||
-                      strcasecmp(payload.c_str(), "true") == 0);
-            setChEnable(on);
-            ESP_LOGI(TAG, "Received CH enable override: %s", on ? "ON" : "OFF");
-            publishState(topicChEnableState_, on ? "ON" : "OFF");
+        if (router_.dispatch(event->topic, topicLen, event->data, len)) {
+            return;
         }
-        else if (topic == topicHbCmd_) {
-            float hb = std::strtof(payload.c_str(), nullptr);
-            setHeartbeat(hb);
-            publishState(topicHbState_, payload);
+        BusCommand command;
+        if (parseBusTopic(topicBusBase_, event->topic, topicLen, command)) {
+            onBusCommand(command, event->data, len);
+            return;
         }
-        else if (topic == topicControlCmd_) {
-            bool on = (strcasecmp(payload.c_str(), "on") == 0 ||
-                      payload == "1" ||
-                      strcasecmp(payload.c_str(), "true") == 0);
-            setControl(on);
-            ESP_LOGI(TAG, "Received Control Mode override: %s", on ? "ON" : "OFF");
-            publishState(topicControlState_, on ? "ON" : "OFF");
+        if (topicLen == topicHaStatus_.size() && memcmp(event->topic, topicHaStatus_.data(), topicLen) == 0) {
+            // Home Assistant's birth message: it restarted and may have
+            // lost the entities the retained configs did not restore
+            if (len == 6 && memcmp(event->data, "online", 6) == 0) {
+                ESP_LOGI(TAG, "Home Assistant online, announcing sensors");
+                announce_ = true;
+                wakePublisher();
+            }
+            return;
         }
+        ESP_LOGD(TAG, "Ignoring message on %.*s", event->topic_len, event->topic);
     }
 
     static void eventHandler(void* handlerArgs, esp_event_base_t base,
@@ -378,11 +997,13 @@ private:
             case MQTT_EVENT_CONNECTED:
                 ESP_LOGI(TAG, "MQTT connected");
                 self->setConnected(true);
-                esp_mqtt_client_subscribe(self->client_, self->topicTsetCmd_.c_str(), 1);
-                esp_mqtt_client_subscribe(self->client_, self->topicChEnableCmd_.c_str(), 1);
-                esp_mqtt_client_subscribe(self->client_, self->topicHbCmd_.c_str(), 1);
-                esp_mqtt_client_subscribe(self->client_, self->topicControlCmd_.c_str(), 1);
-                self->publishDiscovery();
+                esp_mqtt_client_subscribe(self->client_, self->router_.filter().c_str(), 1);
+                esp_mqtt_client_subscribe(self->client_, self->topicBusRead_.c_str(), 1);
+                esp_mqtt_client_subscribe(self->client_, self->topicBusWrite_.c_str(), 1);
+                esp_mqtt_client_subscribe(self->client_, self->topicHaStatus_.c_str(), 1);
+                // Discovery and the current values go out from the publisher task
+                self->announce_ = true;
+                self->wakePublisher();
                 break;
 
             case MQTT_EVENT_DISCONNECTED:
@@ -400,12 +1021,51 @@ private:
     }
 
     MqttConfig config_;
-    MqttState state_;
+    SnapshotCell<MqttState> state_;                 // Read without locking
     SemaphoreHandle_t mutex_ = nullptr;
+    SemaphoreHandle_t stateWriter_ = nullptr;       // Serialises writers of state_
     esp_mqtt_client_handle_t client_ = nullptr;
-    bool running_ = false;
+    std::atomic<bool> running_{false};
     ControlModeCallback controlCallback_;
 
+    // Diagnostic publishing
+    QueueHandle_t publishQueue_ = nullptr;
+    QueueHandle_t busResponseQueue_ = nullptr;      // BusResponse
+    SemaphoreHandle_t publishStopped_ = nullptr;
+    TaskHandle_t publishTask_ = nullptr;
+    std::atomic<bool> publishStop_{false};
+    std::atomic<bool> announce_{false};      // Connected: send discovery and all values
+    SensorInfo sensorInfo_[MAX_SENSORS] = {};
+    SensorValue sensorValues_[MAX_SENSORS];         // Publisher task only, but the counters
+    std::atomic<size_t> sensorCount_{0};            // Declared; entries never removed
+    std::atomic<uint32_t> queued_{0};
+    std::atomic<uint32_t> dropped_{0};
+    std::atomic<uint32_t> coalesced_{0};
+    std::atomic<uint32_t> suppressed_{0};
+    std::atomic<uint32_t> keepAlives_{0};
+    std::atomic<uint32_t> published_{0};
+    std::atomic<uint32_t> failed_{0};
+    std::atomic<uint32_t> discoveries_{0};
+    std::atomic<uint32_t> discoveryBytes_{0};
+    std::atomic<uint32_t> stateBytes_{0};
+    std::atomic<uint32_t> snapshots_{0};
+    std::atomic<uint32_t> snapshotBytes_{0};
+
+    // <base>/state snapshot; buffer and timing are publisher task only
+    SnapshotWriter snapshotWriter_;                 // Under mutex_
+    char snapshotBuf_[MqttBridge::SNAPSHOT_MAX];
+    int64_t nextSnapshotMs_ = 0;
+    bool changedSinceSnapshot_ = false;
+
+    // Samples kept while disconnected; ring is publisher task only
+    std::unique_ptr<OfflineSample[]> offline_;
+    size_t offlineHead_ = 0;                        // Oldest
+    std::atomic<uint32_t> offlineCount_{0};
+    int64_t nextReplayMs_ = 0;
+    std::atomic<uint32_t> offlineBuffered_{0};
+    std::atomic<uint32_t> offlineDropped_{0};
+    std::atomic<uint32_t> offlineReplayed_{0};
+
     // Topics
     std::string topicTsetCmd_;
     std::string topicTsetState_;
@@ -415,6 +1075,17 @@ private:
     std::string topicHbState_;
     std::string topicControlCmd_;
     std::string topicControlState_;
+    std::string topicDiagBase_;     // <base>/diag/
+    std::string topicSnapshot_;     // <base>/state
+    std::string topicHaStatus_;     // <discovery prefix>/status
+    CommandRouter router_;          // <base>/+/set; filled at construction
+    std::string topicBusBase_;      // <base>/ot/
+    std::string topicBusRead_;      // <base>/ot/+/read
+    std::string topicBusWrite_;     // <base>/ot/+/write
+    BusCommandHandler busHandler_;
+    std::atomic<uint32_t> busCommands_{0};
+    std::atomic<uint32_t> busRejected_{0};
+    std::atomic<uint32_t> busResponses_{0};
 };
 
 // MqttBridge implementation
@@ -446,14 +1117,38 @@ MqttState MqttBridge::state() const {
     return impl_->state();
 }
 
-esp_err_t MqttBridge::publishSensor(std::string_view id, std::string_view name,
-                                    std::string_view unit, float value, bool valid) {
-    return impl_->publishSensor(id, name, unit, value, valid);
+uint32_t MqttBridge::stateRetries() const {
+    return impl_->stateRetries();
 }
 
-esp_err_t MqttBridge::publishBinarySensor(std::string_view id, std::string_view name,
-                                           bool state, bool valid) {
-    return impl_->publishBinarySensor(id, name, state, valid);
+SensorHandle MqttBridge::declareSensor(const char* id, const char* name, const char* unit,
+                                       const PublishPolicy& policy) {
+    return impl_->declare(false, id, name, unit, policy);
+}
+
+SensorHandle MqttBridge::declareBinarySensor(const char* id, const char* name,
+                                             const PublishPolicy& policy) {
+    return impl_->declare(true, id, name, nullptr, policy);
+}
+
+esp_err_t MqttBridge::publishSensor(SensorHandle sensor, float value, bool valid) {
+    return impl_->publishValue(sensor, value, valid);
+}
+
+esp_err_t MqttBridge::publishBinarySensor(SensorHandle sensor, bool state, bool valid) {
+    return impl_->publishValue(sensor, state ? 1.0f : 0.0f, valid);
+}
+
+void MqttBridge::setSnapshotWriter(SnapshotWriter writer) {
+    impl_->setSnapshotWriter(std::move(writer));
+}
+
+MqttPublishStats MqttBridge::publishStats() const {
+    return impl_->publishStats();
+}
+
+size_t MqttBridge::sensorStats(MqttSensorStats* out, size_t max) const {
+    return impl_->sensorStats(out, max);
 }
 
 void MqttBridge::setControlCallback(ControlModeCallback callback) {
@@ -464,6 +1159,14 @@ void MqttBridge::publishControlState(bool enabled) {
     impl_->publishControlState(enabled);
 }
 
+void MqttBridge::setBusCommandHandler(BusCommandHandler handler) {
+    impl_->setBusCommandHandler(std::move(handler));
+}
+
+void MqttBridge::publishBusResponse(const BusCommand& command, esp_err_t result, uint32_t response) {
+    impl_->publishBusResponse(command, result, response);
+}
+
 // Static config utilities
 
 esp_err_t MqttBridge::loadConfig(MqttConfig& config) {
@@ -475,6 +1178,8 @@ esp_err_t MqttBridge::loadConfig(MqttConfig& config) {
     config.password = CONFIG_OT_MQTT_PASSWORD;
     config.baseTopic = CONFIG_OT_MQTT_BASE_TOPIC;
     config.discoveryPrefix = "homeassistant";
+    config.snapshotIntervalMs = SNAPSHOT_INTERVAL_S * 1000;
+    config.snapshotOnChange = SNAPSHOT_ON_CHANGE;
 
     nvs_handle_t nvs;
     esp_err_t err = nvs_open("mqtt", NVS_READONLY, &nvs);
@@ -515,6 +1220,27 @@ esp_err_t MqttBridge::loadConfig(MqttConfig& config) {
         config.discoveryPrefix = buf;
     }
 
+    // Overrides can outgrow buf
+    len = 0;
+    if (nvs_get_str(nvs, "policies", nullptr, &len) == ESP_OK && len > 0) {
+        std::string text(len, '\0');
+        if (nvs_get_str(nvs, "policies", text.data(), &len) == ESP_OK) {
+            text.resize(len - 1);
+            if (!parsePolicies(text, config.policies)) {
+                ESP_LOGW(TAG, "Ignoring malformed publish policies in NVS");
+            }
+        }
+    }
+
+    uint32_t snapshotMs;
+    if (nvs_get_u32(nvs, "snap_ms", &snapshotMs) == ESP_OK) {
+        config.snapshotIntervalMs = snapshotMs;
+    }
+    uint8_t snapshotOnChange;
+    if (nvs_get_u8(nvs, "snap_change", &snapshotOnChange) == ESP_OK) {
+        config.snapshotOnChange = snapshotOnChange != 0;
+    }
+
     uint8_t enable = config.enable ? 1 : 0;
     if (nvs_get_u8(nvs, "enable", &enable) == ESP_OK) {
         config.enable = enable != 0;
@@ -537,6 +1263,9 @@ esp_err_t MqttBridge::saveConfig(const MqttConfig& config) {
     err |= nvs_set_str(nvs, "password", config.password.c_str());
     err |= nvs_set_str(nvs, "base_topic", config.baseTopic.c_str());
     err |= nvs_set_str(nvs, "disc_prefix", config.discoveryPrefix.c_str());
+    err |= nvs_set_str(nvs, "policies", formatPolicies(config.policies).c_str());
+    err |= nvs_set_u32(nvs, "snap_ms", config.snapshotIntervalMs);
+    err |= nvs_set_u8(nvs, "snap_change", config.snapshotOnChange ? 1 : 0);
     err |= nvs_set_u8(nvs, "enable", config.enable ? 1 : 0);
 
     if (err == ESP_OK) {
@@ -0,0 +1,119 @@
+/*
+ * Diagnostic publish policy (see publish_policy.h)
+ */
+
+#include "publish_policy.h"
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace ot {
+
+bool PublishPolicy::exceeds(float last, float value) const
+{
+    const float delta = std::fabs(value - last);
+    return delta > deadband && delta > deadbandPct * std::fabs(last) / 100.0f;
+}
+
+PublishDecision decidePublish(const PublishPolicy& policy, bool published,
+                              bool lastValid, float lastValue,
+                              bool valid, float value, int64_t sinceLastMs)
+{
+    if (!published) {
+        return PublishDecision::Send;
+    }
+    const bool changed = valid != lastValid || (valid && policy.exceeds(lastValue, value));
+    if (changed) {
+        return sinceLastMs >= policy.minIntervalMs ? PublishDecision::Send : PublishDecision::Hold;
+    }
+    if (policy.maxIntervalMs > 0 && sinceLastMs >= policy.maxIntervalMs) {
+        return PublishDecision::KeepAlive;
+    }
+    return PublishDecision::Suppress;
+}
+
+// One "id=a,b,c,d" entry
+static bool parseEntry(std::string_view entry, SensorPolicy& out)
+{
+    const size_t eq = entry.find('=');
+    if (eq == std::string_view::npos || eq == 0) {
+        return false;
+    }
+    for (char c : entry.substr(0, eq)) {
+        // Sensor ids are topic segments
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+            return false;
+        }
+    }
+    out.id = std::string(entry.substr(0, eq));
+    out.policy = PublishPolicy();
+
+    std::string fields(entry.substr(eq + 1));
+    const char* p = fields.c_str();
+    for (int field = 0; field < 4 && *p; field++) {
+        char* end;
+        if (field < 2) {
+            float v = std::strtof(p, &end);
+            if (end == p || !std::isfinite(v) || v < 0.0f) {
+                return false;
+            }
+            (field == 0 ? out.policy.deadband : out.policy.deadbandPct) = v;
+        } else {
+            if (*p == '-') {
+                return false;
+            }
+            unsigned long v = std::strtoul(p, &end, 10);
+            if (end == p) {
+                return false;
+            }
+            (field == 2 ? out.policy.minIntervalMs : out.policy.maxIntervalMs) = static_cast<uint32_t>(v);
+        }
+        p = end;
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return false;
+        }
+    }
+    return *p == '\0';
+}
+
+bool parsePolicies(std::string_view text, std::vector<SensorPolicy>& out)
+{
+    std::vector<SensorPolicy> result;
+    while (!text.empty()) {
+        const size_t semi = text.find(';');
+        std::string_view entry = text.substr(0, semi);
+        text = semi == std::string_view::npos ? std::string_view() : text.substr(semi + 1);
+        if (entry.empty()) {
+            continue;
+        }
+        SensorPolicy policy;
+        if (!parseEntry(entry, policy)) {
+            return false;
+        }
+        result.push_back(std::move(policy));
+    }
+    out = std::move(result);
+    return true;
+}
+
+std::string formatPolicies(const std::vector<SensorPolicy>& policies)
+{
+    std::string text;
+    char buf[64];
+    for (const SensorPolicy& sp : policies) {
+        snprintf(buf, sizeof(buf), "=%g,%g,%lu,%lu", sp.policy.deadband, sp.policy.deadbandPct,
+                 static_cast<unsigned long>(sp.policy.minIntervalMs),
+                 static_cast<unsigned long>(sp.policy.maxIntervalMs));
+        if (!text.empty()) {
+            text += ';';
+        }
+        text += sp.id;
+        text += buf;
+    }
+    return text;
+}
+
+} // namespace ot
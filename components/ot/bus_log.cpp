@@ -0,0 +1,263 @@
+#include "bus_log.h"
+#include "open_therm.h"
+#include "rmt_parser.h"
+#include "esp_log.h"
+#include "ot_clock.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+namespace ot {
+
+static const char* TAG = "BusLog";
+
+static_assert((BUS_LOG_DEPTH & (BUS_LOG_DEPTH - 1)) == 0, "BUS_LOG_DEPTH must be a power of two");
+static_assert(offsetof(LogRecord, symbols) == LOG_RECORD_HEADER_BYTES, "LogRecord header layout");
+
+static constexpr uint32_t RING_MASK = BUS_LOG_DEPTH - 1;
+static constexpr size_t RECENT_FAILURES = 8;
+
+// Bounded multi-producer ring (Vyukov). A slot's sequence says whose turn it
+// is: producer of position pos when seq == pos, consumer when seq == pos + 1.
+// Stored relative to the slot index so zero-initialised storage is valid.
+struct RingSlot
+{
+    std::atomic<uint32_t> seq;
+    LogRecord record;
+};
+
+static RingSlot s_ring[BUS_LOG_DEPTH];
+static std::atomic<uint32_t> s_head{0};     // Next position to claim (producers)
+static uint32_t s_tail = 0;                 // Next position to drain (drain task only)
+static std::atomic<uint32_t> s_dropped{0};
+static TaskHandle_t s_drainTask = nullptr;
+
+static SemaphoreHandle_t s_lock = nullptr;    // Recent failures
+
+// Failed captures kept for snapshot(), written by the drain task
+static LogRecord s_recent[RECENT_FAILURES];
+static size_t s_recentNext = 0;
+static size_t s_recentCount = 0;
+
+static void lockShared()
+{
+    if (s_lock) xSemaphoreTake(s_lock, portMAX_DELAY);
+}
+
+static void unlockShared()
+{
+    if (s_lock) xSemaphoreGive(s_lock);
+}
+
+const char* toString(LogEvent event)
+{
+    switch (event) {
+        case LogEvent::ParseFailed:    return "PARSE_FAILED";
+        case LogEvent::FrameDecoded:   return "FRAME_DECODED";
+        case LogEvent::StreamFailed:   return "STREAM_FAILED";
+        case LogEvent::Forwarding:     return "FORWARDING";
+        case LogEvent::BoilerResponse: return "BOILER_RESPONSE";
+        case LogEvent::BoilerTimeout:  return "BOILER_TIMEOUT";
+        case LogEvent::ResponseSent:   return "RESPONSE_SENT";
+        default:                       return "UNKNOWN";
+    }
+}
+
+const char* toString(MessageDirection direction)
+{
+    switch (direction) {
+        case MessageDirection::Request:          return "REQUEST";
+        case MessageDirection::Response:         return "RESPONSE";
+        case MessageDirection::DiscardedRequest: return "DISCARDED_REQUEST";
+        default:                                 return "UNKNOWN";
+    }
+}
+
+bool BusLog::push(LogEvent event, uint8_t source, uint32_t frame, uint32_t arg,
+                  const rmt_symbol_word_t* symbols, size_t numSymbols)
+{
+    uint32_t pos = s_head.load(std::memory_order_relaxed);
+    RingSlot* slot;
+    while (true) {
+        slot = &s_ring[pos & RING_MASK];
+        uint32_t seq = slot->seq.load(std::memory_order_acquire) + (pos & RING_MASK);
+        int32_t diff = static_cast<int32_t>(seq - pos);
+        if (diff == 0) {
+            if (s_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = s_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    LogRecord& r = slot->record;
+    // Streaming captures report a symbol count without keeping the symbols
+    size_t stored = !symbols ? 0 : numSymbols < BUS_LOG_MAX_SYMBOLS ? numSymbols : BUS_LOG_MAX_SYMBOLS;
+    r.timestampUs = static_cast<uint32_t>(clockUs());
+    r.event = event;
+    r.source = source;
+    r.symbolCount = static_cast<uint8_t>(stored);
+    r.symbolTotal = static_cast<uint8_t>(numSymbols < 255 ? numSymbols : 255);
+    r.frame = frame;
+    r.arg = arg;
+    if (stored) memcpy(r.symbols, symbols, stored * sizeof(rmt_symbol_word_t));
+    slot->seq.store(pos + 1 - (pos & RING_MASK), std::memory_order_release);
+
+    TaskHandle_t drain = s_drainTask;
+    if (drain) xTaskNotifyGive(drain);
+    return true;
+}
+
+// Copy out the oldest record, freeing its slot. Drain task only.
+static bool popRecord(LogRecord& out)
+{
+    uint32_t pos = s_tail;
+    RingSlot* slot = &s_ring[pos & RING_MASK];
+    uint32_t seq = slot->seq.load(std::memory_order_acquire) + (pos & RING_MASK);
+    if (seq != pos + 1) return false;
+
+    memcpy(&out, &slot->record, LOG_RECORD_HEADER_BYTES + slot->record.symbolCount * sizeof(rmt_symbol_word_t));
+    slot->seq.store(pos + BUS_LOG_DEPTH - (pos & RING_MASK), std::memory_order_release);
+    s_tail = pos + 1;
+    return true;
+}
+
+void BusLog::format(const LogRecord& r, char* buffer, size_t size)
+{
+    const char side = static_cast<char>(r.source);
+    const ParseError error = static_cast<ParseError>(r.arg & 0xFF);
+    const int bit = static_cast<int>((r.arg >> 8) & 0xFF);
+    int n = 0;
+
+    switch (r.event) {
+        case LogEvent::ParseFailed:
+            n = snprintf(buffer, size, "%c RMT[%u] FAILED (%s @bit %d): ", side, r.symbolTotal,
+                         toString(error), bit);
+            break;
+        case LogEvent::FrameDecoded:
+            n = snprintf(buffer, size, "%c RMT[%u] -> 0x%08lx%s", side, r.symbolTotal,
+                         static_cast<unsigned long>(r.frame), r.symbolCount ? ": " : " (streamed)");
+            break;
+        case LogEvent::StreamFailed:
+            n = snprintf(buffer, size, "%c RMT[%u] FAILED (%s @bit %d)", side, r.symbolTotal,
+                         toString(error), bit);
+            break;
+        case LogEvent::Forwarding:
+            n = snprintf(buffer, size, "Forwarding ID=%d request 0x%08lX to boiler",
+                         Frame(r.frame).dataId(), static_cast<unsigned long>(r.frame));
+            break;
+        case LogEvent::BoilerResponse:
+            n = snprintf(buffer, size, "Boiler response: 0x%08lX (took %lu ms)",
+                         static_cast<unsigned long>(r.frame), static_cast<unsigned long>(r.arg / 1000));
+            break;
+        case LogEvent::BoilerTimeout:
+            n = snprintf(buffer, size, "Failed to send request 0x%08lX to boiler (took %lu ms)",
+                         static_cast<unsigned long>(r.frame), static_cast<unsigned long>(r.arg / 1000));
+            break;
+        case LogEvent::ResponseSent:
+            n = snprintf(buffer, size, "Response sent to thermostat: %s (took %lu ms total)",
+                         (r.arg >> 31) ? "OK" : "FAILED",
+                         static_cast<unsigned long>((r.arg & 0x7FFFFFFF) / 1000));
+            break;
+        default:
+            n = snprintf(buffer, size, "%s frame=0x%08lx arg=%lu", toString(r.event),
+                         static_cast<unsigned long>(r.frame), static_cast<unsigned long>(r.arg));
+            break;
+    }
+
+    if (n > 0 && static_cast<size_t>(n) < size && r.symbolCount) {
+        // Symbols as the parser test corpus expects them (test/run_tests.py)
+        buildRMTSymbolLogString(const_cast<rmt_symbol_word_t*>(r.symbols), r.symbolCount,
+                                buffer + n, size - n);
+    }
+}
+
+static void drainTask(void* arg)
+{
+    (void)arg;
+    LogRecord record;
+    char line[640];
+    uint32_t reportedDrops = 0;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (popRecord(record)) {
+            BusLog::format(record, line, sizeof(line));
+            switch (record.event) {
+                case LogEvent::ParseFailed:
+                case LogEvent::StreamFailed:
+                    ESP_LOGW("OT", "%s", line);
+                    break;
+                case LogEvent::FrameDecoded:
+                    ESP_LOGI("OT", "%s", line);
+                    break;
+                case LogEvent::BoilerTimeout:
+                    ESP_LOGW("BoilerMgr", "%s", line);
+                    break;
+                default:
+                    ESP_LOGI("BoilerMgr", "%s", line);
+                    break;
+            }
+
+            if (record.event == LogEvent::ParseFailed) {
+                lockShared();
+                s_recent[s_recentNext] = record;
+                s_recentNext = (s_recentNext + 1) % RECENT_FAILURES;
+                if (s_recentCount < RECENT_FAILURES) s_recentCount++;
+                unlockShared();
+            }
+        }
+
+        uint32_t drops = s_dropped.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            ESP_LOGW(TAG, "%lu records dropped (ring full)", static_cast<unsigned long>(drops - reportedDrops));
+            reportedDrops = drops;
+        }
+    }
+}
+
+esp_err_t BusLog::start(UBaseType_t priority, uint32_t stackSize)
+{
+    if (s_drainTask) return ESP_OK;
+    if (!s_lock) {
+        s_lock = xSemaphoreCreateMutex();
+        if (!s_lock) return ESP_ERR_NO_MEM;
+    }
+
+    TaskHandle_t task = nullptr;
+    if (xTaskCreate(drainTask, "ot_bus_log", stackSize, nullptr, priority, &task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_drainTask = task;
+    xTaskNotifyGive(task);  // Drain whatever was pushed before start()
+    return ESP_OK;
+}
+
+uint32_t BusLog::dropped()
+{
+    return s_dropped.load(std::memory_order_relaxed);
+}
+
+size_t BusLog::snapshot(uint8_t* out, size_t size)
+{
+    size_t written = 0;
+    lockShared();
+    size_t first = (s_recentNext + RECENT_FAILURES - s_recentCount) % RECENT_FAILURES;
+    for (size_t i = 0; i < s_recentCount; i++) {
+        const LogRecord& r = s_recent[(first + i) % RECENT_FAILURES];
+        size_t bytes = LOG_RECORD_HEADER_BYTES + r.symbolCount * sizeof(rmt_symbol_word_t);
+        if (written + bytes > size) break;
+        memcpy(out + written, &r, bytes);
+        written += bytes;
+    }
+    unlockShared();
+    return written;
+}
+
+} // namespace ot
@@ -0,0 +1,95 @@
+#ifndef BUS_LOG_H
+#define BUS_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/rmt_types.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+namespace ot {
+
+/**
+ * Deferred binary log for the bus hot paths
+ *
+ * The RMT monitor tasks and the manager loop push fixed-size records into a
+ * lock-free ring instead of formatting text; a low-priority task drains the
+ * ring and prints each record with ESP_LOG. A push never blocks: when the
+ * ring is full the record is dropped and counted.
+ */
+
+enum class LogEvent : uint8_t
+{
+    ParseFailed,     // source: 'T'/'B' side, arg: ParseError | bit << 8, symbols attached
+    FrameDecoded,    // source: side, frame (RMT debug logging), symbols attached when batch
+    StreamFailed,    // source: side, arg: ParseError | bit << 8 (streaming receive, no symbols)
+    Forwarding,      // frame: thermostat request about to be sent to the boiler
+    BoilerResponse,  // frame: boiler response, arg: request-to-response us
+    BoilerTimeout,   // frame: request, arg: us waited
+    ResponseSent,    // frame: response, arg: total us | ok << 31
+};
+
+// Direction of a frame the manager handled (see FrameEvent)
+enum class MessageDirection : uint8_t
+{
+    Request,
+    Response,
+    DiscardedRequest,
+};
+
+#ifdef CONFIG_OT_BUS_LOG_DEPTH
+static constexpr size_t BUS_LOG_DEPTH = CONFIG_OT_BUS_LOG_DEPTH;
+#else
+static constexpr size_t BUS_LOG_DEPTH = 32;
+#endif
+// Enough for a clean frame (at most 34 symbols) plus a few glitches
+static constexpr size_t BUS_LOG_MAX_SYMBOLS = 48;
+
+/**
+ * One log record. The first 16 bytes are the header; the binary form
+ * (BusLog::snapshot()) is the header followed by symbolCount raw RMT
+ * symbols, all little-endian.
+ */
+struct LogRecord
+{
+    uint32_t timestampUs;   // clockUs(), truncated
+    LogEvent event;
+    uint8_t source;
+    uint8_t symbolCount;    // Symbols stored (at most BUS_LOG_MAX_SYMBOLS)
+    uint8_t symbolTotal;    // Symbols in the capture (saturates at 255)
+    uint32_t frame;
+    uint32_t arg;
+    rmt_symbol_word_t symbols[BUS_LOG_MAX_SYMBOLS];
+};
+
+static constexpr size_t LOG_RECORD_HEADER_BYTES = 16;
+
+class BusLog
+{
+public:
+    // Start the drain task. Records pushed earlier are kept until it runs.
+    static esp_err_t start(UBaseType_t priority = 2, uint32_t stackSize = 3072);
+
+    // Enqueue a record; safe from any task. Returns false (and counts a drop)
+    // when the ring is full.
+    static bool push(LogEvent event, uint8_t source, uint32_t frame, uint32_t arg,
+                     const rmt_symbol_word_t* symbols = nullptr, size_t numSymbols = 0);
+
+    // Records lost to a full ring
+    static uint32_t dropped();
+
+    // Most recent failed captures (ParseFailed records) in binary form, oldest
+    // first. Returns bytes written.
+    static size_t snapshot(uint8_t* out, size_t size);
+
+    // Text form used by the drain task
+    static void format(const LogRecord& record, char* buffer, size_t size);
+};
+
+const char* toString(LogEvent event);
+const char* toString(MessageDirection direction);
+
+} // namespace ot
+
+#endif // BUS_LOG_H
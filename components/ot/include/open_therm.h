@@ -4,7 +4,6 @@
 #define OPEN_THERM_H
 
 #include <stdint.h>
-#include <functional>
 #include "driver/gpio.h"
 #include "driver/rmt_rx.h"
 #include "driver/rmt_tx.h"
@@ -13,205 +12,83 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "soc/soc_caps.h"
+#include "sdkconfig.h"
+#include "rmt_parser.h"
+#include "open_therm_protocol.h"
 
 namespace ot {
 
-
-enum class OpenThermResponseStatus : uint8_t
+class OpenTherm;
+
+/**
+ * Handle for a request submitted with OpenTherm::submitRequest()
+ *
+ * Completion is signalled from the RMT monitor task when the response is
+ * decoded (or fails to decode). Waiting sleeps on a semaphore instead of
+ * spinning on process(). Only the most recent transaction of an OpenTherm
+ * instance is live; older handles report NONE.
+ */
+class OpenThermTransaction
 {
-    NONE,
-    SUCCESS,
-    INVALID,
-    TIMEOUT
-};
+public:
+    OpenThermTransaction() = default;
 
-enum class OpenThermMessageType : uint8_t
-{
-    /*  Master to Slave */
-    READ_DATA = 0b000,
-    READ = READ_DATA, // for backward compatibility
-    WRITE_DATA = 0b001,
-    WRITE = WRITE_DATA, // for backward compatibility
-    INVALID_DATA = 0b010,
-    RESERVED = 0b011,
-    /* Slave to Master */
-    READ_ACK = 0b100,
-    WRITE_ACK = 0b101,
-    DATA_INVALID = 0b110,
-    UNKNOWN_DATA_ID = 0b111
-};
+    explicit operator bool() const { return owner_ != nullptr; }
 
-typedef OpenThermMessageType OpenThermRequestType; // for backward compatibility
+    // Block until the response arrives, decoding fails, the 1 s bus timeout
+    // expires (TIMEOUT) or `timeout` elapses. Returns NONE if the caller's
+    // timeout elapsed first; the transaction stays pending and can be waited
+    // on again or cancelled.
+    OpenThermResponseStatus wait(TickType_t timeout = portMAX_DELAY);
 
-enum class OpenThermMessageID : uint8_t
-{
-    Status                                       = 0, // flag8/flag8  Master and Slave Status flags.
-    TSet                                         = 1, // f8.8    Control Setpoint i.e.CH water temperature Setpoint(°C)
-    MConfigMMemberIDcode                         = 2, // flag8/u8  Master Configuration Flags / Master MemberID Code
-    SConfigSMemberIDcode                         = 3, // flag8/u8  Slave Configuration Flags / Slave MemberID Code
-    RemoteRequest                                = 4, // u8/u8     Remote Request
-    ASFflags                                     = 5, // flag8/u8  Application - specific fault flags and OEM fault code
-    RBPflags                                     = 6, // flag8/flag8   Remote boiler parameter transfer - enable & read / write flags
-    CoolingControl                               = 7, // f8.8    Cooling control signal(%)
-    TsetCH2                                      = 8, // f8.8    Control Setpoint for 2e CH circuit(°C)
-    TrOverride                                   = 9, // f8.8    Remote override room Setpoint
-    TSP                                         = 10, // u8/u8     Number of Transparent - Slave - Parameters supported by slave
-    TSPindexTSPvalue                            = 11, // u8/u8     Index number / Value of referred - to transparent slave parameter.
-    FHBsize                                     = 12, // u8/u8     Size of Fault - History - Buffer supported by slave
-    FHBindexFHBvalue                            = 13, // u8/u8     Index number / Value of referred - to fault - history buffer entry.
-    MaxRelModLevelSetting                       = 14, // f8.8    Maximum relative modulation level setting(%)
-    MaxCapacityMinModLevel                      = 15, // u8/u8     Maximum boiler capacity(kW) / Minimum boiler modulation level(%)
-    TrSet                                       = 16, // f8.8    Room Setpoint(°C)
-    RelModLevel                                 = 17, // f8.8    Relative Modulation Level(%)
-    CHPressure                                  = 18, // f8.8    Water pressure in CH circuit(bar)
-    DHWFlowRate                                 = 19, // f8.8    Water flow rate in DHW circuit. (litres / minute)
-    DayTime                                     = 20, // special/u8    Day of Week and Time of Day
-    Date                                        = 21, // u8/u8     Calendar date
-    Year                                        = 22, // u16     Calendar year
-    TrSetCH2                                    = 23, // f8.8    Room Setpoint for 2nd CH circuit(°C)
-    Tr                                          = 24, // f8.8    Room temperature(°C)
-    Tboiler                                     = 25, // f8.8    Boiler flow water temperature(°C)
-    Tdhw                                        = 26, // f8.8    DHW temperature(°C)
-    Toutside                                    = 27, // f8.8    Outside temperature(°C)
-    Tret                                        = 28, // f8.8    Return water temperature(°C)
-    Tstorage                                    = 29, // f8.8    Solar storage temperature(°C)
-    Tcollector                                  = 30, // f8.8    Solar collector temperature(°C)
-    TflowCH2                                    = 31, // f8.8    Flow water temperature CH2 circuit(°C)
-    Tdhw2                                       = 32, // f8.8    Domestic hot water temperature 2 (°C)
-    Texhaust                                    = 33, // s16     Boiler exhaust temperature(°C)
-    TboilerHeatExchanger                        = 34, // f8.8    Boiler heat exchanger temperature(°C)
-    BoilerFanSpeedSetpointAndActual             = 35, // u8/u8     Boiler fan speed Setpoint and actual value
-    FlameCurrent                                = 36, // f8.8    Electrical current through burner flame[μA]
-    TrCH2                                       = 37, // f8.8    Room temperature for 2nd CH circuit(°C)
-    RelativeHumidity                            = 38, // f8.8    Actual relative humidity as a percentage
-    TrOverride2                                 = 39, // f8.8    Remote Override Room Setpoint 2
-    TdhwSetUBTdhwSetLB                          = 48, // s8/s8     DHW Setpoint upper & lower bounds for adjustment(°C)
-    MaxTSetUBMaxTSetLB                          = 49, // s8/s8     Max CH water Setpoint upper & lower bounds for adjustment(°C)
-    TdhwSet                                     = 56, // f8.8    DHW Setpoint(°C) (Remote parameter 1)
-    MaxTSet                                     = 57, // f8.8    Max CH water Setpoint(°C) (Remote parameters 2)
-    StatusVentilationHeatRecovery               = 70, // flag8/flag8   Master and Slave Status flags ventilation / heat - recovery
-    Vset                                        = 71, // -/u8  Relative ventilation position (0-100%).
-    ASFflagsOEMfaultCodeVentilationHeatRecovery = 72, // flag8/u8  Application-specific fault flags and OEM fault code ventilation / heat-recovery
-    OEMDiagnosticCodeVentilationHeatRecovery    = 73, // u16     An OEM-specific diagnostic/service code for ventilation / heat-recovery system
-    SConfigSMemberIDCodeVentilationHeatRecovery = 74, // flag8/u8  Slave Configuration Flags / Slave MemberID Code ventilation / heat-recovery
-    OpenThermVersionVentilationHeatRecovery     = 75, // f8.8    The implemented version of the OpenTherm Protocol Specification in the ventilation / heat-recovery system.
-    VentilationHeatRecoveryVersion              = 76, // u8/u8     Ventilation / heat-recovery product version number and type
-    RelVentLevel                                = 77, // -/u8  Relative ventilation (0-100%)
-    RHexhaust                                   = 78, // -/u8  Relative humidity exhaust air (0-100%)
-    CO2exhaust                                  = 79, // u16     CO2 level exhaust air (0-2000 ppm)
-    Tsi                                         = 80, // f8.8    Supply inlet temperature (°C)
-    Tso                                         = 81, // f8.8    Supply outlet temperature (°C)
-    Tei                                         = 82, // f8.8    Exhaust inlet temperature (°C)
-    Teo                                         = 83, // f8.8    Exhaust outlet temperature (°C)
-    RPMexhaust                                  = 84, // u16     Exhaust fan speed in rpm
-    RPMsupply                                   = 85, // u16     Supply fan speed in rpm
-    RBPflagsVentilationHeatRecovery             = 86, // flag8/flag8   Remote ventilation / heat-recovery parameter transfer-enable & read/write flags
-    NominalVentilationValue                     = 87, // u8/-  Nominal relative value for ventilation (0-100 %)
-    TSPventilationHeatRecovery                  = 88, // u8/u8     Number of Transparent-Slave-Parameters supported by TSP's ventilation / heat-recovery
-    TSPindexTSPvalueVentilationHeatRecovery     = 89, // u8/u8     Index number / Value of referred-to transparent TSP's ventilation / heat-recovery parameter.
-    FHBsizeVentilationHeatRecovery              = 90, // u8/u8     Size of Fault-History-Buffer supported by ventilation / heat-recovery
-    FHBindexFHBvalueVentilationHeatRecovery     = 91, // u8/u8     Index number / Value of referred-to fault-history buffer entry ventilation / heat-recovery
-    Brand                                       = 93, // u8/u8     Index number of the character in the text string ASCII character referenced by the above index number
-    BrandVersion                                = 94, // u8/u8     Index number of the character in the text string ASCII character referenced by the above index number
-    BrandSerialNumber                           = 95, // u8/u8     Index number of the character in the text string ASCII character referenced by the above index number
-    CoolingOperationHours                       = 96, // u16     Number of hours that the slave is in Cooling Mode.
-    PowerCycles                                 = 97, // u16     Number of Power Cycles of a slave (wake-up after Reset)
-    RFsensorStatusInformation                   = 98, // special/special   For a specific RF sensor the RF strength and battery level is written
-    RemoteOverrideOperatingModeHeatingDHW       = 99, // special/special   Operating Mode HC1, HC2/ Operating Mode DHW
-    RemoteOverrideFunction                     = 100, // flag8/-   Function of manual and program changes in master and remote room Setpoint
-    StatusSolarStorage                         = 101, // flag8/flag8   Master and Slave Status flags Solar Storage
-    ASFflagsOEMfaultCodeSolarStorage           = 102, // flag8/u8  Application-specific fault flags and OEM fault code Solar Storage
-    SConfigSMemberIDcodeSolarStorage           = 103, // flag8/u8  Slave Configuration Flags / Slave MemberID Code Solar Storage
-    SolarStorageVersion                        = 104, // u8/u8     Solar Storage product version number and type
-    TSPSolarStorage                            = 105, // u8/u8     Number of Transparent - Slave - Parameters supported by TSP's Solar Storage
-    TSPindexTSPvalueSolarStorage               = 106, // u8/u8     Index number / Value of referred - to transparent TSP's Solar Storage parameter.
-    FHBsizeSolarStorage                        = 107, // u8/u8     Size of Fault - History - Buffer supported by Solar Storage
-    FHBindexFHBvalueSolarStorage               = 108, // u8/u8     Index number / Value of referred - to fault - history buffer entry Solar Storage
-    ElectricityProducerStarts                  = 109, // U16     Number of start of the electricity producer.
-    ElectricityProducerHours                   = 110, // U16     Number of hours the electricity produces is in operation
-    ElectricityProduction                      = 111, // U16     Current electricity production in Watt.
-    CumulativElectricityProduction             = 112, // U16     Cumulative electricity production in KWh.
-    UnsuccessfulBurnerStarts                   = 113, // u16     Number of un - successful burner starts
-    FlameSignalTooLowNumber                    = 114, // u16     Number of times flame signal was too low
-    OEMDiagnosticCode                          = 115, // u16     OEM - specific diagnostic / service code
-    SuccessfulBurnerStarts                     = 116, // u16     Number of succesful starts burner
-    CHPumpStarts                               = 117, // u16     Number of starts CH pump
-    DHWPumpValveStarts                         = 118, // u16     Number of starts DHW pump / valve
-    DHWBurnerStarts                            = 119, // u16     Number of starts burner during DHW mode
-    BurnerOperationHours                       = 120, // u16     Number of hours that burner is in operation(i.e.flame on)
-    CHPumpOperationHours                       = 121, // u16     Number of hours that CH pump has been running
-    DHWPumpValveOperationHours                 = 122, // u16     Number of hours that DHW pump has been running or DHW valve has been opened
-    DHWBurnerOperationHours                    = 123, // u16     Number of hours that burner is in operation during DHW mode
-    OpenThermVersionMaster                     = 124, // f8.8    The implemented version of the OpenTherm Protocol Specification in the master.
-    OpenThermVersionSlave                      = 125, // f8.8    The implemented version of the OpenTherm Protocol Specification in the slave.
-    MasterVersion                              = 126, // u8/u8     Master product version number and type
-    SlaveVersion                               = 127, // u8/u8     Slave product version number and type
-};
+    // Abandon the transaction. A late response is ignored and the bus
+    // returns to READY after the normal inter-frame delay.
+    void cancel();
 
-enum class OpenThermStatus : uint8_t
-{
-    NOT_INITIALIZED,
-    READY,
-    DELAY,
-    REQUEST_SENDING,
-    RESPONSE_WAITING,
-    RESPONSE_START_BIT,
-    RESPONSE_RECEIVING,
-    RESPONSE_READY,
-    RESPONSE_INVALID
+    // Response frame (valid once wait() returned SUCCESS or INVALID)
+    unsigned long response() const { return response_; }
+    OpenThermResponseStatus status() const { return status_; }
+
+private:
+    friend class OpenTherm;
+    OpenThermTransaction(OpenTherm* owner, uint32_t seq) : owner_(owner), seq_(seq) {}
+
+    OpenTherm* owner_ = nullptr;
+    uint32_t seq_ = 0;
+    unsigned long response_ = 0;
+    OpenThermResponseStatus status_ = OpenThermResponseStatus::NONE;
 };
 
-// Forward declaration for friend function
+// Forward declaration for friend functions
 bool on_rmt_rx_done(rmt_channel_handle_t rx_chan, const rmt_rx_done_event_data_t *edata, void *user_ctx);
-
-class OpenTherm
+bool on_rmt_tx_done(rmt_channel_handle_t tx_chan, const rmt_tx_done_event_data_t *edata, void *user_ctx);
+void on_repeat_edge(void *arg);
+
+/**
+ * OpenTherm side on the ESP32: the protocol core driven by the RMT
+ * peripheral (the RMT backend), with a monitor task decoding captures and
+ * blocking transactions on top.
+ */
+class OpenTherm : private BusBackend, public OpenThermProtocol
 {
 public:
     friend void monitorTaskEntry(void* pvParameters);
+    friend class OpenThermTransaction;
     friend bool on_rmt_rx_done(rmt_channel_handle_t rx_chan, const rmt_rx_done_event_data_t *edata, void *user_ctx);
+    friend bool on_rmt_tx_done(rmt_channel_handle_t tx_chan, const rmt_tx_done_event_data_t *edata, void *user_ctx);
+    friend void on_repeat_edge(void *arg);
     OpenTherm(gpio_num_t inPin = GPIO_NUM_4, gpio_num_t outPin = GPIO_NUM_5, bool isSlave = false, bool invertOutput = false);
     ~OpenTherm();
-    volatile OpenThermStatus status;
     void begin();
-    bool isReady();
     unsigned long sendRequest(unsigned long request);
-    bool sendResponse(unsigned long request);
-    bool sendRequestAsync(unsigned long request);
-    [[deprecated("Use OpenTherm::sendRequestAsync(unsigned long) instead")]]
-    bool sendRequestAync(unsigned long request) {
-        return sendRequestAsync(request);
-    }
-    static unsigned long buildRequest(OpenThermMessageType type, OpenThermMessageID id, unsigned int data);
-    static unsigned long buildResponse(OpenThermMessageType type, OpenThermMessageID id, unsigned int data);
-    unsigned long getLastResponse();
-    OpenThermResponseStatus getLastResponseStatus();
-    static const char *statusToString(OpenThermResponseStatus status);
-    unsigned long process(std::function<void(unsigned long, OpenThermResponseStatus)> callback = nullptr);
+    // Send a request and return a handle to wait on or cancel. Sleeps out the
+    // inter-frame delay if the bus is still in DELAY. Returns an empty handle
+    // if another request is in flight or transmission failed.
+    OpenThermTransaction submitRequest(unsigned long request);
     void end();
 
-    static bool parity(unsigned long frame);
-    static OpenThermMessageType getMessageType(unsigned long message);
-    static OpenThermMessageID getDataID(unsigned long frame);
-    static const char *messageTypeToString(OpenThermMessageType message_type);
-    static bool isValidRequest(unsigned long request, bool isSlave);
-    static bool isValidResponse(unsigned long response, bool isSlave);
-
-    // requests
-    static unsigned long buildSetBoilerStatusRequest(bool enableCentralHeating, bool enableHotWater = false, bool enableCooling = false, bool enableOutsideTemperatureCompensation = false, bool enableCentralHeating2 = false);
-    static unsigned long buildSetBoilerTemperatureRequest(float temperature);
-    static unsigned long buildGetBoilerTemperatureRequest();
-
-    // responses
-    static bool isFault(unsigned long response);
-    static bool isCentralHeatingActive(unsigned long response);
-    static bool isHotWaterActive(unsigned long response);
-    static bool isFlameOn(unsigned long response);
-    static bool isCoolingActive(unsigned long response);
-    static bool isDiagnostic(unsigned long response);
-    static uint16_t getUInt(const unsigned long response);
-    static float getFloat(const unsigned long response);
-    static unsigned int temperatureToData(float temperature);
-
     // basic requests
     unsigned long setBoilerStatus(bool enableCentralHeating, bool enableHotWater = false, bool enableCooling = false, bool enableOutsideTemperatureCompensation = false, bool enableCentralHeating2 = false);
     bool setBoilerTemperature(float temperature);
@@ -226,16 +103,56 @@ public:
     // Debug/data collection
     // Enable detailed RMT symbol logging for test data collection.
     // When enabled, logs all RMT symbols with parsed frame result (success or failure).
+    // Lines are printed by the BusLog task, so they need BusLog::start().
     // Output format: "B RMT[n] -> 0x12345678: L500,H500,..." (success)
     //            or: "B RMT[n] FAILED (reason): L500,H500,..." (error)
     // Use this to collect test cases for parseRMTSymbols validation.
     void setRMTDebugLogging(bool enable) { rmtDebugLogging_ = enable; }
     bool getRMTDebugLogging() const { return rmtDebugLogging_; }
+    // Least free stack (bytes) the RMT monitor task has had so far
+    UBaseType_t monitorStackHeadroom() const;
+    // Frames that failed to decode and how many each repair saved
+    // (CONFIG_OT_RMT_FRAME_REPAIR; stays zero in streaming mode)
+    const RepairStats& repairStats() const { return rmtRepairs_; }
+    // Protocol counters plus this side's repair counts
+    BusStats busStats() const;
+
+    // Event notification
+    // Register a task to be woken (xTaskNotify with eSetBits) whenever the monitor
+    // task decodes a frame, a pending response fails to decode, or a transmitted
+    // frame has left the wire. Lets a consumer block in xTaskNotifyWait()
+    // instead of polling process().
+    void setEventNotify(TaskHandle_t task, uint32_t bits);
+    // Ticks until process() has a timeout or inter-frame delay to act on,
+    // 0 if a result is already pending, portMAX_DELAY when idle.
+    TickType_t nextProcessDeadline() const;
+    // esp_timer timestamp (us, truncated) of the last completed transmission
+    unsigned long lastTxDoneTimestamp() const { return txDoneTimestamp_; }
+    // Block until every queued frame has left the wire
+    bool waitTxIdle(TickType_t timeout);
+
+    // Cut-through repeating
+    // Re-emit the half-bits seen on this instance's input pin on target's
+    // output, REPEAT_LEAD_US behind the wire, instead of waiting for the whole
+    // frame to be decoded and re-encoded. RMT RX keeps decoding the frames so
+    // process() still reports them. The target must not send frames of its own
+    // while it is repeating. Pass nullptr to stop.
+    esp_err_t repeatTo(OpenTherm* target);
+    // Runs dropped because the target's TX ring was full or a half-bit was
+    // out of tolerance (each aborts the rest of that frame)
+    uint32_t repeatDropCount() const { return repeatDrops_; }
 
 
     void monitorInterrupts();
 
 private:
+    // BusBackend (RMT)
+    bool transmit(uint32_t frame) override { return sendFrameRMT(frame); }
+    uint32_t nowUs() const override;
+    void requestCompleted(uint32_t frame, OpenThermResponseStatus result) override;
+    void lockState() override { taskENTER_CRITICAL(&txnLock_); }
+    void unlockState() override { taskEXIT_CRITICAL(&txnLock_); }
+
     void monitorRMT();
 
     // RMT methods
@@ -243,22 +160,33 @@ private:
     void initRMTTx();
     void startRMTReceive();
     void stopRMTReceive();
-    uint32_t parseRMTSymbols(rmt_symbol_word_t* symbols, size_t num_symbols);
-    void buildRMTSymbolLogString(rmt_symbol_word_t* symbols, size_t num_symbols, char* buffer, size_t bufferSize);
+    uint32_t parseRMTSymbols(rmt_symbol_word_t* symbols, size_t num_symbols, ParseError& error);
     size_t encodeFrameToRMT(unsigned long frame, rmt_symbol_word_t* symbols);
     bool sendFrameRMT(unsigned long frame);
+    esp_err_t startRepeatSink();
+    void stopRepeatSink();
+    static void repeatTaskEntry(void* arg);
+    void repeatTask();
+    bool transmitRepeatRun(uint8_t run);
     const gpio_num_t inPin;
     const gpio_num_t outPin;
-    const bool isSlave;
     const bool invertOutput;
 
-    volatile unsigned long response;
-    volatile OpenThermResponseStatus responseStatus;
-    volatile unsigned long responseTimestamp;
-
     TaskHandle_t monitorTaskHandle_;
     bool rmtDebugLogging_;  // Flag to enable verbose RMT symbol logging
 
+    // Task notified on decoded frames (see setEventNotify)
+    TaskHandle_t volatile eventTask_;
+    volatile uint32_t eventBits_;
+
+    // Transaction completion (see submitRequest)
+    portMUX_TYPE txnLock_;
+    SemaphoreHandle_t txnDone_;
+    volatile uint32_t txnSeq_;                 // Sequence of the live transaction
+    volatile uint32_t txnCompletedSeq_;        // Sequence the completion belongs to
+    volatile unsigned long txnResponse_;
+    volatile OpenThermResponseStatus txnStatus_;
+
     // RMT-related members
     rmt_channel_handle_t rmtChannel_;      // RX channel
     rmt_channel_handle_t rmtTxChannel_;    // TX channel
@@ -269,93 +197,50 @@ private:
     volatile uint8_t rmtActiveBuffer_;    // Which buffer RMT is writing to (0 or 1)
     volatile size_t rmtFrameSize_;        // Number of symbols received (set by ISR)
     volatile bool rmtFrameReady_;         // Flag to indicate frame ready for processing
-
-    // TX buffer for RMT (34 bits = 34 symbols max)
-    rmt_symbol_word_t rmtTxBuffer_[34];
-};
-
-enum class MessageType : uint8_t {
-    ReadData     = 0b000,
-    WriteData    = 0b001,
-    InvalidData  = 0b010,
-    Reserved     = 0b011,
-    ReadAck      = 0b100,
-    WriteAck     = 0b101,
-    DataInvalid  = 0b110,
-    UnknownId    = 0b111
+    BitClock rmtBitClock_;                // This side's half-bit period, tracked across frames
+    RepairStats rmtRepairs_;              // Written by the monitor task only
+    volatile unsigned long rmtRxDoneUs_;  // When the ISR published the capture (set with rmtFrameReady_)
+
+#if CONFIG_OT_RMT_STREAMING_RX
+    // Partial receive: the ISR feeds each chunk to the streaming decoder and
+    // publishes the result; the user buffer only has to hold one ping-pong half
+    static constexpr size_t RMT_RX_RECEIVE_BYTES = (SOC_RMT_MEM_WORDS_PER_CHANNEL / 2) * sizeof(rmt_symbol_word_t);
+    ManchesterDecoder rmtDecoder_;
+    volatile uint32_t rmtStreamFrame_;    // Decoded frame (0 on failure)
+    volatile ParseError rmtStreamError_;
+    volatile int rmtStreamBit_;
+    volatile uint32_t rmtStreamHalfBitUs_; // Measured half-bit period of the decoded frame
+    volatile bool rmtRestartPending_;     // Reception ended, task must call rmt_receive()
+#else
+    static constexpr size_t RMT_RX_RECEIVE_BYTES = sizeof(rmt_symbol_word_t) * 128;
+#endif
+
+    // TX ring for RMT: one pre-encoded frame (34 bits = 34 symbols) per queued
+    // transaction. A slot is claimed from rmtTxSlots_ when a frame is encoded
+    // and returned by the TX-done callback once it has left the wire.
+    // Cut-through keeps up to REPEAT_LEAD_US worth of single-symbol runs queued.
+    static constexpr size_t RMT_TX_QUEUE_DEPTH = 8;
+    rmt_symbol_word_t rmtTxBuffers_[RMT_TX_QUEUE_DEPTH][34];
+    uint8_t rmtTxHead_;                   // Next slot to encode into
+    SemaphoreHandle_t rmtTxSlots_;        // Counting semaphore of free slots
+    volatile unsigned long txDoneTimestamp_;
+
+    // Cut-through repeater, source side (state owned by on_repeat_edge)
+    OpenTherm* volatile repeatTarget_;
+    int64_t repeatLastEdgeUs_;
+    int repeatLevel_;                     // Input level after the last edge
+    int repeatIdleLevel_;                 // Input idle level (learned from inter-frame gaps)
+    bool repeatInFrame_;                  // Forwarding a frame (false between frames or after an abort)
+    uint8_t repeatHalfBits_;              // Half-bits forwarded in the current frame
+    volatile uint32_t repeatDrops_;
+
+    // Cut-through repeater, target side: runs queued by the source's edge ISR
+    // and put on the wire by repeatTask (rmt_transmit is not ISR-safe)
+    QueueHandle_t repeatQueue_;
+    TaskHandle_t repeatTaskHandle_;
+    volatile bool repeatSink_;            // Suppress per-run TX-done event notifications
 };
 
-class Frame {
-public:
-    constexpr Frame() : raw_(0) {}
-    constexpr explicit Frame(uint32_t raw) : raw_(raw) {}
-
-    static Frame buildRequest(MessageType type, uint8_t dataId, uint16_t data) {
-        uint32_t frame = (static_cast<uint32_t>(type) << 28) |
-                         (static_cast<uint32_t>(dataId) << 16) |
-                         data;
-        // Add parity bit if needed (odd parity)
-        uint8_t p = 0;
-        uint32_t temp = frame;
-        while (temp > 0) {
-            if (temp & 1) p++;
-            temp >>= 1;
-        }
-        if (p & 1) frame |= (1UL << 31);
-        return Frame(frame);
-    }
-
-    static Frame buildResponse(MessageType type, uint8_t dataId, uint16_t data) {
-        return buildRequest(type, dataId, data);
-    }
-
-    constexpr uint32_t raw() const { return raw_; }
-
-    constexpr MessageType messageType() const {
-        return static_cast<MessageType>((raw_ >> 28) & 0x7);
-    }
-
-    constexpr uint8_t dataId() const {
-        return static_cast<uint8_t>((raw_ >> 16) & 0xFF);
-    }
-
-    constexpr uint16_t dataValue() const {
-        return static_cast<uint16_t>(raw_ & 0xFFFF);
-    }
-
-    constexpr uint8_t highByte() const {
-        return static_cast<uint8_t>((raw_ >> 8) & 0xFF);
-    }
-
-    constexpr uint8_t lowByte() const {
-        return static_cast<uint8_t>(raw_ & 0xFF);
-    }
-
-    float asFloat() const {
-        uint16_t u88 = dataValue();
-        return (u88 & 0x8000) ? -(0x10000L - u88) / 256.0f : u88 / 256.0f;
-    }
-
-    constexpr explicit operator bool() const { return raw_ != 0; }
-
-private:
-    uint32_t raw_;
-};
-
-inline const char* toString(MessageType type) {
-    switch (type) {
-        case MessageType::ReadData:    return "READ_DATA";
-        case MessageType::WriteData:   return "WRITE_DATA";
-        case MessageType::InvalidData: return "INVALID_DATA";
-        case MessageType::Reserved:    return "RESERVED";
-        case MessageType::ReadAck:     return "READ_ACK";
-        case MessageType::WriteAck:    return "WRITE_ACK";
-        case MessageType::DataInvalid: return "DATA_INVALID";
-        case MessageType::UnknownId:   return "UNKNOWN_ID";
-        default:                       return "UNKNOWN";
-    }
-}
-
 } // namespace ot
 
 #endif // OpenTherm_h
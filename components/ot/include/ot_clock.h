@@ -0,0 +1,71 @@
+/*
+ * Injectable time source
+ *
+ * Timeouts, ages and timestamps across the gateway (bus transactions, the
+ * bus log, diagnostics, MQTT heartbeat, websocket events) read the time
+ * through clockUs()/clockMs() rather than esp_timer_get_time(). The system
+ * clock is used unless another is installed with setClock(); a host build
+ * installs a VirtualClock and steps it, so hours of bus time run in
+ * milliseconds.
+ */
+
+#ifndef OT_CLOCK_H
+#define OT_CLOCK_H
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+namespace ot {
+
+class Clock
+{
+public:
+    virtual ~Clock() = default;
+
+    // Microseconds since an arbitrary epoch, monotonic
+    virtual int64_t nowUs() const = 0;
+};
+
+/**
+ * Clock that only moves when told to. Safe to read from any thread while
+ * one thread steps it.
+ */
+class VirtualClock : public Clock
+{
+public:
+    explicit VirtualClock(int64_t startUs = 0) : nowUs_(startUs) {}
+
+    int64_t nowUs() const override { return nowUs_.load(std::memory_order_acquire); }
+
+    void advance(int64_t us) { nowUs_.fetch_add(us, std::memory_order_acq_rel); }
+    // Never moves backwards
+    void advanceTo(int64_t us) {
+        int64_t cur = nowUs_.load(std::memory_order_relaxed);
+        while (us > cur && !nowUs_.compare_exchange_weak(cur, us, std::memory_order_acq_rel)) {
+        }
+    }
+
+private:
+    std::atomic<int64_t> nowUs_;
+};
+
+/**
+ * Install the clock everything reads (nullptr restores the system clock).
+ * The clock must outlive its installation. Install before starting the
+ * components: timestamps taken on different clocks do not compare.
+ */
+void setClock(Clock* clock);
+
+// Current time on the installed clock. Callable from ISRs on the system
+// clock (IRAM); a VirtualClock is for host builds only.
+int64_t clockUs();
+
+inline std::chrono::milliseconds clockMs()
+{
+    return std::chrono::milliseconds(clockUs() / 1000);
+}
+
+} // namespace ot
+
+#endif // OT_CLOCK_H
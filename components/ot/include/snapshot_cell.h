@@ -0,0 +1,117 @@
+/*
+ * Lock-free snapshot cell
+ *
+ * Holds a small trivially copyable struct that one task at a time writes
+ * and any task reads, without a lock on the read side. There are two
+ * copies: a writer fills the one readers are not looking at, then flips
+ * the index. Each copy carries a sequence number, odd while it is
+ * written, so a reader that overlapped a write notices and reads again
+ * from the copy just published. A reader therefore only ever repeats
+ * because a writer completed a store meanwhile; one that preempts a
+ * writer mid-store reads the other, complete copy first time. Repeats
+ * are counted, to show how contended the cell is.
+ *
+ * The data is kept in relaxed atomic words, so concurrent reads and
+ * writes are well defined.
+ */
+
+#ifndef SNAPSHOT_CELL_H
+#define SNAPSHOT_CELL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+namespace ot {
+
+template <typename T>
+class SnapshotCell
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SnapshotCell copies T word by word");
+
+public:
+    explicit SnapshotCell(const T& initial = T())
+    {
+        write(0, initial);
+        write(1, initial);
+    }
+
+    SnapshotCell(const SnapshotCell&) = delete;
+    SnapshotCell& operator=(const SnapshotCell&) = delete;
+
+    // Never blocks
+    T load() const
+    {
+        T out;
+        while (true) {
+            const uint32_t index = active_.load(std::memory_order_acquire);
+            const Copy& copy = copies_[index];
+            const uint32_t before = copy.seq.load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                uint32_t words[WORDS];
+                for (size_t i = 0; i < WORDS; i++) {
+                    words[i] = copy.words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (copy.seq.load(std::memory_order_relaxed) == before) {
+                    memcpy(&out, words, sizeof(T));
+                    return out;
+                }
+            }
+            retries_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Writers must be serialised by the caller
+    void store(const T& value)
+    {
+        const uint32_t next = active_.load(std::memory_order_relaxed) ^ 1;
+        write(next, value);
+        active_.store(next, std::memory_order_release);
+    }
+
+    // Read-modify-write for the (serialised) writer
+    template <typename F>
+    void update(F&& modify)
+    {
+        T value = load();
+        modify(value);
+        store(value);
+    }
+
+    // Reads that had to start over because a store overlapped them
+    uint32_t retries() const { return retries_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    struct Copy
+    {
+        std::atomic<uint32_t> seq{0};       // Odd while being written
+        std::atomic<uint32_t> words[WORDS];
+    };
+
+    void write(uint32_t index, const T& value)
+    {
+        Copy& copy = copies_[index];
+        uint32_t words[WORDS] = {};
+        memcpy(words, &value, sizeof(T));
+        const uint32_t seq = copy.seq.load(std::memory_order_relaxed);
+        copy.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            copy.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        copy.seq.store(seq + 2, std::memory_order_release);
+    }
+
+    Copy copies_[2];
+    std::atomic<uint32_t> active_{0};
+    mutable std::atomic<uint32_t> retries_{0};
+};
+
+} // namespace ot
+
+#endif // SNAPSHOT_CELL_H
@@ -1,11 +1,14 @@
 
 #include "open_therm.h"
 #include "rmt_parser.h"
+#include "bus_log.h"
 #include "driver/gpio.h"
+#include "ot_clock.h"
 #include "esp_timer.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <algorithm>
 #include <cstring>
 
 
@@ -17,12 +20,59 @@ static void monitorTaskEntry(void* pvParameters) {
 
 namespace ot {
 
+static rmt_receive_config_t makeReceiveConfig()
+{
+    // Half-bits are ~500μs, full bits ~1000μs, so allow some tolerance
+    rmt_receive_config_t receive_config = {
+        .signal_range_min_ns = 3000,  // 3μs minimum (filter noise)
+        .signal_range_max_ns = 2000000, // 2000μs maximum (allow tolerance)
+    };
+#if CONFIG_OT_RMT_STREAMING_RX
+    // Deliver symbols chunk by chunk so the decoder can finish at the stop bit
+    receive_config.flags.en_partial_rx = true;
+#endif
+    return receive_config;
+}
+
 bool IRAM_ATTR on_rmt_rx_done(rmt_channel_handle_t rx_chan, const rmt_rx_done_event_data_t *edata, void *user_ctx) {
     OpenTherm* instance = static_cast<OpenTherm*>(user_ctx);
     BaseType_t high_task_wakeup = pdFALSE;
 
+#if CONFIG_OT_RMT_STREAMING_RX
+    // Partial receive: decode each chunk as it lands instead of waiting for
+    // the idle timeout, and publish the frame as soon as the stop bit is seen
+    ManchesterDecoder& decoder = instance->rmtDecoder_;
+    bool notify = false;
+    if (decoder.state() == ManchesterDecoder::State::Receiving) {
+        decoder.feed(edata->received_symbols, edata->num_symbols);
+        if (edata->flags.is_last) {
+            decoder.finish();
+        }
+        if (decoder.state() != ManchesterDecoder::State::Receiving) {
+            instance->rmtStreamFrame_ = decoder.frame();
+            instance->rmtStreamError_ = decoder.error();
+            instance->rmtStreamBit_ = decoder.bitIndex();
+            instance->rmtStreamHalfBitUs_ = decoder.measuredHalfBitUs();
+            instance->rmtFrameSize_ = decoder.symbolsConsumed();
+            instance->rmtRxDoneUs_ = clockUs();
+            instance->rmtFrameReady_ = true;
+            notify = true;
+        }
+    }
+    if (edata->flags.is_last) {
+        // Reception ended on idle: arm the decoder and let the task restart RX
+        decoder.reset(instance->rmtBitClock_);
+        instance->rmtRestartPending_ = true;
+        notify = true;
+    }
+
+    if (notify && instance->monitorTaskHandle_ != nullptr) {
+        vTaskNotifyGiveFromISR(instance->monitorTaskHandle_, &high_task_wakeup);
+    }
+#else
     // Record frame size from current buffer (the one RMT just finished writing)
     instance->rmtFrameSize_ = edata->num_symbols;
+    instance->rmtRxDoneUs_ = clockUs();
     instance->rmtFrameReady_ = true;
 
     // Swap to the other buffer for the next receive (task will restart receive)
@@ -32,30 +82,152 @@ bool IRAM_ATTR on_rmt_rx_done(rmt_channel_handle_t rx_chan, const rmt_rx_done_ev
     if (instance->monitorTaskHandle_ != nullptr) {
         vTaskNotifyGiveFromISR(instance->monitorTaskHandle_, &high_task_wakeup);
     }
+#endif
+
+    return high_task_wakeup == pdTRUE;
+}
+
+bool IRAM_ATTR on_rmt_tx_done(rmt_channel_handle_t tx_chan, const rmt_tx_done_event_data_t *edata, void *user_ctx) {
+    OpenTherm* instance = static_cast<OpenTherm*>(user_ctx);
+    BaseType_t high_task_wakeup = pdFALSE;
+    unsigned long now = clockUs();
+
+    instance->txDoneTimestamp_ = now;
+
+    // The request is on the wire: start the response timeout from here
+    taskENTER_CRITICAL_ISR(&instance->txnLock_);
+    instance->transmitDone(now);
+    taskEXIT_CRITICAL_ISR(&instance->txnLock_);
+
+    // Return the buffer slot for the next frame
+    xSemaphoreGiveFromISR(instance->rmtTxSlots_, &high_task_wakeup);
+
+    // Repeated runs complete every half-bit or two; nobody waits on those
+    TaskHandle_t eventTask = instance->eventTask_;
+    if (eventTask != nullptr && !instance->repeatSink_) {
+        xTaskNotifyFromISR(eventTask, instance->eventBits_, eSetBits, &high_task_wakeup);
+    }
 
     return high_task_wakeup == pdTRUE;
 }
 
+// Cut-through repeater run encoding (one byte per queue item)
+static constexpr uint8_t REPEAT_HALF_BITS_MASK = 0x03;  // 1 or 2 half-bits
+static constexpr uint8_t REPEAT_ACTIVE = 1u << 2;       // Run is at the active level
+static constexpr uint8_t REPEAT_LEAD = 1u << 5;         // Frame start: hold idle for the lead
+static constexpr uint8_t REPEAT_ABORT = 1u << 6;        // Frame broken: return to idle
+static constexpr uint8_t REPEAT_EXIT = 1u << 7;         // Stop repeatTask
+static constexpr size_t REPEAT_QUEUE_LENGTH = 16;
+
+// Delay between a half-bit arriving and being re-emitted. A run's length is
+// only known once the following edge arrives, i.e. up to two half-bits after
+// it started, so the lead has to cover one bit period plus the ISR -> task ->
+// rmt_transmit latency.
+static constexpr uint32_t REPEAT_LEAD_US = 1500;
+static constexpr uint8_t REPEAT_FRAME_HALF_BITS = 67;  // 34 bits, last idle half merges into the gap
+
+void IRAM_ATTR on_repeat_edge(void *arg) {
+    OpenTherm* instance = static_cast<OpenTherm*>(arg);
+    OpenTherm* target = instance->repeatTarget_;
+    if (target == nullptr || target->repeatQueue_ == nullptr) {
+        return;
+    }
+
+    // Pulse widths are measured on the hardware timer, whatever clock is installed
+    int64_t now = esp_timer_get_time();
+    int level = gpio_get_level(instance->inPin);
+    if (level == instance->repeatLevel_) {
+        return;  // Glitch shorter than the ISR latency
+    }
+    uint32_t durationUs = static_cast<uint32_t>(now - instance->repeatLastEdgeUs_);
+    bool wasActive = instance->repeatLevel_ != instance->repeatIdleLevel_;
+    instance->repeatLastEdgeUs_ = now;
+    instance->repeatLevel_ = level;
+
+    uint8_t halfBits = 0;
+    if (durationUs >= 300 && durationUs < 700) {
+        halfBits = 1;
+    } else if (durationUs >= 700 && durationUs <= 1300) {
+        halfBits = 2;
+    }
+
+    uint8_t run;
+    if (durationUs > 1300) {
+        // Only the bus idles that long: learn its level, this edge starts a frame
+        instance->repeatIdleLevel_ = 1 - level;
+        instance->repeatInFrame_ = true;
+        instance->repeatHalfBits_ = 0;
+        run = REPEAT_LEAD;
+    } else if (!instance->repeatInFrame_) {
+        return;  // Rest of an aborted frame
+    } else if (halfBits == 0) {
+        instance->repeatInFrame_ = false;
+        instance->repeatDrops_ = instance->repeatDrops_ + 1;
+        run = REPEAT_ABORT;
+    } else {
+        run = halfBits | (wasActive ? REPEAT_ACTIVE : 0);
+        instance->repeatHalfBits_ += halfBits;
+        if (instance->repeatHalfBits_ >= REPEAT_FRAME_HALF_BITS) {
+            instance->repeatInFrame_ = false;  // Stop bit done, wait for the next gap
+        }
+    }
+
+    BaseType_t high_task_wakeup = pdFALSE;
+    if (xQueueSendFromISR(target->repeatQueue_, &run, &high_task_wakeup) != pdTRUE) {
+        instance->repeatInFrame_ = false;
+        instance->repeatDrops_ = instance->repeatDrops_ + 1;
+    }
+    if (high_task_wakeup == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
 OpenTherm::OpenTherm(gpio_num_t inPin, gpio_num_t outPin, bool isSlave, bool invertOutput) :
-    status(OpenThermStatus::NOT_INITIALIZED),
+    OpenThermProtocol(*this, isSlave),
     inPin(inPin),
     outPin(outPin),
-    isSlave(isSlave),
     invertOutput(invertOutput),
-    response(0),
-    responseStatus(OpenThermResponseStatus::NONE),
-    responseTimestamp(0),
     monitorTaskHandle_(nullptr),
     rmtDebugLogging_(false),
+    eventTask_(nullptr),
+    eventBits_(0),
+    txnLock_(portMUX_INITIALIZER_UNLOCKED),
+    txnDone_(xSemaphoreCreateBinary()),
+    txnSeq_(0),
+    txnCompletedSeq_(0),
+    txnResponse_(0),
+    txnStatus_(OpenThermResponseStatus::NONE),
     rmtChannel_(nullptr),
     rmtTxChannel_(nullptr),
     rmtCopyEncoder_(nullptr),
     rmtActiveBuffer_(0),
     rmtFrameSize_(0),
-    rmtFrameReady_(false)
+    rmtFrameReady_(false),
+    rmtRepairs_(),
+    rmtRxDoneUs_(0),
+#if CONFIG_OT_RMT_STREAMING_RX
+    rmtStreamFrame_(0),
+    rmtStreamError_(ParseError::None),
+    rmtStreamBit_(0),
+    rmtStreamHalfBitUs_(0),
+    rmtRestartPending_(false),
+#endif
+    rmtTxHead_(0),
+    rmtTxSlots_(xSemaphoreCreateCounting(RMT_TX_QUEUE_DEPTH, RMT_TX_QUEUE_DEPTH)),
+    txDoneTimestamp_(0),
+    repeatTarget_(nullptr),
+    repeatLastEdgeUs_(0),
+    repeatLevel_(0),
+    repeatIdleLevel_(0),
+    repeatInFrame_(false),
+    repeatHalfBits_(0),
+    repeatDrops_(0),
+    repeatQueue_(nullptr),
+    repeatTaskHandle_(nullptr),
+    repeatSink_(false)
 {
     memset(rmtRxBuffers_, 0, sizeof(rmtRxBuffers_));
-    memset(rmtTxBuffer_, 0, sizeof(rmtTxBuffer_));
+    memset(rmtTxBuffers_, 0, sizeof(rmtTxBuffers_));
 }
 
 void OpenTherm::begin()
@@ -91,7 +263,7 @@ void OpenTherm::begin()
     BaseType_t ret = xTaskCreatePinnedToCore(
         monitorTaskEntry,
         "ot_rmt_monitor",
-        4096, // Stack size (bytes) - reduced from 8192 (parseRMTSymbols now uses ~512B for error logs)
+        4096, // Stack size (bytes): the repair stage uses ~1KB; symbol dumps are formatted by the bus log task
         this,
         configMAX_PRIORITIES - 1, // High priority
         &monitorTaskHandle_,
@@ -106,7 +278,7 @@ void OpenTherm::begin()
     // Start RMT reception
     startRMTReceive();
 
-    status = OpenThermStatus::READY;
+    start();
 }
 
 void OpenTherm::initRMT()
@@ -118,7 +290,12 @@ void OpenTherm::initRMT()
         .gpio_num = inPin,
         .clk_src = RMT_CLK_SRC_DEFAULT,
         .resolution_hz = 1000000,  // 1MHz resolution (1μs ticks)
+#if CONFIG_OT_RMT_STREAMING_RX
+        // Ping-pong receive only needs one hardware block (48 symbols on C3)
+        .mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL,
+#else
         .mem_block_symbols = 128,  // Memory block size for received symbols
+#endif
     };
 
     ESP_ERROR_CHECK(rmt_new_rx_channel(&rx_config, &rmtChannel_));
@@ -146,7 +323,7 @@ void OpenTherm::initRMTTx()
         .clk_src = RMT_CLK_SRC_DEFAULT,
         .resolution_hz = 1000000,  // 1MHz resolution (1μs ticks)
         .mem_block_symbols = 64,   // Memory block size
-        .trans_queue_depth = 4,    // Transaction queue depth
+        .trans_queue_depth = RMT_TX_QUEUE_DEPTH,  // One transaction per TX ring slot
     };
 
     ESP_ERROR_CHECK(rmt_new_tx_channel(&tx_config, &rmtTxChannel_));
@@ -157,6 +334,12 @@ void OpenTherm::initRMTTx()
     ESP_ERROR_CHECK(rmt_new_copy_encoder(&copy_encoder_config, &rmtCopyEncoder_));
     ESP_LOGI("OpenTherm", "RMT copy encoder created");
 
+    // TX-done callback releases ring slots and arms the response timeout
+    rmt_tx_event_callbacks_t cbs = {
+        .on_trans_done = on_rmt_tx_done,
+    };
+    ESP_ERROR_CHECK(rmt_tx_register_event_callbacks(rmtTxChannel_, &cbs, this));
+
     // Enable the TX channel
     ESP_ERROR_CHECK(rmt_enable(rmtTxChannel_));
     ESP_LOGI("OpenTherm", "RMT TX channel enabled");
@@ -170,14 +353,13 @@ void OpenTherm::startRMTReceive()
     if (rmtChannel_) {
         ESP_LOGI("OpenTherm", "Starting RMT reception...");
         // Use receive config appropriate for OpenTherm Manchester encoding
-        // Half-bits are ~500μs, full bits ~1000μs, so allow some tolerance
-        rmt_receive_config_t receive_config = {
-            .signal_range_min_ns = 3000,  // 3μs minimum (filter noise)
-            .signal_range_max_ns = 2000000, // 2000μs maximum (allow tolerance)
-        };
+        rmt_receive_config_t receive_config = makeReceiveConfig();
         // Start with buffer 0
         rmtActiveBuffer_ = 0;
-        ESP_ERROR_CHECK(rmt_receive(rmtChannel_, rmtRxBuffers_[0], sizeof(rmtRxBuffers_[0]), &receive_config));
+#if CONFIG_OT_RMT_STREAMING_RX
+        rmtDecoder_.reset(rmtBitClock_);
+#endif
+        ESP_ERROR_CHECK(rmt_receive(rmtChannel_, rmtRxBuffers_[0], RMT_RX_RECEIVE_BYTES, &receive_config));
         ESP_LOGI("OpenTherm", "RMT reception started");
     } else {
         ESP_LOGE("OpenTherm", "RMT not initialized: rmtChannel_=%p", rmtChannel_);
@@ -246,8 +428,19 @@ bool OpenTherm::sendFrameRMT(unsigned long frame)
         return false;
     }
 
+    // Claim a free ring slot (only blocks if RMT_TX_QUEUE_DEPTH frames are queued)
+    if (xSemaphoreTake(rmtTxSlots_, pdMS_TO_TICKS(50)) != pdTRUE) {
+        ESP_LOGE("OpenTherm", "RMT TX queue full");
+        return false;
+    }
+
+    taskENTER_CRITICAL(&txnLock_);
+    rmt_symbol_word_t* symbols = rmtTxBuffers_[rmtTxHead_];
+    rmtTxHead_ = (rmtTxHead_ + 1) % RMT_TX_QUEUE_DEPTH;
+    taskEXIT_CRITICAL(&txnLock_);
+
     // Encode the frame to RMT symbols
-    size_t numSymbols = encodeFrameToRMT(frame, rmtTxBuffer_);
+    size_t numSymbols = encodeFrameToRMT(frame, symbols);
 
     // Configure transmission
     rmt_transmit_config_t tx_config = {
@@ -257,104 +450,316 @@ bool OpenTherm::sendFrameRMT(unsigned long frame)
         },
     };
 
-    // Transmit the symbols
+    // Queue the symbols; on_rmt_tx_done fires once they have left the wire
     esp_err_t err = rmt_transmit(rmtTxChannel_, rmtCopyEncoder_,
-                                  rmtTxBuffer_, numSymbols * sizeof(rmt_symbol_word_t),
+                                  symbols, numSymbols * sizeof(rmt_symbol_word_t),
                                   &tx_config);
     if (err != ESP_OK) {
         ESP_LOGE("OpenTherm", "RMT transmit failed: %d", err);
-        return false;
-    }
-
-    // Wait for transmission to complete (34 bits * 1ms = 34ms max)
-    err = rmt_tx_wait_all_done(rmtTxChannel_, 50);  // 50ms timeout
-    if (err != ESP_OK) {
-        ESP_LOGE("OpenTherm", "RMT TX wait failed: %d", err);
+        xSemaphoreGive(rmtTxSlots_);
         return false;
     }
 
     return true;
 }
 
-bool IRAM_ATTR OpenTherm::isReady()
+bool OpenTherm::waitTxIdle(TickType_t timeout)
 {
-    return status == OpenThermStatus::READY;
+    if (!rmtTxChannel_) {
+        return true;
+    }
+    int timeoutMs = timeout == portMAX_DELAY ? -1 : static_cast<int>(pdTICKS_TO_MS(timeout));
+    return rmt_tx_wait_all_done(rmtTxChannel_, timeoutMs) == ESP_OK;
 }
 
-bool OpenTherm::sendRequestAsync(unsigned long request)
+esp_err_t OpenTherm::repeatTo(OpenTherm* target)
 {
-    const bool ready = isReady();
+    if (target == repeatTarget_) {
+        return ESP_OK;
+    }
+    if (target == this) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    if (!ready)
-    {
-        return false;
+    // Detach from the current target first
+    if (repeatTarget_ != nullptr) {
+        gpio_intr_disable(inPin);
+        gpio_isr_handler_remove(inPin);
+        OpenTherm* previous = repeatTarget_;
+        repeatTarget_ = nullptr;
+        previous->stopRepeatSink();
+        ESP_LOGI("OpenTherm", "Cut-through from GPIO %d stopped", inPin);
+    }
+    if (target == nullptr) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = target->startRepeatSink();
+    if (err != ESP_OK) {
+        return err;
+    }
+    // Shared GPIO ISR service; already installed is fine
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        target->stopRepeatSink();
+        return err;
     }
 
-    status = OpenThermStatus::REQUEST_SENDING;
-    response = 0;
-    responseStatus = OpenThermResponseStatus::NONE;
+    // Assume the bus is idle right now; the first inter-frame gap corrects it
+    repeatLevel_ = gpio_get_level(inPin);
+    repeatIdleLevel_ = repeatLevel_;
+    repeatLastEdgeUs_ = esp_timer_get_time();
+    repeatInFrame_ = false;
+    repeatHalfBits_ = 0;
+    repeatTarget_ = target;
 
-    // Use RMT for hardware-timed transmission
-    if (!sendFrameRMT(request)) {
-        status = OpenThermStatus::READY;
-        return false;
+    gpio_set_intr_type(inPin, GPIO_INTR_ANYEDGE);
+    err = gpio_isr_handler_add(inPin, on_repeat_edge, this);
+    if (err != ESP_OK) {
+        repeatTarget_ = nullptr;
+        target->stopRepeatSink();
+        return err;
     }
+    gpio_intr_enable(inPin);
 
-    responseTimestamp = esp_timer_get_time();
-    status = OpenThermStatus::RESPONSE_WAITING;
+    ESP_LOGI("OpenTherm", "Cut-through GPIO %d -> GPIO %d (lead %lu us)",
+             inPin, target->outPin, (unsigned long)REPEAT_LEAD_US);
+    return ESP_OK;
+}
 
-    return true;
+esp_err_t OpenTherm::startRepeatSink()
+{
+    if (!rmtTxChannel_) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (repeatQueue_ == nullptr) {
+        repeatQueue_ = xQueueCreate(REPEAT_QUEUE_LENGTH, sizeof(uint8_t));
+        if (repeatQueue_ == nullptr) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    // The task lives until end(); sources only route edges to it while armed
+    if (repeatTaskHandle_ == nullptr) {
+        BaseType_t ret = xTaskCreatePinnedToCore(
+            &OpenTherm::repeatTaskEntry,
+            "ot_repeat",
+            3072,
+            this,
+            configMAX_PRIORITIES - 1, // Same as the monitor task: runs are due within a bit period
+            &repeatTaskHandle_,
+            1
+        );
+        if (ret != pdPASS) {
+            repeatTaskHandle_ = nullptr;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    repeatSink_ = true;
+    return ESP_OK;
 }
 
-unsigned long OpenTherm::sendRequest(unsigned long request)
+void OpenTherm::stopRepeatSink()
 {
-    if (!sendRequestAsync(request))
-    {
-        return 0;
+    if (repeatQueue_ != nullptr) {
+        // Don't leave the line parked at the active level mid-frame
+        uint8_t run = REPEAT_ABORT;
+        xQueueSend(repeatQueue_, &run, pdMS_TO_TICKS(10));
     }
+    waitTxIdle(pdMS_TO_TICKS(100));
+    repeatSink_ = false;
+}
 
-    while (!isReady())
-    {
-        process();
-        taskYIELD();
+void OpenTherm::repeatTaskEntry(void* arg)
+{
+    static_cast<OpenTherm*>(arg)->repeatTask();
+    vTaskDelete(nullptr);
+}
+
+void OpenTherm::repeatTask()
+{
+    uint8_t run;
+    while (xQueueReceive(repeatQueue_, &run, portMAX_DELAY) == pdTRUE) {
+        if (run & REPEAT_EXIT) {
+            break;
+        }
+        if (!transmitRepeatRun(run)) {
+            repeatDrops_ = repeatDrops_ + 1;
+        }
     }
-    return response;
+    repeatTaskHandle_ = nullptr;
 }
 
-bool OpenTherm::sendResponse(unsigned long request)
+bool OpenTherm::transmitRepeatRun(uint8_t run)
 {
-    // Allow sending response when READY or DELAY (after receiving a request in slave mode)
-    const bool canSend = (status == OpenThermStatus::READY || status == OpenThermStatus::DELAY);
+    constexpr uint32_t HALF_BIT_US = 500;
+    const uint32_t activeLevel = invertOutput ? 1 : 0;
+    const uint32_t idleLevel = invertOutput ? 0 : 1;
 
-    if (!canSend)
-    {
+    if (!rmtTxChannel_ || !rmtCopyEncoder_) {
+        return false;
+    }
+    // Never block: a late run is as good as a lost one
+    if (xSemaphoreTake(rmtTxSlots_, 0) != pdTRUE) {
         return false;
     }
 
-    status = OpenThermStatus::REQUEST_SENDING;
-    response = 0;
-    responseStatus = OpenThermResponseStatus::NONE;
+    taskENTER_CRITICAL(&txnLock_);
+    rmt_symbol_word_t* symbol = rmtTxBuffers_[rmtTxHead_];
+    rmtTxHead_ = (rmtTxHead_ + 1) % RMT_TX_QUEUE_DEPTH;
+    taskEXIT_CRITICAL(&txnLock_);
+
+    // One symbol per run, regenerated at nominal timing. The end-of-transmission
+    // level is the level of the next run, so a late run only stretches the
+    // previous one instead of glitching the line.
+    uint32_t level = idleLevel;
+    uint32_t eotLevel = idleLevel;
+    uint32_t durationUs = HALF_BIT_US;
+    if (run & REPEAT_LEAD) {
+        durationUs = REPEAT_LEAD_US;
+    } else if (!(run & REPEAT_ABORT)) {
+        const bool active = run & REPEAT_ACTIVE;
+        level = active ? activeLevel : idleLevel;
+        eotLevel = active ? idleLevel : activeLevel;
+        durationUs = (run & REPEAT_HALF_BITS_MASK) * HALF_BIT_US;
+    }
+    symbol->level0 = level;
+    symbol->duration0 = durationUs / 2;
+    symbol->level1 = level;
+    symbol->duration1 = durationUs - durationUs / 2;
 
-    // Use RMT for hardware-timed transmission
-    if (!sendFrameRMT(request)) {
-        status = OpenThermStatus::READY;
+    rmt_transmit_config_t tx_config = {
+        .loop_count = 0,
+        .flags = {
+            .eot_level = eotLevel,
+        },
+    };
+    esp_err_t err = rmt_transmit(rmtTxChannel_, rmtCopyEncoder_,
+                                 symbol, sizeof(rmt_symbol_word_t), &tx_config);
+    if (err != ESP_OK) {
+        xSemaphoreGive(rmtTxSlots_);
         return false;
     }
-
-    status = OpenThermStatus::READY;
     return true;
 }
 
-unsigned long OpenTherm::getLastResponse()
+OpenThermTransaction OpenTherm::submitRequest(unsigned long request)
 {
-    return response;
+    // Sleep out the inter-frame delay instead of spinning on process()
+    if (status == OpenThermStatus::DELAY) {
+        TickType_t remaining = nextProcessDeadline();
+        if (remaining > 0 && remaining != portMAX_DELAY) {
+            vTaskDelay(remaining);
+        }
+        process();
+    }
+
+    if (!claimForRequest()) {
+        return {};
+    }
+
+    taskENTER_CRITICAL(&txnLock_);
+    uint32_t seq = ++txnSeq_;
+    taskEXIT_CRITICAL(&txnLock_);
+    xSemaphoreTake(txnDone_, 0);  // Drop a completion left over from an earlier transaction
+
+    if (!transmitClaimedRequest(request)) {
+        return {};
+    }
+    return OpenThermTransaction(this, seq);
+}
+
+uint32_t OpenTherm::nowUs() const
+{
+    return static_cast<uint32_t>(clockUs());
+}
+
+// Wakes the transaction waiter (see submitRequest)
+void OpenTherm::requestCompleted(uint32_t frame, OpenThermResponseStatus result)
+{
+    taskENTER_CRITICAL(&txnLock_);
+    txnResponse_ = frame;
+    txnStatus_ = result;
+    txnCompletedSeq_ = txnSeq_;
+    taskEXIT_CRITICAL(&txnLock_);
+    xSemaphoreGive(txnDone_);
+}
+
+OpenThermResponseStatus OpenThermTransaction::wait(TickType_t timeout)
+{
+    if (!owner_) {
+        return OpenThermResponseStatus::NONE;
+    }
+    if (status_ != OpenThermResponseStatus::NONE) {
+        return status_;  // Already completed
+    }
+
+    OpenTherm& ot = *owner_;
+    const TickType_t start = xTaskGetTickCount();
+
+    while (true) {
+        taskENTER_CRITICAL(&ot.txnLock_);
+        const bool live = ot.txnSeq_ == seq_;
+        const bool done = live && ot.txnCompletedSeq_ == seq_;
+        if (done) {
+            response_ = ot.txnResponse_;
+            status_ = ot.txnStatus_;
+            // Consume the result the same way process() does
+            ot.consumeResult(status_);
+        }
+        taskEXIT_CRITICAL(&ot.txnLock_);
+
+        if (done) {
+            return status_;
+        }
+        if (!live) {
+            return OpenThermResponseStatus::NONE;  // Cancelled or superseded
+        }
+
+        TickType_t slice = ot.nextProcessDeadline();
+        if (slice == portMAX_DELAY) {
+            slice = pdMS_TO_TICKS(1000);
+        }
+        if (timeout != portMAX_DELAY) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= timeout) {
+                return OpenThermResponseStatus::NONE;
+            }
+            slice = std::min(slice, timeout - elapsed);
+        }
+
+        if (xSemaphoreTake(ot.txnDone_, slice) != pdTRUE) {
+            ot.process();  // Applies the 1 s bus timeout, completing with TIMEOUT
+        }
+    }
 }
 
-OpenThermResponseStatus OpenTherm::getLastResponseStatus()
+void OpenThermTransaction::cancel()
 {
-    return responseStatus;
+    if (!owner_) {
+        return;
+    }
+
+    OpenTherm& ot = *owner_;
+    taskENTER_CRITICAL(&ot.txnLock_);
+    if (ot.txnSeq_ == seq_) {
+        ot.txnSeq_ = seq_ + 1;
+        ot.abandonRequest();
+    }
+    taskEXIT_CRITICAL(&ot.txnLock_);
+    owner_ = nullptr;
 }
 
+unsigned long OpenTherm::sendRequest(unsigned long request)
+{
+    OpenThermTransaction txn = submitRequest(request);
+    if (!txn)
+    {
+        return 0;
+    }
+
+    txn.wait();
+    return txn.response();
+}
 
 void OpenTherm::monitorInterrupts()
 {
@@ -363,15 +768,44 @@ void OpenTherm::monitorInterrupts()
 
 void OpenTherm::monitorRMT()
 {
-    rmt_receive_config_t receive_config = {
-        .signal_range_min_ns = 3000,
-        .signal_range_max_ns = 2000000,
-    };
+    rmt_receive_config_t receive_config = makeReceiveConfig();
 
     while (true) {
         // Wait for notification from RMT callback
         ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
+#if CONFIG_OT_RMT_STREAMING_RX
+        // Reception ended on idle - restart it (single buffer, the ISR has
+        // already decoded every chunk)
+        if (rmtRestartPending_) {
+            rmtRestartPending_ = false;
+            esp_err_t err = rmt_receive(rmtChannel_, rmtRxBuffers_[0], RMT_RX_RECEIVE_BYTES, &receive_config);
+            if (err != ESP_OK) {
+                ESP_LOGW("OpenTherm", "rmt_receive failed (%d), re-enabling channel", err);
+                rmt_enable(rmtChannel_);
+                rmt_receive(rmtChannel_, rmtRxBuffers_[0], RMT_RX_RECEIVE_BYTES, &receive_config);
+            }
+        }
+
+        if (!rmtFrameReady_) {
+            continue;
+        }
+        rmtFrameReady_ = false;
+
+        // Decoded in the ISR; raw symbols are not retained in partial mode
+        uint32_t parsedFrame = rmtStreamFrame_;
+        ParseError parseError = rmtStreamError_;
+        if (parsedFrame == 0) {
+            BusLog::push(LogEvent::StreamFailed, isSlave ? 'T' : 'B', 0,
+                         (uint32_t)rmtStreamError_ | ((uint32_t)rmtStreamBit_ << 8), nullptr, rmtFrameSize_);
+        } else {
+            // Follow this side's bit clock, as the batch path does
+            rmtBitClock_.update(rmtStreamHalfBitUs_);
+            if (rmtDebugLogging_) {
+                BusLog::push(LogEvent::FrameDecoded, isSlave ? 'T' : 'B', parsedFrame, 0, nullptr, rmtFrameSize_);
+            }
+        }
+#else
         // Check if frame is ready (callback sets this)
         if (!rmtFrameReady_) {
             continue;
@@ -385,159 +819,78 @@ void OpenTherm::monitorRMT()
 
         // Restart receive ASAP with the new active buffer (before processing)
         esp_err_t err = rmt_receive(rmtChannel_, rmtRxBuffers_[rmtActiveBuffer_],
-                                    sizeof(rmtRxBuffers_[0]), &receive_config);
+                                    RMT_RX_RECEIVE_BYTES, &receive_config);
         if (err != ESP_OK) {
             // Channel may need re-enabling
             ESP_LOGW("OpenTherm", "rmt_receive failed (%d), re-enabling channel", err);
             rmt_enable(rmtChannel_);
             rmt_receive(rmtChannel_, rmtRxBuffers_[rmtActiveBuffer_],
-                       sizeof(rmtRxBuffers_[0]), &receive_config);
+                       RMT_RX_RECEIVE_BYTES, &receive_config);
         }
 
         // Parse the RMT symbols from the completed buffer
-        uint32_t parsedFrame = parseRMTSymbols(rmtRxBuffers_[completedBuffer], frameSize);
-
-        if (parsedFrame != 0) {
-            response = parsedFrame;
-            responseTimestamp = esp_timer_get_time();
-
-            // Validate based on mode: slave expects requests, master expects responses
-            bool valid = isSlave ? isValidRequest(parsedFrame, isSlave) : isValidResponse(parsedFrame, isSlave);
-            responseStatus = valid ? OpenThermResponseStatus::SUCCESS : OpenThermResponseStatus::INVALID;
-            status = OpenThermStatus::RESPONSE_READY;
-        } else if (status == OpenThermStatus::RESPONSE_WAITING) {
-            // Frame parsing failed while we were expecting a response - mark as invalid
-            responseTimestamp = esp_timer_get_time();
-            status = OpenThermStatus::RESPONSE_INVALID;
-        }
-    }
-}
+        ParseError parseError = ParseError::None;
+        uint32_t parsedFrame = parseRMTSymbols(rmtRxBuffers_[completedBuffer], frameSize, parseError);
+#endif
 
-
-unsigned long OpenTherm::process(std::function<void(unsigned long, OpenThermResponseStatus)> callback)
-{
-    OpenThermStatus st = status;
-    unsigned long ts = responseTimestamp;
-
-    if (st == OpenThermStatus::READY)
-        return 0;
-    unsigned long newTs = esp_timer_get_time();
-    if (st != OpenThermStatus::NOT_INITIALIZED && st != OpenThermStatus::DELAY && (newTs - ts) > 1000000)
-    {
-        status = OpenThermStatus::READY;
-        responseStatus = OpenThermResponseStatus::TIMEOUT;
-        if (callback) callback(response, responseStatus);
-        return response;
-    }
-    else if (st == OpenThermStatus::RESPONSE_INVALID)
-    {
-        status = OpenThermStatus::DELAY;
-        responseStatus = OpenThermResponseStatus::INVALID;
-        if (callback) callback(response, responseStatus);
-        return response;
-    }
-    else if (st == OpenThermStatus::RESPONSE_READY)
-    {
-        status = OpenThermStatus::DELAY;
-        responseStatus = (isSlave ? isValidRequest(response, isSlave) : isValidResponse(response, isSlave)) ? OpenThermResponseStatus::SUCCESS : OpenThermResponseStatus::INVALID;
-        if (callback) callback(response, responseStatus);
-        return response;
-    }
-    else if (st == OpenThermStatus::DELAY)
-    {
-        if ((newTs - ts) > (isSlave ? 20000 : 100000))
-        {
-            status = OpenThermStatus::READY;
+        if (!frameCaptured(parsedFrame, parseError, rmtRxDoneUs_)) {
+            continue;  // Nothing for process() to act on
         }
-    }
-    return 0;
-}
-
-bool OpenTherm::parity(unsigned long frame) // odd parity
-{
-    uint8_t p = 0;
-    while (frame > 0)
-    {
-        if (frame & 1)
-            p++;
-        frame = frame >> 1;
-    }
-    return (p & 1);
-}
-
-OpenThermMessageType OpenTherm::getMessageType(unsigned long message)
-{
-    OpenThermMessageType msg_type = static_cast<OpenThermMessageType>((message >> 28) & 7);
-    return msg_type;
-}
-
-OpenThermMessageID OpenTherm::getDataID(unsigned long frame)
-{
-    return (OpenThermMessageID)((frame >> 16) & 0xFF);
-}
 
-unsigned long OpenTherm::buildRequest(OpenThermMessageType type, OpenThermMessageID id, unsigned int data)
-{
-    unsigned long request = data;
-    if (type == OpenThermMessageType::WRITE_DATA)
-    {
-        request |= 1ul << 28;
+        // Wake the consumer so it can run process() without polling
+        TaskHandle_t eventTask = eventTask_;
+        if (eventTask != nullptr) {
+            xTaskNotify(eventTask, eventBits_, eSetBits);
+        }
     }
-    request |= ((unsigned long)id) << 16;
-    if (parity(request))
-        request |= (1ul << 31);
-    return request;
 }
 
-unsigned long OpenTherm::buildResponse(OpenThermMessageType type, OpenThermMessageID id, unsigned int data)
+void OpenTherm::setEventNotify(TaskHandle_t task, uint32_t bits)
 {
-    unsigned long response = data;
-    response |= ((unsigned long)type) << 28;
-    response |= ((unsigned long)id) << 16;
-    if (parity(response))
-        response |= (1ul << 31);
-    return response;
+    eventBits_ = bits;
+    eventTask_ = task;
 }
 
-bool OpenTherm::isValidResponse(unsigned long response, bool isSlave)
+TickType_t OpenTherm::nextProcessDeadline() const
 {
-    if (parity(response)) {
-        ESP_LOGW("OT", "%s Invalid response (parity): %lu", isSlave ? "T" : "B", response);
-        return false;
+    uint32_t dueUs = processDueInUs();
+    if (dueUs == UINT32_MAX) {
+        return portMAX_DELAY;
     }
-    
-    uint8_t msgType = (response << 1) >> 29;
-    bool valid = msgType == (uint8_t)OpenThermMessageType::READ_ACK || msgType == (uint8_t)OpenThermMessageType::WRITE_ACK;
-    if (!valid) {
-        ESP_LOGW("OT", "%s Invalid response (type): %lu", isSlave ? "T" : "B", response);
+    if (dueUs == 0) {
+        return 0;
     }
-    return valid;
+    // Round up so we never wake before process() would act
+    return pdMS_TO_TICKS((dueUs - 1) / 1000) + 1;
 }
 
-bool OpenTherm::isValidRequest(unsigned long request, bool isSlave)
+
+void OpenTherm::end()
 {
-    if (parity(request)) {
-        ESP_LOGW("OT", "%s Invalid request (parity): %lu", isSlave ? "T" : "B", request);
-        return false;
+    // Stop repeating in both roles before the TX channel goes away
+    repeatTo(nullptr);
+    if (repeatTaskHandle_ != nullptr) {
+        uint8_t run = REPEAT_EXIT;
+        xQueueSend(repeatQueue_, &run, pdMS_TO_TICKS(10));
+        for (int i = 0; i < 10 && repeatTaskHandle_ != nullptr; i++) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
     }
-    uint8_t msgType = (request << 1) >> 29;
-    bool valid = msgType == (uint8_t)OpenThermMessageType::READ_DATA || msgType == (uint8_t)OpenThermMessageType::WRITE_DATA;
-    if (!valid) {
-        ESP_LOGW("OT", "%s Invalid request (type): %lu", isSlave ? "T" : "B", request);
+    if (repeatQueue_ != nullptr && repeatTaskHandle_ == nullptr) {
+        vQueueDelete(repeatQueue_);
+        repeatQueue_ = nullptr;
     }
-    return valid;
-}
+    repeatSink_ = false;
 
-void OpenTherm::end()
-{
     // Clean up RX channel
     if (rmtChannel_) {
         ESP_ERROR_CHECK(rmt_disable(rmtChannel_));
         ESP_ERROR_CHECK(rmt_del_channel(rmtChannel_));
         rmtChannel_ = nullptr;
     }
-    // Clean up TX channel
+    // Clean up TX channel (let queued frames finish first)
     if (rmtTxChannel_) {
+        rmt_tx_wait_all_done(rmtTxChannel_, 100);
         ESP_ERROR_CHECK(rmt_disable(rmtTxChannel_));
         ESP_ERROR_CHECK(rmt_del_channel(rmtTxChannel_));
         rmtTxChannel_ = nullptr;
@@ -557,124 +910,16 @@ void OpenTherm::end()
 OpenTherm::~OpenTherm()
 {
     end();
-}
-
-const char *OpenTherm::statusToString(OpenThermResponseStatus status)
-{
-    switch (status)
-    {
-    case OpenThermResponseStatus::NONE:
-        return "NONE";
-    case OpenThermResponseStatus::SUCCESS:
-        return "SUCCESS";
-    case OpenThermResponseStatus::INVALID:
-        return "INVALID";
-    case OpenThermResponseStatus::TIMEOUT:
-        return "TIMEOUT";
-    default:
-        return "UNKNOWN";
+    if (txnDone_) {
+        vSemaphoreDelete(txnDone_);
+        txnDone_ = nullptr;
     }
-}
-
-const char *OpenTherm::messageTypeToString(OpenThermMessageType message_type)
-{
-    switch (message_type)
-    {
-    case OpenThermMessageType::READ_DATA:
-        return "READ_DATA";
-    case OpenThermMessageType::WRITE_DATA:
-        return "WRITE_DATA";
-    case OpenThermMessageType::INVALID_DATA:
-        return "INVALID_DATA";
-    case OpenThermMessageType::RESERVED:
-        return "RESERVED";
-    case OpenThermMessageType::READ_ACK:
-        return "READ_ACK";
-    case OpenThermMessageType::WRITE_ACK:
-        return "WRITE_ACK";
-    case OpenThermMessageType::DATA_INVALID:
-        return "DATA_INVALID";
-    case OpenThermMessageType::UNKNOWN_DATA_ID:
-        return "UNKNOWN_DATA_ID";
-    default:
-        return "UNKNOWN";
+    if (rmtTxSlots_) {
+        vSemaphoreDelete(rmtTxSlots_);
+        rmtTxSlots_ = nullptr;
     }
 }
 
-// building requests
-
-unsigned long OpenTherm::buildSetBoilerStatusRequest(bool enableCentralHeating, bool enableHotWater, bool enableCooling, bool enableOutsideTemperatureCompensation, bool enableCentralHeating2)
-{
-    unsigned int data = enableCentralHeating | (enableHotWater << 1) | (enableCooling << 2) | (enableOutsideTemperatureCompensation << 3) | (enableCentralHeating2 << 4);
-    data <<= 8;
-    return buildRequest(OpenThermMessageType::READ_DATA, OpenThermMessageID::Status, data);
-}
-
-unsigned long OpenTherm::buildSetBoilerTemperatureRequest(float temperature)
-{
-    unsigned int data = temperatureToData(temperature);
-    return buildRequest(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, data);
-}
-
-unsigned long OpenTherm::buildGetBoilerTemperatureRequest()
-{
-    return buildRequest(OpenThermMessageType::READ_DATA, OpenThermMessageID::Tboiler, 0);
-}
-
-// parsing responses
-bool OpenTherm::isFault(unsigned long response)
-{
-    return response & 0x1;
-}
-
-bool OpenTherm::isCentralHeatingActive(unsigned long response)
-{
-    return response & 0x2;
-}
-
-bool OpenTherm::isHotWaterActive(unsigned long response)
-{
-    return response & 0x4;
-}
-
-bool OpenTherm::isFlameOn(unsigned long response)
-{
-    return response & 0x8;
-}
-
-bool OpenTherm::isCoolingActive(unsigned long response)
-{
-    return response & 0x10;
-}
-
-bool OpenTherm::isDiagnostic(unsigned long response)
-{
-    return response & 0x40;
-}
-
-uint16_t OpenTherm::getUInt(const unsigned long response)
-{
-    const uint16_t u88 = response & 0xffff;
-    return u88;
-}
-
-float OpenTherm::getFloat(const unsigned long response)
-{
-    const uint16_t u88 = getUInt(response);
-    const float f = (u88 & 0x8000) ? -(0x10000L - u88) / 256.0f : u88 / 256.0f;
-    return f;
-}
-
-unsigned int OpenTherm::temperatureToData(float temperature)
-{
-    if (temperature < 0)
-        temperature = 0;
-    if (temperature > 100)
-        temperature = 100;
-    unsigned int data = (unsigned int)(temperature * 256);
-    return data;
-}
-
 // basic requests
 
 unsigned long OpenTherm::setBoilerStatus(bool enableCentralHeating, bool enableHotWater, bool enableCooling, bool enableOutsideTemperatureCompensation, bool enableCentralHeating2)
@@ -730,30 +975,39 @@ unsigned char OpenTherm::getFault()
     return ((sendRequest(buildRequest(OpenThermRequestType::READ, OpenThermMessageID::ASFflags, 0)) >> 8) & 0xff);
 }
 
-void OpenTherm::buildRMTSymbolLogString(rmt_symbol_word_t* symbols, size_t num_symbols, char* buffer, size_t bufferSize)
+uint32_t OpenTherm::parseRMTSymbols(rmt_symbol_word_t* symbols, size_t num_symbols, ParseError& error)
 {
-    // Delegate to standalone implementation
-    ot::buildRMTSymbolLogString(symbols, num_symbols, buffer, bufferSize);
-}
+    // Parse using standalone implementation, following this side's bit clock
+    ParseFailure failure = {};
+#if CONFIG_OT_RMT_FRAME_REPAIR
+    uint32_t frame = ot::parseRMTSymbolsAdaptive(symbols, num_symbols, rmtBitClock_, isSlave, &rmtRepairs_, &failure);
+#else
+    uint32_t frame = ot::parseRMTSymbolsAdaptive(symbols, num_symbols, rmtBitClock_, isSlave, nullptr, &failure);
+#endif
 
-uint32_t OpenTherm::parseRMTSymbols(rmt_symbol_word_t* symbols, size_t num_symbols)
-{
-    // Parse using standalone implementation
-    uint32_t frame = ot::parseRMTSymbols(symbols, num_symbols, isSlave);
-    
-    // Add logging wrapper for debug mode
-    if (rmtDebugLogging_ || frame == 0) {
-        char logBuf[512];
-        buildRMTSymbolLogString(symbols, num_symbols, logBuf, sizeof(logBuf));
-        
-        if (frame != 0) {
-            ESP_LOGI("OT", "%s RMT[%zu] -> 0x%08lx: %s", isSlave ? "T" : "B", num_symbols, frame, logBuf);
-        } else {
-            ESP_LOGW("OT", "%s RMT[%zu] FAILED (parsing error): %s", isSlave ? "T" : "B", num_symbols, logBuf);
-        }
+    error = failure.error;
+
+    // Symbol dumps are formatted later by the bus log task
+    if (frame == 0) {
+        BusLog::push(LogEvent::ParseFailed, isSlave ? 'T' : 'B', 0,
+                     (uint32_t)failure.error | ((uint32_t)failure.bitIndex << 8), symbols, num_symbols);
+    } else if (rmtDebugLogging_) {
+        BusLog::push(LogEvent::FrameDecoded, isSlave ? 'T' : 'B', frame, 0, symbols, num_symbols);
     }
-    
+
     return frame;
 }
 
+BusStats OpenTherm::busStats() const
+{
+    BusStats s = OpenThermProtocol::busStats();
+    s.repairs = rmtRepairs_;
+    return s;
+}
+
+UBaseType_t OpenTherm::monitorStackHeadroom() const
+{
+    return monitorTaskHandle_ ? uxTaskGetStackHighWaterMark(monitorTaskHandle_) : 0;
+}
+
 } // namespace ot
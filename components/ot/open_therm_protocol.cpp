@@ -0,0 +1,484 @@
+/*
+ * OpenTherm protocol core: message helpers and the request/response state
+ * machine. No ESP-IDF dependencies; see open_therm_protocol.h.
+ */
+
+#include "open_therm_protocol.h"
+
+namespace ot {
+
+OpenThermProtocol::OpenThermProtocol(BusBackend& backend, bool isSlave) :
+    status(OpenThermStatus::NOT_INITIALIZED),
+    isSlave(isSlave),
+    response(0),
+    responseStatus(OpenThermResponseStatus::NONE),
+    responseTimestamp(0),
+    backend_(backend)
+{
+}
+
+bool OpenThermProtocol::claimForRequest()
+{
+    backend_.lockState();
+    const bool claimed = isReady();
+    if (claimed) {
+        status = OpenThermStatus::REQUEST_SENDING;
+    }
+    backend_.unlockState();
+    return claimed;
+}
+
+bool OpenThermProtocol::sendRequestAsync(unsigned long request)
+{
+    if (!claimForRequest())
+    {
+        return false;
+    }
+
+    return transmitClaimedRequest(request);
+}
+
+bool OpenThermProtocol::transmitClaimedRequest(unsigned long request)
+{
+    response = 0;
+    responseStatus = OpenThermResponseStatus::NONE;
+    responseTimestamp = backend_.nowUs();
+
+    // transmitDone() moves us to RESPONSE_WAITING once the frame has left
+    // the wire
+    if (!transmitFrame(request)) {
+        status = OpenThermStatus::READY;
+        return false;
+    }
+
+    return true;
+}
+
+bool OpenThermProtocol::sendResponse(unsigned long request)
+{
+    // Allow sending response when READY or DELAY (after receiving a request in slave mode)
+    const bool canSend = (status == OpenThermStatus::READY || status == OpenThermStatus::DELAY);
+
+    if (!canSend)
+    {
+        return false;
+    }
+
+    status = OpenThermStatus::REQUEST_SENDING;
+    response = 0;
+    responseStatus = OpenThermResponseStatus::NONE;
+
+    // Queued by the backend, returns before the frame has left the wire
+    if (!transmitFrame(request)) {
+        status = OpenThermStatus::READY;
+        return false;
+    }
+
+    status = OpenThermStatus::READY;
+    return true;
+}
+
+bool OpenThermProtocol::transmitFrame(unsigned long frame)
+{
+    if (!backend_.transmit(static_cast<uint32_t>(frame))) {
+        busCounters_.txFailed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    busCounters_.txFrames.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void OT_PARSER_IRAM_ATTR OpenThermProtocol::transmitDone(uint32_t nowUs)
+{
+    // The request is on the wire: start the response timeout from here
+    if (status == OpenThermStatus::REQUEST_SENDING) {
+        responseTimestamp = nowUs;
+        status = OpenThermStatus::RESPONSE_WAITING;
+    }
+}
+
+bool OpenThermProtocol::frameCaptured(uint32_t frame, ParseError error, uint32_t rxDoneUs)
+{
+    BusCounters& c = busCounters_;
+    const uint32_t now = backend_.nowUs();
+    if (frame != 0) {
+        c.rxFrames.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        size_t kind = static_cast<size_t>(error);
+        c.rxErrors[kind < BusStats::ERROR_KINDS ? kind : 0].fetch_add(1, std::memory_order_relaxed);
+    }
+    uint32_t us = now - rxDoneUs;
+    c.decodeLastUs.store(us, std::memory_order_relaxed);
+    if (us > c.decodeMaxUs.load(std::memory_order_relaxed)) {
+        c.decodeMaxUs.store(us, std::memory_order_relaxed);
+    }
+    c.decodeSumUs.fetch_add(us, std::memory_order_relaxed);
+    c.decodeCount.fetch_add(1, std::memory_order_relaxed);
+
+    // Validate based on mode: slave expects requests, master expects responses
+    const bool valid = frame != 0 && (isSlave ? isValidRequest(frame, isSlave) : isValidResponse(frame, isSlave));
+    if (frame != 0 && !valid) {
+        c.rxInvalid.fetch_add(1, std::memory_order_relaxed);
+    }
+    const OpenThermResponseStatus result = valid ? OpenThermResponseStatus::SUCCESS : OpenThermResponseStatus::INVALID;
+
+    // Against process() timing the request out meanwhile: only one of the
+    // two completes it
+    backend_.lockState();
+    const bool waiting = status == OpenThermStatus::RESPONSE_WAITING;
+    if (frame != 0) {
+        response = frame;
+        responseTimestamp = now;
+        responseStatus = result;
+        status = OpenThermStatus::RESPONSE_READY;
+    } else if (waiting) {
+        // Frame parsing failed while we were expecting a response - mark as invalid
+        responseTimestamp = now;
+        status = OpenThermStatus::RESPONSE_INVALID;
+    }
+    backend_.unlockState();
+
+    if (waiting) {
+        backend_.requestCompleted(frame, result);
+    }
+    return frame != 0 || waiting;  // false: nothing for process() to act on
+}
+
+void OpenThermProtocol::consumeResult(OpenThermResponseStatus result)
+{
+    if (status == OpenThermStatus::RESPONSE_READY || status == OpenThermStatus::RESPONSE_INVALID) {
+        status = OpenThermStatus::DELAY;
+        responseStatus = result;
+    }
+}
+
+void OpenThermProtocol::abandonRequest()
+{
+    OpenThermStatus st = status;
+    if (st == OpenThermStatus::REQUEST_SENDING || st == OpenThermStatus::RESPONSE_WAITING ||
+        st == OpenThermStatus::RESPONSE_READY || st == OpenThermStatus::RESPONSE_INVALID) {
+        // Keep the inter-frame gap before the next request
+        status = OpenThermStatus::DELAY;
+        responseTimestamp = backend_.nowUs();
+    }
+}
+
+unsigned long OpenThermProtocol::getLastResponse()
+{
+    return response;
+}
+
+OpenThermResponseStatus OpenThermProtocol::getLastResponseStatus()
+{
+    return responseStatus;
+}
+
+unsigned long OpenThermProtocol::process(std::function<void(unsigned long, OpenThermResponseStatus)> callback)
+{
+    if (status == OpenThermStatus::READY)
+        return 0;
+
+    // The transition is decided and made under the lock, so a response
+    // captured at the timeout boundary is either taken or timed out, never
+    // both; the callbacks run after it
+    bool timedOut = false;
+    bool completed = false;
+    bool report = false;
+    backend_.lockState();
+    const OpenThermStatus st = status;
+    const uint32_t ts = responseTimestamp;
+    const uint32_t newTs = backend_.nowUs();
+    if (st != OpenThermStatus::READY && st != OpenThermStatus::NOT_INITIALIZED && st != OpenThermStatus::DELAY &&
+        (newTs - ts) > RESPONSE_TIMEOUT_US)
+    {
+        status = OpenThermStatus::READY;
+        responseStatus = OpenThermResponseStatus::TIMEOUT;
+        timedOut = true;
+        completed = st == OpenThermStatus::REQUEST_SENDING || st == OpenThermStatus::RESPONSE_WAITING;
+        report = true;
+    }
+    else if (st == OpenThermStatus::RESPONSE_INVALID)
+    {
+        status = OpenThermStatus::DELAY;
+        responseStatus = OpenThermResponseStatus::INVALID;
+        report = true;
+    }
+    else if (st == OpenThermStatus::RESPONSE_READY)
+    {
+        status = OpenThermStatus::DELAY;
+        responseStatus = (isSlave ? isValidRequest(response, isSlave) : isValidResponse(response, isSlave)) ? OpenThermResponseStatus::SUCCESS : OpenThermResponseStatus::INVALID;
+        report = true;
+    }
+    else if (st == OpenThermStatus::DELAY)
+    {
+        if ((newTs - ts) > (isSlave ? SLAVE_DELAY_US : MASTER_DELAY_US))
+        {
+            status = OpenThermStatus::READY;
+        }
+    }
+    const unsigned long frame = response;
+    const OpenThermResponseStatus result = responseStatus;
+    backend_.unlockState();
+
+    if (timedOut) {
+        busCounters_.timeouts.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (completed) {
+        backend_.requestCompleted(0, OpenThermResponseStatus::TIMEOUT);
+    }
+    if (!report) {
+        return 0;
+    }
+    if (callback) callback(frame, result);
+    return frame;
+}
+
+uint32_t OpenThermProtocol::processDueInUs() const
+{
+    OpenThermStatus st = status;
+    uint32_t limitUs;
+
+    switch (st) {
+        case OpenThermStatus::NOT_INITIALIZED:
+        case OpenThermStatus::READY:
+            return UINT32_MAX;
+        case OpenThermStatus::RESPONSE_READY:
+        case OpenThermStatus::RESPONSE_INVALID:
+            return 0;
+        case OpenThermStatus::DELAY:
+            limitUs = isSlave ? SLAVE_DELAY_US : MASTER_DELAY_US;
+            break;
+        default:
+            limitUs = RESPONSE_TIMEOUT_US;
+            break;
+    }
+
+    // Same wrap-safe arithmetic as process()
+    uint32_t elapsedUs = backend_.nowUs() - responseTimestamp;
+    if (elapsedUs > limitUs) {
+        return 0;
+    }
+    return limitUs - elapsedUs + 1;
+}
+
+BusStats OpenThermProtocol::busStats() const
+{
+    const BusCounters& c = busCounters_;
+    BusStats s = {};
+    s.rxFrames = c.rxFrames.load(std::memory_order_relaxed);
+    s.rxInvalid = c.rxInvalid.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < BusStats::ERROR_KINDS; i++) {
+        s.rxErrors[i] = c.rxErrors[i].load(std::memory_order_relaxed);
+    }
+    s.txFrames = c.txFrames.load(std::memory_order_relaxed);
+    s.txFailed = c.txFailed.load(std::memory_order_relaxed);
+    s.timeouts = c.timeouts.load(std::memory_order_relaxed);
+    s.decodeLastUs = c.decodeLastUs.load(std::memory_order_relaxed);
+    s.decodeMaxUs = c.decodeMaxUs.load(std::memory_order_relaxed);
+    uint32_t count = c.decodeCount.load(std::memory_order_relaxed);
+    s.decodeAvgUs = count ? static_cast<uint32_t>(c.decodeSumUs.load(std::memory_order_relaxed) / count) : 0;
+    return s;
+}
+
+void OpenThermProtocol::resetBusStats()
+{
+    BusCounters& c = busCounters_;
+    c.rxFrames.store(0, std::memory_order_relaxed);
+    c.rxInvalid.store(0, std::memory_order_relaxed);
+    for (auto& e : c.rxErrors) {
+        e.store(0, std::memory_order_relaxed);
+    }
+    c.txFrames.store(0, std::memory_order_relaxed);
+    c.txFailed.store(0, std::memory_order_relaxed);
+    c.timeouts.store(0, std::memory_order_relaxed);
+    c.decodeLastUs.store(0, std::memory_order_relaxed);
+    c.decodeMaxUs.store(0, std::memory_order_relaxed);
+    c.decodeSumUs.store(0, std::memory_order_relaxed);
+    c.decodeCount.store(0, std::memory_order_relaxed);
+}
+
+bool OpenThermProtocol::parity(unsigned long frame) // odd parity
+{
+    uint8_t p = 0;
+    while (frame > 0)
+    {
+        if (frame & 1)
+            p++;
+        frame = frame >> 1;
+    }
+    return (p & 1);
+}
+
+OpenThermMessageType OpenThermProtocol::getMessageType(unsigned long message)
+{
+    OpenThermMessageType msg_type = static_cast<OpenThermMessageType>((message >> 28) & 7);
+    return msg_type;
+}
+
+OpenThermMessageID OpenThermProtocol::getDataID(unsigned long frame)
+{
+    return (OpenThermMessageID)((frame >> 16) & 0xFF);
+}
+
+unsigned long OpenThermProtocol::buildRequest(OpenThermMessageType type, OpenThermMessageID id, unsigned int data)
+{
+    unsigned long request = data;
+    if (type == OpenThermMessageType::WRITE_DATA)
+    {
+        request |= 1ul << 28;
+    }
+    request |= ((unsigned long)id) << 16;
+    if (parity(request))
+        request |= (1ul << 31);
+    return request;
+}
+
+unsigned long OpenThermProtocol::buildResponse(OpenThermMessageType type, OpenThermMessageID id, unsigned int data)
+{
+    unsigned long response = data;
+    response |= ((unsigned long)type) << 28;
+    response |= ((unsigned long)id) << 16;
+    if (parity(response))
+        response |= (1ul << 31);
+    return response;
+}
+
+// Not logged: frameCaptured() counts the failures in rxInvalid, and the
+// manager traces the frames themselves
+bool OpenThermProtocol::isValidResponse(unsigned long response, bool isSlave)
+{
+    (void)isSlave;
+    if (parity(response)) {
+        return false;
+    }
+    uint8_t msgType = (response >> 28) & 7;
+    return msgType == (uint8_t)OpenThermMessageType::READ_ACK || msgType == (uint8_t)OpenThermMessageType::WRITE_ACK;
+}
+
+bool OpenThermProtocol::isValidRequest(unsigned long request, bool isSlave)
+{
+    (void)isSlave;
+    if (parity(request)) {
+        return false;
+    }
+    uint8_t msgType = (request >> 28) & 7;
+    return msgType == (uint8_t)OpenThermMessageType::READ_DATA || msgType == (uint8_t)OpenThermMessageType::WRITE_DATA;
+}
+
+const char *OpenThermProtocol::statusToString(OpenThermResponseStatus status)
+{
+    switch (status)
+    {
+    case OpenThermResponseStatus::NONE:
+        return "NONE";
+    case OpenThermResponseStatus::SUCCESS:
+        return "SUCCESS";
+    case OpenThermResponseStatus::INVALID:
+        return "INVALID";
+    case OpenThermResponseStatus::TIMEOUT:
+        return "TIMEOUT";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+const char *OpenThermProtocol::messageTypeToString(OpenThermMessageType message_type)
+{
+    switch (message_type)
+    {
+    case OpenThermMessageType::READ_DATA:
+        return "READ_DATA";
+    case OpenThermMessageType::WRITE_DATA:
+        return "WRITE_DATA";
+    case OpenThermMessageType::INVALID_DATA:
+        return "INVALID_DATA";
+    case OpenThermMessageType::RESERVED:
+        return "RESERVED";
+    case OpenThermMessageType::READ_ACK:
+        return "READ_ACK";
+    case OpenThermMessageType::WRITE_ACK:
+        return "WRITE_ACK";
+    case OpenThermMessageType::DATA_INVALID:
+        return "DATA_INVALID";
+    case OpenThermMessageType::UNKNOWN_DATA_ID:
+        return "UNKNOWN_DATA_ID";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+// building requests
+
+unsigned long OpenThermProtocol::buildSetBoilerStatusRequest(bool enableCentralHeating, bool enableHotWater, bool enableCooling, bool enableOutsideTemperatureCompensation, bool enableCentralHeating2)
+{
+    unsigned int data = enableCentralHeating | (enableHotWater << 1) | (enableCooling << 2) | (enableOutsideTemperatureCompensation << 3) | (enableCentralHeating2 << 4);
+    data <<= 8;
+    return buildRequest(OpenThermMessageType::READ_DATA, OpenThermMessageID::Status, data);
+}
+
+unsigned long OpenThermProtocol::buildSetBoilerTemperatureRequest(float temperature)
+{
+    unsigned int data = temperatureToData(temperature);
+    return buildRequest(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, data);
+}
+
+unsigned long OpenThermProtocol::buildGetBoilerTemperatureRequest()
+{
+    return buildRequest(OpenThermMessageType::READ_DATA, OpenThermMessageID::Tboiler, 0);
+}
+
+// parsing responses
+bool OpenThermProtocol::isFault(unsigned long response)
+{
+    return response & 0x1;
+}
+
+bool OpenThermProtocol::isCentralHeatingActive(unsigned long response)
+{
+    return response & 0x2;
+}
+
+bool OpenThermProtocol::isHotWaterActive(unsigned long response)
+{
+    return response & 0x4;
+}
+
+bool OpenThermProtocol::isFlameOn(unsigned long response)
+{
+    return response & 0x8;
+}
+
+bool OpenThermProtocol::isCoolingActive(unsigned long response)
+{
+    return response & 0x10;
+}
+
+bool OpenThermProtocol::isDiagnostic(unsigned long response)
+{
+    return response & 0x40;
+}
+
+uint16_t OpenThermProtocol::getUInt(const unsigned long response)
+{
+    const uint16_t u88 = response & 0xffff;
+    return u88;
+}
+
+float OpenThermProtocol::getFloat(const unsigned long response)
+{
+    const uint16_t u88 = getUInt(response);
+    const float f = (u88 & 0x8000) ? -(0x10000L - u88) / 256.0f : u88 / 256.0f;
+    return f;
+}
+
+unsigned int OpenThermProtocol::temperatureToData(float temperature)
+{
+    if (temperature < 0)
+        temperature = 0;
+    if (temperature > 100)
+        temperature = 100;
+    unsigned int data = (unsigned int)(temperature * 256);
+    return data;
+}
+
+} // namespace ot
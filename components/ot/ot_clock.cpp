@@ -0,0 +1,31 @@
+#include "ot_clock.h"
+#include "rmt_parser.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#endif
+
+namespace ot {
+
+static std::atomic<Clock*> s_clock{nullptr};
+
+void setClock(Clock* clock)
+{
+    s_clock.store(clock, std::memory_order_release);
+}
+
+int64_t OT_PARSER_IRAM_ATTR clockUs()
+{
+    Clock* clock = s_clock.load(std::memory_order_acquire);
+    if (clock) {
+        return clock->nowUs();
+    }
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+} // namespace ot
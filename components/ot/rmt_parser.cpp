@@ -5,11 +5,35 @@
  */
 
 #include "rmt_parser.h"
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
 namespace ot {
 
+// Number of half-bits a pulse spans (0 = out of range). With nominal windows
+// a single half-bit is 500us +-200us and a double 1000us +-300us.
+static inline int OT_PARSER_IRAM_ATTR classifyPulse(uint32_t dur, const HalfBitWindows& windows)
+{
+    if (dur < windows.singleMin || dur > windows.doubleMax) return 0;
+    return dur < windows.doubleMin ? 1 : 2;
+}
+
+const char* toString(ParseError error)
+{
+    switch (error) {
+        case ParseError::None:         return "none";
+        case ParseError::BadStart:     return "bad start";
+        case ParseError::BadStop:      return "bad stop";
+        case ParseError::NoTransition: return "no transition";
+        case ParseError::BadDuration:  return "bad duration";
+        case ParseError::Incomplete:   return "incomplete";
+        case ParseError::Parity:       return "parity";
+        default:                       return "unknown";
+    }
+}
+
 void buildRMTSymbolLogString(rmt_symbol_word_t* symbols, size_t num_symbols, 
                               char* buffer, size_t bufferSize)
 {
@@ -30,20 +54,410 @@ void buildRMTSymbolLogString(rmt_symbol_word_t* symbols, size_t num_symbols,
     }
 }
 
-uint32_t parseRMTSymbols(rmt_symbol_word_t* symbols, size_t num_symbols, bool isSlave)
+static void logParseFailure(rmt_symbol_word_t* symbols, size_t num_symbols, bool isSlave,
+                            ParseError error, int bitIndex)
+{
+    char logBuf[512];
+    buildRMTSymbolLogString(symbols, num_symbols, logBuf, sizeof(logBuf));
+    ESP_LOGW("OT", "%s RMT[%zu] FAILED (%s @bit %d): %s",
+             isSlave ? "T" : "B", num_symbols, toString(error), bitIndex, logBuf);
+}
+
+// Kernels decode without logging so callers can retry with other windows;
+// they return the frame (0 on failure) and set error/bitIndex.
+static uint32_t decodeStateMachine(const rmt_symbol_word_t* symbols, size_t num_symbols,
+                                   const HalfBitWindows& windows, ParseError& error, int& bitIndex);
+static uint32_t decodePacked(const rmt_symbol_word_t* symbols, size_t num_symbols,
+                             const HalfBitWindows& windows, ParseError& error, int& bitIndex);
+
+static inline uint32_t decodeSelected(const rmt_symbol_word_t* symbols, size_t num_symbols,
+                                      const HalfBitWindows& windows, ParseError& error, int& bitIndex)
+{
+#if OT_RMT_PARSER_PACKED
+    return decodePacked(symbols, num_symbols, windows, error, bitIndex);
+#else
+    return decodeStateMachine(symbols, num_symbols, windows, error, bitIndex);
+#endif
+}
+
+uint32_t parseRMTSymbols(rmt_symbol_word_t* symbols, size_t num_symbols, bool isSlave,
+                         const HalfBitWindows& windows)
+{
+    ParseError error;
+    int bitIndex;
+    uint32_t frame = decodeSelected(symbols, num_symbols, windows, error, bitIndex);
+    if (error != ParseError::None) {
+        logParseFailure(symbols, num_symbols, isSlave, error, bitIndex);
+    }
+    return frame;
+}
+
+uint32_t parseRMTSymbolsStateMachine(rmt_symbol_word_t* symbols, size_t num_symbols, bool isSlave,
+                                     const HalfBitWindows& windows)
+{
+    ParseError error;
+    int bitIndex;
+    uint32_t frame = decodeStateMachine(symbols, num_symbols, windows, error, bitIndex);
+    if (error != ParseError::None) {
+        logParseFailure(symbols, num_symbols, isSlave, error, bitIndex);
+    }
+    return frame;
+}
+
+uint32_t parseRMTSymbolsPacked(rmt_symbol_word_t* symbols, size_t num_symbols, bool isSlave,
+                               const HalfBitWindows& windows)
+{
+    ParseError error;
+    int bitIndex;
+    uint32_t frame = decodePacked(symbols, num_symbols, windows, error, bitIndex);
+    if (error != ParseError::None) {
+        logParseFailure(symbols, num_symbols, isSlave, error, bitIndex);
+    }
+    return frame;
+}
+
+// ============================================================================
+// Adaptive bit clock
+// ============================================================================
+
+// Pulses (start bit onwards) used to estimate a frame's own half-bit period
+static constexpr size_t ADAPTIVE_ESTIMATE_PULSES = 8;
+// Half-bits measured before the streaming decoder trusts its running estimate
+static constexpr uint32_t ADAPTIVE_SETTLE_HALVES = 4;
+
+void BitClock::update(uint32_t measuredUs)
+{
+    if (measuredUs < MIN_HALF_BIT_US) measuredUs = MIN_HALF_BIT_US;
+    if (measuredUs > MAX_HALF_BIT_US) measuredUs = MAX_HALF_BIT_US;
+    // halfBitX16 += (measured - halfBit) / 4, in Q4
+    int32_t delta = (int32_t)(measuredUs << 4) - (int32_t)halfBitX16_;
+    halfBitX16_ = (uint32_t)((int32_t)halfBitX16_ + delta / 4);
+}
+
+uint32_t estimateHalfBit(const rmt_symbol_word_t* symbols, size_t num_symbols,
+                         uint32_t priorUs, size_t maxPulses)
+{
+    uint32_t totalUs = 0;
+    uint32_t totalHalves = 0;
+    size_t pulses = 0;
+
+    // The start bit's first half may be merged with idle: skip it like the kernels do
+    size_t idx = (num_symbols > 0 &&
+                  symbols[0].level0 == 1 && symbols[0].duration0 > 0 &&
+                  symbols[0].level1 == 0 && symbols[0].duration1 > 0) ? 1 : 0;
+    for (; idx < num_symbols * 2 && pulses < maxPulses; idx++) {
+        const rmt_symbol_word_t& sym = symbols[idx >> 1];
+        uint32_t dur = (idx & 1) ? sym.duration1 : sym.duration0;
+        if (dur < 100) continue;     // Noise/end marker
+        if (dur > 3 * priorUs) break; // Idle or garbage: nothing more to learn
+
+        // Above 1.5 periods of the prior it spans two half-bits
+        totalHalves += (2 * dur >= 3 * priorUs) ? 2 : 1;
+        totalUs += dur;
+        pulses++;
+    }
+    return totalHalves ? (totalUs + totalHalves / 2) / totalHalves : priorUs;
+}
+
+uint32_t parseRMTSymbolsAdaptive(rmt_symbol_word_t* symbols, size_t num_symbols, BitClock& clock, bool isSlave,
+                                 RepairStats* repairs, ParseFailure* failure)
+{
+    ParseError error;
+    int bitIndex;
+
+    // 1. The channel's smoothed estimate: stable against per-frame jitter
+    uint32_t halfBit = clock.halfBitUs();
+    uint32_t frame = decodeSelected(symbols, num_symbols, HalfBitWindows::forHalfBit(halfBit), error, bitIndex);
+
+    // 2. This frame's own period from its start bit and first transitions
+    //    (first frames from a device, or its clock has moved)
+    if (error != ParseError::None) {
+        uint32_t estimate = estimateHalfBit(symbols, num_symbols, halfBit, ADAPTIVE_ESTIMATE_PULSES);
+        if (estimate != halfBit) {
+            ParseError retryError;
+            int retryBit;
+            uint32_t retry = decodeSelected(symbols, num_symbols, HalfBitWindows::forHalfBit(estimate),
+                                            retryError, retryBit);
+            if (retryError == ParseError::None) {
+                frame = retry;
+                error = retryError;
+                halfBit = estimate;
+            }
+        }
+    }
+
+    // 3. Spec windows, in case a glitch dragged the estimates off
+    if (error != ParseError::None && halfBit != BitClock::NOMINAL_HALF_BIT_US) {
+        ParseError retryError;
+        int retryBit;
+        uint32_t retry = decodeSelected(symbols, num_symbols, HalfBitWindows::nominal(), retryError, retryBit);
+        if (retryError == ParseError::None) {
+            frame = retry;
+            error = retryError;
+            halfBit = BitClock::NOMINAL_HALF_BIT_US;
+        }
+    }
+
+    if (error != ParseError::None) {
+        // 4. Single-glitch repairs against the channel's clock
+        if (repairs) {
+            frame = repairRMTSymbols(symbols, num_symbols, clock.halfBitUs(), *repairs);
+            if (frame != 0) return frame;
+        }
+        if (failure) {
+            failure->error = error;
+            failure->bitIndex = bitIndex;
+        } else {
+            logParseFailure(symbols, num_symbols, isSlave, error, bitIndex);
+        }
+        return 0;
+    }
+
+    // Measure over the whole frame before folding it into the channel estimate
+    clock.update(estimateHalfBit(symbols, num_symbols, halfBit, SIZE_MAX));
+    return frame;
+}
+
+// ============================================================================
+// Repair stage
+// ============================================================================
+
+// One pulse as half an RMT symbol lays it out: level << 15 | duration
+typedef uint16_t Pulse;
+
+static inline Pulse makePulse(uint32_t level, uint32_t dur) { return (Pulse)((level << 15) | (dur & 0x7FFF)); }
+static inline uint32_t pulseLevel(Pulse p) { return p >> 15; }
+static inline uint32_t pulseDuration(Pulse p) { return p & 0x7FFF; }
+
+static constexpr size_t REPAIR_MAX_PULSES = 256;  // 128 symbols
+
+// Candidate edit: `replaced` pulses from `at` are substituted by `with`
+struct PulseEdit {
+    size_t at;
+    size_t replaced;
+    size_t count;
+    Pulse with[3];
+};
+
+// Re-pack the pulse list (with an optional edit) into symbols and decode it
+static uint32_t decodePulses(const Pulse* pulses, size_t count, const PulseEdit* edit,
+                             rmt_symbol_word_t* scratch, const HalfBitWindows& windows,
+                             ParseError& error, int& bitIndex)
+{
+    size_t n = 0;
+    bool second = false;
+    auto emit = [&](Pulse p) {
+        if (!second) {
+            scratch[n].level0 = pulseLevel(p);
+            scratch[n].duration0 = pulseDuration(p);
+        } else {
+            scratch[n].level1 = pulseLevel(p);
+            scratch[n].duration1 = pulseDuration(p);
+            n++;
+        }
+        second = !second;
+    };
+
+    for (size_t i = 0; i < count; i++) {
+        if (edit && i == edit->at) {
+            for (size_t k = 0; k < edit->count; k++) emit(edit->with[k]);
+            i += edit->replaced - 1;
+        } else {
+            emit(pulses[i]);
+        }
+    }
+    if (second) emit(makePulse(0, 0));  // End marker, as the receiver leaves it
+    return decodeSelected(scratch, n, windows, error, bitIndex);
+}
+
+// Lost or displaced edge: split the one pulse spanning 3-4 half-bits around
+// an opposite half-bit. Ambiguous when several split positions decode.
+static uint32_t repairSplit(const Pulse* pulses, size_t count, size_t first, uint32_t halfBitUs,
+                            rmt_symbol_word_t* scratch, const HalfBitWindows& windows)
+{
+    size_t longIdx = SIZE_MAX;
+    for (size_t i = first; i < count; i++) {
+        if (pulseDuration(pulses[i]) <= windows.doubleMax) continue;
+        if (longIdx != SIZE_MAX) return 0;  // More than one glitch
+        longIdx = i;
+    }
+    if (longIdx == SIZE_MAX) return 0;
+
+    uint32_t dur = pulseDuration(pulses[longIdx]);
+    uint32_t level = pulseLevel(pulses[longIdx]);
+    uint32_t halves = (dur + halfBitUs / 2) / halfBitUs;
+    if (halves < 3 || halves > 4) return 0;
+
+    uint32_t found = 0;
+    for (uint32_t pos = 1; pos + 1 < halves; pos++) {
+        PulseEdit edit;
+        edit.at = longIdx;
+        edit.replaced = 1;
+        edit.count = 3;
+        uint32_t head = dur * pos / halves;
+        uint32_t mid = dur / halves;
+        edit.with[0] = makePulse(level, head);
+        edit.with[1] = makePulse(!level, mid);
+        edit.with[2] = makePulse(level, dur - head - mid);
+
+        ParseError error;
+        int bitIndex;
+        uint32_t frame = decodePulses(pulses, count, &edit, scratch, windows, error, bitIndex);
+        if (error != ParseError::None) continue;
+        if (found != 0) return 0;
+        found = frame;
+    }
+    return found;
+}
+
+// Edge misplaced by about half a half-bit: between two pulses spanning three
+// half-bits together it is unclear which of them holds the double. Pick the
+// pair where (single, double) and (double, single) fit the durations most
+// equally, and decode it the other way from before, which flips the level of
+// one half-bit (one data bit). Edges after the failing bit cannot cause a
+// transition error and are not considered.
+static uint32_t repairFlip(const Pulse* pulses, size_t count, size_t first, uint32_t halfBitUs,
+                           rmt_symbol_word_t* scratch, const HalfBitWindows& windows,
+                           ParseError error, int failedBit)
+{
+    const int32_t t = (int32_t)halfBitUs;
+    int32_t bestMargin = INT32_MAX;
+    int32_t runnerUpMargin = INT32_MAX;
+    size_t best = SIZE_MAX;
+    int halvesBefore = (int)first;  // The implicit start half
+
+    for (size_t i = first; i + 1 < count; i++) {
+        int32_t a = (int32_t)pulseDuration(pulses[i]);
+        int32_t b = (int32_t)pulseDuration(pulses[i + 1]);
+        halvesBefore += classifyPulse(a, windows);
+        if (error == ParseError::NoTransition && halvesBefore > 2 * (failedBit + 1)) break;
+        if (abs(a + b - 3 * t) > t / 2) continue;
+
+        // Distance between the fits of the two readings: 2T for a clean
+        // edge, down to 0 for one sitting halfway
+        int32_t singleFirst = abs(a - t) + abs(b - 2 * t);
+        int32_t doubleFirst = abs(a - 2 * t) + abs(b - t);
+        int32_t margin = abs(singleFirst - doubleFirst);
+        if (margin < bestMargin) {
+            runnerUpMargin = bestMargin;
+            bestMargin = margin;
+            best = i;
+        } else if (margin < runnerUpMargin) {
+            runnerUpMargin = margin;
+        }
+    }
+    // At least 3T/8 off its clean position, and clearly the worst edge
+    if (best == SIZE_MAX || bestMargin > t / 2) return 0;
+    if (runnerUpMargin != INT32_MAX && runnerUpMargin - bestMargin < t / 4) return 0;
+
+    uint32_t a = pulseDuration(pulses[best]);
+    uint32_t b = pulseDuration(pulses[best + 1]);
+    int ha = classifyPulse(a, windows);
+    int hb = classifyPulse(b, windows);
+    // Read as decoded before: swap. Read as two doubles or two singles: both
+    // readings are new, best fit first.
+    bool doubleFirst[2];
+    int tries;
+    if (ha + hb == 3) {
+        doubleFirst[0] = (ha == 1);
+        tries = 1;
+    } else {
+        doubleFirst[0] = a > b;
+        doubleFirst[1] = !doubleFirst[0];
+        tries = 2;
+    }
+
+    for (int k = 0; k < tries; k++) {
+        // Keep the total; the pair's period is a third of it
+        uint32_t newA = doubleFirst[k] ? (a + b) * 2 / 3 : (a + b) / 3;
+        PulseEdit edit;
+        edit.at = best;
+        edit.replaced = 2;
+        edit.count = 2;
+        edit.with[0] = makePulse(pulseLevel(pulses[best]), newA);
+        edit.with[1] = makePulse(pulseLevel(pulses[best + 1]), a + b - newA);
+
+        ParseError retryError;
+        int retryBit;
+        uint32_t frame = decodePulses(pulses, count, &edit, scratch, windows, retryError, retryBit);
+        if (retryError == ParseError::None) return frame;
+    }
+    return 0;
+}
+
+uint32_t repairRMTSymbols(const rmt_symbol_word_t* symbols, size_t num_symbols, uint32_t halfBitUs,
+                          RepairStats& stats)
+{
+    const HalfBitWindows windows = HalfBitWindows::forHalfBit(halfBitUs);
+    const uint32_t spikeMaxUs = windows.singleMin / 2;
+    Pulse pulses[REPAIR_MAX_PULSES] = {};
+    rmt_symbol_word_t scratch[REPAIR_MAX_PULSES / 2 + 2];
+    size_t count = 0;
+    bool merged = false;
+
+    if (num_symbols > REPAIR_MAX_PULSES / 2) num_symbols = REPAIR_MAX_PULSES / 2;
+
+    // The idle-merged first pulse of an implicit HIGH start carries no timing
+    size_t first = (num_symbols > 0 &&
+                    symbols[0].level0 == 1 && symbols[0].duration0 > 0 &&
+                    symbols[0].level1 == 0 && symbols[0].duration1 > 0) ? 1 : 0;
+
+    // Flatten, folding spikes (and the split halves around them) together
+    for (size_t idx = 0; idx < num_symbols * 2; idx++) {
+        const rmt_symbol_word_t& sym = symbols[idx >> 1];
+        uint32_t dur = (idx & 1) ? sym.duration1 : sym.duration0;
+        uint32_t level = (idx & 1) ? sym.level1 : sym.level0;
+        if (dur == 0) continue;  // End marker
+        if (count > 0 && (dur < spikeMaxUs || pulseLevel(pulses[count - 1]) == level)) {
+            uint32_t total = pulseDuration(pulses[count - 1]) + dur;
+            pulses[count - 1] = makePulse(pulseLevel(pulses[count - 1]), total > 0x7FFF ? 0x7FFF : total);
+            merged = true;
+            continue;
+        }
+        if (dur < spikeMaxUs) continue;  // Leading spike
+        pulses[count++] = makePulse(level, dur);
+    }
+
+    ParseError error;
+    int bitIndex;
+    uint32_t frame = decodePulses(pulses, count, nullptr, scratch, windows, error, bitIndex);
+    if (error == ParseError::None && !merged) return frame;  // Nothing to repair
+
+    stats.attempted++;
+    if (error == ParseError::None) {
+        stats.spikeMerges++;
+        return frame;
+    }
+
+    frame = 0;
+    if (error == ParseError::BadDuration) {
+        frame = repairSplit(pulses, count, first, halfBitUs, scratch, windows);
+        if (frame != 0) stats.pulseSplits++;
+    } else if (error == ParseError::Parity || error == ParseError::NoTransition ||
+               error == ParseError::BadStop) {
+        frame = repairFlip(pulses, count, first, halfBitUs, scratch, windows, error, bitIndex);
+        if (frame != 0) stats.halfBitFlips++;
+    }
+    if (frame == 0) stats.unrepaired++;
+    return frame;
+}
+
+// ============================================================================
+// State machine kernel
+// ============================================================================
+
+static uint32_t decodeStateMachine(const rmt_symbol_word_t* symbols, size_t num_symbols,
+                                   const HalfBitWindows& windows, ParseError& error, int& bitIndex)
 {
     // Manchester decoding for OpenTherm using RMT symbols
     // Single-pass: decode directly to frame without intermediate arrays
     // For Manchester: bit '1' = HIGH->LOW, bit '0' = LOW->HIGH
 
-    #define IS_SINGLE_HALF(dur) ((dur) >= 300 && (dur) < 700) // Single half-bit duration is 500ms, +-200ms
-    #define IS_DOUBLE_HALF(dur) ((dur) >= 700 && (dur) <= 1300) // Double half-bit duration is 1000ms, +-200ms
-
     uint32_t frame = 0;
-    int bitIndex = 0;              // Bit being decoded (0=start, 1-32=data, 33=stop)
+    bitIndex = 0;                  // Bit being decoded (0=start, 1-32=data, 33=stop)
     bool inSecondHalf = false;     // Waiting for second half of Manchester bit
     bool firstHalfHigh = false;    // Level of first half (valid when inSecondHalf)
-    const char* error = nullptr;   // Error reason (null = success)
+    error = ParseError::None;
 
     // Detect implicit HIGH start (idle HIGH merged with start bit's first half)
     bool skipFirst = num_symbols > 0 &&
@@ -56,16 +470,16 @@ uint32_t parseRMTSymbols(rmt_symbol_word_t* symbols, size_t num_symbols, bool is
 
     // Process one half-bit: either record first half or complete a Manchester bit
     #define PROCESS_HALF_BIT() \
-        if (bitIndex < 34 && !error) { \
+        if (bitIndex < 34 && error == ParseError::None) { \
             if (!inSecondHalf) { \
                 firstHalfHigh = level; \
                 inSecondHalf = true; \
             } else if (firstHalfHigh == level) { \
-                error = "no transition"; \
+                error = ParseError::NoTransition; \
             } else { \
                 bool bit = firstHalfHigh && !level; \
-                if (bitIndex == 0 && !bit) error = "bad start"; \
-                else if (bitIndex == 33 && !bit) error = "bad stop"; \
+                if (bitIndex == 0 && !bit) error = ParseError::BadStart; \
+                else if (bitIndex == 33 && !bit) error = ParseError::BadStop; \
                 else { \
                     if (bitIndex <= 32) frame = (frame << 1) | bit; \
                     bitIndex++; \
@@ -75,15 +489,15 @@ uint32_t parseRMTSymbols(rmt_symbol_word_t* symbols, size_t num_symbols, bool is
         }
 
     // Flatten symbol parts into single stream: idx 0,1 = symbol[0], idx 2,3 = symbol[1], etc.
-    for (size_t idx = skipFirst ? 1 : 0; idx < num_symbols * 2 && bitIndex < 34 && !error; idx++) {
-        rmt_symbol_word_t& sym = symbols[idx >> 1];
+    for (size_t idx = skipFirst ? 1 : 0; idx < num_symbols * 2 && bitIndex < 34 && error == ParseError::None; idx++) {
+        const rmt_symbol_word_t& sym = symbols[idx >> 1];
         bool secondPart = idx & 1;
 
         uint32_t dur = secondPart ? sym.duration1 : sym.duration0;
         if (dur == 0 || dur < 100) continue;  // Skip noise/end markers
 
-        int halves = IS_SINGLE_HALF(dur) ? 1 : IS_DOUBLE_HALF(dur) ? 2 : 0;
-        if (halves == 0) { error = "bad duration"; break; }
+        int halves = classifyPulse(dur, windows);
+        if (halves == 0) { error = ParseError::BadDuration; break; }
 
         bool level = secondPart ? sym.level1 : sym.level0;
 
@@ -93,21 +507,268 @@ uint32_t parseRMTSymbols(rmt_symbol_word_t* symbols, size_t num_symbols, bool is
         }
     }
 
+    #undef PROCESS_HALF_BIT
+
     // Infer missing final LOW (stop bit's second half produces no edge)
-    if (!error && bitIndex == 33 && inSecondHalf && firstHalfHigh) bitIndex++;
+    if (error == ParseError::None && bitIndex == 33 && inSecondHalf && firstHalfHigh) bitIndex++;
 
-    if (!error && bitIndex != 34) error = "incomplete";
-    if (!error && (__builtin_popcount(frame) & 1)) error = "parity";
+    if (error == ParseError::None && bitIndex != 34) error = ParseError::Incomplete;
+    if (error == ParseError::None && (__builtin_popcount(frame) & 1)) error = ParseError::Parity;
 
-    if (error) {
-        char logBuf[512];
-        buildRMTSymbolLogString(symbols, num_symbols, logBuf, sizeof(logBuf));
-        ESP_LOGW("OT", "%s RMT[%zu] FAILED (%s @bit %d): %s",
-                 isSlave ? "T" : "B", num_symbols, error, bitIndex, logBuf);
-        return 0;
+    return error == ParseError::None ? frame : 0;
+}
+
+// ============================================================================
+// Packed kernel
+// ============================================================================
+
+// One byte of the half-bit stream holds four Manchester bits, first half in
+// the odd bit of each pair (MSB first). Entry: high nibble = first-half
+// levels (the decoded bits), low nibble = first XOR second (1 = transition).
+#define OT_PAIR_FIRST(b)  ((((b) >> 4) & 8) | (((b) >> 3) & 4) | (((b) >> 2) & 2) | (((b) >> 1) & 1))
+#define OT_PAIR_SECOND(b) ((((b) >> 3) & 8) | (((b) >> 2) & 4) | (((b) >> 1) & 2) | ((b) & 1))
+#define OT_PAIR_ENTRY(b)  (uint8_t)((OT_PAIR_FIRST(b) << 4) | (OT_PAIR_FIRST(b) ^ OT_PAIR_SECOND(b)))
+#define OT_PAIR_ROW4(b)   OT_PAIR_ENTRY(b), OT_PAIR_ENTRY((b) + 1), OT_PAIR_ENTRY((b) + 2), OT_PAIR_ENTRY((b) + 3)
+#define OT_PAIR_ROW16(b)  OT_PAIR_ROW4(b), OT_PAIR_ROW4((b) + 4), OT_PAIR_ROW4((b) + 8), OT_PAIR_ROW4((b) + 12)
+#define OT_PAIR_ROW64(b)  OT_PAIR_ROW16(b), OT_PAIR_ROW16((b) + 16), OT_PAIR_ROW16((b) + 32), OT_PAIR_ROW16((b) + 48)
+
+static const uint8_t PAIR_LUT[256] = {
+    OT_PAIR_ROW64(0), OT_PAIR_ROW64(64), OT_PAIR_ROW64(128), OT_PAIR_ROW64(192)
+};
+
+#undef OT_PAIR_ROW64
+#undef OT_PAIR_ROW16
+#undef OT_PAIR_ROW4
+#undef OT_PAIR_ENTRY
+#undef OT_PAIR_SECOND
+#undef OT_PAIR_FIRST
+
+static constexpr int FRAME_HALVES = 68;           // 34 bits
+static constexpr int STREAM_BYTES = 9;            // 72 halves: 36 pair slots, last 2 unused
+static constexpr uint64_t PAIRS_ALL_VALID = (1ULL << 34) - 1;
+
+// Append one pulse to the half-bit stream. Branch-free on the data (level and
+// single/double); only noise and out-of-range pulses take a branch.
+static inline bool appendPulse(uint8_t* stream, int& halves, uint32_t dur, uint32_t level,
+                               const HalfBitWindows& windows)
+{
+    if (dur < 100) return true;  // Skip noise/end markers
+
+    uint32_t count = (dur >= windows.singleMin) + (dur >= windows.doubleMin);
+    if (count == 0 || dur > windows.doubleMax) return false;
+
+    // 0b11 or 0b10 at the top of a 16-bit window, shifted to the write position
+    uint32_t pattern = ((0xC0u << (2 - count)) & 0xC0u) & (0u - level);
+    uint32_t window = (pattern << 8) >> (halves & 7);
+    stream[halves >> 3] |= (uint8_t)(window >> 8);
+    stream[(halves >> 3) + 1] |= (uint8_t)window;
+    halves += count;
+    return true;
+}
+
+static uint32_t decodePacked(const rmt_symbol_word_t* symbols, size_t num_symbols,
+                             const HalfBitWindows& windows, ParseError& error, int& bitIndex)
+{
+    uint8_t stream[STREAM_BYTES + 1] = {0};  // +1: spill byte for appendPulse()
+    int halves = 0;
+    bool badDuration = false;
+
+    // Pass 1: classify every pulse into 1 or 2 half-bits of its level
+    size_t i = 0;
+    if (num_symbols > 0 &&
+        symbols[0].level0 == 1 && symbols[0].duration0 > 0 &&
+        symbols[0].level1 == 0 && symbols[0].duration1 > 0) {
+        // Implicit HIGH start: the first half of the start bit merged with idle
+        stream[0] = 0x80;
+        halves = 1;
+        badDuration = !appendPulse(stream, halves, symbols[0].duration1, symbols[0].level1, windows);
+        i = 1;
+    }
+    for (; i < num_symbols && halves < FRAME_HALVES && !badDuration; i++) {
+        const rmt_symbol_word_t sym = symbols[i];
+        if (!appendPulse(stream, halves, sym.duration0, sym.level0, windows)) { badDuration = true; break; }
+        if (halves >= FRAME_HALVES) break;
+        if (!appendPulse(stream, halves, sym.duration1, sym.level1, windows)) { badDuration = true; break; }
     }
 
-    return frame;
+    // Infer missing final LOW (stop bit's second half produces no edge)
+    if (!badDuration && halves == FRAME_HALVES - 1 && (stream[8] & 0x20)) {
+        halves = FRAME_HALVES;
+    }
+
+    // Pass 2: four bits per table lookup; bit i of the frame lands at
+    // position 35 - i of both accumulators
+    uint64_t bits = 0;
+    uint64_t valid = 0;
+    for (int i = 0; i < STREAM_BYTES; i++) {
+        uint8_t entry = PAIR_LUT[stream[i]];
+        bits = (bits << 4) | (entry >> 4);
+        valid = (valid << 4) | (entry & 0x0F);
+    }
+    valid >>= 2;  // Drop the two unused pair slots: bit i now at 33 - i
+    bits >>= 2;
+
+    // Report the first failure in wire order, as the state machine does
+    error = ParseError::None;
+    bitIndex = halves / 2;
+    uint64_t bad = ~valid & PAIRS_ALL_VALID;
+    bad |= ~bits & ((1ULL << 33) | 1ULL);  // Start and stop bits must be '1'
+    // Only pairs that were completely received count
+    int completePairs = halves / 2;
+    if (completePairs < 34) {
+        bad &= ~((1ULL << (34 - completePairs)) - 1);
+    }
+    if (bad) {
+        bitIndex = 33 - (63 - __builtin_clzll(bad));
+        if (!(valid & (1ULL << (33 - bitIndex)))) error = ParseError::NoTransition;
+        else error = bitIndex == 0 ? ParseError::BadStart : ParseError::BadStop;
+    } else if (badDuration) {
+        error = ParseError::BadDuration;
+    } else if (halves < FRAME_HALVES) {
+        error = ParseError::Incomplete;
+    }
+
+    uint32_t frame = static_cast<uint32_t>(bits >> 1);
+    if (error == ParseError::None && (__builtin_popcount(frame) & 1)) {
+        error = ParseError::Parity;
+        bitIndex = 34;
+    }
+
+    return error == ParseError::None ? frame : 0;
+}
+
+// ============================================================================
+// Streaming decoder
+// ============================================================================
+
+void OT_PARSER_IRAM_ATTR ManchesterDecoder::reset(const BitClock& clock)
+{
+    reset(clock.windows());
+    estimateUs_ = clock.halfBitUs();
+    trackingPulses_ = ADAPTIVE_ESTIMATE_PULSES;
+}
+
+void OT_PARSER_IRAM_ATTR ManchesterDecoder::reset(const HalfBitWindows& windows)
+{
+    windows_ = windows;
+    estimateUs_ = 0;
+    trackingPulses_ = 0;
+    clockMissed_ = false;
+    pulseUs_ = 0;
+    pulseHalves_ = 0;
+    frame_ = 0;
+    symbolsConsumed_ = 0;
+    bitIndex_ = 0;
+    started_ = false;
+    inSecondHalf_ = false;
+    firstHalfHigh_ = false;
+    state_ = State::Receiving;
+    error_ = ParseError::None;
+}
+
+void OT_PARSER_IRAM_ATTR ManchesterDecoder::fail(ParseError error)
+{
+    error_ = error;
+    state_ = State::Failed;
+}
+
+// Same state machine as PROCESS_HALF_BIT() in parseRMTSymbols()
+void OT_PARSER_IRAM_ATTR ManchesterDecoder::processHalf(bool level)
+{
+    if (!inSecondHalf_) {
+        firstHalfHigh_ = level;
+        inSecondHalf_ = true;
+    } else if (firstHalfHigh_ == level) {
+        fail(ParseError::NoTransition);
+    } else {
+        bool bit = firstHalfHigh_ && !level;
+        if (bitIndex_ == 0 && !bit) fail(ParseError::BadStart);
+        else if (bitIndex_ == 33 && !bit) fail(ParseError::BadStop);
+        else {
+            if (bitIndex_ <= 32) frame_ = (frame_ << 1) | bit;
+            bitIndex_++;
+            inSecondHalf_ = false;
+        }
+    }
+}
+
+// The frame is complete once the stop bit's active (HIGH) half has ended:
+// its second half is the idle level, which produces no further edge.
+void OT_PARSER_IRAM_ATTR ManchesterDecoder::checkComplete()
+{
+    if (state_ != State::Receiving) return;
+
+    if (bitIndex_ == 34 || (bitIndex_ == 33 && inSecondHalf_ && firstHalfHigh_)) {
+        bitIndex_ = 34;
+        if (__builtin_popcount(frame_) & 1) fail(ParseError::Parity);
+        else state_ = State::Done;
+    }
+}
+
+ManchesterDecoder::State OT_PARSER_IRAM_ATTR ManchesterDecoder::feed(const rmt_symbol_word_t* symbols, size_t num_symbols)
+{
+    for (size_t i = 0; i < num_symbols && state_ == State::Receiving; i++) {
+        const rmt_symbol_word_t& sym = symbols[i];
+        symbolsConsumed_++;
+
+        int part = 0;
+        if (!started_) {
+            started_ = true;
+            // Implicit HIGH start: idle HIGH merged with the start bit's first half
+            if (sym.level0 == 1 && sym.duration0 > 0 && sym.level1 == 0 && sym.duration1 > 0) {
+                firstHalfHigh_ = true;
+                inSecondHalf_ = true;
+                part = 1;
+            }
+        }
+
+        for (; part < 2 && state_ == State::Receiving; part++) {
+            uint32_t dur = part ? sym.duration1 : sym.duration0;
+            if (dur < 100) continue;  // Skip noise/end markers
+
+            int halves;
+            if (trackingPulses_ > 0) {
+                // Bit clock recovery: the channel's clock decides first (as in
+                // parseRMTSymbolsAdaptive()); a pulse it rejects is classified
+                // against the running estimate instead, as estimateHalfBit()
+                // does, and the windows are re-derived from the measured
+                // period. A single jittered pulse is too noisy to steer by, so
+                // the prior holds until a few half-bits have been measured.
+                halves = classifyPulse(dur, windows_);
+                if (halves == 0) {
+                    clockMissed_ = true;
+                    halves = (2 * dur < estimateUs_ || dur > 3 * estimateUs_) ? 0
+                           : (2 * dur >= 3 * estimateUs_) ? 2 : 1;
+                }
+                if (halves && --trackingPulses_ == 0) {
+                    if (clockMissed_) windows_ = HalfBitWindows::forHalfBit((pulseUs_ + dur) / (pulseHalves_ + halves));
+                } else if (halves && pulseHalves_ + halves >= ADAPTIVE_SETTLE_HALVES) {
+                    estimateUs_ = (pulseUs_ + dur) / (pulseHalves_ + halves);
+                }
+            } else {
+                halves = classifyPulse(dur, windows_);
+            }
+            if (halves == 0) { fail(ParseError::BadDuration); break; }
+            pulseUs_ += dur;
+            pulseHalves_ += halves;
+
+            bool level = part ? sym.level1 : sym.level0;
+            processHalf(level);
+            if (halves == 2 && state_ == State::Receiving && bitIndex_ < 34) processHalf(level);
+
+            checkComplete();
+        }
+    }
+    return state_;
+}
+
+ManchesterDecoder::State OT_PARSER_IRAM_ATTR ManchesterDecoder::finish()
+{
+    checkComplete();
+    if (state_ == State::Receiving) {
+        fail(ParseError::Incomplete);
+    }
+    return state_;
 }
 
 } // namespace ot
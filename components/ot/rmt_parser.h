@@ -14,7 +14,14 @@
 // Conditional compilation for ESP-IDF vs standalone
 #ifdef ESP_PLATFORM
     #include "driver/rmt_types.h"
+    #include "esp_attr.h"
     #include "esp_log.h"
+    #include "sdkconfig.h"
+    // Streaming decoder is fed from the RMT RX ISR
+    #define OT_PARSER_IRAM_ATTR IRAM_ATTR
+    #if CONFIG_OT_RMT_PARSER_KERNEL_PACKED
+        #define OT_RMT_PARSER_PACKED 1
+    #endif
 #else
     // Standalone mode - mock the types
     struct rmt_symbol_word_t {
@@ -28,21 +35,177 @@
     #include <cstdio>
     #define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W (%s): " fmt "\n", tag, ##__VA_ARGS__)
     #define ESP_LOGI(tag, fmt, ...) fprintf(stdout, "I (%s): " fmt "\n", tag, ##__VA_ARGS__)
+    #define OT_PARSER_IRAM_ATTR
 #endif
 
 namespace ot {
 
+/**
+ * Reason a Manchester frame failed to decode
+ */
+enum class ParseError : uint8_t {
+    None,
+    BadStart,       // Start bit was not '1'
+    BadStop,        // Stop bit was not '1'
+    NoTransition,   // Two halves of a bit at the same level
+    BadDuration,    // Pulse neither a single nor a double half-bit
+    Incomplete,     // Reception ended before 34 bits
+    Parity          // Odd parity check failed
+};
+
+const char* toString(ParseError error);
+
+/**
+ * Pulse duration windows for one and two Manchester half-bits
+ *
+ * A pulse of [singleMin, doubleMin) us spans one half-bit, [doubleMin,
+ * doubleMax] two; anything else is a bad duration. Pulses under 100 us are
+ * always treated as noise.
+ */
+struct HalfBitWindows {
+    uint16_t singleMin;
+    uint16_t doubleMin;
+    uint16_t doubleMax;
+
+    // Windows scaled to a half-bit period T: 0.6T / 1.4T / 2.6T
+    static HalfBitWindows forHalfBit(uint32_t halfBitUs) {
+        HalfBitWindows w;
+        w.singleMin = static_cast<uint16_t>(halfBitUs * 3 / 5);
+        w.doubleMin = static_cast<uint16_t>(halfBitUs * 7 / 5);
+        w.doubleMax = static_cast<uint16_t>(halfBitUs * 13 / 5);
+        return w;
+    }
+    // Fixed windows for the nominal 500 us half-bit (300 / 700 / 1300 us)
+    static HalfBitWindows nominal() { return forHalfBit(500); }
+};
+
+/**
+ * Half-bit period estimate for one channel, smoothed across frames
+ *
+ * Lets the decoder follow a thermostat or boiler whose bit clock is off spec,
+ * or whose optocoupler stretches edges, instead of rejecting its frames with
+ * the fixed windows. Updated only from frames that decoded successfully.
+ */
+class BitClock {
+public:
+    static constexpr uint32_t NOMINAL_HALF_BIT_US = 500;
+    static constexpr uint32_t MIN_HALF_BIT_US = 300;
+    static constexpr uint32_t MAX_HALF_BIT_US = 800;
+
+    BitClock() { reset(); }
+
+    void reset() { halfBitX16_ = NOMINAL_HALF_BIT_US << 4; }
+    uint32_t halfBitUs() const { return (halfBitX16_ + 8) >> 4; }
+    HalfBitWindows windows() const { return HalfBitWindows::forHalfBit(halfBitUs()); }
+
+    // Fold in a decoded frame's half-bit period (exponential average, 1/4 weight)
+    void update(uint32_t measuredUs);
+
+private:
+    uint32_t halfBitX16_;   // Q4 fixed point
+};
+
 /**
  * Parse RMT symbols into an OpenTherm frame
  * 
  * Decodes Manchester-encoded OpenTherm data from RMT peripheral symbols.
+ * Uses the kernel selected at build time (OT_RMT_PARSER_PACKED, set from
+ * CONFIG_OT_RMT_PARSER_KERNEL_PACKED on ESP-IDF); both kernels return the
+ * same frame for every input.
  * 
  * @param symbols Array of RMT symbols (max 128)
  * @param num_symbols Number of symbols in the array
  * @param isSlave Whether this is slave (thermostat) mode (affects logging only)
  * @return Decoded 32-bit frame, or 0 if parsing failed
  */
-uint32_t parseRMTSymbols(rmt_symbol_word_t* symbols, size_t num_symbols, bool isSlave = false);
+uint32_t parseRMTSymbols(rmt_symbol_word_t* symbols, size_t num_symbols, bool isSlave = false,
+                         const HalfBitWindows& windows = HalfBitWindows::nominal());
+
+/**
+ * State machine kernel: classifies each pulse and advances the Manchester
+ * state one half-bit at a time.
+ */
+uint32_t parseRMTSymbolsStateMachine(rmt_symbol_word_t* symbols, size_t num_symbols, bool isSlave = false,
+                                     const HalfBitWindows& windows = HalfBitWindows::nominal());
+
+/**
+ * Packed kernel: classifies all pulses in one pass into a packed half-bit
+ * stream, then decodes four bits per byte of the stream with a lookup table
+ * (first-half levels plus first XOR second transition checks).
+ */
+uint32_t parseRMTSymbolsPacked(rmt_symbol_word_t* symbols, size_t num_symbols, bool isSlave = false,
+                               const HalfBitWindows& windows = HalfBitWindows::nominal());
+
+/**
+ * Estimate the half-bit period from the first maxPulses pulses
+ *
+ * Each pulse is counted as one or two half-bits by comparing it with
+ * 1.5 x priorUs; the estimate is total duration over total half-bits.
+ *
+ * @return Estimated half-bit period in us, or priorUs if nothing was usable
+ */
+uint32_t estimateHalfBit(const rmt_symbol_word_t* symbols, size_t num_symbols,
+                         uint32_t priorUs, size_t maxPulses);
+
+/**
+ * Per-type counts of the repair stage, for one channel
+ */
+struct RepairStats {
+    uint32_t attempted;      // Frames that failed to decode and entered the stage
+    uint32_t spikeMerges;    // Saved by folding glitch spikes into their neighbours
+    uint32_t pulseSplits;    // Saved by splitting a pulse that swallowed a half-bit
+    uint32_t halfBitFlips;   // Saved by moving the most ambiguous edge one half-bit
+    uint32_t unrepaired;     // Still discarded
+};
+
+/**
+ * Why a frame was discarded, for callers that log failures themselves
+ */
+struct ParseFailure {
+    ParseError error;
+    int bitIndex;
+};
+
+/**
+ * Parse with windows recovered from the frame itself
+ *
+ * Decodes with windows scaled to the channel's smoothed half-bit period.
+ * If that fails, estimates this frame's own period from its start bit and
+ * first transitions and retries, then falls back to the nominal windows.
+ * A decoded frame's period is folded into the clock.
+ *
+ * @param clock Per-channel estimate, updated on success
+ * @param repairs When set, a frame that fails every window is passed to
+ *        repairRMTSymbols() before being discarded (repaired frames do not
+ *        update the clock)
+ * @param failure When set, receives the reason a frame was discarded instead
+ *        of it being logged here
+ * @return Decoded 32-bit frame, or 0 if parsing failed
+ */
+uint32_t parseRMTSymbolsAdaptive(rmt_symbol_word_t* symbols, size_t num_symbols, BitClock& clock,
+                                 bool isSlave = false, RepairStats* repairs = nullptr,
+                                 ParseFailure* failure = nullptr);
+
+/**
+ * Try bounded single-glitch repairs on a frame that failed to decode
+ *
+ * In order, each only if the previous step did not produce a frame:
+ *  - pulses shorter than 0.3T are merged into their neighbours
+ *  - on a bad duration, the one pulse spanning 3-4 half-bits is split
+ *    around a swallowed opposite half-bit; kept only if exactly one
+ *    split position decodes
+ *  - on a parity or missing-transition error, the edge whose position is
+ *    most ambiguous between its two pulses (a single and a double) is moved
+ *    by one half-bit, flipping one bit; only if it sits at least 3T/8 off its
+ *    decoded position and clearly ahead of the runner-up
+ *
+ * At most five decodes per frame. Counts the outcome in stats.
+ *
+ * @param halfBitUs Half-bit period T the frame was sent with
+ * @return Repaired 32-bit frame, or 0
+ */
+uint32_t repairRMTSymbols(const rmt_symbol_word_t* symbols, size_t num_symbols, uint32_t halfBitUs,
+                          RepairStats& stats);
 
 /**
  * Build a compact log string from RMT symbols for debugging
@@ -55,6 +218,77 @@ uint32_t parseRMTSymbols(rmt_symbol_word_t* symbols, size_t num_symbols, bool is
 void buildRMTSymbolLogString(rmt_symbol_word_t* symbols, size_t num_symbols, 
                               char* buffer, size_t bufferSize);
 
+/**
+ * Resumable Manchester decoder fed with RMT symbols in arbitrary chunks
+ *
+ * Produces the same frames as parseRMTSymbols() but can be fed partial
+ * receive chunks (RMT ping-pong mode) and completes as soon as the stop
+ * bit's active half has been seen, without waiting for the RMT idle
+ * timeout that terminates a batch receive.
+ *
+ * Usage: reset(), feed() chunks until it returns Done or Failed, or call
+ * finish() when reception ends to resolve a frame that is still open.
+ */
+class ManchesterDecoder {
+public:
+    enum class State : uint8_t {
+        Receiving,  // Needs more symbols
+        Done,       // frame() is valid
+        Failed      // error() says why
+    };
+
+    ManchesterDecoder() { reset(); }
+
+    // Arm for a new frame, classifying pulses with the given windows
+    void reset(const HalfBitWindows& windows = HalfBitWindows::nominal());
+    // Arm for a new frame with bit clock recovery: the first pulses are
+    // classified against a running estimate seeded from the channel's clock,
+    // which then sets the windows for the rest of the frame
+    void reset(const BitClock& clock);
+
+    /**
+     * Consume a chunk of symbols. Stops consuming once the frame is
+     * complete or has failed; further calls are no-ops until reset().
+     *
+     * @return Decoder state after this chunk
+     */
+    State feed(const rmt_symbol_word_t* symbols, size_t num_symbols);
+
+    /**
+     * Reception ended (RMT idle timeout): fail a frame that is still open.
+     */
+    State finish();
+
+    State state() const { return state_; }
+    uint32_t frame() const { return state_ == State::Done ? frame_ : 0; }
+    ParseError error() const { return error_; }
+    int bitIndex() const { return bitIndex_; }
+    // Symbols consumed before the frame completed or failed
+    size_t symbolsConsumed() const { return symbolsConsumed_; }
+    // Mean half-bit period of the pulses decoded so far (0 if none)
+    uint32_t measuredHalfBitUs() const { return pulseHalves_ ? pulseUs_ / pulseHalves_ : 0; }
+
+private:
+    void processHalf(bool level);
+    void fail(ParseError error);
+    void checkComplete();
+
+    HalfBitWindows windows_;
+    uint32_t estimateUs_;    // Running half-bit estimate while tracking
+    uint8_t trackingPulses_; // Pulses left to classify against estimateUs_
+    bool clockMissed_;       // The clock's windows rejected a pulse while tracking
+    uint32_t pulseUs_;       // Duration and half-bits of classified pulses,
+    uint32_t pulseHalves_;   // for measuredHalfBitUs()
+    uint32_t frame_;
+    size_t symbolsConsumed_;
+    int8_t bitIndex_;        // Bit being decoded (0=start, 1-32=data, 33=stop)
+    bool started_;           // First symbol seen (implicit HIGH start resolved)
+    bool inSecondHalf_;      // Waiting for second half of Manchester bit
+    bool firstHalfHigh_;     // Level of first half (valid when inSecondHalf_)
+    State state_;
+    ParseError error_;
+};
+
 } // namespace ot
 
 #endif // RMT_PARSER_H
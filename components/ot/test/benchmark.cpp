@@ -0,0 +1,357 @@
+// Standalone benchmark for the RMT parser kernels
+// Reads "0xEXPECTED level0,dur0,level1,dur1;..." lines on stdin (run_tests.py --bench
+// converts test-inputs.txt), adds a synthetic corpus, and reports ns/frame per kernel.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// Disable ESP_PLATFORM for standalone mode
+#undef ESP_PLATFORM
+
+#include "../rmt_parser.h"
+
+struct BenchFrame {
+    uint32_t expected;
+    std::vector<rmt_symbol_word_t> symbols;
+};
+
+typedef uint32_t (*ParseFn)(rmt_symbol_word_t*, size_t, bool, const ot::HalfBitWindows&);
+
+struct Kernel {
+    const char* name;
+    ParseFn parse;
+};
+
+static const Kernel KERNELS[] = {
+    {"state machine", ot::parseRMTSymbolsStateMachine},
+    {"packed",        ot::parseRMTSymbolsPacked},
+};
+
+static bool parseLine(const char* line, BenchFrame& out) {
+    char* endptr;
+    out.expected = (uint32_t)strtoul(line, &endptr, 16);
+    if (endptr == line) return false;
+
+    const char* ptr = endptr;
+    out.symbols.clear();
+    while (*ptr) {
+        while (*ptr == ' ' || *ptr == ';') ptr++;
+        if (*ptr == '\0' || *ptr == '\n' || *ptr == '\r') break;
+        long v[4];
+        for (int i = 0; i < 4; i++) {
+            v[i] = strtol(ptr, &endptr, 10);
+            if (endptr == ptr) return false;
+            ptr = (*endptr == ',') ? endptr + 1 : endptr;
+        }
+        rmt_symbol_word_t sym;
+        sym.level0 = (uint32_t)v[0];
+        sym.duration0 = (uint32_t)v[1];
+        sym.level1 = (uint32_t)v[2];
+        sym.duration1 = (uint32_t)v[3];
+        out.symbols.push_back(sym);
+    }
+    return !out.symbols.empty() && out.symbols.size() <= 128;
+}
+
+static uint32_t xorshift32(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+typedef std::vector<std::pair<int, int> > Runs;  // (level, duration us)
+
+// Encode a frame the way the RMT receiver captures it: Manchester halves merged
+// into runs of one or two half-bit periods (+- jitter); the stop bit's idle
+// half never ends in an edge
+static Runs synthesizeRuns(uint32_t frame, int jitterUs, uint32_t& rng, int halfBitUs) {
+    uint64_t bits = (1ULL << 33) | ((uint64_t)frame << 1) | 1ULL;
+
+    int levels[68];
+    for (int i = 0; i < 34; i++) {
+        bool bit = (bits >> (33 - i)) & 1;
+        levels[2 * i] = bit ? 1 : 0;
+        levels[2 * i + 1] = bit ? 0 : 1;
+    }
+
+    Runs runs;
+    for (int i = 0; i < 67; i++) {
+        if (!runs.empty() && runs.back().first == levels[i]) {
+            runs.back().second += halfBitUs;
+        } else {
+            runs.push_back(std::make_pair(levels[i], halfBitUs));
+        }
+    }
+    for (size_t i = 0; i < runs.size(); i++) {
+        int j = jitterUs ? (int)(xorshift32(rng) % (2 * jitterUs + 1)) - jitterUs : 0;
+        runs[i].second += j;
+    }
+    return runs;
+}
+
+// Pack runs into symbols, idle after the stop bit as a 0 duration
+static BenchFrame packRuns(uint32_t frame, Runs runs) {
+    runs.push_back(std::make_pair(0, 0));
+
+    BenchFrame out;
+    out.expected = frame;
+    for (size_t i = 0; i < runs.size(); i += 2) {
+        rmt_symbol_word_t sym;
+        sym.level0 = runs[i].first;
+        sym.duration0 = runs[i].second;
+        sym.level1 = i + 1 < runs.size() ? runs[i + 1].first : 0;
+        sym.duration1 = i + 1 < runs.size() ? runs[i + 1].second : 0;
+        out.symbols.push_back(sym);
+    }
+    return out;
+}
+
+static BenchFrame synthesize(uint32_t frame, int jitterUs, uint32_t& rng, int halfBitUs = 500) {
+    return packRuns(frame, synthesizeRuns(frame, jitterUs, rng, halfBitUs));
+}
+
+static uint32_t randomFrame(uint32_t& rng) {
+    uint32_t frame = xorshift32(rng) & 0x7FFFFFFF;
+    if (__builtin_popcount(frame) & 1) frame |= 0x80000000;  // Even parity overall
+    return frame;
+}
+
+static volatile uint32_t g_sink;
+
+// Returns ns/frame; counts frames whose result differs from the expected value
+static double timeKernel(const Kernel& kernel, std::vector<BenchFrame>& corpus, int passes, size_t& mismatches) {
+    const ot::HalfBitWindows windows = ot::HalfBitWindows::nominal();
+    mismatches = 0;
+    for (size_t i = 0; i < corpus.size(); i++) {
+        if (kernel.parse(corpus[i].symbols.data(), corpus[i].symbols.size(), false, windows) != corpus[i].expected) {
+            mismatches++;
+        }
+    }
+
+    uint32_t acc = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < passes; p++) {
+        for (size_t i = 0; i < corpus.size(); i++) {
+            acc ^= kernel.parse(corpus[i].symbols.data(), corpus[i].symbols.size(), false, windows);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    g_sink = acc;
+
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    return ns / ((double)passes * (double)corpus.size());
+}
+
+// Off-spec bit clocks and noisy edges; one channel (BitClock) per scenario
+struct RateScenario {
+    int halfBitUs;
+    int jitterUs;
+};
+
+static const RateScenario RATE_SCENARIOS[] = {
+    {500, 40}, {500, 150}, {380, 80}, {420, 120}, {560, 150}, {600, 100}, {650, 60}, {700, 60},
+};
+
+static void reportDecodeRates(size_t framesPerScenario) {
+    printf("Decode rate: %zu frames per scenario\n", framesPerScenario);
+    printf("  half-bit  jitter     fixed  adaptive    stream  (estimate)\n");
+    for (size_t s = 0; s < sizeof(RATE_SCENARIOS) / sizeof(RATE_SCENARIOS[0]); s++) {
+        const RateScenario& sc = RATE_SCENARIOS[s];
+        uint32_t rng = 0x4F54u + (uint32_t)s;
+        ot::BitClock clock;
+        ot::BitClock streamClock;
+        ot::ManchesterDecoder decoder;
+        size_t fixedOk = 0;
+        size_t adaptiveOk = 0;
+        size_t streamOk = 0;
+        for (size_t i = 0; i < framesPerScenario; i++) {
+            BenchFrame f = synthesize(randomFrame(rng), sc.jitterUs, rng, sc.halfBitUs);
+            if (ot::parseRMTSymbols(f.symbols.data(), f.symbols.size(), false) == f.expected) fixedOk++;
+            if (ot::parseRMTSymbolsAdaptive(f.symbols.data(), f.symbols.size(), clock, false) == f.expected) adaptiveOk++;
+
+            // Streaming decoder as the RX ISR drives it
+            decoder.reset(streamClock);
+            decoder.feed(f.symbols.data(), f.symbols.size());
+            decoder.finish();
+            if (decoder.frame() != 0) streamClock.update(decoder.measuredHalfBitUs());
+            if (decoder.frame() == f.expected) streamOk++;
+        }
+        printf("  %5d us  +-%3d us  %6.1f%%  %7.1f%%  %7.1f%%  (%lu us)\n", sc.halfBitUs, sc.jitterUs,
+               100.0 * (double)fixedOk / (double)framesPerScenario,
+               100.0 * (double)adaptiveOk / (double)framesPerScenario,
+               100.0 * (double)streamOk / (double)framesPerScenario,
+               (unsigned long)clock.halfBitUs());
+    }
+}
+
+// Single glitches injected into one run of a clean frame
+enum class Glitch { None, Spike, Swallowed, DisplacedEdge };
+
+static void injectGlitch(Runs& runs, Glitch glitch, uint32_t& rng, int halfBitUs) {
+    size_t n = runs.size();
+    switch (glitch) {
+        case Glitch::None:
+            break;
+        case Glitch::Spike: {
+            // 30-90 us opposite spike somewhere inside a run
+            size_t i = 1 + xorshift32(rng) % (n - 2);
+            int level = runs[i].first;
+            int dur = runs[i].second;
+            int spike = 30 + (int)(xorshift32(rng) % 61);
+            int head = dur / 8 + (int)(xorshift32(rng) % (uint32_t)(dur * 3 / 4));
+            if (head + spike >= dur) head = dur - spike - 1;
+            runs[i].second = head;
+            runs.insert(runs.begin() + i + 1, std::make_pair(1 - level, spike));
+            runs.insert(runs.begin() + i + 2, std::make_pair(level, dur - head - spike));
+            break;
+        }
+        case Glitch::Swallowed: {
+            // A single half-bit pulse lost: its neighbours merge across it
+            for (int tries = 0; tries < 16; tries++) {
+                size_t i = 2 + xorshift32(rng) % (n - 4);
+                if (runs[i].second >= halfBitUs * 3 / 2) continue;
+                runs[i - 1].second += runs[i].second + runs[i + 1].second;
+                runs.erase(runs.begin() + i, runs.begin() + i + 2);
+                break;
+            }
+            break;
+        }
+        case Glitch::DisplacedEdge: {
+            // An edge between a single and a double pulse lands 0.42-0.55T
+            // towards the double
+            for (int tries = 0; tries < 16; tries++) {
+                size_t i = 1 + xorshift32(rng) % (n - 3);
+                bool aSingle = runs[i].second < halfBitUs * 3 / 2;
+                bool bSingle = runs[i + 1].second < halfBitUs * 3 / 2;
+                if (aSingle == bSingle) continue;
+                int e = halfBitUs * (42 + (int)(xorshift32(rng) % 14)) / 100;
+                runs[i].second += aSingle ? e : -e;
+                runs[i + 1].second += aSingle ? -e : e;
+                break;
+            }
+            break;
+        }
+    }
+}
+
+struct RepairScenario {
+    const char* name;
+    Glitch glitch;
+    int jitterUs;
+};
+
+static const RepairScenario REPAIR_SCENARIOS[] = {
+    {"spike",          Glitch::Spike,         40},
+    {"swallowed",      Glitch::Swallowed,     40},
+    {"displaced edge", Glitch::DisplacedEdge, 40},
+    {"none, +-220 us", Glitch::None,          220},
+};
+
+static void reportRepairRates(size_t framesPerScenario) {
+    printf("Repair: %zu frames per scenario (half-bit 500 us)\n", framesPerScenario);
+    printf("  glitch             plain  repaired  wrong (plain)  spike split  flip  us/repair\n");
+    for (size_t s = 0; s < sizeof(REPAIR_SCENARIOS) / sizeof(REPAIR_SCENARIOS[0]); s++) {
+        const RepairScenario& sc = REPAIR_SCENARIOS[s];
+        uint32_t rng = 0x52u + (uint32_t)s;
+        ot::BitClock plainClock;
+        ot::BitClock repairClock;
+        ot::RepairStats stats = {};
+        size_t plainOk = 0;
+        size_t repairedOk = 0;
+        size_t wrong = 0;
+        size_t plainWrong = 0;
+        double repairNs = 0;
+        for (size_t i = 0; i < framesPerScenario; i++) {
+            uint32_t frame = randomFrame(rng);
+            Runs runs = synthesizeRuns(frame, sc.jitterUs, rng, 500);
+            injectGlitch(runs, sc.glitch, rng, 500);
+            BenchFrame f = packRuns(frame, runs);
+            if (f.symbols.size() > 128) continue;
+
+            uint32_t plain = ot::parseRMTSymbolsAdaptive(f.symbols.data(), f.symbols.size(), plainClock, false);
+            if (plain == f.expected) plainOk++;
+            else if (plain != 0) plainWrong++;
+            uint32_t attempted = stats.attempted;
+            auto start = std::chrono::steady_clock::now();
+            uint32_t result = ot::parseRMTSymbolsAdaptive(f.symbols.data(), f.symbols.size(), repairClock, false, &stats);
+            auto end = std::chrono::steady_clock::now();
+            if (stats.attempted != attempted) {
+                repairNs += (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            }
+            if (result == f.expected) repairedOk++;
+            else if (result != 0) wrong++;
+        }
+        printf("  %-16s %6.1f%%  %7.1f%%  %5zu %7zu  %5lu %5lu %5lu  %9.2f\n", sc.name,
+               100.0 * (double)plainOk / (double)framesPerScenario,
+               100.0 * (double)repairedOk / (double)framesPerScenario, wrong, plainWrong,
+               (unsigned long)stats.spikeMerges, (unsigned long)stats.pulseSplits,
+               (unsigned long)stats.halfBitFlips,
+               stats.attempted ? repairNs / 1000.0 / (double)stats.attempted : 0.0);
+    }
+}
+
+static bool report(const char* title, std::vector<BenchFrame>& corpus, int passes) {
+    bool ok = true;
+    printf("%s: %zu frames x %d passes\n", title, corpus.size(), passes);
+    for (size_t k = 0; k < sizeof(KERNELS) / sizeof(KERNELS[0]); k++) {
+        size_t mismatches = 0;
+        double nsPerFrame = timeKernel(KERNELS[k], corpus, passes, mismatches);
+        printf("  %-14s %8.1f ns/frame", KERNELS[k].name, nsPerFrame);
+        if (mismatches) {
+            printf("  (%zu mismatches)", mismatches);
+            ok = false;
+        }
+        printf("\n");
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    size_t syntheticCount = 20000;
+    int jitterUs = 40;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--frames=", 9) == 0) syntheticCount = (size_t)atol(argv[i] + 9);
+        else if (strncmp(argv[i], "--jitter=", 9) == 0) jitterUs = atoi(argv[i] + 9);
+        else if (strcmp(argv[i], "--verbose") == 0) verbose = true;
+        else {
+            fprintf(stderr, "Usage: %s [--frames=N] [--jitter=US] [--verbose] < corpus\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!verbose) {
+        // Every rejected frame logs its symbols; the rate tables reject thousands
+        fflush(stderr);
+        if (!freopen("/dev/null", "w", stderr)) return 1;
+    }
+
+    std::vector<BenchFrame> corpus;
+    char line[4096];
+    while (fgets(line, sizeof(line), stdin)) {
+        BenchFrame f;
+        if (parseLine(line, f)) corpus.push_back(f);
+    }
+
+    std::vector<BenchFrame> synthetic;
+    uint32_t rng = 0x4F54u;  // Fixed seed: runs are comparable
+    for (size_t i = 0; i < syntheticCount; i++) {
+        synthetic.push_back(synthesize(randomFrame(rng), jitterUs, rng));
+    }
+
+    bool ok = true;
+    if (!corpus.empty()) {
+        ok &= report("Corpus", corpus, 2000);
+    }
+    char title[64];
+    snprintf(title, sizeof(title), "Synthetic (jitter +-%d us)", jitterUs);
+    ok &= report(title, synthetic, 20);
+    reportDecodeRates(2000);
+    reportRepairRates(2000);
+
+    return ok ? 0 : 1;
+}
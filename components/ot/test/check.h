@@ -0,0 +1,22 @@
+// Checks for the host tests
+//
+// A failed CHECK prints where it was and counts in s_failures; the test
+// carries on and main() reports the count at the end. Atomic, so worker
+// threads can check too.
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <atomic>
+#include <cstdio>
+
+static std::atomic<int> s_failures{0};
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "  %s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            s_failures++; \
+        } \
+    } while (0)
+
+#endif // CHECK_H
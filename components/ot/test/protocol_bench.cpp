@@ -0,0 +1,140 @@
+// Request/response throughput and latency on the simulated bus
+//
+// The master sends back-to-back requests (each as soon as its inter-frame
+// delay allows) and the slave answers every valid one. Reports the host
+// cost of the state machine per transaction, and the virtual bus latency
+// and throughput, optionally with frames dropped or corrupted on the wire.
+//
+//   protocol_bench [--transactions=N] [--drop=PCT] [--corrupt=PCT]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "sim_bus.h"
+
+using ot::OpenThermMessageID;
+using ot::OpenThermMessageType;
+using ot::OpenThermProtocol;
+using ot::OpenThermResponseStatus;
+
+static uint32_t xorshift32(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+struct LatencyStats {
+    uint64_t count = 0;
+    uint64_t sumUs = 0;
+    uint64_t minUs = UINT64_MAX;
+    uint64_t maxUs = 0;
+
+    void add(uint64_t us) {
+        count++;
+        sumUs += us;
+        minUs = std::min(minUs, us);
+        maxUs = std::max(maxUs, us);
+    }
+};
+
+int main(int argc, char** argv)
+{
+    long transactions = 100000;
+    long dropPct = 0;
+    long corruptPct = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--transactions=", 15) == 0) {
+            transactions = strtol(argv[i] + 15, nullptr, 10);
+        } else if (strncmp(argv[i], "--drop=", 7) == 0) {
+            dropPct = strtol(argv[i] + 7, nullptr, 10);
+        } else if (strncmp(argv[i], "--corrupt=", 10) == 0) {
+            corruptPct = strtol(argv[i] + 10, nullptr, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--transactions=N] [--drop=PCT] [--corrupt=PCT]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    SimBus bus;
+    bus.begin();
+    uint32_t rng = 0x2545F491;
+    if (dropPct > 0 || corruptPct > 0) {
+        bus.setFault([&rng, dropPct, corruptPct](const SimNode&, uint32_t) {
+            long roll = static_cast<long>(xorshift32(rng) % 100);
+            if (roll < dropPct) return SimBus::Fault::Drop;
+            if (roll < dropPct + corruptPct) return SimBus::Fault::Corrupt;
+            return SimBus::Fault::None;
+        });
+    }
+
+    SimNode& master = bus.master();
+    SimNode& slave = bus.slave();
+    LatencyStats byStatus[4];
+    long started = 0;
+    long finished = 0;
+    uint64_t startedAt = 0;
+    bool inFlight = false;
+
+    auto respond = [&slave](unsigned long request, OpenThermResponseStatus status) {
+        if (status == OpenThermResponseStatus::SUCCESS) {
+            slave.sendResponse(OpenThermProtocol::buildResponse(
+                OpenThermMessageType::READ_ACK, OpenThermProtocol::getDataID(request), request & 0xFFFF));
+        }
+    };
+    auto complete = [&](unsigned long, OpenThermResponseStatus status) {
+        if (!inFlight) return;
+        byStatus[static_cast<size_t>(status)].add(bus.now() - startedAt);
+        inFlight = false;
+        finished++;
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    while (finished < transactions) {
+        if (!inFlight && master.isReady()) {
+            // IDs 1..127: READ_DATA of ID 0 with no data is the all-zero
+            // frame, which the capture path reserves for "nothing decoded"
+            unsigned long request = OpenThermProtocol::buildRequest(
+                OpenThermMessageType::READ_DATA, static_cast<OpenThermMessageID>(started % 127 + 1), 0);
+            if (master.sendRequestAsync(request)) {
+                started++;
+                startedAt = bus.now();
+                inFlight = true;
+            }
+        }
+        if (!bus.advance()) {
+            break;
+        }
+        slave.process(respond);
+        master.process(complete);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    double hostNs = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    double busSeconds = bus.now() / 1e6;
+
+    printf("Transactions: %ld (drop %ld%%, corrupt %ld%%)\n", finished, dropPct, corruptPct);
+    printf("Host:  %.0f ns/transaction (state machine + simulated wire)\n",
+           finished ? hostNs / finished : 0.0);
+    printf("Bus:   %.2f transactions/s over %.1f s of bus time, %llu frames\n",
+           busSeconds > 0 ? finished / busSeconds : 0.0, busSeconds,
+           static_cast<unsigned long long>(bus.framesSent()));
+    printf("\n%-8s %10s %10s %10s %10s\n", "result", "count", "min us", "avg us", "max us");
+    for (size_t i = 0; i < 4; i++) {
+        const LatencyStats& st = byStatus[i];
+        if (st.count == 0) continue;
+        printf("%-8s %10llu %10llu %10llu %10llu\n",
+               OpenThermProtocol::statusToString(static_cast<OpenThermResponseStatus>(i)),
+               static_cast<unsigned long long>(st.count), static_cast<unsigned long long>(st.minUs),
+               static_cast<unsigned long long>(st.sumUs / st.count), static_cast<unsigned long long>(st.maxUs));
+    }
+
+    ot::BusStats m = master.busStats();
+    printf("\nMaster: tx=%u rx=%u invalid=%u errors=%u timeouts=%u\n",
+           m.txFrames, m.rxFrames, m.rxInvalid, m.rxErrorTotal(), m.timeouts);
+    return finished == transactions ? 0 : 1;
+}
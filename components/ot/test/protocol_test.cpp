@@ -0,0 +1,183 @@
+// Request/response state machine tests on the simulated bus
+//
+// Drives a master and a slave OpenThermProtocol through SimBus with a
+// virtual clock, so timeouts and inter-frame delays are exact.
+
+#include <cstdio>
+
+#include "sim_bus.h"
+#include "check.h"
+
+using ot::OpenThermMessageID;
+using ot::OpenThermMessageType;
+using ot::OpenThermProtocol;
+using ot::OpenThermResponseStatus;
+using ot::OpenThermStatus;
+using ot::ParseError;
+
+static const unsigned long REQUEST =
+    OpenThermProtocol::buildRequest(OpenThermMessageType::READ_DATA, OpenThermMessageID::Tboiler, 0);
+
+// Slave answers every valid request with READ_ACK and a fixed value
+static unsigned long answer(unsigned long request, OpenThermMessageType type = OpenThermMessageType::READ_ACK)
+{
+    return OpenThermProtocol::buildResponse(type, OpenThermProtocol::getDataID(request), 0x2d80);
+}
+
+struct Outcome {
+    OpenThermResponseStatus status = OpenThermResponseStatus::NONE;
+    unsigned long frame = 0;
+    uint64_t atUs = 0;
+};
+
+// Run both sides until the master's process() reports a result for its
+// request or the bus goes idle
+static Outcome runTransaction(SimBus& bus, OpenThermMessageType responseType = OpenThermMessageType::READ_ACK)
+{
+    Outcome out;
+    SimNode& slave = bus.slave();
+    while (out.status == OpenThermResponseStatus::NONE && bus.advance()) {
+        slave.process([&slave, responseType](unsigned long request, OpenThermResponseStatus status) {
+            if (status == OpenThermResponseStatus::SUCCESS) {
+                slave.sendResponse(answer(request, responseType));
+            }
+        });
+        bus.master().process([&out, &bus](unsigned long frame, OpenThermResponseStatus status) {
+            out.status = status;
+            out.frame = frame;
+            out.atUs = bus.now();
+        });
+    }
+    return out;
+}
+
+static void testRoundTrip()
+{
+    SimBus bus;
+    bus.begin();
+    CHECK(bus.master().sendRequestAsync(REQUEST));
+    CHECK(bus.master().status == OpenThermStatus::REQUEST_SENDING);
+
+    Outcome out = runTransaction(bus);
+    CHECK(out.status == OpenThermResponseStatus::SUCCESS);
+    CHECK(out.frame == answer(REQUEST));
+    // Request and response on the wire, each captured after the idle timeout
+    CHECK(out.atUs == 2 * (SimBus::FRAME_US + SimBus::CAPTURE_DELAY_US));
+    CHECK(bus.master().completions() == 1);
+    CHECK(bus.master().lastCompletion() == OpenThermResponseStatus::SUCCESS);
+
+    ot::BusStats m = bus.master().busStats();
+    ot::BusStats s = bus.slave().busStats();
+    CHECK(m.txFrames == 1 && m.rxFrames == 1 && m.rxErrorTotal() == 0 && m.timeouts == 0);
+    CHECK(s.txFrames == 1 && s.rxFrames == 1);
+}
+
+static void testBusyAndInterFrameDelay()
+{
+    SimBus bus;
+    bus.begin();
+    CHECK(bus.master().sendRequestAsync(REQUEST));
+    CHECK(!bus.master().sendRequestAsync(REQUEST));    // Still in flight
+
+    Outcome out = runTransaction(bus);
+    CHECK(out.status == OpenThermResponseStatus::SUCCESS);
+    CHECK(bus.master().status == OpenThermStatus::DELAY);
+    CHECK(!bus.master().sendRequestAsync(REQUEST));    // Inter-frame gap
+
+    // READY only once the master's delay has passed
+    bus.runUntil(out.atUs + OpenThermProtocol::MASTER_DELAY_US);
+    bus.master().process();
+    CHECK(bus.master().status == OpenThermStatus::DELAY);
+    bus.runUntil(out.atUs + OpenThermProtocol::MASTER_DELAY_US + 1);
+    bus.master().process();
+    CHECK(bus.master().status == OpenThermStatus::READY);
+    CHECK(bus.master().sendRequestAsync(REQUEST));
+}
+
+static void testTimeout()
+{
+    SimBus bus;
+    bus.begin();
+    // The slave never hears the request
+    bus.setFault([](const SimNode& from, uint32_t) {
+        return from.slave() ? SimBus::Fault::None : SimBus::Fault::Drop;
+    });
+    CHECK(bus.master().sendRequestAsync(REQUEST));
+
+    Outcome out = runTransaction(bus);
+    CHECK(out.status == OpenThermResponseStatus::TIMEOUT);
+    // The timeout runs from the end of the request's transmission
+    CHECK(out.atUs == SimBus::FRAME_US + OpenThermProtocol::RESPONSE_TIMEOUT_US + 1);
+    CHECK(bus.master().lastCompletion() == OpenThermResponseStatus::TIMEOUT);
+    CHECK(bus.master().status == OpenThermStatus::READY);
+    CHECK(bus.master().busStats().timeouts == 1);
+}
+
+static void testCorruptResponse()
+{
+    SimBus bus;
+    bus.begin();
+    bus.setFault([](const SimNode& from, uint32_t) {
+        return from.slave() ? SimBus::Fault::Corrupt : SimBus::Fault::None;
+    });
+    CHECK(bus.master().sendRequestAsync(REQUEST));
+
+    Outcome out = runTransaction(bus);
+    CHECK(out.status == OpenThermResponseStatus::INVALID);
+    CHECK(bus.master().lastCompletion() == OpenThermResponseStatus::INVALID);
+    ot::BusStats m = bus.master().busStats();
+    CHECK(m.rxErrors[static_cast<size_t>(ParseError::Parity)] == 1);
+    CHECK(m.rxFrames == 0 && m.rxInvalid == 0);
+}
+
+static void testWrongResponseType()
+{
+    SimBus bus;
+    bus.begin();
+    CHECK(bus.master().sendRequestAsync(REQUEST));
+
+    // Decodes, but a READ_DATA frame is not a response
+    Outcome out = runTransaction(bus, OpenThermMessageType::READ_DATA);
+    CHECK(out.status == OpenThermResponseStatus::INVALID);
+    ot::BusStats m = bus.master().busStats();
+    CHECK(m.rxFrames == 1 && m.rxInvalid == 1);
+}
+
+static void testUnsolicitedCapture()
+{
+    SimBus bus;
+    bus.begin();
+    // A failed capture while no request is outstanding is only counted
+    bus.setFault([](const SimNode&, uint32_t) { return SimBus::Fault::Corrupt; });
+    CHECK(bus.slave().sendResponse(answer(REQUEST)));
+    while (bus.advance()) {
+        bus.master().process();
+    }
+    CHECK(bus.master().status == OpenThermStatus::READY);
+    CHECK(bus.master().completions() == 0);
+    CHECK(bus.master().busStats().rxErrorTotal() == 1);
+}
+
+int main()
+{
+    struct { const char* name; void (*fn)(); } tests[] = {
+        {"round trip", testRoundTrip},
+        {"busy and inter-frame delay", testBusyAndInterFrameDelay},
+        {"timeout", testTimeout},
+        {"corrupt response", testCorruptResponse},
+        {"wrong response type", testWrongResponseType},
+        {"unsolicited capture", testUnsolicitedCapture},
+    };
+
+    int failed = 0;
+    for (const auto& t : tests) {
+        int before = s_failures;
+        t.fn();
+        bool ok = s_failures == before;
+        printf("%-28s %s\n", t.name, ok ? "PASS" : "FAIL");
+        if (!ok) failed++;
+    }
+    printf("\n%d/%zu protocol tests passed\n", (int)(sizeof(tests) / sizeof(tests[0])) - failed,
+           sizeof(tests) / sizeof(tests[0]));
+    return failed == 0 ? 0 : 1;
+}
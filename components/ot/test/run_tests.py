@@ -115,16 +115,58 @@ def compile_test_binary(test_dir: Path, output_file: Path) -> bool:
         return False
 
 
-def run_single_test(test_binary: Path, symbol_data: str, expected: int, test_num: int) -> Tuple[bool, str]:
+def compile_benchmark(test_dir: Path, output_file: Path) -> bool:
     """
-    Run a single test case.
+    Compile the kernel benchmark (optimised like firmware, -O2).
+    """
+    cmd = [
+        'g++',
+        '-std=c++11',
+        '-O2',
+        '-Wall',
+        '-I', str(test_dir.parent),
+        '-o', str(output_file),
+        str(test_dir / "benchmark.cpp"),
+        str(test_dir.parent / "rmt_parser.cpp")
+    ]
+
+    try:
+        subprocess.run(cmd, capture_output=True, text=True, check=True)
+        return True
+    except subprocess.CalledProcessError as e:
+        print(f"Benchmark compilation failed!", file=sys.stderr)
+        print(f"stderr: {e.stderr}", file=sys.stderr)
+        return False
+
+
+def run_benchmark(script_dir: Path, test_cases: List[Tuple[int, str, str]], extra_args: List[str]) -> int:
+    """
+    Time every parser kernel over the corpus and a synthetic corpus.
+    """
+    bench_binary = script_dir / "rmt_parser_bench"
+    print("Compiling benchmark...")
+    if not compile_benchmark(script_dir, bench_binary):
+        return 1
+
+    corpus = ''.join(f"0x{expected:08x} {symbol_data}\n" for expected, symbol_data, _ in test_cases)
+    result = subprocess.run([str(bench_binary)] + extra_args, input=corpus, text=True)
+    return result.returncode
+
+
+MODES = ['batch', 'packed', 'adaptive', 'repair', 'stream']
+
+
+def run_single_test(test_binary: Path, symbol_data: str, expected: int, test_num: int,
+                    mode: str = 'batch') -> Tuple[bool, str]:
+    """
+    Run a single test case through one parser entry point.
     
     Returns:
         (success, output) - success is True if result matches expected
     """
     try:
         result = subprocess.run(
-            [str(test_binary), symbol_data],
+            [str(test_binary), f'--mode={mode}', symbol_data],
             capture_output=True,
             text=True,
             timeout=5
@@ -199,10 +241,6 @@ def main():
         print(f"Please create test cases file at: {log_file}", file=sys.stderr)
         sys.exit(1)
     
-    # Compile the test binary
-    if not compile_test_binary(script_dir, test_binary):
-        sys.exit(1)
-    
     # Load test cases
     print(f"\nLoading test cases from {log_file}...")
     test_cases = load_test_cases(log_file)
@@ -211,30 +249,41 @@ def main():
     if not test_cases:
         print("No test cases found!", file=sys.stderr)
         sys.exit(1)
+
+    # --bench [--frames=N] [--jitter=US]: time the kernels instead of testing
+    if '--bench' in sys.argv[1:]:
+        extra = [arg for arg in sys.argv[1:] if arg != '--bench']
+        sys.exit(run_benchmark(script_dir, test_cases, extra))
+
+    # Compile the test binary
+    if not compile_test_binary(script_dir, test_binary):
+        sys.exit(1)
     
     # Run tests
     passed = 0
     failed = 0
     
+    # Every case must decode identically through the batch and streaming entry points
     for idx, (expected, symbol_data, original) in enumerate(test_cases, 1):
-        success, output = run_single_test(test_binary, symbol_data, expected, idx)
-        
-        if success:
-            print(f"Test {idx:3d}: PASS (0x{expected:08x})")
-            passed += 1
-        else:
-            print(f"Test {idx:3d}: FAIL (expected 0x{expected:08x})")
-            print(f"  Source: {original}")
-            print(f"  Debug output:")
-            for line in output.split('\n'):
-                if line.strip():
-                    print(f"    {line}")
-            print()
-            failed += 1
+        for mode in MODES:
+            success, output = run_single_test(test_binary, symbol_data, expected, idx, mode)
+            
+            if success:
+                print(f"Test {idx:3d} [{mode}]: PASS (0x{expected:08x})")
+                passed += 1
+            else:
+                print(f"Test {idx:3d} [{mode}]: FAIL (expected 0x{expected:08x})")
+                print(f"  Source: {original}")
+                print(f"  Debug output:")
+                for line in output.split('\n'):
+                    if line.strip():
+                        print(f"    {line}")
+                print()
+                failed += 1
     
     # Summary
     print("\n=== Test Summary ===")
-    print(f"Total:  {len(test_cases)}")
+    print(f"Total:  {len(test_cases) * len(MODES)} ({len(test_cases)} cases x {len(MODES)} modes)")
     print(f"Passed: {passed}")
     print(f"Failed: {failed}")
     
@@ -0,0 +1,125 @@
+// In-memory OpenTherm bus (see sim_bus.h)
+
+#include "sim_bus.h"
+
+#include <algorithm>
+
+using ot::OpenThermResponseStatus;
+using ot::ParseError;
+
+SimNode::SimNode(SimBus& bus, bool isSlave) :
+    OpenThermProtocol(*this, isSlave),
+    bus_(bus),
+    wireFreeAt_(0),
+    completions_(0),
+    lastCompletion_(OpenThermResponseStatus::NONE),
+    lastCompletionFrame_(0)
+{
+}
+
+bool SimNode::transmit(uint32_t frame)
+{
+    return bus_.send(*this, frame);
+}
+
+uint32_t SimNode::nowUs() const
+{
+    return static_cast<uint32_t>(bus_.now());
+}
+
+void SimNode::requestCompleted(uint32_t frame, OpenThermResponseStatus result)
+{
+    completions_++;
+    lastCompletion_ = result;
+    lastCompletionFrame_ = frame;
+}
+
+SimBus::SimBus() :
+    master_(*this, false),
+    slave_(*this, true),
+    seq_(0),
+    framesSent_(0)
+{
+}
+
+void SimBus::begin()
+{
+    master_.start();
+    slave_.start();
+}
+
+bool SimBus::send(SimNode& from, uint32_t frame)
+{
+    // Frames from one side go out back to back, like the RMT TX queue
+    uint64_t startAt = std::max(now(), from.wireFreeAt_);
+    uint64_t endAt = startAt + FRAME_US;
+    from.wireFreeAt_ = endAt;
+    framesSent_++;
+
+    push(Event{endAt, 0, &from, true, frame, ParseError::None});
+
+    Fault fault = fault_ ? fault_(from, frame) : Fault::None;
+    if (fault == Fault::Drop) {
+        return true;
+    }
+    SimNode& to = (&from == &master_) ? slave_ : master_;
+    if (fault == Fault::Corrupt) {
+        push(Event{endAt + CAPTURE_DELAY_US, 0, &to, false, 0, ParseError::Parity});
+    } else {
+        push(Event{endAt + CAPTURE_DELAY_US, 0, &to, false, frame, ParseError::None});
+    }
+    return true;
+}
+
+bool SimBus::later(const Event& a, const Event& b)
+{
+    return a.at != b.at ? a.at > b.at : a.seq > b.seq;
+}
+
+void SimBus::push(const Event& e)
+{
+    events_.push_back(e);
+    events_.back().seq = seq_++;
+    std::push_heap(events_.begin(), events_.end(), later);
+}
+
+void SimBus::deliver(const Event& e)
+{
+    if (e.txDone) {
+        e.node->transmitDone(static_cast<uint32_t>(now()));
+    } else {
+        // Captured and decoded at the same instant
+        e.node->frameCaptured(e.frame, e.error, static_cast<uint32_t>(now()));
+    }
+}
+
+void SimBus::runUntil(uint64_t t)
+{
+    while (!events_.empty() && events_.front().at <= t) {
+        std::pop_heap(events_.begin(), events_.end(), later);
+        Event e = events_.back();
+        events_.pop_back();
+        clock_.advanceTo(static_cast<int64_t>(e.at));
+        deliver(e);
+    }
+    clock_.advanceTo(static_cast<int64_t>(t));
+}
+
+bool SimBus::advance(uint64_t limit)
+{
+    uint64_t next = UINT64_MAX;
+    if (!events_.empty()) {
+        next = events_.front().at;
+    }
+    for (SimNode* node : {&master_, &slave_}) {
+        uint32_t due = node->processDueInUs();
+        if (due != UINT32_MAX) {
+            next = std::min(next, now() + due);
+        }
+    }
+    if (next == UINT64_MAX && limit == UINT64_MAX) {
+        return false;
+    }
+    runUntil(std::min(next, limit));
+    return true;
+}
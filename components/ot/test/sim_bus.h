@@ -0,0 +1,110 @@
+// In-memory OpenTherm bus for host tests and benchmarks
+//
+// A simulated backend for the protocol core: a master and a slave
+// OpenThermProtocol joined by a wire with a virtual microsecond clock. A
+// transmitted frame occupies the wire for FRAME_US, completes on the sender
+// (transmitDone) and is captured by the other side CAPTURE_DELAY_US later,
+// as the RMT receive idle timeout does on the device. A fault hook can drop
+// or corrupt frames on the way.
+
+#ifndef SIM_BUS_H
+#define SIM_BUS_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "open_therm_protocol.h"
+#include "ot_clock.h"
+
+class SimBus;
+
+class SimNode : private ot::BusBackend, public ot::OpenThermProtocol
+{
+public:
+    SimNode(SimBus& bus, bool isSlave);
+
+    bool slave() const { return isSlave; }
+    // Requests completed through requestCompleted() and the last outcome
+    uint32_t completions() const { return completions_; }
+    ot::OpenThermResponseStatus lastCompletion() const { return lastCompletion_; }
+    uint32_t lastCompletionFrame() const { return lastCompletionFrame_; }
+
+private:
+    friend class SimBus;
+
+    bool transmit(uint32_t frame) override;
+    uint32_t nowUs() const override;
+    void requestCompleted(uint32_t frame, ot::OpenThermResponseStatus result) override;
+
+    SimBus& bus_;
+    uint64_t wireFreeAt_;       // End of this node's last queued frame
+    uint32_t completions_;
+    ot::OpenThermResponseStatus lastCompletion_;
+    uint32_t lastCompletionFrame_;
+};
+
+class SimBus
+{
+public:
+    static constexpr uint32_t FRAME_US = 34 * 1000;      // 34 bits of 1 ms
+    static constexpr uint32_t CAPTURE_DELAY_US = 2000;   // RX idle timeout after the stop bit
+
+    enum class Fault : uint8_t {
+        None,
+        Drop,       // Never reaches the other side
+        Corrupt     // Captured, but fails to decode (parity)
+    };
+    typedef std::function<Fault(const SimNode& from, uint32_t frame)> FaultFn;
+
+    SimBus();
+
+    SimNode& master() { return master_; }
+    SimNode& slave() { return slave_; }
+    uint64_t now() const { return static_cast<uint64_t>(clock_.nowUs()); }
+    // The bus time; install with ot::setClock() to run everything on it
+    ot::VirtualClock& clock() { return clock_; }
+
+    // Bring both sides to READY
+    void begin();
+    // Decide the fate of every frame put on the wire (default: deliver)
+    void setFault(FaultFn fault) { fault_ = std::move(fault); }
+
+    // Move the clock to the earliest pending wire event or process()
+    // deadline of either side, but no further than limit, and deliver the
+    // events due by then. Returns false if nothing is pending (both sides
+    // idle, wire empty) and no limit was given.
+    bool advance(uint64_t limit = UINT64_MAX);
+    // Deliver every event due up to time t and move the clock there
+    void runUntil(uint64_t t);
+
+    // Frames put on the wire so far
+    uint64_t framesSent() const { return framesSent_; }
+
+private:
+    friend class SimNode;
+
+    struct Event {
+        uint64_t at;
+        uint64_t seq;           // FIFO order among events due at the same time
+        SimNode* node;          // Node the event is delivered to
+        bool txDone;            // Transmit completed (else: capture)
+        uint32_t frame;
+        ot::ParseError error;
+    };
+
+    static bool later(const Event& a, const Event& b);
+    bool send(SimNode& from, uint32_t frame);
+    void push(const Event& e);
+    void deliver(const Event& e);
+
+    SimNode master_;
+    SimNode slave_;
+    ot::VirtualClock clock_;
+    uint64_t seq_;
+    uint64_t framesSent_;
+    std::vector<Event> events_;     // Min-heap on (at, seq)
+    FaultFn fault_;
+};
+
+#endif // SIM_BUS_H
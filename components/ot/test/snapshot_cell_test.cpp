@@ -0,0 +1,130 @@
+// SnapshotCell tests
+//
+// A writer thread stores values whose fields all derive from one counter
+// while reader threads load them; every load must be one whole value, and
+// the values a reader sees must never go back.
+
+#include <cstdio>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "snapshot_cell.h"
+#include "check.h"
+
+using ot::SnapshotCell;
+
+// Odd size, so the last word is partly padding
+struct Sample {
+    uint32_t seq;
+    uint32_t words[14];
+    uint16_t tail;
+    bool odd;
+};
+
+static Sample make(uint32_t seq)
+{
+    Sample s = {};
+    s.seq = seq;
+    for (uint32_t i = 0; i < 14; i++) {
+        s.words[i] = seq * 2654435761u + i;
+    }
+    s.tail = static_cast<uint16_t>(seq ^ 0xa5a5);
+    s.odd = seq & 1;
+    return s;
+}
+
+static bool whole(const Sample& s)
+{
+    const Sample expect = make(s.seq);
+    for (uint32_t i = 0; i < 14; i++) {
+        if (s.words[i] != expect.words[i]) {
+            return false;
+        }
+    }
+    return s.tail == expect.tail && s.odd == expect.odd;
+}
+
+static void testStoreLoad()
+{
+    SnapshotCell<Sample> cell(make(7));
+    CHECK(cell.load().seq == 7);
+    CHECK(whole(cell.load()));
+
+    for (uint32_t i = 8; i < 12; i++) {
+        cell.store(make(i));
+        CHECK(cell.load().seq == i);
+        CHECK(whole(cell.load()));
+    }
+    cell.update([](Sample& s) { s = make(s.seq + 100); });
+    CHECK(cell.load().seq == 111);
+    CHECK(whole(cell.load()));
+
+    // Single-threaded reads never overlap a store
+    CHECK(cell.retries() == 0);
+}
+
+static void testConcurrent()
+{
+    static constexpr uint32_t STORES = 200000;
+    static constexpr int READERS = 3;
+
+    SnapshotCell<Sample> cell(make(0));
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> loads{0};
+    std::atomic<uint32_t> torn{0};
+    std::atomic<uint32_t> backwards{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++) {
+        readers.emplace_back([&]() {
+            uint32_t last = 0;
+            uint32_t n = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                const Sample s = cell.load();
+                if (!whole(s)) {
+                    torn++;
+                }
+                if (s.seq < last) {
+                    backwards++;
+                }
+                last = s.seq;
+                n++;
+            }
+            loads += n;
+        });
+    }
+
+    for (uint32_t i = 1; i <= STORES; i++) {
+        cell.store(make(i));
+    }
+    done = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    printf("  %u stores, %u loads, %u retries\n", STORES, loads.load(), cell.retries());
+    CHECK(torn == 0);
+    CHECK(backwards == 0);
+    CHECK(cell.load().seq == STORES);
+}
+
+int main()
+{
+    struct { const char* name; void (*fn)(); } tests[] = {
+        {"store and load", testStoreLoad},
+        {"concurrent readers", testConcurrent},
+    };
+
+    int failed = 0;
+    for (const auto& t : tests) {
+        int before = s_failures;
+        t.fn();
+        bool ok = s_failures == before;
+        printf("%-28s %s\n", t.name, ok ? "PASS" : "FAIL");
+        if (!ok) failed++;
+    }
+    printf("\n%d/%zu snapshot cell tests passed\n", (int)(sizeof(tests) / sizeof(tests[0])) - failed,
+           sizeof(tests) / sizeof(tests[0]));
+    return failed == 0 ? 0 : 1;
+}
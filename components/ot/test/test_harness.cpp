@@ -73,9 +73,132 @@ bool parseSymbolFormat(const char* input, rmt_symbol_word_t* symbols, size_t* nu
     return idx > 0;
 }
 
+/**
+ * Feed symbols through the streaming decoder in chunks of `chunk` symbols,
+ * the way RMT partial receive delivers them.
+ */
+uint32_t parseStreaming(rmt_symbol_word_t* symbols, size_t num_symbols, size_t chunk, ot::ManchesterDecoder& decoder) {
+    decoder.reset();
+    for (size_t off = 0; off < num_symbols; off += chunk) {
+        size_t n = (num_symbols - off < chunk) ? num_symbols - off : chunk;
+        if (decoder.feed(symbols + off, n) != ot::ManchesterDecoder::State::Receiving) {
+            break;
+        }
+    }
+    decoder.finish();
+    return decoder.frame();
+}
+
+/**
+ * Re-pack symbols with pulse `at` replaced by `with` (a glitch), keeping the
+ * (level, duration) pulse order. Returns the new symbol count.
+ */
+size_t injectGlitch(const rmt_symbol_word_t* symbols, size_t num_symbols, size_t at, size_t replaced,
+                    const uint32_t (*with)[2], size_t count, rmt_symbol_word_t* out, size_t maxOut) {
+    uint32_t pulses[260][2];
+    size_t n = 0;
+    for (size_t idx = 0; idx < num_symbols * 2 && n < 256; idx++) {
+        if (idx == at) {
+            for (size_t k = 0; k < count; k++) {
+                pulses[n][0] = with[k][0];
+                pulses[n][1] = with[k][1];
+                n++;
+            }
+            idx += replaced - 1;
+            continue;
+        }
+        const rmt_symbol_word_t& sym = symbols[idx >> 1];
+        pulses[n][0] = (idx & 1) ? sym.level1 : sym.level0;
+        pulses[n][1] = (idx & 1) ? sym.duration1 : sym.duration0;
+        n++;
+    }
+    size_t out_n = 0;
+    for (size_t i = 0; i < n && out_n < maxOut; i += 2) {
+        out[out_n].level0 = pulses[i][0];
+        out[out_n].duration0 = pulses[i][1];
+        out[out_n].level1 = i + 1 < n ? pulses[i + 1][0] : 0;
+        out[out_n].duration1 = i + 1 < n ? pulses[i + 1][1] : 0;
+        out_n++;
+    }
+    return out_n;
+}
+
+/**
+ * Repair mode: the clean frame must decode untouched, a spike cut into the
+ * middle pulse must be repaired to the same frame, and a swallowed half-bit
+ * must be repaired or rejected, never decoded to a different frame.
+ */
+uint32_t parseWithRepairs(rmt_symbol_word_t* symbols, size_t num_symbols) {
+    ot::BitClock clock;
+    ot::RepairStats stats = {};
+    uint32_t result = ot::parseRMTSymbolsAdaptive(symbols, num_symbols, clock, false, &stats);
+    if (result == 0 || stats.attempted != 0) return 0;
+
+    rmt_symbol_word_t glitched[130];
+    size_t mid = num_symbols;  // Pulse index in the middle of the frame
+    const rmt_symbol_word_t& midSym = symbols[mid >> 1];
+    uint32_t level = (mid & 1) ? midSym.level1 : midSym.level0;
+    uint32_t dur = (mid & 1) ? midSym.duration1 : midSym.duration0;
+    const uint32_t spike[3][2] = {{level, dur / 3}, {!level, 60}, {level, dur - dur / 3 - 60}};
+    size_t n = injectGlitch(symbols, num_symbols, mid, 1, spike, 3, glitched, 130);
+    ot::BitClock spikeClock;
+    uint32_t repaired = ot::parseRMTSymbolsAdaptive(glitched, n, spikeClock, false, &stats);
+    fprintf(stdout, "Spike in pulse %zu: 0x%08x (%lu repaired)\n", mid, repaired,
+            (unsigned long)stats.spikeMerges);
+    if (repaired != result) return 0;
+
+    // First single-half-bit pulse after the middle, merged with both neighbours
+    for (size_t idx = mid + 1; idx + 2 < num_symbols * 2; idx++) {
+        const rmt_symbol_word_t& sym = symbols[idx >> 1];
+        uint32_t d = (idx & 1) ? sym.duration1 : sym.duration0;
+        if (d == 0 || d >= 750) continue;
+        const rmt_symbol_word_t& prev = symbols[(idx - 1) >> 1];
+        const rmt_symbol_word_t& next = symbols[(idx + 1) >> 1];
+        uint32_t merged = d + ((idx - 1) & 1 ? prev.duration1 : prev.duration0)
+                            + ((idx + 1) & 1 ? next.duration1 : next.duration0);
+        uint32_t prevLevel = (idx - 1) & 1 ? prev.level1 : prev.level0;
+        const uint32_t swallowed[1][2] = {{prevLevel, merged}};
+        n = injectGlitch(symbols, num_symbols, idx - 1, 3, swallowed, 1, glitched, 130);
+        ot::BitClock swallowClock;
+        repaired = ot::parseRMTSymbolsAdaptive(glitched, n, swallowClock, false, &stats);
+        fprintf(stdout, "Swallowed pulse %zu: 0x%08x (%lu split)\n", idx, repaired,
+                (unsigned long)stats.pulseSplits);
+        if (repaired != 0 && repaired != result) return 0;
+        break;
+    }
+    return result;
+}
+
 int main(int argc, char* argv[]) {
+    // Optional entry point selector: --mode=batch (default), --mode=packed,
+    // --mode=adaptive, --mode=repair or --mode=stream
+    bool streaming = false;
+    bool packed = false;
+    bool adaptive = false;
+    bool repair = false;
+    if (argc == 3 && strcmp(argv[1], "--mode=stream") == 0) {
+        streaming = true;
+        argv++;
+        argc--;
+    } else if (argc == 3 && strcmp(argv[1], "--mode=packed") == 0) {
+        packed = true;
+        argv++;
+        argc--;
+    } else if (argc == 3 && strcmp(argv[1], "--mode=adaptive") == 0) {
+        adaptive = true;
+        argv++;
+        argc--;
+    } else if (argc == 3 && strcmp(argv[1], "--mode=repair") == 0) {
+        repair = true;
+        argv++;
+        argc--;
+    } else if (argc == 3 && strcmp(argv[1], "--mode=batch") == 0) {
+        argv++;
+        argc--;
+    }
+
     if (argc != 2) {
-        fprintf(stderr, "Usage: %s <symbol_data>\n", argv[0]);
+        fprintf(stderr, "Usage: %s [--mode=batch|--mode=packed|--mode=adaptive|--mode=repair|--mode=stream] <symbol_data>\n", argv[0]);
         fprintf(stderr, "Format: level0,dur0,level1,dur1;level0,dur0,level1,dur1;...\n");
         fprintf(stderr, "Example: 1,520,0,492;0,1002,1,513\n");
         return 1;
@@ -98,8 +221,49 @@ int main(int argc, char* argv[]) {
     ot::buildRMTSymbolLogString(symbols, num_symbols, logBuf, sizeof(logBuf));
     fprintf(stdout, "RMT symbols: %s\n", logBuf);
     
-    // Run parser (this will also produce ESP_LOGI/LOGW output via mocks)
-    uint32_t result = ot::parseRMTSymbols(symbols, num_symbols, false);
+    uint32_t result;
+    if (streaming) {
+        // Every chunking must agree; chunk=1 is edge-by-edge, 128 is one batch
+        static const size_t chunks[] = {1, 2, 3, 5, 8, 16, 24, 32, 128};
+        ot::ManchesterDecoder decoder;
+        result = parseStreaming(symbols, num_symbols, chunks[0], decoder);
+        fprintf(stdout, "Stream: %s after %zu/%zu symbols (bit %d)\n",
+                decoder.state() == ot::ManchesterDecoder::State::Done ? "done" : ot::toString(decoder.error()),
+                decoder.symbolsConsumed(), num_symbols, decoder.bitIndex());
+        for (size_t chunk : chunks) {
+            uint32_t chunked = parseStreaming(symbols, num_symbols, chunk, decoder);
+            if (chunked != result) {
+                fprintf(stderr, "Chunk size %zu gave 0x%08x, chunk size 1 gave 0x%08x\n",
+                        chunk, chunked, result);
+                result = 0;
+                break;
+            }
+        }
+    } else if (packed) {
+        result = ot::parseRMTSymbolsPacked(symbols, num_symbols, false);
+    } else if (adaptive) {
+        // Fresh channel: the estimate comes from this frame alone
+        ot::BitClock clock;
+        result = ot::parseRMTSymbolsAdaptive(symbols, num_symbols, clock, false);
+        fprintf(stdout, "Adaptive: half-bit %lu us\n", (unsigned long)clock.halfBitUs());
+
+        // The streaming decoder's in-frame recovery must agree
+        ot::BitClock streamClock;
+        ot::ManchesterDecoder decoder;
+        decoder.reset(streamClock);
+        decoder.feed(symbols, num_symbols);
+        decoder.finish();
+        if (decoder.frame() != result) {
+            fprintf(stderr, "Streaming recovery gave 0x%08x (%s), batch gave 0x%08x\n",
+                    decoder.frame(), ot::toString(decoder.error()), result);
+            result = 0;
+        }
+    } else if (repair) {
+        result = parseWithRepairs(symbols, num_symbols);
+    } else {
+        // Run parser (this will also produce ESP_LOGI/LOGW output via mocks)
+        result = ot::parseRMTSymbols(symbols, num_symbols, false);
+    }
     
     // Print result on last line (Python will parse this)
     printf("RESULT: 0x%08x\n", result);
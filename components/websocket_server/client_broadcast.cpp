@@ -0,0 +1,158 @@
+/*
+ * WebSocket client table and broadcast queue (see client_broadcast.h)
+ */
+
+#include "client_broadcast.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ot {
+
+int ClientBroadcast::add(int fd, Format format)
+{
+    if (fd < 0) {
+        return -1;
+    }
+    int slot = -1;
+    for (size_t i = 0; i < MAX_CLIENTS; i++) {
+        if (clients_[i].fd == fd) {
+            slot = static_cast<int>(i);
+            break;
+        }
+        if (slot < 0 && clients_[i].fd < 0) {
+            slot = static_cast<int>(i);
+        }
+    }
+    if (slot >= 0) {
+        clients_[slot] = Client{};
+        clients_[slot].fd = fd;
+        clients_[slot].format = format;
+        clients_[slot].cursor = head_;
+    }
+    return slot;
+}
+
+void ClientBroadcast::remove(size_t slot)
+{
+    if (slot < MAX_CLIENTS) {
+        clients_[slot] = Client{};
+    }
+}
+
+size_t ClientBroadcast::clients() const
+{
+    return std::count_if(clients_, clients_ + MAX_CLIENTS, [](const Client& c) { return c.fd >= 0; });
+}
+
+// The slot for the next message, already counted as pushed
+ClientBroadcast::Message& ClientBroadcast::claim()
+{
+    Message& m = ring_[head_ & (DEPTH - 1)];
+    head_++;
+
+    for (Client& c : clients_) {
+        if (c.fd < 0) {
+            continue;
+        }
+        // The slot being written held this client's oldest unsent message
+        if (head_ - c.cursor > DEPTH) {
+            c.cursor = head_ - DEPTH;
+            c.dropped++;
+        }
+        c.maxLag = std::max(c.maxLag, head_ - c.cursor);
+    }
+    return m;
+}
+
+bool ClientBroadcast::push(const char* text, size_t len)
+{
+    if (!text || len >= MESSAGE_MAX) {
+        return false;
+    }
+    Message& m = claim();
+    m.frame = false;
+    memcpy(m.text, text, len);
+    m.text[len] = '\0';
+    m.len = static_cast<uint16_t>(len);
+    return true;
+}
+
+void ClientBroadcast::pushFrame(FrameRecord record)
+{
+    record.seq = static_cast<uint16_t>(head_);
+    Message& m = claim();
+    m.frame = true;
+    m.record = record;
+}
+
+ClientBroadcast::Pending ClientBroadcast::pending(size_t slot) const
+{
+    if (slot >= MAX_CLIENTS || clients_[slot].fd < 0 || clients_[slot].cursor == head_) {
+        return Pending::None;
+    }
+    return ring_[clients_[slot].cursor & (DEPTH - 1)].frame ? Pending::Frame : Pending::Text;
+}
+
+size_t ClientBroadcast::nextText(size_t slot, char* out, uint32_t& seq) const
+{
+    if (pending(slot) != Pending::Text) {
+        return 0;
+    }
+    seq = clients_[slot].cursor;
+    const Message& m = ring_[seq & (DEPTH - 1)];
+    memcpy(out, m.text, m.len + 1);
+    return m.len;
+}
+
+size_t ClientBroadcast::nextFrames(size_t slot, FrameRecord* out, size_t max, uint32_t& seq) const
+{
+    if (pending(slot) != Pending::Frame) {
+        return 0;
+    }
+    seq = clients_[slot].cursor;
+    size_t n = 0;
+    for (uint32_t s = seq; n < max && s != head_; s++, n++) {
+        const Message& m = ring_[s & (DEPTH - 1)];
+        if (!m.frame) {
+            break;
+        }
+        out[n] = m.record;
+    }
+    return n;
+}
+
+void ClientBroadcast::sent(size_t slot, uint32_t seq, size_t count, size_t bytes)
+{
+    if (slot >= MAX_CLIENTS || clients_[slot].fd < 0) {
+        return;
+    }
+    Client& c = clients_[slot];
+    c.sent += static_cast<uint32_t>(count);
+    c.bytes += static_cast<uint32_t>(bytes);
+    // Unless pushes have already dropped the client past them
+    const uint32_t end = seq + static_cast<uint32_t>(count);
+    if (static_cast<int32_t>(c.cursor - end) < 0) {
+        c.cursor = end;
+    }
+}
+
+void ClientBroadcast::stalled(size_t slot)
+{
+    if (slot < MAX_CLIENTS && clients_[slot].fd >= 0) {
+        clients_[slot].stalls++;
+    }
+}
+
+size_t ClientBroadcast::stats(ClientStats* out, size_t max) const
+{
+    size_t n = 0;
+    for (const Client& c : clients_) {
+        if (c.fd < 0 || n >= max) {
+            continue;
+        }
+        out[n++] = ClientStats{c.fd, c.format, head_ - c.cursor, c.maxLag, c.sent, c.dropped, c.stalls, c.bytes};
+    }
+    return n;
+}
+
+} // namespace ot
@@ -0,0 +1,126 @@
+/*
+ * WebSocket client table and broadcast queue
+ *
+ * Every message is stored once, in a ring of DEPTH slots; each client reads
+ * it through a cursor of its own, so a client's backlog is bounded by DEPTH
+ * and pushing never waits for anyone. When a client falls DEPTH messages
+ * behind, its oldest unsent message is dropped and counted against that
+ * client only. Messages are text, or frame records that the sender encodes
+ * for each client's format (see frame_stream.h). Not thread-safe: the
+ * server holds its own lock around every call. No IDF dependencies; the
+ * host tests build it as is.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "frame_stream.h"
+
+namespace ot {
+
+class ClientBroadcast {
+public:
+    static constexpr size_t MAX_CLIENTS = 4;
+    static constexpr size_t DEPTH = 32;            // Messages; power of two
+    static constexpr size_t MESSAGE_MAX = 256;     // Bytes, including a NUL
+    static_assert((DEPTH & (DEPTH - 1)) == 0, "DEPTH must be a power of two");
+
+    enum class Format : uint8_t {
+        Json,       // Frames as JSON text
+        Binary,     // Frames as FRAME_STREAM_PROTOCOL batches
+    };
+
+    // What a client's oldest unsent message is
+    enum class Pending : uint8_t {
+        None,
+        Text,
+        Frame,
+    };
+
+    struct ClientStats {
+        int fd;
+        Format format;
+        uint32_t lag;       // Messages waiting now
+        uint32_t maxLag;    // Most ever waiting
+        uint32_t sent;
+        uint32_t dropped;   // Overwritten before they could be sent
+        uint32_t stalls;    // Sends put off because the socket was full
+        uint32_t bytes;     // Payload bytes sent
+    };
+
+    /**
+     * Start sending to fd from the next message pushed. Returns the client's
+     * slot, or -1 when all MAX_CLIENTS slots are taken. An fd already in the
+     * table is a new connection that reused it and starts over.
+     */
+    int add(int fd, Format format = Format::Json);
+    void remove(size_t slot);
+
+    // fd of the client in slot, or -1 when it is free
+    int fd(size_t slot) const { return slot < MAX_CLIENTS ? clients_[slot].fd : -1; }
+    Format format(size_t slot) const { return slot < MAX_CLIENTS ? clients_[slot].format : Format::Json; }
+    size_t clients() const;
+
+    /**
+     * Queue text for every client. Returns false, queueing nothing, when it
+     * does not fit in MESSAGE_MAX.
+     */
+    bool push(const char* text, size_t len);
+    // Queue a frame for every client; its seq is set here
+    void pushFrame(FrameRecord record);
+
+    Pending pending(size_t slot) const;
+
+    /**
+     * Copy slot's oldest unsent message, when it is text, into out
+     * (MESSAGE_MAX bytes, NUL-terminated) and return its length; 0
+     * otherwise. seq identifies the message for sent().
+     */
+    size_t nextText(size_t slot, char* out, uint32_t& seq) const;
+
+    /**
+     * Copy up to max of slot's oldest unsent messages into out, as long as
+     * they are frames, and return how many; 0 when the oldest is not one.
+     */
+    size_t nextFrames(size_t slot, FrameRecord* out, size_t max, uint32_t& seq) const;
+
+    // count messages from seq on went out as bytes of payload. Moves past
+    // them unless a push dropped them meanwhile.
+    void sent(size_t slot, uint32_t seq, size_t count, size_t bytes);
+    void stalled(size_t slot);
+
+    // Per-client counters; returns the number filled in
+    size_t stats(ClientStats* out, size_t max) const;
+    uint32_t published() const { return head_; }
+
+private:
+    struct Client {
+        int fd = -1;
+        Format format = Format::Json;
+        uint32_t cursor = 0;    // Sequence number of the next message to send
+        uint32_t maxLag = 0;
+        uint32_t sent = 0;
+        uint32_t dropped = 0;
+        uint32_t stalls = 0;
+        uint32_t bytes = 0;
+    };
+
+    struct Message {
+        bool frame = false;
+        uint16_t len = 0;       // Text only
+        union {
+            char text[MESSAGE_MAX];
+            FrameRecord record;
+        };
+        Message() : text{} {}
+    };
+
+    Message& claim();
+
+    Client clients_[MAX_CLIENTS];
+    Message ring_[DEPTH];
+    uint32_t head_ = 0;         // Sequence number of the next message pushed
+};
+
+} // namespace ot
@@ -0,0 +1,72 @@
+/*
+ * Live frame stream encodings (see frame_stream.h)
+ */
+
+#include "frame_stream.h"
+#include "boiler_manager.hpp"
+#include <cstdio>
+
+namespace ot {
+
+static uint8_t* put16(uint8_t* p, uint16_t v)
+{
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    return p + 2;
+}
+
+static uint8_t* put32(uint8_t* p, uint32_t v)
+{
+    p = put16(p, static_cast<uint16_t>(v));
+    return put16(p, static_cast<uint16_t>(v >> 16));
+}
+
+FrameRecord frameRecord(const FrameEvent& event, int64_t nowUs)
+{
+    FrameRecord r = {};
+    r.timeUs = nowUs - static_cast<uint32_t>(static_cast<uint32_t>(nowUs) - event.timestampUs);
+    r.frame = event.frame.raw();
+    r.source = static_cast<uint8_t>(event.source);
+    r.direction = static_cast<uint8_t>(event.direction);
+    return r;
+}
+
+size_t encodeFrameBatch(uint8_t* out, size_t size, const FrameRecord* records, size_t count)
+{
+    const size_t bytes = FRAME_BATCH_HEADER_BYTES + count * FRAME_RECORD_BYTES;
+    if (!out || !records || count == 0 || count > FRAME_BATCH_MAX || size < bytes) {
+        return 0;
+    }
+    uint8_t* p = out;
+    *p++ = FRAME_STREAM_VERSION;
+    *p++ = FRAME_RECORD_BYTES;
+    p = put16(p, static_cast<uint16_t>(count));
+    p = put32(p, static_cast<uint32_t>(records[0].timeUs));
+
+    int64_t previousUs = records[0].timeUs;
+    for (size_t i = 0; i < count; i++) {
+        const FrameRecord& r = records[i];
+        p = put32(p, static_cast<uint32_t>(r.timeUs - previousUs));
+        p = put32(p, r.frame);
+        *p++ = r.source;
+        *p++ = r.direction;
+        p = put16(p, r.seq);
+        previousUs = r.timeUs;
+    }
+    return bytes;
+}
+
+size_t formatFrameJson(char* out, size_t size, const FrameRecord& record)
+{
+    const Frame frame(record.frame);
+    int len = snprintf(out, size,
+        "{\"timestamp\":%lld,\"direction\":\"%s\",\"source\":\"%s\",\"message\":%lu,\"msg_type\":\"%s\",\"data_id\":%u,\"data_value\":%u}",
+        static_cast<long long>(record.timeUs / 1000),
+        toString(static_cast<MessageDirection>(record.direction)),
+        toString(static_cast<MessageSource>(record.source)),
+        static_cast<unsigned long>(record.frame), toString(frame.messageType()),
+        frame.dataId(), frame.dataValue());
+    return len > 0 && static_cast<size_t>(len) < size ? static_cast<size_t>(len) : 0;
+}
+
+} // namespace ot
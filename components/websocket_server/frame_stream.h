@@ -0,0 +1,62 @@
+/*
+ * Live frame stream encodings
+ *
+ * By default the WebSocket message log carries one JSON object per frame.
+ * A client that asks for the "ot-frames.v1" subprotocol gets binary
+ * messages of batched fixed-size records instead, little-endian:
+ *
+ *   header  u8 version (1), u8 record size (12), u16 count, u32 first record's time, us
+ *   record  u32 us since the previous record (0 for the first)
+ *           u32 raw frame
+ *           u8  source: 0 thermostat-boiler, 1 gateway-boiler, 2 thermostat-gateway
+ *           u8  direction: 0 request, 1 response, 2 discarded request
+ *           u16 sequence number; a gap means the client missed messages
+ *
+ * web-ui/src/lib/frame_stream.js decodes it.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ot {
+
+struct FrameEvent;
+
+static constexpr char FRAME_STREAM_PROTOCOL[] = "ot-frames.v1";
+static constexpr uint8_t FRAME_STREAM_VERSION = 1;
+static constexpr size_t FRAME_BATCH_HEADER_BYTES = 8;
+static constexpr size_t FRAME_RECORD_BYTES = 12;
+static constexpr size_t FRAME_BATCH_MAX = 16;      // Records per message
+static constexpr size_t FRAME_BATCH_BYTES_MAX = FRAME_BATCH_HEADER_BYTES + FRAME_BATCH_MAX * FRAME_RECORD_BYTES;
+
+// One frame event as queued for the clients
+struct FrameRecord {
+    int64_t timeUs;     // clockUs() when the frame event was published
+    uint32_t frame;
+    uint8_t source;     // MessageSource
+    uint8_t direction;  // MessageDirection
+    uint16_t seq;
+};
+
+/**
+ * The record for a frame event, timed when the event was published. The
+ * event's 32-bit timestamp is widened against nowUs, the current
+ * clockUs(); events are taken to be less than 71 minutes old.
+ */
+FrameRecord frameRecord(const FrameEvent& event, int64_t nowUs);
+
+/**
+ * Binary message for count (1 to FRAME_BATCH_MAX) records. Returns the
+ * bytes written, or 0 when out is too small.
+ */
+size_t encodeFrameBatch(uint8_t* out, size_t size, const FrameRecord* records, size_t count);
+
+/**
+ * The JSON text of one record, as the default stream carries it. Returns
+ * the length, or 0 when out is too small.
+ */
+size_t formatFrameJson(char* out, size_t size, const FrameRecord& record);
+
+} // namespace ot
@@ -3,9 +3,13 @@
  */
 
 #include "websocket_server.h"
+#include "client_broadcast.h"
+#include "frame_stream.h"
 #include "boiler_manager.hpp"
+#include "diagnostics_snapshot.h"
 #include "mqtt_bridge.hpp"
 #include "open_therm.h"
+#include "bus_log.h"
 
 extern "C" {
 #include "web_ui.h"
@@ -13,7 +17,13 @@ extern "C" {
 
 #include "esp_log.h"
 #include "esp_http_server.h"
-#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "ot_clock.h"
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <cstdio>
 #include <cstdlib>
@@ -22,6 +32,21 @@ static const char* TAG = "WebSocket";
 static ot::BoilerManager* s_boiler_mgr = nullptr;
 static ot::MqttBridge* s_mqtt = nullptr;
 static websocket_server_t* s_ws_server = nullptr;
+static int s_ws_subscriber = -1;    // Frame event subscription of the message log feed
+
+// WebSocket clients. Messages are queued for every client at once and sent
+// by a task of its own, which never waits on a full socket: a slow client
+// only falls behind, losing its oldest messages, while the others and the
+// feed carry on.
+static ot::ClientBroadcast s_clients;
+static SemaphoreHandle_t s_clients_lock = nullptr;
+static TaskHandle_t s_sender_task = nullptr;
+static SemaphoreHandle_t s_sender_stopped = nullptr;
+static std::atomic<bool> s_sender_stop{false};
+
+static constexpr size_t WS_SEND_BATCH = 8;           // Messages per client per pass
+static constexpr uint32_t WS_STALL_RETRY_MS = 20;    // Next try at a full socket
+static constexpr uint32_t WS_IDLE_CHECK_MS = 1000;   // Look for closed clients this often
 
 // Callback for MQTT control mode changes
 static void mqtt_control_mode_handler(bool enabled) {
@@ -97,21 +122,64 @@ static esp_err_t assets_handler(httpd_req_t* req) {
 // MQTT state API
 static esp_err_t mqtt_state_handler(httpd_req_t* req) {
     ot::MqttState st;
+    ot::MqttPublishStats pub;
+    uint32_t stateRetries = 0;
+    static ot::MqttSensorStats sensors[ot::MqttBridge::MAX_SENSORS];
+    size_t sensorCount = 0;
     if (s_mqtt) {
         st = s_mqtt->state();
+        stateRetries = s_mqtt->stateRetries();
+        pub = s_mqtt->publishStats();
+        sensorCount = s_mqtt->sensorStats(sensors, ot::MqttBridge::MAX_SENSORS);
     }
 
-    char buf[256];
+    // Static: up to MAX_SENSORS entries, and handlers run one at a time
+    static char buf[4096];
     int len = snprintf(buf, sizeof(buf),
         "{\"connected\":%s,\"last_tset_valid\":%s,\"last_tset\":%.2f,"
-        "\"last_ch_enable_valid\":%s,\"last_ch_enable\":%s,\"last_update_ms\":%lld,\"available\":%s}",
+        "\"last_ch_enable_valid\":%s,\"last_ch_enable\":%s,\"last_update_ms\":%lld,\"available\":%s,"
+        "\"state_retries\":%lu,\"publish\":{\"queued\":%lu,\"dropped\":%lu,\"coalesced\":%lu,\"suppressed\":%lu,\"keep_alives\":%lu,"
+        "\"published\":%lu,\"failed\":%lu,\"discoveries\":%lu,\"discovery_bytes\":%lu,\"state_bytes\":%lu,"
+        "\"snapshots\":%lu,\"snapshot_bytes\":%lu,"
+        "\"offline\":{\"buffered\":%lu,\"dropped\":%lu,\"replayed\":%lu,\"pending\":%lu},"
+        "\"bus\":{\"commands\":%lu,\"rejected\":%lu,\"responses\":%lu},\"sensors\":[",
         st.connected ? "true" : "false",
         st.lastTsetC.has_value() ? "true" : "false",
         st.lastTsetC.value_or(0.0f),
         st.lastChEnable.has_value() ? "true" : "false",
         st.lastChEnable.value_or(false) ? "true" : "false",
         static_cast<long long>(st.lastUpdateTime.count()),
-        st.available ? "true" : "false");
+        st.available ? "true" : "false",
+        static_cast<unsigned long>(stateRetries),
+        static_cast<unsigned long>(pub.queued),
+        static_cast<unsigned long>(pub.dropped),
+        static_cast<unsigned long>(pub.coalesced),
+        static_cast<unsigned long>(pub.suppressed),
+        static_cast<unsigned long>(pub.keepAlives),
+        static_cast<unsigned long>(pub.published),
+        static_cast<unsigned long>(pub.failed),
+        static_cast<unsigned long>(pub.discoveries),
+        static_cast<unsigned long>(pub.discoveryBytes),
+        static_cast<unsigned long>(pub.stateBytes),
+        static_cast<unsigned long>(pub.snapshots),
+        static_cast<unsigned long>(pub.snapshotBytes),
+        static_cast<unsigned long>(pub.offlineBuffered),
+        static_cast<unsigned long>(pub.offlineDropped),
+        static_cast<unsigned long>(pub.offlineReplayed),
+        static_cast<unsigned long>(pub.offlinePending),
+        static_cast<unsigned long>(pub.busCommands),
+        static_cast<unsigned long>(pub.busRejected),
+        static_cast<unsigned long>(pub.busResponses));
+    for (size_t i = 0; i < sensorCount && len < static_cast<int>(sizeof(buf)); i++) {
+        len += snprintf(buf + len, sizeof(buf) - len, "%s{\"id\":\"%s\",\"sent\":%lu,\"suppressed\":%lu}",
+                        i ? "," : "", sensors[i].id,
+                        static_cast<unsigned long>(sensors[i].sent),
+                        static_cast<unsigned long>(sensors[i].suppressed));
+    }
+    if (len < static_cast<int>(sizeof(buf))) {
+        len += snprintf(buf + len, sizeof(buf) - len, "]}}");
+    }
+    len = std::min(len, static_cast<int>(sizeof(buf)) - 1);
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, buf, len);
     return ESP_OK;
@@ -174,28 +242,48 @@ static esp_err_t mqtt_config_get_handler(httpd_req_t* req) {
     ot::MqttConfig cfg;
     (void)ot::MqttBridge::loadConfig(cfg);
     ot::MqttState st;
+    static ot::MqttSensorStats sensors[ot::MqttBridge::MAX_SENSORS];
+    size_t sensorCount = 0;
     if (s_mqtt) {
         st = s_mqtt->state();
+        sensorCount = s_mqtt->sensorStats(sensors, ot::MqttBridge::MAX_SENSORS);
     }
 
-    char buf[512];
+    // "policies" are the configured overrides, "sensors" the policy in force
+    static char buf[4096];
     int len = snprintf(buf, sizeof(buf),
         "{\"enable\":%s,\"broker_uri\":\"%s\",\"client_id\":\"%s\","
-        "\"username\":\"%s\",\"base_topic\":\"%s\",\"discovery_prefix\":\"%s\",\"connected\":%s}",
+        "\"username\":\"%s\",\"base_topic\":\"%s\",\"discovery_prefix\":\"%s\",\"connected\":%s,"
+        "\"snapshot_interval\":%lu,\"snapshot_on_change\":%s,\"policies\":\"%s\",\"sensors\":[",
         cfg.enable ? "true" : "false",
         cfg.brokerUri.c_str(),
         cfg.clientId.c_str(),
         cfg.username.c_str(),
         cfg.baseTopic.c_str(),
         cfg.discoveryPrefix.c_str(),
-        st.connected ? "true" : "false");
+        st.connected ? "true" : "false",
+        static_cast<unsigned long>(cfg.snapshotIntervalMs / 1000),
+        cfg.snapshotOnChange ? "true" : "false",
+        ot::formatPolicies(cfg.policies).c_str());
+    for (size_t i = 0; i < sensorCount && len < static_cast<int>(sizeof(buf)); i++) {
+        const ot::PublishPolicy& p = sensors[i].policy;
+        len += snprintf(buf + len, sizeof(buf) - len,
+                        "%s{\"id\":\"%s\",\"deadband\":%g,\"deadband_pct\":%g,\"min_ms\":%lu,\"max_ms\":%lu}",
+                        i ? "," : "", sensors[i].id, p.deadband, p.deadbandPct,
+                        static_cast<unsigned long>(p.minIntervalMs),
+                        static_cast<unsigned long>(p.maxIntervalMs));
+    }
+    if (len < static_cast<int>(sizeof(buf))) {
+        len += snprintf(buf + len, sizeof(buf) - len, "]}");
+    }
+    len = std::min(len, static_cast<int>(sizeof(buf)) - 1);
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, buf, len);
     return ESP_OK;
 }
 
 static esp_err_t mqtt_config_post_handler(httpd_req_t* req) {
-    char body[512];
+    char body[1024];
     read_req_body(req, body, sizeof(body));
 
     ot::MqttConfig cfg;
@@ -219,6 +307,24 @@ static esp_err_t mqtt_config_post_handler(httpd_req_t* req) {
     parse_form_kv(body, "discovery_prefix", disc_prefix, sizeof(disc_prefix));
     if (disc_prefix[0]) cfg.discoveryPrefix = disc_prefix;
 
+    // <base>/state snapshot: interval in seconds (0: off) and on-change trigger
+    parse_form_kv(body, "snapshot_interval", val, sizeof(val));
+    if (val[0]) cfg.snapshotIntervalMs = static_cast<uint32_t>(strtoul(val, nullptr, 10)) * 1000;
+    parse_form_kv(body, "snapshot_on_change", val, sizeof(val));
+    if (val[0]) cfg.snapshotOnChange = (strcmp(val, "on") == 0 || strcmp(val, "1") == 0 || strcasecmp(val, "true") == 0);
+
+    // Publish policy overrides, "id=deadband,deadband_pct,min_ms,max_ms;..."
+    // (see publish_policy.h); "default" drops them all
+    char policies[768];
+    parse_form_kv(body, "policies", policies, sizeof(policies));
+    if (strcmp(policies, "default") == 0) {
+        cfg.policies.clear();
+    } else if (policies[0] && !ot::parsePolicies(policies, cfg.policies)) {
+        httpd_resp_set_status(req, "400 Bad Request");
+        httpd_resp_send(req, "{\"error\":\"Malformed policies\"}", -1);
+        return ESP_FAIL;
+    }
+
     (void)ot::MqttBridge::saveConfig(cfg);
     if (s_mqtt) {
         (void)s_mqtt->reconfigure(cfg);
@@ -236,22 +342,186 @@ static esp_err_t control_mode_get_handler(httpd_req_t* req) {
         st = s_boiler_mgr->status();
     }
 
-    char buf[256];
+    char buf[512];
     int len = snprintf(buf, sizeof(buf),
         "{\"enabled\":%s,\"active\":%s,\"fallback\":%s,\"mqtt_available\":%s,"
-        "\"demand_tset\":%.2f,\"demand_ch\":%s,\"last_demand_ms\":%lld}",
+        "\"demand_tset\":%.2f,\"demand_ch\":%s,\"last_demand_ms\":%lld,"
+        "\"wake_latency_us\":{\"last\":%lu,\"max\":%lu,\"avg\":%lu},"
+        "\"forward_latency_us\":{\"last\":%lu,\"max\":%lu},\"bus_log_dropped\":%lu,"
+        "\"gateway_requests\":{\"queued\":%lu,\"rejected\":%lu,\"answered\":%lu,\"failed\":%lu,\"pending\":%lu}}",
         st.controlEnabled ? "true" : "false",
         st.controlActive ? "true" : "false",
         st.fallbackActive ? "true" : "false",
         st.mqttAvailable ? "true" : "false",
         st.demandTsetC,
         st.demandChEnabled ? "true" : "false",
-        static_cast<long long>(st.lastDemandTime.count()));
+        static_cast<long long>(st.lastDemandTime.count()),
+        static_cast<unsigned long>(st.wakeLatencyLastUs),
+        static_cast<unsigned long>(st.wakeLatencyMaxUs),
+        static_cast<unsigned long>(st.wakeLatencyAvgUs),
+        static_cast<unsigned long>(st.forwardLatencyLastUs),
+        static_cast<unsigned long>(st.forwardLatencyMaxUs),
+        static_cast<unsigned long>(ot::BusLog::dropped()),
+        static_cast<unsigned long>(st.gatewayQueued),
+        static_cast<unsigned long>(st.gatewayRejected),
+        static_cast<unsigned long>(st.gatewayAnswered),
+        static_cast<unsigned long>(st.gatewayFailed),
+        static_cast<unsigned long>(st.gatewayPending));
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, buf, len);
     return ESP_OK;
 }
 
+// Recent failed captures as raw BusLog records (see bus_log.h for the layout)
+static esp_err_t bus_log_get_handler(httpd_req_t* req) {
+    static uint8_t buf[8 * sizeof(ot::LogRecord)];
+    size_t len = ot::BusLog::snapshot(buf, sizeof(buf));
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_send(req, reinterpret_cast<const char*>(buf), len);
+    return ESP_OK;
+}
+
+// One channel's counters as a JSON object; returns characters written
+static int format_bus_stats(char* buf, size_t size, const ot::BusStats& st) {
+    using ot::ParseError;
+    auto err = [&st](ParseError e) {
+        return static_cast<unsigned long>(st.rxErrors[static_cast<size_t>(e)]);
+    };
+    return snprintf(buf, size,
+        "{\"rx_frames\":%lu,\"rx_invalid\":%lu,"
+        "\"rx_errors\":{\"total\":%lu,\"bad_start\":%lu,\"bad_stop\":%lu,\"no_transition\":%lu,"
+        "\"bad_duration\":%lu,\"incomplete\":%lu,\"parity\":%lu},"
+        "\"repaired\":%lu,\"tx_frames\":%lu,\"tx_failed\":%lu,\"timeouts\":%lu,"
+        "\"decode_us\":{\"last\":%lu,\"max\":%lu,\"avg\":%lu}}",
+        static_cast<unsigned long>(st.rxFrames),
+        static_cast<unsigned long>(st.rxInvalid),
+        static_cast<unsigned long>(st.rxErrorTotal()),
+        err(ParseError::BadStart), err(ParseError::BadStop), err(ParseError::NoTransition),
+        err(ParseError::BadDuration), err(ParseError::Incomplete), err(ParseError::Parity),
+        static_cast<unsigned long>(st.repairs.spikeMerges + st.repairs.pulseSplits + st.repairs.halfBitFlips),
+        static_cast<unsigned long>(st.txFrames),
+        static_cast<unsigned long>(st.txFailed),
+        static_cast<unsigned long>(st.timeouts),
+        static_cast<unsigned long>(st.decodeLastUs),
+        static_cast<unsigned long>(st.decodeMaxUs),
+        static_cast<unsigned long>(st.decodeAvgUs));
+}
+
+// Per-channel bus statistics: frames, decode errors by kind, timeouts; and
+// how far each frame event subscriber and WebSocket client kept up
+static esp_err_t bus_stats_get_handler(httpd_req_t* req) {
+    ot::BusStats thermostat = {};
+    ot::BusStats boiler = {};
+    ot::FrameEventBus::SubscriberStats subscribers[ot::FrameEventBus::MAX_SUBSCRIBERS];
+    size_t subscriberCount = 0;
+    uint32_t published = 0;
+    if (s_boiler_mgr) {
+        thermostat = s_boiler_mgr->thermostatBusStats();
+        boiler = s_boiler_mgr->boilerBusStats();
+        published = s_boiler_mgr->events().published();
+        subscriberCount = s_boiler_mgr->events().subscriberStats(subscribers, ot::FrameEventBus::MAX_SUBSCRIBERS);
+    }
+
+    ot::ClientBroadcast::ClientStats clients[ot::ClientBroadcast::MAX_CLIENTS];
+    size_t clientCount = 0;
+    uint32_t broadcast = 0;
+    if (s_clients_lock) {
+        xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+        clientCount = s_clients.stats(clients, ot::ClientBroadcast::MAX_CLIENTS);
+        broadcast = s_clients.published();
+        xSemaphoreGive(s_clients_lock);
+    }
+
+    // Static: both channels, every subscriber and client, and handlers run
+    // one at a time
+    static char buf[3072];
+    size_t len = 0;
+    bool fits = true;
+    // Appends, tracking the length; stops at the first that does not fit
+    auto append = [&len, &fits](int written) {
+        if (!fits || written < 0 || static_cast<size_t>(written) >= sizeof(buf) - len) {
+            fits = false;
+            return;
+        }
+        len += static_cast<size_t>(written);
+    };
+    append(snprintf(buf, sizeof(buf), "{\"thermostat\":"));
+    append(format_bus_stats(buf + len, sizeof(buf) - len, thermostat));
+    append(snprintf(buf + len, sizeof(buf) - len, ",\"boiler\":"));
+    append(format_bus_stats(buf + len, sizeof(buf) - len, boiler));
+    append(snprintf(buf + len, sizeof(buf) - len, ",\"events\":{\"published\":%lu,\"subscribers\":[",
+                    static_cast<unsigned long>(published)));
+    for (size_t i = 0; i < subscriberCount; i++) {
+        append(snprintf(buf + len, sizeof(buf) - len, "%s{\"name\":\"%s\",\"delivered\":%lu,\"dropped\":%lu}",
+                        i ? "," : "", subscribers[i].name,
+                        static_cast<unsigned long>(subscribers[i].delivered),
+                        static_cast<unsigned long>(subscribers[i].dropped)));
+    }
+    append(snprintf(buf + len, sizeof(buf) - len, "]},\"websocket\":{\"published\":%lu,\"clients\":[",
+                    static_cast<unsigned long>(broadcast)));
+    for (size_t i = 0; i < clientCount; i++) {
+        const auto& c = clients[i];
+        append(snprintf(buf + len, sizeof(buf) - len,
+                        "%s{\"fd\":%d,\"format\":\"%s\",\"lag\":%lu,\"max_lag\":%lu,\"sent\":%lu,"
+                        "\"dropped\":%lu,\"stalls\":%lu,\"bytes\":%lu}",
+                        i ? "," : "", c.fd,
+                        c.format == ot::ClientBroadcast::Format::Binary ? "binary" : "json",
+                        static_cast<unsigned long>(c.lag), static_cast<unsigned long>(c.maxLag),
+                        static_cast<unsigned long>(c.sent), static_cast<unsigned long>(c.dropped),
+                        static_cast<unsigned long>(c.stalls), static_cast<unsigned long>(c.bytes)));
+    }
+    append(snprintf(buf + len, sizeof(buf) - len, "]}}"));
+    if (!fits) {
+        ESP_LOGE(TAG, "Bus stats do not fit in %u bytes", static_cast<unsigned>(sizeof(buf)));
+        httpd_resp_set_status(req, "500 Internal Server Error");
+        httpd_resp_send(req, "{\"error\":\"Bus stats too long\"}", -1);
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, buf, len);
+    return ESP_OK;
+}
+
+// Frame trace capture (see frame_trace.h for the layout), streamed while
+// the manager keeps recording; ?clear=1 starts a new trace once sent
+static esp_err_t trace_get_handler(httpd_req_t* req) {
+    if (!s_boiler_mgr) {
+        httpd_resp_set_status(req, "500 Internal Server Error");
+        httpd_resp_send(req, "{\"error\":\"Boiler manager not available\"}", -1);
+        return ESP_FAIL;
+    }
+
+    bool clear = false;
+    char query[32];
+    char value[4];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "clear", value, sizeof(value)) == ESP_OK) {
+        clear = strcmp(value, "1") == 0;
+    }
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"ot_trace.bin\"");
+    ot::FrameTrace& trace = s_boiler_mgr->frameTrace();
+    uint32_t exportedTo = 0;
+    int records = trace.exportTo([req](const void* data, size_t len) {
+        return httpd_resp_send_chunk(req, static_cast<const char*>(data), len) == ESP_OK;
+    }, &exportedTo);
+    if (records < 0) {
+        // Headers are out already; cutting the stream short is all that is left
+        ESP_LOGW(TAG, "Trace export failed");
+        httpd_resp_send_chunk(req, nullptr, 0);
+        return ESP_FAIL;
+    }
+    httpd_resp_send_chunk(req, nullptr, 0);
+    ESP_LOGI(TAG, "Sent trace: %d records", records);
+    if (clear) {
+        // Frames recorded while the download ran go into the next one
+        trace.clear(exportedTo);
+    }
+    return ESP_OK;
+}
+
 static esp_err_t control_mode_post_handler(httpd_req_t* req) {
     char body[256];
     read_req_body(req, body, sizeof(body));
@@ -381,6 +651,8 @@ static esp_err_t write_api_handler(httpd_req_t* req) {
         if (err == ESP_ERR_TIMEOUT) error_msg = "Timeout waiting for response";
         else if (err == ESP_ERR_INVALID_RESPONSE) error_msg = "Invalid response from boiler";
         else if (err == ESP_ERR_NOT_FOUND) error_msg = "Unknown data ID";
+        else if (err == ESP_ERR_NO_MEM) error_msg = "Gateway request queue full";
+        else if (err == ESP_ERR_INVALID_STATE) error_msg = "Gateway cannot transmit";
 
         snprintf(json_response, sizeof(json_response),
                  "{\"success\":false,\"error\":\"%s\",\"error_code\":%d}",
@@ -395,9 +667,8 @@ static esp_err_t write_api_handler(httpd_req_t* req) {
 
 // Helper to format diagnostic value
 static int format_diag_value(char* buf, size_t buf_size, const char* name,
-                              const ot::DiagnosticValue& val, int64_t current_time_ms) {
-    int64_t age_ms = (val.isValid() && val.timestamp.count() > 0)
-                     ? (current_time_ms - val.timestamp.count()) : -1;
+                              const ot::DiagnosticValue& val, std::chrono::milliseconds now) {
+    int64_t age_ms = val.age(now).count();
     return snprintf(buf, buf_size,
         "\"%s\":{\"value\":%.2f,\"age_ms\":%lld,\"valid\":%s}",
         name, val.valueOr(0.0f), static_cast<long long>(age_ms),
@@ -413,7 +684,7 @@ static esp_err_t diagnostics_api_handler(httpd_req_t* req) {
     }
 
     const auto& diag = s_boiler_mgr->diagnostics();
-    int64_t current_time_ms = esp_timer_get_time() / 1000;
+    const std::chrono::milliseconds now = ot::clockMs();
 
     // Build JSON response
     const size_t json_buffer_size = 8192;
@@ -432,32 +703,13 @@ static esp_err_t diagnostics_api_handler(httpd_req_t* req) {
     remaining--;
 
     // Format all diagnostic values
-    struct { const char* name; const ot::DiagnosticValue& val; } fields[] = {
-        {"t_boiler", diag.tBoiler}, {"t_return", diag.tReturn},
-        {"t_dhw", diag.tDhw}, {"t_dhw2", diag.tDhw2},
-        {"t_outside", diag.tOutside}, {"t_exhaust", diag.tExhaust},
-        {"t_heat_exchanger", diag.tHeatExchanger}, {"t_flow_ch2", diag.tFlowCh2},
-        {"t_storage", diag.tStorage}, {"t_collector", diag.tCollector},
-        {"t_setpoint", diag.tSetpoint}, {"modulation_level", diag.modulationLevel},
-        {"pressure", diag.pressure}, {"flow_rate", diag.flowRate},
-        {"fault_code", diag.faultCode}, {"diag_code", diag.diagCode},
-        {"burner_starts", diag.burnerStarts}, {"dhw_burner_starts", diag.dhwBurnerStarts},
-        {"ch_pump_starts", diag.chPumpStarts}, {"dhw_pump_starts", diag.dhwPumpStarts},
-        {"burner_hours", diag.burnerHours}, {"dhw_burner_hours", diag.dhwBurnerHours},
-        {"ch_pump_hours", diag.chPumpHours}, {"dhw_pump_hours", diag.dhwPumpHours},
-        {"max_capacity", diag.maxCapacity}, {"min_mod_level", diag.minModLevel},
-        {"fan_setpoint", diag.fanSetpoint}, {"fan_current", diag.fanCurrent},
-        {"fan_exhaust_rpm", diag.fanExhaustRpm}, {"fan_supply_rpm", diag.fanSupplyRpm},
-        {"co2_exhaust", diag.co2Exhaust}, {"flame_on", diag.flameOn},
-        {"ch_mode", diag.chMode}, {"dhw_mode", diag.dhwMode}
-    };
-
-    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+    for (size_t i = 0; i < ot::DIAGNOSTIC_FIELD_COUNT; i++) {
         if (i > 0) {
             *p++ = ',';
             remaining--;
         }
-        written = format_diag_value(p, remaining, fields[i].name, fields[i].val, current_time_ms);
+        written = format_diag_value(p, remaining, ot::DIAGNOSTIC_FIELDS[i].name,
+                                    diag.*ot::DIAGNOSTIC_FIELDS[i].value, now);
         if (written > 0 && static_cast<size_t>(written) < remaining) {
             p += written;
             remaining -= written;
@@ -482,13 +734,26 @@ static esp_err_t ws_handler(httpd_req_t* req) {
     if (req->method == HTTP_GET) {
         ESP_LOGI(TAG, "WebSocket handshake");
 
-        auto* ws_server = static_cast<websocket_server_t*>(req->user_ctx);
-        if (ws_server) {
-            ws_server->client_fd = httpd_req_to_sockfd(req);
-            ws_server->client_connected = true;
-            ESP_LOGI(TAG, "WebSocket client connected, fd=%d", ws_server->client_fd);
+        // Binary frame batches when the client asked for them
+        char protocols[64] = "";
+        httpd_req_get_hdr_value_str(req, "Sec-WebSocket-Protocol", protocols, sizeof(protocols));
+        const auto format = strstr(protocols, ot::FRAME_STREAM_PROTOCOL) ? ot::ClientBroadcast::Format::Binary
+                                                                          : ot::ClientBroadcast::Format::Json;
+
+        const int fd = httpd_req_to_sockfd(req);
+        xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+        const int slot = s_clients.add(fd, format);
+        const size_t clients = s_clients.clients();
+        xSemaphoreGive(s_clients_lock);
+
+        if (slot < 0) {
+            ESP_LOGW(TAG, "WebSocket client fd=%d refused: %u clients already connected",
+                     fd, static_cast<unsigned>(clients));
+            return ESP_FAIL;
         }
-
+        ESP_LOGI(TAG, "WebSocket client connected, fd=%d, %s (%u connected)", fd,
+                 format == ot::ClientBroadcast::Format::Binary ? ot::FRAME_STREAM_PROTOCOL : "json",
+                 static_cast<unsigned>(clients));
         return ESP_OK;
     }
 
@@ -506,22 +771,134 @@ static esp_err_t ws_handler(httpd_req_t* req) {
     return ESP_OK;
 }
 
-// Message callback for boiler_manager
-static void boiler_manager_message_handler(std::string_view direction,
-                                            ot::MessageSource source,
-                                            ot::Frame message) {
-    if (!s_ws_server) return;
-
-    const char* source_str = ot::toString(source);
-    const char* type_str = ot::toString(message.messageType());
-
-    websocket_server_send_opentherm_message(s_ws_server,
-                                            std::string(direction).c_str(),
-                                            message.raw(),
-                                            type_str,
-                                            message.dataId(),
-                                            message.dataValue(),
-                                            source_str);
+// Nothing more is sent to fd
+static void remove_client(int fd, const char* why) {
+    xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+    for (size_t slot = 0; slot < ot::ClientBroadcast::MAX_CLIENTS; slot++) {
+        if (s_clients.fd(slot) == fd) {
+            s_clients.remove(slot);
+            ESP_LOGI(TAG, "WebSocket client fd=%d %s (%u connected)", fd, why,
+                     static_cast<unsigned>(s_clients.clients()));
+        }
+    }
+    xSemaphoreGive(s_clients_lock);
+}
+
+static bool socket_writable(int fd) {
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(fd, &set);
+    struct timeval now = {0, 0};
+    return select(fd + 1, nullptr, &set, nullptr, &now) > 0;
+}
+
+// Send each client what it has waiting, as far as its socket takes it
+// without blocking. Returns true when a client was left with messages.
+static bool send_to_clients(httpd_handle_t server) {
+    using Pending = ot::ClientBroadcast::Pending;
+    static_assert(ot::FRAME_BATCH_BYTES_MAX <= ot::ClientBroadcast::MESSAGE_MAX, "batch fits the buffer");
+    static uint8_t payload[ot::ClientBroadcast::MESSAGE_MAX];
+    static ot::FrameRecord records[ot::FRAME_BATCH_MAX];
+    bool backlog = false;
+
+    for (size_t slot = 0; slot < ot::ClientBroadcast::MAX_CLIENTS; slot++) {
+        xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+        const int fd = s_clients.fd(slot);
+        xSemaphoreGive(s_clients_lock);
+        if (fd < 0) {
+            continue;
+        }
+        if (httpd_ws_get_fd_info(server, fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+            remove_client(fd, "gone");
+            continue;
+        }
+
+        for (size_t i = 0; i < WS_SEND_BATCH; i++) {
+            // Copy the next message out; frames are encoded after the lock
+            uint32_t seq = 0;
+            size_t count = 0;
+            size_t len = 0;
+            xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+            const bool binary = s_clients.format(slot) == ot::ClientBroadcast::Format::Binary;
+            const Pending pending = s_clients.fd(slot) == fd ? s_clients.pending(slot) : Pending::None;
+            if (pending == Pending::Text) {
+                len = s_clients.nextText(slot, reinterpret_cast<char*>(payload), seq);
+                count = 1;
+            } else if (pending == Pending::Frame) {
+                count = s_clients.nextFrames(slot, records, binary ? ot::FRAME_BATCH_MAX : 1, seq);
+            }
+            xSemaphoreGive(s_clients_lock);
+            if (!count) {
+                break;
+            }
+            if (!socket_writable(fd)) {
+                xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+                s_clients.stalled(slot);
+                xSemaphoreGive(s_clients_lock);
+                backlog = true;
+                break;
+            }
+
+            httpd_ws_frame_t ws_pkt = {};
+            ws_pkt.type = HTTPD_WS_TYPE_TEXT;
+            if (pending == Pending::Frame && binary) {
+                len = ot::encodeFrameBatch(payload, sizeof(payload), records, count);
+                ws_pkt.type = HTTPD_WS_TYPE_BINARY;
+            } else if (pending == Pending::Frame) {
+                len = ot::formatFrameJson(reinterpret_cast<char*>(payload), sizeof(payload), records[0]);
+            }
+            ws_pkt.payload = payload;
+            ws_pkt.len = len;
+            esp_err_t err = httpd_ws_send_frame_async(server, fd, &ws_pkt);
+            if (err != ESP_OK) {
+                // Only this client goes; the others keep their streams
+                ESP_LOGW(TAG, "WebSocket send to fd=%d failed: %s", fd, esp_err_to_name(err));
+                remove_client(fd, "dropped");
+                httpd_sess_trigger_close(server, fd);
+                break;
+            }
+
+            xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+            s_clients.sent(slot, seq, count, len);
+            xSemaphoreGive(s_clients_lock);
+            backlog = backlog || i + 1 == WS_SEND_BATCH;    // The rest on the next pass
+        }
+    }
+    return backlog;
+}
+
+static void ws_sender_task(void* arg) {
+    auto server = static_cast<httpd_handle_t>(arg);
+    bool backlog = false;
+    while (!s_sender_stop) {
+        // Woken by each message queued
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(backlog ? WS_STALL_RETRY_MS : WS_IDLE_CHECK_MS));
+        if (s_sender_stop) {
+            break;
+        }
+        backlog = send_to_clients(server);
+    }
+    xSemaphoreGive(s_sender_stopped);
+    vTaskDelete(nullptr);
+}
+
+// Frame event subscriber feeding the WebSocket message log. Frames are
+// queued as records; the sender renders them in each client's format.
+static void boiler_manager_message_handler(const ot::FrameEvent& event) {
+    if (!s_ws_server || !s_sender_task) return;
+
+    // Timed at publish, not when this task got round to it
+    const ot::FrameRecord record = ot::frameRecord(event, ot::clockUs());
+
+    xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+    const bool connected = s_clients.clients() > 0;
+    if (connected) {
+        s_clients.pushFrame(record);
+    }
+    xSemaphoreGive(s_clients_lock);
+    if (connected) {
+        xTaskNotifyGive(s_sender_task);
+    }
 }
 
 // ============================================================================
@@ -534,13 +911,23 @@ extern "C" esp_err_t websocket_server_start(websocket_server_t* ws_server,
     s_ws_server = ws_server;
     memset(ws_server, 0, sizeof(websocket_server_t));
 
+    if (!s_clients_lock) {
+        s_clients_lock = xSemaphoreCreateMutex();
+        s_sender_stopped = xSemaphoreCreateBinary();
+        if (!s_clients_lock || !s_sender_stopped) {
+            ESP_LOGE(TAG, "Failed to create WebSocket client lock");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
     if (!s_boiler_mgr) {
         ESP_LOGW(TAG, "No boiler manager available - starting without it");
     }
 
-    // Register message callback for logging
-    if (s_boiler_mgr) {
-        s_boiler_mgr->setMessageCallback(boiler_manager_message_handler);
+    // Feed the message log from a subscriber task of its own; it only
+    // queues messages, so no client can hold it up
+    if (s_boiler_mgr && s_ws_subscriber < 0) {
+        s_ws_subscriber = s_boiler_mgr->events().subscribe("ws_feed", boiler_manager_message_handler);
     }
 
     // Register MQTT control mode callback
@@ -550,7 +937,7 @@ extern "C" esp_err_t websocket_server_start(websocket_server_t* ws_server,
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.max_open_sockets = 7;
-    config.max_uri_handlers = 20;
+    config.max_uri_handlers = 24;  // 18 here plus the OTA handlers
     config.uri_match_fn = httpd_uri_match_wildcard;
     config.recv_wait_timeout = 30;
     config.send_wait_timeout = 30;
@@ -598,12 +985,28 @@ extern "C" esp_err_t websocket_server_start(websocket_server_t* ws_server,
     httpd_register_uri_handler(ws_server->server, &control_get_uri);
     httpd_register_uri_handler(ws_server->server, &control_post_uri);
 
+    httpd_uri_t bus_log_uri = { "/api/bus_log", HTTP_GET, bus_log_get_handler, nullptr, false, false, nullptr };
+    httpd_register_uri_handler(ws_server->server, &bus_log_uri);
+
+    httpd_uri_t bus_stats_uri = { "/api/bus_stats", HTTP_GET, bus_stats_get_handler, nullptr, false, false, nullptr };
+    httpd_register_uri_handler(ws_server->server, &bus_stats_uri);
+
+    httpd_uri_t trace_uri = { "/api/trace", HTTP_GET, trace_get_handler, nullptr, false, false, nullptr };
+    httpd_register_uri_handler(ws_server->server, &trace_uri);
+
     httpd_uri_t write_api_uri = { "/api/write", HTTP_POST, write_api_handler, nullptr, false, false, nullptr };
     httpd_register_uri_handler(ws_server->server, &write_api_uri);
 
-    httpd_uri_t ws_uri = { "/ws", HTTP_GET, ws_handler, ws_server, true, false, nullptr };
+    httpd_uri_t ws_uri = { "/ws", HTTP_GET, ws_handler, nullptr, true, false, ot::FRAME_STREAM_PROTOCOL };
     httpd_register_uri_handler(ws_server->server, &ws_uri);
 
+    s_sender_stop = false;
+    if (xTaskCreate(ws_sender_task, "ws_send", 3072, ws_server->server, 1, &s_sender_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create WebSocket sender task");
+        s_sender_task = nullptr;
+        return ESP_ERR_NO_MEM;
+    }
+
     ESP_LOGI(TAG, "WebSocket server started successfully");
     return ESP_OK;
 }
@@ -616,33 +1019,51 @@ extern "C" void websocket_server_set_mqtt(ot::MqttBridge* mqtt) {
 }
 
 extern "C" void websocket_server_stop(websocket_server_t* ws_server) {
+    if (s_boiler_mgr && s_ws_subscriber >= 0) {
+        s_boiler_mgr->events().unsubscribe(s_ws_subscriber);
+        s_ws_subscriber = -1;
+    }
+    if (s_sender_task) {
+        s_sender_stop = true;
+        xTaskNotifyGive(s_sender_task);
+        xSemaphoreTake(s_sender_stopped, portMAX_DELAY);
+        s_sender_task = nullptr;
+    }
     if (ws_server->server) {
         httpd_stop(ws_server->server);
         ws_server->server = nullptr;
-        ws_server->client_connected = false;
+    }
+    if (s_clients_lock) {
+        xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+        for (size_t slot = 0; slot < ot::ClientBroadcast::MAX_CLIENTS; slot++) {
+            s_clients.remove(slot);
+        }
+        xSemaphoreGive(s_clients_lock);
     }
 }
 
 extern "C" esp_err_t websocket_server_send_text(websocket_server_t* ws_server, const char* text) {
-    if (!ws_server->server || !ws_server->client_connected) {
-        ESP_LOGD(TAG, "Not sending WebSocket message: server not started or client not connected");
+    if (!ws_server->server || !s_sender_task) {
+        ESP_LOGD(TAG, "Not sending WebSocket message: server not started");
         return ESP_FAIL;
     }
 
-    httpd_ws_frame_t ws_pkt = {};
-    ws_pkt.payload = reinterpret_cast<uint8_t*>(const_cast<char*>(text));
-    ws_pkt.len = strlen(text);
-    ws_pkt.type = HTTPD_WS_TYPE_TEXT;
+    const size_t len = strlen(text);
+    xSemaphoreTake(s_clients_lock, portMAX_DELAY);
+    const bool connected = s_clients.clients() > 0;
+    const bool queued = connected && s_clients.push(text, len);
+    xSemaphoreGive(s_clients_lock);
 
-    esp_err_t ret = httpd_ws_send_frame_async(ws_server->server, ws_server->client_fd, &ws_pkt);
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to send WebSocket message: %s", esp_err_to_name(ret));
-        ws_server->client_connected = false;
-    } else {
-        ESP_LOGD(TAG, "WebSocket message sent");
+    if (!connected) {
+        ESP_LOGD(TAG, "Not sending WebSocket message: no client connected");
+        return ESP_FAIL;
     }
-
-    return ret;
+    if (!queued) {
+        ESP_LOGW(TAG, "WebSocket message too long (%u bytes)", static_cast<unsigned>(len));
+        return ESP_ERR_INVALID_SIZE;
+    }
+    xTaskNotifyGive(s_sender_task);
+    return ESP_OK;
 }
 
 extern "C" esp_err_t websocket_server_send_opentherm_message(websocket_server_t* ws_server,
@@ -653,7 +1074,7 @@ extern "C" esp_err_t websocket_server_send_opentherm_message(websocket_server_t*
                                                               uint16_t data_value,
                                                               const char* source) {
     char json_buffer[512];
-    int64_t timestamp = esp_timer_get_time() / 1000;
+    int64_t timestamp = ot::clockMs().count();
 
     snprintf(json_buffer, sizeof(json_buffer),
              "{\"timestamp\":%lld,\"direction\":\"%s\",\"source\":\"%s\",\"message\":%lu,\"msg_type\":\"%s\",\"data_id\":%u,\"data_value\":%u}",
@@ -20,11 +20,9 @@ namespace ot {
 extern "C" {
 #endif
 
-// WebSocket server handle
+// WebSocket server handle; the server keeps its client table itself
 typedef struct {
     httpd_handle_t server;
-    int client_fd;
-    bool client_connected;
 } websocket_server_t;
 
 #ifdef __cplusplus
@@ -38,7 +36,8 @@ void websocket_server_set_mqtt(ot::MqttBridge *mqtt);
 // Stop WebSocket server
 void websocket_server_stop(websocket_server_t *ws_server);
 
-// Send text message to all connected clients
+// Queue a text message for every connected client; returns ESP_FAIL when
+// none is connected. Never waits on a client.
 esp_err_t websocket_server_send_text(websocket_server_t *ws_server, const char *text);
 
 // Send JSON formatted OpenTherm message
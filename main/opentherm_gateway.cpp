@@ -135,23 +135,12 @@ static esp_err_t wifi_init_sta() {
     }
 }
 
-// Message callback - logs all OpenTherm messages to WebSocket
-static void opentherm_message_callback(std::string_view direction, ot::MessageSource source,
-                                       ot::Frame message) {
-    uint8_t data_id = message.dataId();
-    uint16_t data_value = message.dataValue();
-
-    const char* type_str = ot::toString(message.messageType());
-    const char* source_str = ot::toString(source);
-
-    ESP_LOGI(TAG, "%.*s | Type: %s | ID: %d | Value: 0x%04X | Source: %s",
-             static_cast<int>(direction.size()), direction.data(),
-             type_str, data_id, data_value, source_str);
-
-    websocket_server_send_opentherm_message(&ws_server,
-                                            std::string(direction).c_str(),
-                                            message.raw(),
-                                            type_str, data_id, data_value, source_str);
+// Frame event subscriber - logs all OpenTherm messages (the WebSocket
+// server subscribes on its own)
+static void opentherm_message_logger(const ot::FrameEvent& event) {
+    ESP_LOGI(TAG, "%s | Type: %s | ID: %d | Value: 0x%04X | Source: %s",
+             ot::toString(event.direction), ot::toString(event.frame.messageType()),
+             event.frame.dataId(), event.frame.dataValue(), ot::toString(event.source));
 }
 
 // Heartbeat task - sends periodic status updates
@@ -205,7 +194,11 @@ static void start_gateway() {
 
     // Initialize boiler manager (before WebSocket so it's available for API calls)
     ot::ManagerConfig mgr_cfg;
+#if CONFIG_OT_CUT_THROUGH
+    mgr_cfg.mode = ot::ManagerMode::CutThrough;
+#else
     mgr_cfg.mode = ot::ManagerMode::Proxy;
+#endif
     mgr_cfg.interceptRate = 4;
     mgr_cfg.taskStackSize = 4096;
     mgr_cfg.taskPriority = 5;
@@ -216,8 +209,10 @@ static void start_gateway() {
 
     s_manager = std::make_unique<ot::BoilerManager>(mgr_cfg);
 
-    // Set message callback
-    s_manager->setMessageCallback(opentherm_message_callback);
+    // Log every frame from a subscriber task of its own
+    if (s_manager->events().subscribe("ot_msg_log", opentherm_message_logger) < 0) {
+        ESP_LOGW(TAG, "OpenTherm messages will not be logged");
+    }
 
     // Set MQTT bridge for diagnostics publishing
     s_manager->setMqttBridge(s_mqtt.get());
@@ -0,0 +1,49 @@
+/**
+ * Binary live frame stream ("ot-frames.v1" WebSocket subprotocol)
+ *
+ * Layout in components/websocket_server/frame_stream.h. Each record decodes
+ * to the same fields as the JSON stream's messages.
+ */
+
+export const FRAME_STREAM_PROTOCOL = 'ot-frames.v1';
+
+const VERSION = 1;
+const HEADER_BYTES = 8;
+
+const MSG_TYPES = ['READ_DATA', 'WRITE_DATA', 'INVALID_DATA', 'RESERVED',
+                   'READ_ACK', 'WRITE_ACK', 'DATA_INVALID', 'UNKNOWN_ID'];
+const SOURCES = ['THERMOSTAT_BOILER', 'GATEWAY_BOILER', 'THERMOSTAT_GATEWAY'];
+const DIRECTIONS = ['REQUEST', 'RESPONSE', 'DISCARDED_REQUEST'];
+
+/**
+ * Records of one binary message, oldest first. time_us is the gateway's
+ * clock, truncated to 32 bits; seq counts every message the gateway
+ * queued, so a gap means some were dropped. Returns [] for a message of
+ * another version.
+ */
+export function decodeFrameBatch(buffer) {
+  const view = new DataView(buffer);
+  if (view.byteLength < HEADER_BYTES || view.getUint8(0) !== VERSION) return [];
+
+  const recordBytes = view.getUint8(1);
+  const count = view.getUint16(2, true);
+  let timeUs = view.getUint32(4, true);
+  if (recordBytes < 12 || HEADER_BYTES + count * recordBytes > view.byteLength) return [];
+
+  const records = [];
+  for (let i = 0, off = HEADER_BYTES; i < count; i++, off += recordBytes) {
+    timeUs = (timeUs + view.getUint32(off, true)) >>> 0;
+    const message = view.getUint32(off + 4, true);
+    records.push({
+      time_us: timeUs,
+      direction: DIRECTIONS[view.getUint8(off + 9)] || 'UNKNOWN',
+      source: SOURCES[view.getUint8(off + 8)] || 'UNKNOWN',
+      message,
+      msg_type: MSG_TYPES[(message >>> 28) & 7],
+      data_id: (message >>> 16) & 0xFF,
+      data_value: message & 0xFFFF,
+      seq: view.getUint16(off + 10, true)
+    });
+  }
+  return records;
+}
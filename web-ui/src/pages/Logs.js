@@ -3,6 +3,7 @@
  */
 
 import { ID_DECODERS, fmtHex } from '../lib/opentherm.js';
+import { FRAME_STREAM_PROTOCOL, decodeFrameBatch } from '../lib/frame_stream.js';
 
 let ws = null;
 let logsContainer = null;
@@ -104,8 +105,21 @@ function appendLogEntry(d) {
   logsContainer.scrollTop = logsContainer.scrollHeight;
 }
 
+function showCount() {
+  const countEl = document.getElementById('msg-count');
+  if (countEl) countEl.textContent = msgCount;
+}
+
+function addMessage(d) {
+  allMessages.push({ data: d, timestamp: new Date() });
+  if (allMessages.length > 500) allMessages.shift();
+  if (passesFilter(d)) appendLogEntry(d);
+}
+
 function connect() {
-  ws = new WebSocket('ws://' + window.location.host + '/ws');
+  // Binary frame batches where the gateway offers them; JSON otherwise
+  ws = new WebSocket('ws://' + window.location.host + '/ws', FRAME_STREAM_PROTOCOL);
+  ws.binaryType = 'arraybuffer';
 
   ws.onopen = () => {
     const dot = document.getElementById('status-dot');
@@ -125,16 +139,19 @@ function connect() {
   ws.onmessage = (e) => {
     if (paused) return;
 
+    if (e.data instanceof ArrayBuffer) {
+      const records = decodeFrameBatch(e.data);
+      msgCount += records.length;
+      showCount();
+      records.forEach(addMessage);
+      return;
+    }
+
     msgCount++;
-    const countEl = document.getElementById('msg-count');
-    if (countEl) countEl.textContent = msgCount;
+    showCount();
 
     try {
-      const d = JSON.parse(e.data);
-      allMessages.push({ data: d, timestamp: new Date() });
-      if (allMessages.length > 500) allMessages.shift();
-      if (!passesFilter(d)) return;
-      appendLogEntry(d);
+      addMessage(JSON.parse(e.data));
     } catch (err) {
       const div = document.createElement('div');
       const ts = new Date().toLocaleTimeString('en-GB', { hour12: false });